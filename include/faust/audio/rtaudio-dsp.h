@@ -29,9 +29,11 @@
 #include <assert.h>
 #include <rtaudio/RtAudio.h>
 #include <stdlib.h>
+#include <algorithm>
 
 #include "faust/audio/audio.h"
 #include "faust/dsp/dsp-adapter.h"
+#include "faust/dsp/dsp-tools.h"
 
 #define FORMAT RTAUDIO_FLOAT32
 
@@ -50,6 +52,7 @@ class rtaudio : public audio {
         dsp* fDsp;
         RtAudio fAudioDAC;
         unsigned int fSampleRate;
+        unsigned int fDSPSampleRate;    // requested rate, resampled to fSampleRate if the device does not support it
         unsigned int fBufferSize;
          
         //----------------------------------------------------------------------------
@@ -57,11 +60,86 @@ class rtaudio : public audio {
         //----------------------------------------------------------------------------
         int	fDevNumInChans;
         int	fDevNumOutChans;
+    
+        //----------------------------------------------------------------------------
+        // 'native' mode: the stream uses the device sample format and interleaving,
+        // so that RtAudio does not convert the buffers itself. The conversion is done
+        // in a single pass from/to the preallocated non-interleaved fInputs/fOutputs.
+        //----------------------------------------------------------------------------
+        bool fNative;
+        bool fInterleaved;
+        RtAudioFormat fFormat;
+        FAUSTFLOAT** fInputs;
+        FAUSTFLOAT** fOutputs;
+    
+        static RtAudioFormat getNativeFormat(RtAudioFormat formats)
+        {
+            if (formats & RTAUDIO_FLOAT32) return RTAUDIO_FLOAT32;
+            if (formats & RTAUDIO_SINT32) return RTAUDIO_SINT32;
+            if (formats & RTAUDIO_SINT24) return RTAUDIO_SINT24;
+            if (formats & RTAUDIO_SINT16) return RTAUDIO_SINT16;
+            return RTAUDIO_FLOAT32;
+        }
+    
+        static bool isNativeInterleaved(RtAudio::Api api)
+        {
+            // JACK and ASIO buffers are non-interleaved, the other APIs are interleaved
+            return (api != RtAudio::UNIX_JACK) && (api != RtAudio::WINDOWS_ASIO);
+        }
+    
+        void allocateBuffers()
+        {
+            fInputs = new FAUSTFLOAT*[fDevNumInChans];
+            for (int i = 0; i < fDevNumInChans; i++) {
+                fInputs[i] = new FAUSTFLOAT[fBufferSize];
+            }
+            fOutputs = new FAUSTFLOAT*[fDevNumOutChans];
+            for (int i = 0; i < fDevNumOutChans; i++) {
+                fOutputs[i] = new FAUSTFLOAT[fBufferSize];
+            }
+        }
+    
+        void deleteBuffers()
+        {
+            if (fInputs) {
+                for (int i = 0; i < fDevNumInChans; i++) {
+                    delete [] fInputs[i];
+                }
+                delete [] fInputs;
+                fInputs = nullptr;
+            }
+            if (fOutputs) {
+                for (int i = 0; i < fDevNumOutChans; i++) {
+                    delete [] fOutputs[i];
+                }
+                delete [] fOutputs;
+                fOutputs = nullptr;
+            }
+        }
+    
+        template <typename SAMPLE>
+        void processNative(double streamTime, void* inbuf, void* outbuf, unsigned long frames)
+        {
+            assert(frames <= fBufferSize);
+            readSamples(static_cast<SAMPLE*>(inbuf), fDevNumInChans, fInterleaved, fInputs, fDsp->getNumInputs(), int(frames));
+            fDsp->compute(streamTime * 1000000., int(frames), fInputs, fOutputs);
+            writeSamples(fOutputs, fDsp->getNumOutputs(), static_cast<SAMPLE*>(outbuf), fDevNumOutChans, fInterleaved, int(frames));
+        }
         
         virtual int processAudio(double streamTime, void* inbuf, void* outbuf, unsigned long frames) 
         {
             AVOIDDENORMALS;
             
+            if (fNative) {
+                switch (fFormat) {
+                    case RTAUDIO_SINT16: processNative<int16_t>(streamTime, inbuf, outbuf, frames); break;
+                    case RTAUDIO_SINT24: processNative<int24_packed>(streamTime, inbuf, outbuf, frames); break;
+                    case RTAUDIO_SINT32: processNative<int32_t>(streamTime, inbuf, outbuf, frames); break;
+                    default: processNative<float>(streamTime, inbuf, outbuf, frames); break;
+                }
+                return 0;
+            }
+            
             float* inputs[fDsp->getNumInputs()];
             float* outputs[fDsp->getNumOutputs()];
             
@@ -87,9 +165,20 @@ class rtaudio : public audio {
       
     public:
         
-        rtaudio(int srate, int bsize) : fDsp(0),
-                fSampleRate(srate), fBufferSize(bsize), 
-                fDevNumInChans(0), fDevNumOutChans(0) {}
+        /**
+         * Constructor.
+         *
+         * @param srate - the sample rate
+         * @param bsize - the buffer size
+         * @param native - open the stream with the device native sample format and interleaving
+         * and convert the buffers in the driver, instead of letting RtAudio convert them to
+         * non-interleaved float buffers
+         */
+        rtaudio(int srate, int bsize, bool native = false) : fDsp(0),
+                fSampleRate(srate), fDSPSampleRate(srate), fBufferSize(bsize), 
+                fDevNumInChans(0), fDevNumOutChans(0),
+                fNative(native), fInterleaved(false), fFormat(FORMAT),
+                fInputs(nullptr), fOutputs(nullptr) {}
             
         virtual ~rtaudio() 
         {
@@ -106,6 +195,7 @@ class rtaudio : public audio {
             }
             fAudioDAC.closeStream();
 #endif
+            deleteBuffers();
         }
         
         virtual bool init(const char* name, dsp* DSP)
@@ -139,26 +229,52 @@ class rtaudio : public audio {
             oParams.nChannels = fDevNumOutChans;
             oParams.firstChannel = 0;
             
+            // Use the device preferred rate if the requested one is not supported, the DSP will be resampled
+            RtAudio::DeviceInfo& info = (numOutputs > 0) ? info_out : info_in;
+            fSampleRate = fDSPSampleRate;
+            if (info.preferredSampleRate > 0
+                && std::find(info.sampleRates.begin(), info.sampleRates.end(), fSampleRate) == info.sampleRates.end()) {
+                std::cout << "Sample rate " << fSampleRate << " is not supported, resampling to " << info.preferredSampleRate << std::endl;
+                fSampleRate = info.preferredSampleRate;
+            }
+            
             RtAudio::StreamOptions options;
-            options.flags |= RTAUDIO_NONINTERLEAVED;
+            if (fNative) {
+                RtAudioFormat formats = 0;
+                if (numInputs > 0) formats = info_in.nativeFormats;
+                if (numOutputs > 0) formats = (formats & info_out.nativeFormats) ? (formats & info_out.nativeFormats) : info_out.nativeFormats;
+                fFormat = getNativeFormat(formats);
+                fInterleaved = isNativeInterleaved(fAudioDAC.getCurrentApi());
+            } else {
+                fFormat = FORMAT;
+                fInterleaved = false;
+            }
+            if (!fInterleaved) {
+                options.flags |= RTAUDIO_NONINTERLEAVED;
+            }
 
 #if RTAUDIO_VERSION_MAJOR < 6
             try {
                 fAudioDAC.openStream(((numOutputs > 0) ? &oParams : NULL),
-                    ((numInputs > 0) ? &iParams : NULL), FORMAT,
+                    ((numInputs > 0) ? &iParams : NULL), fFormat,
                     fSampleRate, &fBufferSize, audioCallback, this, &options);
             } catch (RtAudioError& e) {
                 std::cout << '\n' << e.getMessage() << '\n' << std::endl;
 #else
             RtAudioErrorType err = fAudioDAC.openStream(
                 ((numOutputs > 0) ? &oParams : NULL),
-                ((numInputs > 0) ? &iParams : NULL), FORMAT,
+                ((numInputs > 0) ? &iParams : NULL), fFormat,
                 fSampleRate, &fBufferSize, audioCallback, this, &options);
             if (err != RTAUDIO_NO_ERROR) {
                 std::cout << '\n' << fAudioDAC.getErrorText() << '\n' << std::endl;
 #endif
                 return false;
             }
+            // fBufferSize may have been changed by openStream
+            if (fNative) {
+                deleteBuffers();
+                allocateBuffers();
+            }
             return true;
         }
         
@@ -173,6 +289,10 @@ class rtaudio : public audio {
                 fDsp = new dsp_adapter(fDsp, fDevNumInChans, fDevNumOutChans, fBufferSize);
             }
             
+            if (fDSPSampleRate != fSampleRate) {
+                fDsp = createRateAdapter(fDsp, fDSPSampleRate, fBufferSize);
+            }
+            
             fDsp->init(fSampleRate);
         }
         
@@ -228,6 +348,13 @@ class rtaudio : public audio {
         {
             return fDevNumOutChans;
         }
+    
+        bool isNative() { return fNative; }
+    
+        // The stream sample format (RTAUDIO_FLOAT32 unless in 'native' mode)
+        RtAudioFormat getFormat() { return fFormat; }
+    
+        bool isInterleaved() { return fInterleaved; }
 };
 
 #endif
@@ -32,8 +32,12 @@
 #include <cmath>
 #include <assert.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
 
 #include "faust/dsp/dsp.h"
+#include "faust/dsp/dsp-simd.h"
 
 // Adapts a DSP for a different number of inputs/outputs
 class dsp_adapter : public decorator_dsp {
@@ -640,11 +644,370 @@ class dsp_up_sampler : public sr_sampler<FILTER> {
         virtual void compute(double /*date_usec*/, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) { compute(count, inputs, outputs); }
 };
 
-// Create a UP/DS + Filter adapted DSP
+// Inner product used by the polyphase filters (4 partial sums, SSE/NEON version for float samples)
+template <typename REAL>
+inline REAL dotProduct(const REAL* a, const REAL* b, int size)
+{
+    REAL sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    for (int i = 0; i < size; i += 4) {
+        sum0 += a[i] * b[i];
+        sum1 += a[i + 1] * b[i + 1];
+        sum2 += a[i + 2] * b[i + 2];
+        sum3 += a[i + 3] * b[i + 3];
+    }
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+#if defined (DSP_SIMD)
+inline float dotProduct(const float* a, const float* b, int size)
+{
+    simd_float4 sum = simd_set1(0.f);
+    for (int i = 0; i < size; i += 4) {
+        sum = simd_add(sum, simd_mul(simd_load(&a[i]), simd_load(&b[i])));
+    }
+    return simd_sum(sum);
+}
+#endif
+
+/*
+ Streaming polyphase FIR resampler for a group of channels, with a rational 'up/down' ratio
+ (output rate = input rate * up / down).
+ 
+ The prototype is a Kaiser windowed sinc, designed at 'up' times the input rate, and split in 'up'
+ phases of 'fTaps' coefficients (a multiple of 4, stored reversed so that each output is a forward
+ inner product). Only the needed output phases are computed. The filter is causal: an output is
+ produced as soon as its most recent input is known, so that each block of 'count' inputs gives
+ about count * up / down outputs, without additional buffering.
+*/
+class polyphase_resampler {
+    
+    private:
+    
+        int fUp;
+        int fDown;
+        int fTaps;
+        int fChannels;
+        int fMaxCount;
+        
+        std::vector<FAUSTFLOAT> fBank;                  // fUp phases * fTaps coefficients
+        std::vector<std::vector<FAUSTFLOAT> > fHistory; // fTaps previous inputs + fMaxCount new inputs, for each channel
+        
+        int fIndex;     // index (relative to the next block) of the most recent input used by the next output, >= -1
+        int fPhase;     // phase of the next output, in [0, fUp)
+    
+        static double besselI0(double x)
+        {
+            double sum = 1., term = 1.;
+            for (int k = 1; k < 64; k++) {
+                term *= (x / (2. * k)) * (x / (2. * k));
+                sum += term;
+                if (term < sum * 1e-12) break;
+            }
+            return sum;
+        }
+    
+        void makeBank(int quality)
+        {
+            // Cutoff at 0.45 of the lower rate (as the previous IIR filters), in cycles per sample at the 'up' rate
+            int factor = std::max(fUp, fDown);
+            double cutoff = 0.45 / double(factor);
+            int length = 2 * quality * factor;
+            fTaps = ((length + fUp - 1) / fUp + 3) & ~3;
+            length = fTaps * fUp;
+            double center = double(length - 1) / 2.;
+            // About 100 dB of stopband attenuation
+            double beta = 10.;
+            double norm = besselI0(beta);
+            
+            std::vector<double> prototype(length);
+            for (int i = 0; i < length; i++) {
+                double t = double(i) - center;
+                double x = 2. * cutoff * t;
+                double sinc = (std::fabs(x) < 1e-12) ? 1. : std::sin(M_PI * x) / (M_PI * x);
+                double w = 2. * t / double(length - 1);
+                prototype[i] = sinc * besselI0(beta * std::sqrt(std::max(0., 1. - w * w))) / norm;
+            }
+            
+            // Phase p uses prototype[p + k * fUp] on the input 'index - k', normalized for an unity DC gain
+            fBank.assign(fUp * fTaps, FAUSTFLOAT(0));
+            for (int phase = 0; phase < fUp; phase++) {
+                double sum = 0.;
+                for (int k = 0; k < fTaps; k++) {
+                    sum += prototype[phase + k * fUp];
+                }
+                for (int k = 0; k < fTaps; k++) {
+                    fBank[phase * fTaps + (fTaps - 1 - k)] = FAUSTFLOAT(prototype[phase + k * fUp] / sum);
+                }
+            }
+        }
+    
+    public:
+    
+        /**
+         * Constructor.
+         *
+         * @param up - the interpolation factor
+         * @param down - the decimation factor
+         * @param channels - the number of channels
+         * @param max_count - the maximum number of input frames given to 'compute'
+         * @param quality - number of zero-crossings of the sinc at each side of its center (cost is proportional)
+         */
+        polyphase_resampler(int up, int down, int channels, int max_count, int quality = 16)
+        {
+            int a = up, b = down;
+            while (b != 0) { int t = a % b; a = b; b = t; }
+            fUp = up / a;
+            fDown = down / a;
+            fChannels = channels;
+            fMaxCount = max_count;
+            makeBank(quality);
+            fHistory.resize(fChannels, std::vector<FAUSTFLOAT>(fTaps + fMaxCount));
+            reset();
+        }
+    
+        void reset()
+        {
+            for (int chan = 0; chan < fChannels; chan++) {
+                std::fill(fHistory[chan].begin(), fHistory[chan].end(), FAUSTFLOAT(0));
+            }
+            fIndex = 0;
+            fPhase = 0;
+        }
+    
+        // Maximum number of outputs for 'count' inputs
+        int getMaxOutputs(int count) { return int((int64_t(count) * fUp + fDown - 1) / fDown) + 1; }
+    
+        int getTaps() { return fTaps; }
+    
+        // Group delay of the filter, in input frames
+        double getLatency() { return double(fTaps * fUp - 1) / (2. * fUp); }
+    
+        /**
+         * Resample a block.
+         *
+         * @param count - the number of input frames (<= max_count)
+         * @param inputs - the input buffers
+         * @param outputs - the output buffers
+         * @param max_outputs - the maximum number of outputs to produce, the remaining ones are produced by the next call
+         * @return the number of output frames
+         */
+        int compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs, int max_outputs)
+        {
+            assert(count <= fMaxCount);
+            int index = fIndex;
+            int phase = fPhase;
+            int produced = 0;
+            for (int chan = 0; chan < fChannels; chan++) {
+                FAUSTFLOAT* history = fHistory[chan].data();
+                memcpy(&history[fTaps], inputs[chan], sizeof(FAUSTFLOAT) * count);
+                FAUSTFLOAT* output = outputs[chan];
+                index = fIndex;
+                phase = fPhase;
+                produced = 0;
+                // The window of the most recent input 'index' starts at history[index + 1]
+                while (index < count && produced < max_outputs) {
+                    output[produced++] = dotProduct(&fBank[phase * fTaps], &history[index + 1], fTaps);
+                    phase += fDown;
+                    index += phase / fUp;
+                    phase %= fUp;
+                }
+                memmove(history, &history[count], sizeof(FAUSTFLOAT) * fTaps);
+            }
+            if (fChannels == 0) {
+                while (index < count && produced < max_outputs) {
+                    produced++;
+                    phase += fDown;
+                    index += phase / fUp;
+                    phase %= fUp;
+                }
+            }
+            fIndex = index - count;
+            fPhase = phase;
+            return produced;
+        }
+};
+
+/*
+ Sample-rate adapter using polyphase FIR resamplers: the decorated DSP runs at 'up/down' times the
+ rate given to 'init' (or at a fixed 'dsp_rate' whatever this rate is). Inputs are resampled to
+ the DSP rate and outputs back to the external rate, so that each block of 'count' frames gives
+ exactly 'count' frames, the DSP itself receiving a (possibly varying) number of frames.
+ Buffers are allocated in the constructor and in 'init', not in 'compute'.
+*/
+class dsp_resampler : public decorator_dsp {
+    
+    private:
+    
+        int fUp;
+        int fDown;
+        int fQuality;
+        int fBufferSize;
+        int fDSPRate;
+        
+        polyphase_resampler* fInputResampler;
+        polyphase_resampler* fOutputResampler;
+        std::vector<std::vector<FAUSTFLOAT> > fInputBuffers;
+        std::vector<std::vector<FAUSTFLOAT> > fOutputBuffers;
+        std::vector<FAUSTFLOAT*> fInputs;
+        std::vector<FAUSTFLOAT*> fOutputs;
+        std::vector<FAUSTFLOAT*> fExtInputs;
+        std::vector<FAUSTFLOAT*> fExtOutputs;
+    
+        void setRatio(int sample_rate)
+        {
+            if (fDSPRate > 0) {
+                fUp = fDSPRate;
+                fDown = sample_rate;
+            }
+            delete fInputResampler;
+            delete fOutputResampler;
+            fInputResampler = new polyphase_resampler(fUp, fDown, fDSP->getNumInputs(), fBufferSize, fQuality);
+            int inner_size = fInputResampler->getMaxOutputs(fBufferSize);
+            fOutputResampler = new polyphase_resampler(fDown, fUp, fDSP->getNumOutputs(), inner_size, fQuality);
+            for (int chan = 0; chan < fDSP->getNumInputs(); chan++) {
+                fInputBuffers[chan].assign(inner_size, FAUSTFLOAT(0));
+                fInputs[chan] = fInputBuffers[chan].data();
+            }
+            for (int chan = 0; chan < fDSP->getNumOutputs(); chan++) {
+                fOutputBuffers[chan].assign(inner_size, FAUSTFLOAT(0));
+                fOutputs[chan] = fOutputBuffers[chan].data();
+            }
+        }
+    
+        int getInnerRate(int sample_rate)
+        {
+            return (fDSPRate > 0) ? fDSPRate : int((int64_t(sample_rate) * fUp) / fDown);
+        }
+    
+        template <typename COMPUTE>
+        void computeAux(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs, COMPUTE compute)
+        {
+            // Blocks larger than the allocated size are split
+            for (int frame = 0; frame < count; frame += fBufferSize) {
+                int size = std::min(fBufferSize, count - frame);
+                for (int chan = 0; chan < fDSP->getNumInputs(); chan++) {
+                    fExtInputs[chan] = inputs[chan] + frame;
+                }
+                for (int chan = 0; chan < fDSP->getNumOutputs(); chan++) {
+                    fExtOutputs[chan] = outputs[chan] + frame;
+                }
+                int inner_count = fInputResampler->compute(size, fExtInputs.data(), fInputs.data(), fInputResampler->getMaxOutputs(size));
+                compute(inner_count, fInputs.data(), fOutputs.data());
+                int res = fOutputResampler->compute(inner_count, fOutputs.data(), fExtOutputs.data(), size);
+                // Only at the very beginning, when the output filter is not yet primed
+                for (int chan = 0; chan < fDSP->getNumOutputs(); chan++) {
+                    memset(fExtOutputs[chan] + res, 0, sizeof(FAUSTFLOAT) * (size - res));
+                }
+            }
+        }
+    
+    public:
+    
+        /**
+         * Constructor.
+         *
+         * @param dsp - the DSP to be decorated (owned by the decorator)
+         * @param up - the DSP runs at 'sample_rate * up / down', 'sample_rate' being given to 'init'
+         * @param down - see 'up'
+         * @param quality - number of zero-crossings of the resampling filters (4 to 64, cost is proportional)
+         * @param buffer_size - the buffer size preallocated for 'compute' (larger blocks are split)
+         * @param dsp_rate - if not 0, the DSP always runs at this rate and 'up/down' are computed in 'init'
+         */
+        dsp_resampler(dsp* dsp, int up, int down, int quality = 16, int buffer_size = 4096, int dsp_rate = 0)
+        :decorator_dsp(dsp), fUp(std::max(1, up)), fDown(std::max(1, down)), fQuality(quality),
+        fBufferSize(buffer_size), fDSPRate(dsp_rate), fInputResampler(nullptr), fOutputResampler(nullptr)
+        {
+            fInputBuffers.resize(fDSP->getNumInputs());
+            fOutputBuffers.resize(fDSP->getNumOutputs());
+            fInputs.resize(fDSP->getNumInputs());
+            fOutputs.resize(fDSP->getNumOutputs());
+            fExtInputs.resize(fDSP->getNumInputs());
+            fExtOutputs.resize(fDSP->getNumOutputs());
+            if (fDSPRate == 0) setRatio(0);
+        }
+    
+        virtual ~dsp_resampler()
+        {
+            delete fInputResampler;
+            delete fOutputResampler;
+        }
+    
+        virtual void init(int sample_rate)
+        {
+            setRatio(sample_rate);
+            fDSP->init(getInnerRate(sample_rate));
+        }
+    
+        virtual void instanceInit(int sample_rate)
+        {
+            setRatio(sample_rate);
+            fDSP->instanceInit(getInnerRate(sample_rate));
+        }
+    
+        virtual void instanceConstants(int sample_rate)
+        {
+            setRatio(sample_rate);
+            fDSP->instanceConstants(getInnerRate(sample_rate));
+        }
+    
+        virtual void instanceClear()
+        {
+            if (fInputResampler) fInputResampler->reset();
+            if (fOutputResampler) fOutputResampler->reset();
+            fDSP->instanceClear();
+        }
+    
+        virtual dsp_resampler* clone() { return new dsp_resampler(fDSP->clone(), fUp, fDown, fQuality, fBufferSize, fDSPRate); }
+    
+        // Latency of both resampling filters, in frames at the external rate
+        double getLatency()
+        {
+            return (fInputResampler && fOutputResampler)
+                ? fInputResampler->getLatency() + fOutputResampler->getLatency() * double(fDown) / double(fUp)
+                : 0.;
+        }
+    
+        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            computeAux(count, inputs, outputs, [this](int inner_count, FAUSTFLOAT** ins, FAUSTFLOAT** outs) {
+                fDSP->compute(inner_count, ins, outs);
+            });
+        }
+    
+        virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            computeAux(count, inputs, outputs, [this, date_usec](int inner_count, FAUSTFLOAT** ins, FAUSTFLOAT** outs) {
+                fDSP->compute(date_usec, inner_count, ins, outs);
+            });
+        }
+};
+
+/**
+ * Create a DSP always running at 'dsp_rate', whatever the rate given to 'init' (typically the audio driver rate).
+ *
+ * @param DSP - the DSP to be decorated (owned by the returned DSP)
+ * @param dsp_rate - the DSP sample rate
+ * @param buffer_size - the maximum buffer size given to 'compute'
+ * @param quality - number of zero-crossings of the resampling filters
+ */
+inline dsp* createRateAdapter(dsp* DSP, int dsp_rate, int buffer_size = 4096, int quality = 16)
+{
+    return new dsp_resampler(DSP, 1, 1, quality, buffer_size, dsp_rate);
+}
+
+// Create a UP/DS + Filter adapted DSP: 'filter' 0 only decimates/inserts zeros,
+// 1 to 4 use polyphase FIR resampling with increasing quality (and cost)
 template <typename REAL>
 dsp* createSRAdapter(dsp* DSP, int ds = 0, int us = 0, int filter = 0)
 {
-    if (ds > 0) {
+    if ((ds > 0 || us > 0) && filter >= 1 && filter <= 4) {
+        static const int quality[] = { 4, 8, 16, 32 };
+        if (ds > 0) {
+            return new dsp_resampler(DSP, 1, ds, quality[filter - 1]);
+        } else {
+            return new dsp_resampler(DSP, us, 1, quality[filter - 1]);
+        }
+    } else if (ds > 0) {
         switch (filter) {
             case 0:
                 if (ds == 2) {
@@ -664,78 +1027,6 @@ dsp* createSRAdapter(dsp* DSP, int ds = 0, int us = 0, int filter = 0)
                     assert(false);
                     return nullptr;
                 }
-            case 1:
-                if (ds == 2) {
-                    return new dsp_down_sampler<LowPass3<Double<45,100>, 2, REAL>>(DSP);
-                } else if (ds == 3) {
-                    return new dsp_down_sampler<LowPass3<Double<45,100>, 3, REAL>>(DSP);
-                } else if (ds == 4) {
-                    return new dsp_down_sampler<LowPass3<Double<45,100>, 4, REAL>>(DSP);
-                } else if (ds == 8) {
-                    return new dsp_down_sampler<LowPass3<Double<45,100>, 8, REAL>>(DSP);
-                } else if (ds == 16) {
-                    return new dsp_down_sampler<LowPass3<Double<45,100>, 16, REAL>>(DSP);
-                } else if (ds == 32) {
-                    return new dsp_down_sampler<LowPass3<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : ds factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
-            case 2:
-                if (ds == 2) {
-                    return new dsp_down_sampler<LowPass4<Double<45,100>, 2, REAL>>(DSP);
-                } else if (ds == 3) {
-                    return new dsp_down_sampler<LowPass4<Double<45,100>, 3, REAL>>(DSP);
-                } else if (ds == 4) {
-                    return new dsp_down_sampler<LowPass4<Double<45,100>, 4, REAL>>(DSP);
-                } else if (ds == 8) {
-                    return new dsp_down_sampler<LowPass4<Double<45,100>, 8, REAL>>(DSP);
-                } else if (ds == 16) {
-                    return new dsp_down_sampler<LowPass4<Double<45,100>, 16, REAL>>(DSP);
-                } else if (ds == 32) {
-                    return new dsp_down_sampler<LowPass4<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : ds factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
-            case 3:
-                if (ds == 2) {
-                    return new dsp_down_sampler<LowPass3e<Double<45,100>, 2, REAL>>(DSP);
-                } else if (ds == 3) {
-                    return new dsp_down_sampler<LowPass3e<Double<45,100>, 3, REAL>>(DSP);
-                } else if (ds == 4) {
-                    return new dsp_down_sampler<LowPass3e<Double<45,100>, 4, REAL>>(DSP);
-                } else if (ds == 8) {
-                    return new dsp_down_sampler<LowPass3e<Double<45,100>, 8, REAL>>(DSP);
-                } else if (ds == 16) {
-                    return new dsp_down_sampler<LowPass3e<Double<45,100>, 16, REAL>>(DSP);
-                } else if (ds == 32) {
-                    return new dsp_down_sampler<LowPass3e<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : ds factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
-            case 4:
-                if (ds == 2) {
-                    return new dsp_down_sampler<LowPass6e<Double<45,100>, 2, REAL>>(DSP);
-                } else if (ds == 3) {
-                    return new dsp_down_sampler<LowPass6e<Double<45,100>, 3, REAL>>(DSP);
-                } else if (ds == 4) {
-                    return new dsp_down_sampler<LowPass6e<Double<45,100>, 4, REAL>>(DSP);
-                } else if (ds == 8) {
-                    return new dsp_down_sampler<LowPass6e<Double<45,100>, 8, REAL>>(DSP);
-                } else if (ds == 16) {
-                    return new dsp_down_sampler<LowPass6e<Double<45,100>, 16, REAL>>(DSP);
-                } else if (ds == 32) {
-                    return new dsp_down_sampler<LowPass6e<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : ds factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
             default:
                 fprintf(stderr, "ERROR : filter type must be in [0..4] range\n");
                 assert(false);
@@ -762,78 +1053,6 @@ dsp* createSRAdapter(dsp* DSP, int ds = 0, int us = 0, int filter = 0)
                     assert(false);
                     return nullptr;
                 }
-            case 1:
-                if (us == 2) {
-                    return new dsp_up_sampler<LowPass3<Double<45,100>, 2, REAL>>(DSP);
-                } else if (us == 3) {
-                    return new dsp_up_sampler<LowPass3<Double<45,100>, 3, REAL>>(DSP);
-                } else if (us == 4) {
-                    return new dsp_up_sampler<LowPass3<Double<45,100>, 4, REAL>>(DSP);
-                } else if (us == 8) {
-                    return new dsp_up_sampler<LowPass3<Double<45,100>, 8, REAL>>(DSP);
-                } else if (us == 16) {
-                    return new dsp_up_sampler<LowPass3<Double<45,100>, 16, REAL>>(DSP);
-                } else if (us == 32) {
-                    return new dsp_up_sampler<LowPass3<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : us factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
-            case 2:
-                if (us == 2) {
-                    return new dsp_up_sampler<LowPass4<Double<45,100>, 2, REAL>>(DSP);
-                } else if (us == 3) {
-                    return new dsp_up_sampler<LowPass4<Double<45,100>, 3, REAL>>(DSP);
-                } else if (us == 4) {
-                    return new dsp_up_sampler<LowPass4<Double<45,100>, 4, REAL>>(DSP);
-                } else if (us == 8) {
-                    return new dsp_up_sampler<LowPass4<Double<45,100>, 8, REAL>>(DSP);
-                } else if (us == 16) {
-                    return new dsp_up_sampler<LowPass4<Double<45,100>, 16, REAL>>(DSP);
-                } else if (us == 32) {
-                    return new dsp_up_sampler<LowPass4<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : us factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
-            case 3:
-                if (us == 2) {
-                    return new dsp_up_sampler<LowPass3e<Double<45,100>, 2, REAL>>(DSP);
-                } else if (us == 3) {
-                    return new dsp_up_sampler<LowPass3e<Double<45,100>, 3, REAL>>(DSP);
-                } else if (us == 4) {
-                    return new dsp_up_sampler<LowPass3e<Double<45,100>, 4, REAL>>(DSP);
-                } else if (us == 8) {
-                    return new dsp_up_sampler<LowPass3e<Double<45,100>, 8, REAL>>(DSP);
-                } else if (us == 16) {
-                    return new dsp_up_sampler<LowPass3e<Double<45,100>, 16, REAL>>(DSP);
-                } else if (us == 32) {
-                    return new dsp_up_sampler<LowPass3e<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : us factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
-            case 4:
-                if (us == 2) {
-                    return new dsp_up_sampler<LowPass6e<Double<45,100>, 2, REAL>>(DSP);
-                } else if (us == 3) {
-                    return new dsp_up_sampler<LowPass6e<Double<45,100>, 3, REAL>>(DSP);
-                } else if (us == 4) {
-                    return new dsp_up_sampler<LowPass6e<Double<45,100>, 4, REAL>>(DSP);
-                } else if (us == 8) {
-                    return new dsp_up_sampler<LowPass6e<Double<45,100>, 8, REAL>>(DSP);
-                } else if (us == 16) {
-                    return new dsp_up_sampler<LowPass6e<Double<45,100>, 16, REAL>>(DSP);
-                } else if (us == 32) {
-                    return new dsp_up_sampler<LowPass6e<Double<45,100>, 32, REAL>>(DSP);
-                } else {
-                    fprintf(stderr, "ERROR : us factor type must be in [2..32] range\n");
-                    assert(false);
-                    return nullptr;
-                }
             default:
                 fprintf(stderr, "ERROR : filter type must be in [0..4] range\n");
                 assert(false);
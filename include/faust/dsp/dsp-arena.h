@@ -0,0 +1,409 @@
+/************************** BEGIN dsp-arena.h ****************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __dsp_arena__
+#define __dsp_arena__
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifdef __APPLE__
+#include <mach/vm_statistics.h>
+#endif
+
+#include "faust/dsp/dsp.h"
+
+#define ARENA_CACHE_LINE 64
+#define ARENA_CHUNK_SIZE (1 << 20)
+#define ARENA_HUGE_PAGE_SIZE (1 << 21)
+
+/**
+ * A dsp_memory_manager placing DSP instances memory zones in large contiguous chunks.
+ *
+ * Zones are bump-allocated with cache-line alignment, so that all zones of a given
+ * instance end up next to each other instead of being scattered in the heap.
+ * The begin/info/end sizing pass is used to reserve enough room for the whole
+ * instance in the current chunk before the first zone is allocated.
+ * Chunks can optionally be backed by huge pages (Linux MAP_HUGETLB or transparent
+ * huge pages, macOS superpages) to reduce TLB misses when many instances are used.
+ *
+ * A chunk is recycled when all zones allocated in it have been destroyed.
+ * The manager has to outlive all instances created while it was set on a factory.
+ *
+ * Zones allocated between beginInstance/endInstance are recorded as belonging to
+ * the created instance (see createArenaDSPInstance), so that its whole state can be
+ * accessed later on (see dsp-snapshot.h).
+ */
+class arena_memory_manager : public dsp_memory_manager {
+
+    public:
+
+        struct Zone {
+            char* fPtr;
+            size_t fSize;
+        };
+
+    private:
+
+        struct Chunk {
+            char* fBase;
+            size_t fSize;
+            size_t fUsed;
+            size_t fLive;
+            bool fMapped;
+        };
+
+        std::vector<Chunk> fChunks;
+        size_t fCurrent;
+
+        size_t fChunkSize;
+        size_t fAlignment;
+        bool fHugePages;
+
+        // Sizing pass state
+        size_t fPlannedSize;
+
+        // Statistics
+        size_t fAllocatedSize;
+        size_t fLiveZones;
+
+        // Instance zones tracking
+        bool fTracking;
+        std::vector<Zone> fPending;
+        std::map<dsp*, std::vector<Zone> > fInstanceZones;
+        std::map<void*, dsp*> fZoneOwners;
+
+        size_t align(size_t size, size_t alignment)
+        {
+            return (size + alignment - 1) & ~(alignment - 1);
+        }
+
+        bool allocateChunk(size_t size, Chunk& chunk)
+        {
+            chunk.fUsed = 0;
+            chunk.fLive = 0;
+            chunk.fMapped = false;
+        #ifndef _WIN32
+            if (fHugePages) {
+                size = align(size, ARENA_HUGE_PAGE_SIZE);
+                void* ptr = MAP_FAILED;
+            #if defined(__linux__) && defined(MAP_HUGETLB)
+                ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            #elif defined(__APPLE__) && defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+                ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+            #endif
+                // No reserved huge pages available: fallback to regular pages, possibly promoted by the kernel
+                if (ptr == MAP_FAILED) {
+                    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+                #if defined(__linux__) && defined(MADV_HUGEPAGE)
+                    if (ptr != MAP_FAILED) madvise(ptr, size, MADV_HUGEPAGE);
+                #endif
+                }
+                if (ptr == MAP_FAILED) return false;
+                chunk.fBase = static_cast<char*>(ptr);
+                chunk.fSize = size;
+                chunk.fMapped = true;
+                return true;
+            }
+        #endif
+            size = align(size, fAlignment);
+        #ifdef _WIN32
+            chunk.fBase = static_cast<char*>(_aligned_malloc(size, fAlignment));
+        #else
+            void* ptr = nullptr;
+            chunk.fBase = (posix_memalign(&ptr, fAlignment, size) == 0) ? static_cast<char*>(ptr) : nullptr;
+        #endif
+            chunk.fSize = size;
+            return chunk.fBase != nullptr;
+        }
+
+        void deallocateChunk(Chunk& chunk)
+        {
+        #ifdef _WIN32
+            _aligned_free(chunk.fBase);
+        #else
+            if (chunk.fMapped) {
+                munmap(chunk.fBase, chunk.fSize);
+            } else {
+                free(chunk.fBase);
+            }
+        #endif
+            chunk.fBase = nullptr;
+        }
+
+        // Select a chunk with at least 'size' free bytes, possibly allocating a new one
+        bool selectChunk(size_t size)
+        {
+            if (fCurrent < fChunks.size() && fChunks[fCurrent].fSize - fChunks[fCurrent].fUsed >= size) {
+                return true;
+            }
+            for (size_t i = 0; i < fChunks.size(); i++) {
+                if (fChunks[i].fSize - fChunks[i].fUsed >= size) {
+                    fCurrent = i;
+                    return true;
+                }
+            }
+            Chunk chunk;
+            if (!allocateChunk(std::max<size_t>(size, fChunkSize), chunk)) {
+                return false;
+            }
+            fChunks.push_back(chunk);
+            fCurrent = fChunks.size() - 1;
+            return true;
+        }
+
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param chunk_size - the capacity in bytes of each chunk (0 means a default of 1 MB)
+         * @param huge_pages - whether to back chunks with huge pages when available
+         * @param alignment - the alignment in bytes of each zone (a power of two, at least a cache line)
+         */
+        arena_memory_manager(size_t chunk_size = 0, bool huge_pages = false, size_t alignment = ARENA_CACHE_LINE)
+        :fCurrent(0),
+        fChunkSize((chunk_size > 0) ? chunk_size : ARENA_CHUNK_SIZE),
+        fAlignment(std::max<size_t>(alignment, sizeof(void*))),
+        fHugePages(huge_pages),
+        fPlannedSize(0),
+        fAllocatedSize(0),
+        fLiveZones(0),
+        fTracking(false)
+        {
+            if ((fAlignment & (fAlignment - 1)) != 0) {
+                fAlignment = ARENA_CACHE_LINE;
+            }
+        }
+
+        virtual ~arena_memory_manager()
+        {
+            for (auto& it : fChunks) {
+                deallocateChunk(it);
+            }
+        }
+
+        virtual void begin(size_t /*count*/)
+        {
+            fPlannedSize = 0;
+        }
+
+        virtual void info(size_t size, size_t /*reads*/, size_t /*writes*/)
+        {
+            fPlannedSize += align(size, fAlignment);
+        }
+
+        virtual void end()
+        {
+            // Make room for the whole instance so that its zones are contiguous
+            if (fPlannedSize > 0) {
+                selectChunk(fPlannedSize);
+            }
+        }
+
+        virtual void* allocate(size_t size)
+        {
+            size_t asize = align(std::max<size_t>(size, 1), fAlignment);
+            if (!selectChunk(asize)) {
+                return nullptr;
+            }
+            Chunk& chunk = fChunks[fCurrent];
+            void* ptr = chunk.fBase + chunk.fUsed;
+            chunk.fUsed += asize;
+            chunk.fLive++;
+            fAllocatedSize += asize;
+            fLiveZones++;
+            if (fTracking) {
+                fPending.push_back({static_cast<char*>(ptr), size});
+            }
+            return ptr;
+        }
+
+        virtual void destroy(void* ptr)
+        {
+            if (!ptr) return;
+            // The instance is being deleted: forget all its zones
+            auto owner = fZoneOwners.find(ptr);
+            if (owner != fZoneOwners.end()) {
+                dsp* instance = owner->second;
+                for (const auto& it : fInstanceZones[instance]) {
+                    fZoneOwners.erase(it.fPtr);
+                }
+                fInstanceZones.erase(instance);
+            }
+            char* cptr = static_cast<char*>(ptr);
+            for (auto& it : fChunks) {
+                if (cptr >= it.fBase && cptr < it.fBase + it.fSize) {
+                    if (it.fLive > 0 && --it.fLive == 0) {
+                        // All zones of the chunk are dead: it can be reused from the start
+                        fAllocatedSize -= it.fUsed;
+                        it.fUsed = 0;
+                    }
+                    fLiveZones--;
+                    return;
+                }
+            }
+        }
+
+        /**
+         * Start recording the zones allocated for a new instance.
+         */
+        void beginInstance()
+        {
+            fPending.clear();
+            fTracking = true;
+        }
+
+        /**
+         * Stop recording and associate the recorded zones with the created instance.
+         *
+         * @param instance - the created instance (possibly null if creation failed)
+         */
+        void endInstance(dsp* instance)
+        {
+            if (instance && fPending.size() > 0) {
+                for (const auto& it : fPending) {
+                    fZoneOwners[it.fPtr] = instance;
+                }
+                fInstanceZones[instance].swap(fPending);
+            }
+            fPending.clear();
+            fTracking = false;
+        }
+
+        /**
+         * Return the zones allocated for an instance, in allocation order.
+         *
+         * @param instance - an instance created with createArenaDSPInstance
+         *
+         * @return the zones, or a null pointer if the instance is not known by the arena.
+         */
+        const std::vector<Zone>* getInstanceZones(dsp* instance)
+        {
+            auto it = fInstanceZones.find(instance);
+            return (it != fInstanceZones.end()) ? &it->second : nullptr;
+        }
+
+        /**
+         * Make sure at least 'size' contiguous bytes are available without further allocation.
+         *
+         * @param size - the number of bytes to reserve
+         *
+         * @return true if the room is available.
+         */
+        bool reserve(size_t size)
+        {
+            return selectChunk(align(size, fAlignment));
+        }
+
+        /**
+         * Release all chunks which do not contain any live zone.
+         */
+        void trim()
+        {
+            std::vector<Chunk> chunks;
+            for (auto& it : fChunks) {
+                if (it.fLive == 0) {
+                    deallocateChunk(it);
+                } else {
+                    chunks.push_back(it);
+                }
+            }
+            fChunks.swap(chunks);
+            fCurrent = 0;
+        }
+
+        /* Return the size in bytes of the zones currently allocated (alignment padding included) */
+        size_t getAllocatedSize() { return fAllocatedSize; }
+
+        /* Return the size in bytes of all chunks reserved by the arena */
+        size_t getReservedSize()
+        {
+            size_t size = 0;
+            for (const auto& it : fChunks) size += it.fSize;
+            return size;
+        }
+
+        /* Return the number of zones currently allocated */
+        size_t getNumZones() { return fLiveZones; }
+
+        /* Return the number of chunks reserved by the arena */
+        size_t getNumChunks() { return fChunks.size(); }
+
+        /* Return the size in bytes computed by the last begin/info/end sizing pass */
+        size_t getPlannedSize() { return fPlannedSize; }
+
+        size_t getAlignment() { return fAlignment; }
+
+        bool hasHugePages() { return fHugePages; }
+
+};
+
+/**
+ * Create an instance from a factory, recording its zones if the factory uses an arena_memory_manager.
+ *
+ * @param factory - the DSP factory
+ *
+ * @return the instance on success, otherwise a null pointer.
+ */
+template <typename FACTORY>
+auto createArenaDSPInstance(FACTORY* factory) -> decltype(factory->createDSPInstance())
+{
+    arena_memory_manager* arena = dynamic_cast<arena_memory_manager*>(factory->getMemoryManager());
+    if (arena) arena->beginInstance();
+    auto instance = factory->createDSPInstance();
+    if (arena) arena->endInstance(instance);
+    return instance;
+}
+
+/**
+ * Clone an instance, recording the zones of the clone if the instance is known by the arena
+ * (that is if it has been created with createArenaDSPInstance or cloneArenaDSPInstance).
+ *
+ * @param instance - the instance to be cloned
+ * @param arena - the arena used by the instance factory (possibly null)
+ *
+ * @return the clone on success, otherwise a null pointer.
+ */
+template <typename DSP>
+DSP* cloneArenaDSPInstance(DSP* instance, arena_memory_manager* arena)
+{
+    if (!arena || !arena->getInstanceZones(instance)) return instance->clone();
+    arena->beginInstance();
+    DSP* clone = instance->clone();
+    arena->endInstance(clone);
+    return clone;
+}
+
+#endif
+/************************** END dsp-arena.h **************************/
@@ -40,6 +40,15 @@ architecture section is not modified.
 #include <stdlib.h>
 #include <time.h>
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#endif
+#endif
+
 #include "faust/dsp/dsp.h"
 #include "faust/gui/MapUI.h"
 #include "faust/dsp/dsp-adapter.h"
@@ -59,6 +68,200 @@ void FAUSTBENCH_LOG(VAL_TYPE val)
     }
 }
 
+/*
+    A class to read hardware performance counters of the calling thread (Linux perf_event_open only).
+
+    Each counter is opened as an independent event counting user space only, so that counters not
+    supported by the CPU (or the virtual machine) are just reported as unavailable. Values are scaled
+    with the enabled/running times when the kernel has to multiplex counters.
+
+    FP assists (mostly caused by denormals) are a model specific raw event: FP_ASSIST.ANY (0x1eca) is used
+    by default on Intel x86_64, the FAUSTBENCH_FP_ASSIST environment variable can give another raw event
+    code (in hexadecimal), or 0 to disable it.
+*/
+
+class perf_counters {
+
+    public:
+
+        enum { kCycles = 0, kInstructions, kL1DMisses, kLLCMisses, kBranchMisses, kFPAssists, kNumCounters };
+
+    private:
+
+        int fFds[kNumCounters];
+
+        // Values, enabled and running times at 'start'
+        uint64_t fStart[kNumCounters][3];
+
+        // Accumulated deltas between 'start' and 'stop'
+        uint64_t fTotal[kNumCounters][3];
+
+    #ifdef __linux__
+        static int openEvent(uint32_t type, uint64_t config)
+        {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        static uint64_t cacheMiss(uint64_t cache)
+        {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+
+        static uint64_t getFPAssistEvent()
+        {
+            const char* str = getenv("FAUSTBENCH_FP_ASSIST");
+            if (str) return strtoull(str, nullptr, 16);
+        #if defined(__x86_64__) && defined(__GNUC__)
+            // FP_ASSIST.ANY is only defined on Intel CPUs
+            unsigned int eax, ebx, ecx, edx;
+            if (__get_cpuid(0, &eax, &ebx, &ecx, &edx) && ebx == 0x756e6547 && edx == 0x49656e69 && ecx == 0x6c65746e) {
+                return 0x1eca;
+            }
+            return 0;
+        #else
+            return 0;
+        #endif
+        }
+
+        void readCounters(uint64_t values[kNumCounters][3])
+        {
+            for (int i = 0; i < kNumCounters; i++) {
+                if (fFds[i] < 0 || ::read(fFds[i], values[i], sizeof(values[i])) != sizeof(values[i])) {
+                    values[i][0] = values[i][1] = values[i][2] = 0;
+                }
+            }
+        }
+    #endif
+
+    public:
+
+        perf_counters()
+        {
+            for (int i = 0; i < kNumCounters; i++) fFds[i] = -1;
+            reset();
+        }
+
+        virtual ~perf_counters()
+        {
+            close();
+        }
+
+        /**
+         * Open and enable all available counters.
+         *
+         * @return true if at least one counter could be opened.
+         */
+        bool open()
+        {
+            close();
+        #ifdef __linux__
+            fFds[kCycles] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            fFds[kInstructions] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            fFds[kL1DMisses] = openEvent(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D));
+            fFds[kLLCMisses] = openEvent(PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL));
+            fFds[kBranchMisses] = openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+            uint64_t fp_assist = getFPAssistEvent();
+            fFds[kFPAssists] = (fp_assist != 0) ? openEvent(PERF_TYPE_RAW, fp_assist) : -1;
+            for (int i = 0; i < kNumCounters; i++) {
+                if (fFds[i] >= 0) ioctl(fFds[i], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        #endif
+            reset();
+            return isOpen();
+        }
+
+        void close()
+        {
+            for (int i = 0; i < kNumCounters; i++) {
+            #ifdef __linux__
+                if (fFds[i] >= 0) ::close(fFds[i]);
+            #endif
+                fFds[i] = -1;
+            }
+        }
+
+        bool isOpen()
+        {
+            for (int i = 0; i < kNumCounters; i++) {
+                if (fFds[i] >= 0) return true;
+            }
+            return false;
+        }
+
+        bool hasCounter(int counter) { return fFds[counter] >= 0; }
+
+        /* Clear the accumulated values */
+        void reset() { memset(fTotal, 0, sizeof(fTotal)); }
+
+        /* Start a counting period (to be called just before the measured code) */
+        void start()
+        {
+        #ifdef __linux__
+            readCounters(fStart);
+        #endif
+        }
+
+        /* Stop a counting period and accumulate its values (to be called just after the measured code) */
+        void stop()
+        {
+        #ifdef __linux__
+            uint64_t values[kNumCounters][3];
+            readCounters(values);
+            for (int i = 0; i < kNumCounters; i++) {
+                for (int j = 0; j < 3; j++) fTotal[i][j] += values[i][j] - fStart[i][j];
+            }
+        #endif
+        }
+
+        /**
+         * Return the accumulated value of a counter, scaled if the counter has been multiplexed.
+         *
+         * @return the value, or -1 if the counter is not available.
+         */
+        double getValue(int counter)
+        {
+            if (fFds[counter] < 0 || fTotal[counter][2] == 0) return -1;
+            return double(fTotal[counter][0]) * double(fTotal[counter][1]) / double(fTotal[counter][2]);
+        }
+
+        static const char* getName(int counter)
+        {
+            static const char* names[kNumCounters] = { "cycles", "instructions", "L1D-misses", "LLC-misses", "branch-misses", "FP-assists" };
+            return names[counter];
+        }
+
+};
+
+/*
+ Hardware counters normalized by the number of processed samples (-1 when a counter is not available)
+ */
+
+struct perf_stats {
+    
+    bool fValid;
+    double fPerSample[perf_counters::kNumCounters];         // per frame
+    double fPerChannelSample[perf_counters::kNumCounters];  // per frame divided by the (input + output) channels count:
+                                                            // an average over all channels, not a per channel measure
+    double fIPC;                                            // instructions per cycle
+    
+    perf_stats():fValid(false), fIPC(0)
+    {
+        for (int i = 0; i < perf_counters::kNumCounters; i++) {
+            fPerSample[i] = fPerChannelSample[i] = -1;
+        }
+    }
+    
+};
+
 /*
     A class to do do timing measurements
 */
@@ -85,6 +288,9 @@ class time_bench_real {
         struct timeval fTv1;
         struct timeval fTv2;
     
+        // Optional hardware counters, read around each measure
+        perf_counters* fCounters;
+    
         /**
          * Returns the number of clock cycles elapsed since the last reset of the processor
          */
@@ -182,17 +388,53 @@ class time_bench_real {
             fLastRDTSC = 0;
             fStarts = new uint64_t[fCount];
             fStops = new uint64_t[fCount];
+            fCounters = nullptr;
+            // If the environment variable FAUSTBENCH_PERF is 'on', hardware counters are activated by default
+            const char* perf = getenv("FAUSTBENCH_PERF");
+            if (perf && (strcasecmp(perf, "on") == 0)) setPerfCounters(true);
         }
     
         virtual ~time_bench_real()
         {
             delete [] fStarts;
             delete [] fStops;
+            delete fCounters;
+        }
+    
+        /**
+         * Activate or deactivate hardware counters (Linux only).
+         *
+         * @return true if counters are active.
+         */
+        bool setPerfCounters(bool on)
+        {
+            delete fCounters;
+            fCounters = nullptr;
+            if (on) {
+                fCounters = new perf_counters();
+                if (!fCounters->open()) {
+                    delete fCounters;
+                    fCounters = nullptr;
+                }
+            }
+            return fCounters != nullptr;
         }
     
-        void startMeasure() { fStarts[fMeasure % fCount] = getTicks(); }
+        perf_counters* getPerfCounters() { return fCounters; }
     
-        void stopMeasure() { fStops[fMeasure % fCount] = getTicks(); fMeasure++; }
+        // Counters are read outside of the ticks measure
+        void startMeasure()
+        {
+            if (fCounters) fCounters->start();
+            fStarts[fMeasure % fCount] = getTicks();
+        }
+    
+        void stopMeasure()
+        {
+            fStops[fMeasure % fCount] = getTicks();
+            if (fCounters) fCounters->stop();
+            fMeasure++;
+        }
         
         void openMeasure()
         {
@@ -200,6 +442,7 @@ class time_bench_real {
             gettimeofday(&fTv1, &tz);
             fFirstRDTSC = getTicks();
             fMeasure = 0;
+            if (fCounters) fCounters->reset();
         }
         
         void closeMeasure()
@@ -260,6 +503,63 @@ class time_bench_real {
                     megapersec(bsize, ichans+ochans, meaval100));
         }
     
+        /**
+         * Return the durations (in seconds) of the last fCount measures, sorted in increasing order
+         */
+        std::vector<double> getDurations()
+        {
+            int count = std::min(fMeasure, fCount);
+            std::vector<double> V(count);
+            double cps = rdtscpersec();
+            for (int i = 0; i < count; i++) {
+                V[i] = double(fStops[i] - fStarts[i]) / cps;
+            }
+            sort(V.begin(), V.end());
+            return V;
+        }
+    
+        /**
+         * Return the hardware counters of all measures since 'openMeasure', normalized per sample and per channel sample
+         */
+        perf_stats getPerfStats(int bsize, int ichans, int ochans)
+        {
+            perf_stats stats;
+            if (!fCounters || fMeasure == 0) return stats;
+            double samples = double(fMeasure) * double(bsize);
+            double chans = std::max(1, ichans + ochans);
+            for (int i = 0; i < perf_counters::kNumCounters; i++) {
+                double value = fCounters->getValue(i);
+                if (value < 0) continue;
+                stats.fValid = true;
+                stats.fPerSample[i] = value / samples;
+                stats.fPerChannelSample[i] = value / (samples * chans);
+            }
+            if (stats.fPerSample[perf_counters::kCycles] > 0 && stats.fPerSample[perf_counters::kInstructions] >= 0) {
+                stats.fIPC = stats.fPerSample[perf_counters::kInstructions] / stats.fPerSample[perf_counters::kCycles];
+            }
+            return stats;
+        }
+    
+        /**
+         * Print the hardware counters per sample and per channel sample
+         */
+        void printPerfStats(const char* applname, int bsize, int ichans, int ochans)
+        {
+            perf_stats stats = getPerfStats(bsize, ichans, ochans);
+            if (!stats.fValid) {
+                fprintf(stdout, "%s : hardware counters not available\n", applname);
+                return;
+            }
+            fprintf(stdout, "%s : IPC %f\n", applname, stats.fIPC);
+            for (int i = 0; i < perf_counters::kNumCounters; i++) {
+                if (stats.fPerSample[i] < 0) {
+                    fprintf(stdout, "%-16s n/a\n", perf_counters::getName(i));
+                } else {
+                    fprintf(stdout, "%-16s %f/sample\t%f/channel sample\n", perf_counters::getName(i), stats.fPerSample[i], stats.fPerChannelSample[i]);
+                }
+            }
+        }
+    
         bool isRunning() { return (fMeasure <= (fCount + fSkip)); }
     
         int getCount()
@@ -269,6 +569,36 @@ class time_bench_real {
 
 };
 
+/*
+ A structured summary of a measurement, to be used by programs instead of the printed stats
+ */
+
+struct bench_stats {
+    
+    int fBufferSize;
+    int fCount;             // number of measured compute calls
+    double fSampleRate;     // sample rate used for the CPU load
+    double fMBPerSec;       // throughput of the 50 best blocks (as 'getStats')
+    double fStdDev;         // relative standard deviation of the 50 best blocks (in %)
+    double fMin;            // block duration percentiles (in seconds)
+    double fP25;
+    double fP50;
+    double fP75;
+    double fP90;
+    double fP99;
+    double fMax;
+    double fMean;
+    double fCPULoad;        // mean block duration relative to the block period at fSampleRate
+    double fSamplesPerSec;  // frames computed per second (mean)
+    std::vector<double> fThroughputs;   // MBytes/sec of each measured block, in increasing order
+    perf_stats fPerf;       // hardware counters (when activated)
+    
+    bench_stats():fBufferSize(0), fCount(0), fSampleRate(0), fMBPerSec(0), fStdDev(0),
+    fMin(0), fP25(0), fP50(0), fP75(0), fP90(0), fP99(0), fMax(0), fMean(0), fCPULoad(0), fSamplesPerSec(0)
+    {}
+    
+};
+
 /*
  A class to randomly change control values
  */
@@ -396,7 +726,7 @@ class measure_dsp_real : public decorator_dsp {
             int policy;
             uid_t uid = getuid();
             pw = getpwnam("root");
-            setuid(pw->pw_uid);
+            if (pw) setuid(pw->pw_uid);
             
             int err = pthread_getschedparam(pthread_self(), &policy, &param);
             if (err != 0) {
@@ -475,7 +805,7 @@ class measure_dsp_real : public decorator_dsp {
                 fprintf(stdout, "Duration %f\n",  (duration / 1e6));
                 if (control) fprintf(stdout, "Random control is on\n");
             }
-            fCount = int(1000 * (duration_in_sec * 1e6 / duration));
+            fCount = std::max(1, int(1000 * (duration_in_sec * 1e6 / duration)));
             delete fBench;
             
             // Then allocate final time_bench_real object with proper 'count' parameter
@@ -580,6 +910,23 @@ class measure_dsp_real : public decorator_dsp {
     
         bool isRunning() { return fBench->isRunning(); }
     
+        /**
+         * Activate hardware counters for the following measures (Linux only).
+         *
+         * @return true if counters are active.
+         */
+        bool setPerfCounters(bool on) { return fBench->setPerfCounters(on); }
+    
+        perf_stats getPerfStats()
+        {
+            return fBench->getPerfStats(fBufferSize, fDSP->getNumInputs(), fDSP->getNumOutputs());
+        }
+    
+        void printPerfStats(const char* applname)
+        {
+            fBench->printPerfStats(applname, fBufferSize, fDSP->getNumInputs(), fDSP->getNumOutputs());
+        }
+    
         float getCPULoad()
         {
             return (fBench->measureDurationUsec() / 1000.0 * BENCH_SAMPLE_RATE) / (double(fBench->getCount()) * double(fBufferSize) * 1000.0);
@@ -587,8 +934,74 @@ class measure_dsp_real : public decorator_dsp {
     
         int getCount() { return fCount; }
     
+        /**
+         * Return a structured summary of the last measurement.
+         *
+         * @param sample_rate - the sample rate used to compute the CPU load
+         */
+        bench_stats getBenchStats(double sample_rate = BENCH_SAMPLE_RATE)
+        {
+            bench_stats stats;
+            std::vector<double> V = fBench->getDurations();
+            if (V.size() == 0) return stats;
+            
+            int count = int(V.size());
+            int chans = fDSP->getNumInputs() + fDSP->getNumOutputs();
+            auto percentile = [&](double p) { return V[std::min(count - 1, int(p * (count - 1) + 0.5))]; };
+            
+            stats.fBufferSize = fBufferSize;
+            stats.fCount = count;
+            stats.fSampleRate = sample_rate;
+            stats.fMin = V.front();
+            stats.fP25 = percentile(0.25);
+            stats.fP50 = percentile(0.50);
+            stats.fP75 = percentile(0.75);
+            stats.fP90 = percentile(0.90);
+            stats.fP99 = percentile(0.99);
+            stats.fMax = V.back();
+            double sum = 0;
+            for (const auto& it : V) {
+                sum += it;
+                stats.fThroughputs.push_back((double(fBufferSize) * double(chans) * double(sizeof(REAL))) / (1024. * 1024. * it));
+            }
+            // Durations are sorted in increasing order, throughputs in decreasing order
+            std::reverse(stats.fThroughputs.begin(), stats.fThroughputs.end());
+            stats.fMean = sum / count;
+            stats.fCPULoad = stats.fMean / (double(fBufferSize) / sample_rate);
+            stats.fSamplesPerSec = double(fBufferSize) / stats.fMean;
+            if (count > 50) {
+                std::pair<double, double> res = getStats();
+                stats.fMBPerSec = res.first;
+                stats.fStdDev = res.second;
+            } else {
+                stats.fMBPerSec = stats.fThroughputs.back();
+            }
+            stats.fPerf = getPerfStats();
+            return stats;
+        }
+    
 };
 
+/**
+ * Measure the CPU use of a DSP and return a structured summary.
+ * The measure is done on a clone of the DSP, which is not modified.
+ *
+ * @param DSP - the dsp to be measured
+ * @param buffer_size - the buffer size used when calling 'compute'
+ * @param duration_in_sec - the wanted measure duration
+ * @param control - whether to activate random changes of all control values at each cycle
+ * @param sample_rate - the sample rate used to compute the CPU load
+ * @param perf - whether to read hardware counters (see perf_stats)
+ */
+template <typename REAL>
+bench_stats benchDSP(dsp* DSP, int buffer_size, double duration_in_sec, bool control = true, double sample_rate = BENCH_SAMPLE_RATE, bool perf = false)
+{
+    measure_dsp_real<REAL> mes(DSP->clone(), buffer_size, duration_in_sec, false, control);
+    if (perf) mes.setPerfCounters(true);
+    mes.measure();
+    return mes.getBenchStats(sample_rate);
+}
+
 struct measure_dsp : measure_dsp_real<FAUSTFLOAT> {
 
     measure_dsp(dsp* dsp,
@@ -28,10 +28,16 @@ architecture section is not modified.
 #include <string.h>
 #include <string>
 #include <assert.h>
+#include <stdlib.h>
+#include <math.h>
 #include <sstream>
+#include <algorithm>
+#include <vector>
 
 #include "faust/dsp/dsp.h"
+#include "faust/dsp/dsp-simd.h"
 #include "faust/gui/UI.h"
+#include "faust/gui/meta.h"
 
 /**
  * @file dsp-combiner.h
@@ -44,12 +50,19 @@ architecture section is not modified.
 
 enum Layout { kVerticalGroup, kHorizontalGroup, kTabGroup };
 
+enum CrossfadeCurve { kLinearCurve, kEqualPowerCurve };
+
 /**
  * @class dsp_binary_combiner
  * @brief Base class and common code for binary combiners
  *
  * This class serves as the base class for various DSP combiners that work with two DSP modules.
  * It provides common methods for building user interfaces, allocating and deleting channels, and more.
+ *
+ * Intermediate channels are taken in a scratch pool shared by the whole combiners tree and allocated by its root
+ * (see 'prepare'). A combiner only uses its channels while it is being computed, and its two sub-DSPs are never
+ * computed at the same time: the channels of both sub-DSPs are placed just after its own channels and overlap,
+ * so the pool only holds the deepest path of the tree. Blocks larger than the buffer size are subdivided.
  */
 class dsp_binary_combiner : public dsp {
 
@@ -61,6 +74,10 @@ class dsp_binary_combiner : public dsp {
         Layout fLayout;
         std::string fLabel;
 
+        std::vector<FAUSTFLOAT> fPool;          // only allocated by the root of a combiners tree
+        std::vector<FAUSTFLOAT*> fChunkInputs;
+        std::vector<FAUSTFLOAT*> fChunkOutputs;
+
         void buildUserInterfaceAux(UI* ui_interface)
         {
             switch (fLayout) {
@@ -107,6 +124,46 @@ class dsp_binary_combiner : public dsp {
             delete [] channels;
         }
 
+        // Number of scratch channels used by the combiner itself
+        virtual int getScratchChannels() { return 0; }
+
+        // Set the combiner channels pointers on 'getScratchChannels' channels of fBufferSize frames
+        virtual void setScratchChannels(FAUSTFLOAT* /*scratch*/) {}
+
+        // Compute at most fBufferSize frames (or any number for combiners subdividing blocks themselves)
+        virtual void computeChunk(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) = 0;
+
+        static dsp_binary_combiner* getCombiner(dsp* dsp)
+        {
+            return dynamic_cast<dsp_binary_combiner*>(dsp);
+        }
+
+        int getPoolChannels()
+        {
+            dsp_binary_combiner* combiner1 = getCombiner(fDSP1);
+            dsp_binary_combiner* combiner2 = getCombiner(fDSP2);
+            int channels1 = (combiner1) ? combiner1->getPoolChannels() : 0;
+            int channels2 = (combiner2) ? combiner2->getPoolChannels() : 0;
+            return getScratchChannels() + std::max(channels1, channels2);
+        }
+
+        void setPool(FAUSTFLOAT* pool, int buffer_size)
+        {
+            fBufferSize = buffer_size;
+            fChunkInputs.resize(getNumInputs());
+            fChunkOutputs.resize(getNumOutputs());
+            setScratchChannels(pool);
+            FAUSTFLOAT* children = pool + size_t(getScratchChannels()) * buffer_size;
+            dsp_binary_combiner* combiners[2] = { getCombiner(fDSP1), getCombiner(fDSP2) };
+            for (dsp_binary_combiner* combiner : combiners) {
+                if (combiner) {
+                    // The pool of the sub-tree is replaced by the shared one
+                    std::vector<FAUSTFLOAT>().swap(combiner->fPool);
+                    combiner->setPool(children, buffer_size);
+                }
+            }
+        }
+
      public:
 
         dsp_binary_combiner(dsp* dsp1, dsp* dsp2, int buffer_size, Layout layout, const std::string& label)
@@ -119,6 +176,29 @@ class dsp_binary_combiner : public dsp {
             delete fDSP2;
         }
 
+        // The combined DSPs (still owned by the combiner)
+        dsp* getDSP1() { return fDSP1; }
+        dsp* getDSP2() { return fDSP2; }
+
+        /**
+         * Set the largest block size computed without subdivision, and allocate the scratch pool
+         * of the combiners tree rooted at this combiner (to be called outside of the audio thread,
+         * typically with the buffer size of the audio driver).
+         *
+         * @param buffer_size - the block size in frames
+         */
+        void prepare(int buffer_size)
+        {
+            std::vector<FAUSTFLOAT> pool(size_t(getPoolChannels()) * buffer_size, FAUSTFLOAT(0));
+            setPool(pool.data(), buffer_size);
+            fPool.swap(pool);
+        }
+
+        int getBufferSize() { return fBufferSize; }
+
+        // Size of the scratch pool in frames
+        int getPoolSize() { return getPoolChannels() * fBufferSize; }
+
         virtual int getSampleRate()
         {
             return fDSP1->getSampleRate();
@@ -157,6 +237,25 @@ class dsp_binary_combiner : public dsp {
             fDSP2->metadata(m);
         }
 
+        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            if (count <= fBufferSize) {
+                computeChunk(count, inputs, outputs);
+                return;
+            }
+            for (int frame = 0; frame < count; frame += fBufferSize) {
+                for (size_t chan = 0; chan < fChunkInputs.size(); chan++) {
+                    fChunkInputs[chan] = inputs[chan] + frame;
+                }
+                for (size_t chan = 0; chan < fChunkOutputs.size(); chan++) {
+                    fChunkOutputs[chan] = outputs[chan] + frame;
+                }
+                computeChunk(std::min(fBufferSize, count - frame), fChunkInputs.data(), fChunkOutputs.data());
+            }
+        }
+
+        virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) { compute(count, inputs, outputs); }
+
 };
 
 /**
@@ -172,6 +271,23 @@ class dsp_sequencer : public dsp_binary_combiner {
 
         FAUSTFLOAT** fDSP1Outputs;
 
+    protected:
+
+        virtual int getScratchChannels() { return fDSP1->getNumOutputs(); }
+
+        virtual void setScratchChannels(FAUSTFLOAT* scratch)
+        {
+            for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
+                fDSP1Outputs[chan] = scratch + chan * fBufferSize;
+            }
+        }
+
+        virtual void computeChunk(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            fDSP1->compute(count, inputs, fDSP1Outputs);
+            fDSP2->compute(count, fDSP1Outputs, outputs);
+        }
+
     public:
 
         dsp_sequencer(dsp* dsp1, dsp* dsp2,
@@ -180,12 +296,13 @@ class dsp_sequencer : public dsp_binary_combiner {
                       const std::string& label = "Sequencer")
         :dsp_binary_combiner(dsp1, dsp2, buffer_size, layout, label)
         {
-            fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs());
+            fDSP1Outputs = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
+            prepare(buffer_size);
         }
 
         virtual ~dsp_sequencer()
         {
-            deleteChannels(fDSP1Outputs, fDSP1->getNumOutputs());
+            delete [] fDSP1Outputs;
         }
 
         virtual int getNumInputs() { return fDSP1->getNumInputs(); }
@@ -201,14 +318,6 @@ class dsp_sequencer : public dsp_binary_combiner {
             return new dsp_sequencer(fDSP1->clone(), fDSP2->clone(), fBufferSize, fLayout, fLabel);
         }
 
-        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
-        {
-            fDSP1->compute(count, inputs, fDSP1Outputs);
-            fDSP2->compute(count, fDSP1Outputs, outputs);
-        }
-
-        virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) { compute(count, inputs, outputs); }
-
 };
 
 /**
@@ -225,6 +334,24 @@ class dsp_parallelizer : public dsp_binary_combiner {
         FAUSTFLOAT** fDSP2Inputs;
         FAUSTFLOAT** fDSP2Outputs;
 
+    protected:
+
+        // No scratch channels are used, so blocks are not subdivided
+        virtual void computeChunk(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            fDSP1->compute(count, inputs, outputs);
+
+            // Shift inputs/outputs channels for fDSP2
+            for (int chan = 0; chan < fDSP2->getNumInputs(); chan++) {
+                fDSP2Inputs[chan] = inputs[fDSP1->getNumInputs() + chan];
+            }
+            for (int chan = 0; chan < fDSP2->getNumOutputs(); chan++) {
+                fDSP2Outputs[chan] = outputs[fDSP1->getNumOutputs() + chan];
+            }
+
+            fDSP2->compute(count, fDSP2Inputs, fDSP2Outputs);
+        }
+
     public:
 
         dsp_parallelizer(dsp* dsp1, dsp* dsp2,
@@ -235,6 +362,7 @@ class dsp_parallelizer : public dsp_binary_combiner {
         {
             fDSP2Inputs = new FAUSTFLOAT*[fDSP2->getNumInputs()];
             fDSP2Outputs = new FAUSTFLOAT*[fDSP2->getNumOutputs()];
+            prepare(buffer_size);
         }
 
         virtual ~dsp_parallelizer()
@@ -258,17 +386,7 @@ class dsp_parallelizer : public dsp_binary_combiner {
 
         virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
         {
-            fDSP1->compute(count, inputs, outputs);
-
-            // Shift inputs/outputs channels for fDSP2
-            for (int chan = 0; chan < fDSP2->getNumInputs(); chan++) {
-                fDSP2Inputs[chan] = inputs[fDSP1->getNumInputs() + chan];
-            }
-            for (int chan = 0; chan < fDSP2->getNumOutputs(); chan++) {
-                fDSP2Outputs[chan] = outputs[fDSP1->getNumOutputs() + chan];
-            }
-
-            fDSP2->compute(count, fDSP2Inputs, fDSP2Outputs);
+            computeChunk(count, inputs, outputs);
         }
 
         virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) { compute(count, inputs, outputs); }
@@ -289,6 +407,28 @@ class dsp_splitter : public dsp_binary_combiner {
         FAUSTFLOAT** fDSP1Outputs;
         FAUSTFLOAT** fDSP2Inputs;
 
+    protected:
+
+        virtual int getScratchChannels() { return fDSP1->getNumOutputs(); }
+
+        virtual void setScratchChannels(FAUSTFLOAT* scratch)
+        {
+            for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
+                fDSP1Outputs[chan] = scratch + chan * fBufferSize;
+            }
+        }
+
+        virtual void computeChunk(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            fDSP1->compute(count, inputs, fDSP1Outputs);
+
+            for (int chan = 0; chan < fDSP2->getNumInputs(); chan++) {
+                 fDSP2Inputs[chan] = fDSP1Outputs[chan % fDSP1->getNumOutputs()];
+            }
+
+            fDSP2->compute(count, fDSP2Inputs, outputs);
+        }
+
     public:
 
         dsp_splitter(dsp* dsp1, dsp* dsp2,
@@ -297,13 +437,14 @@ class dsp_splitter : public dsp_binary_combiner {
                      const std::string& label = "Splitter")
         :dsp_binary_combiner(dsp1, dsp2, buffer_size, layout, label)
         {
-            fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs());
+            fDSP1Outputs = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
             fDSP2Inputs = new FAUSTFLOAT*[fDSP2->getNumInputs()];
+            prepare(buffer_size);
         }
 
         virtual ~dsp_splitter()
         {
-            deleteChannels(fDSP1Outputs, fDSP1->getNumOutputs());
+            delete [] fDSP1Outputs;
             delete [] fDSP2Inputs;
         }
 
@@ -319,17 +460,6 @@ class dsp_splitter : public dsp_binary_combiner {
         {
             return new dsp_splitter(fDSP1->clone(), fDSP2->clone(), fBufferSize, fLayout, fLabel);
         }
-
-        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
-        {
-            fDSP1->compute(count, inputs, fDSP1Outputs);
-
-            for (int chan = 0; chan < fDSP2->getNumInputs(); chan++) {
-                 fDSP2Inputs[chan] = fDSP1Outputs[chan % fDSP1->getNumOutputs()];
-            }
-
-            fDSP2->compute(count, fDSP2Inputs, outputs);
-        }
 };
 
 /**
@@ -343,7 +473,6 @@ class dsp_merger : public dsp_binary_combiner {
 
     private:
 
-        FAUSTFLOAT** fDSP1Inputs;
         FAUSTFLOAT** fDSP1Outputs;
         FAUSTFLOAT** fDSP2Inputs;
 
@@ -354,6 +483,35 @@ class dsp_merger : public dsp_binary_combiner {
             }
         }
 
+    protected:
+
+        virtual int getScratchChannels() { return fDSP1->getNumOutputs(); }
+
+        virtual void setScratchChannels(FAUSTFLOAT* scratch)
+        {
+            for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
+                fDSP1Outputs[chan] = scratch + chan * fBufferSize;
+            }
+        }
+
+        virtual void computeChunk(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            fDSP1->compute(count, inputs, fDSP1Outputs);
+
+            memset(fDSP2Inputs, 0, sizeof(FAUSTFLOAT*) * fDSP2->getNumInputs());
+
+            for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
+                int mchan = chan % fDSP2->getNumInputs();
+                if (fDSP2Inputs[mchan]) {
+                    mix(count, fDSP2Inputs[mchan], fDSP1Outputs[chan]);
+                } else {
+                    fDSP2Inputs[mchan] = fDSP1Outputs[chan];
+                }
+            }
+
+            fDSP2->compute(count, fDSP2Inputs, outputs);
+        }
+
     public:
 
         dsp_merger(dsp* dsp1, dsp* dsp2,
@@ -362,15 +520,14 @@ class dsp_merger : public dsp_binary_combiner {
                    const std::string& label = "Merger")
         :dsp_binary_combiner(dsp1, dsp2, buffer_size, layout, label)
         {
-            fDSP1Inputs = allocateChannels(fDSP1->getNumInputs());
-            fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs());
+            fDSP1Outputs = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
             fDSP2Inputs = new FAUSTFLOAT*[fDSP2->getNumInputs()];
+            prepare(buffer_size);
         }
 
         virtual ~dsp_merger()
         {
-            deleteChannels(fDSP1Inputs, fDSP1->getNumInputs());
-            deleteChannels(fDSP1Outputs, fDSP1->getNumOutputs());
+            delete [] fDSP1Outputs;
             delete [] fDSP2Inputs;
         }
 
@@ -386,24 +543,6 @@ class dsp_merger : public dsp_binary_combiner {
         {
             return new dsp_merger(fDSP1->clone(), fDSP2->clone(), fBufferSize, fLayout, fLabel);
         }
-
-        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
-        {
-            fDSP1->compute(count, fDSP1Inputs, fDSP1Outputs);
-
-            memset(fDSP2Inputs, 0, sizeof(FAUSTFLOAT*) * fDSP2->getNumInputs());
-
-            for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
-                int mchan = chan % fDSP2->getNumInputs();
-                if (fDSP2Inputs[mchan]) {
-                    mix(count, fDSP2Inputs[mchan], fDSP1Outputs[chan]);
-                } else {
-                    fDSP2Inputs[mchan] = fDSP1Outputs[chan];
-                }
-            }
-
-            fDSP2->compute(count, fDSP2Inputs, outputs);
-        }
 };
 
 /**
@@ -412,75 +551,158 @@ class dsp_merger : public dsp_binary_combiner {
  *
  * This class recursively combines two DSP modules.
  * The outputs of each module are fed as inputs to the other module in a recursive manner.
+ * The feedback path is delayed by 'delay' frames (1 as with the Faust '~' operator), kept in a ring buffer:
+ * since the feedback used by the first module is only known 'delay' frames in advance, both modules
+ * are computed by chunks of 'delay' frames (and frame by frame when 'delay' is 1).
  */
 class dsp_recursiver : public dsp_binary_combiner {
 
     private:
 
-        FAUSTFLOAT** fDSP1Inputs;
-        FAUSTFLOAT** fDSP1Outputs;
+        int fDelay;
+        int fRingPos;
 
-        FAUSTFLOAT** fDSP2Inputs;
+        FAUSTFLOAT** fDSP1Inputs;   // feedback channels, then pointers on the external inputs
+        FAUSTFLOAT** fDSP1Outputs;  // pointers on the external outputs
+        FAUSTFLOAT** fDSP2Inputs;   // pointers on the external outputs
         FAUSTFLOAT** fDSP2Outputs;
+        FAUSTFLOAT** fRing;         // the last 'fDelay' frames of fDSP2 outputs (kept between blocks, so not in the pool)
+
+        struct DelayMeta : public Meta {
+
+            int fDelay = 1;
+
+            void declare(const char* key, const char* value)
+            {
+                if (strcmp(key, "delay") == 0) {
+                    fDelay = std::max(1, atoi(value));
+                }
+            }
+        };
+
+        static int getDelay(dsp* dsp2, int delay)
+        {
+            if (delay > 0) return delay;
+            DelayMeta meta;
+            dsp2->metadata(&meta);
+            return meta.fDelay;
+        }
+
+    protected:
+
+        virtual int getScratchChannels() { return 2 * fDSP2->getNumOutputs(); }
+
+        virtual void setScratchChannels(FAUSTFLOAT* scratch)
+        {
+            for (int chan = 0; chan < fDSP2->getNumOutputs(); chan++) {
+                fDSP1Inputs[chan] = scratch + chan * fBufferSize;
+                fDSP2Outputs[chan] = scratch + (fDSP2->getNumOutputs() + chan) * fBufferSize;
+            }
+        }
+
+        // Blocks are subdivided here in chunks of at most 'fDelay' and fBufferSize frames
+        virtual void computeChunk(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            int feedbacks = fDSP2->getNumOutputs();
+            for (int frame = 0; frame < count;) {
+                int chunk = std::min(std::min(count - frame, fDelay), fBufferSize);
+                int first = std::min(chunk, fDelay - fRingPos);
+
+                // Feedback from 'fDelay' frames before
+                for (int chan = 0; chan < feedbacks; chan++) {
+                    memcpy(fDSP1Inputs[chan], &fRing[chan][fRingPos], sizeof(FAUSTFLOAT) * first);
+                    memcpy(&fDSP1Inputs[chan][first], fRing[chan], sizeof(FAUSTFLOAT) * (chunk - first));
+                }
+                for (int chan = 0; chan < fDSP1->getNumInputs() - feedbacks; chan++) {
+                    fDSP1Inputs[chan + feedbacks] = inputs[chan] + frame;
+                }
+                for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
+                    fDSP1Outputs[chan] = outputs[chan] + frame;
+                }
+                for (int chan = 0; chan < fDSP2->getNumInputs(); chan++) {
+                    fDSP2Inputs[chan] = outputs[chan] + frame;
+                }
+
+                fDSP1->compute(chunk, fDSP1Inputs, fDSP1Outputs);
+                fDSP2->compute(chunk, fDSP2Inputs, fDSP2Outputs);
+
+                // Becomes the feedback 'fDelay' frames later
+                for (int chan = 0; chan < feedbacks; chan++) {
+                    memcpy(&fRing[chan][fRingPos], fDSP2Outputs[chan], sizeof(FAUSTFLOAT) * first);
+                    memcpy(fRing[chan], &fDSP2Outputs[chan][first], sizeof(FAUSTFLOAT) * (chunk - first));
+                }
+                fRingPos = (fRingPos + chunk) % fDelay;
+                frame += chunk;
+            }
+        }
 
     public:
 
+        /**
+         * Constructor.
+         *
+         * @param dsp1 - the forward DSP
+         * @param dsp2 - the feedback DSP
+         * @param layout - the layout for the user interface
+         * @param label - the label for the combiner
+         * @param delay - the feedback delay in frames, or 0 to use the 'delay' metadata of 'dsp2' (or 1 if missing)
+         */
         dsp_recursiver(dsp* dsp1, dsp* dsp2,
                        Layout layout = Layout::kTabGroup,
-                       const std::string& label = "Recursiver")
-        :dsp_binary_combiner(dsp1, dsp2, 1, layout, label)
+                       const std::string& label = "Recursiver",
+                       int delay = 1)
+        :dsp_binary_combiner(dsp1, dsp2, 4096, layout, label), fDelay(getDelay(dsp2, delay)), fRingPos(0)
         {
-            fDSP1Inputs = allocateChannels(fDSP1->getNumInputs());
-            fDSP1Outputs = allocateChannels(fDSP1->getNumOutputs());
-            fDSP2Inputs = allocateChannels(fDSP2->getNumInputs());
-            fDSP2Outputs = allocateChannels(fDSP2->getNumOutputs());
+            fDSP1Inputs = new FAUSTFLOAT*[fDSP1->getNumInputs()];
+            fDSP1Outputs = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
+            fDSP2Inputs = new FAUSTFLOAT*[fDSP2->getNumInputs()];
+            fDSP2Outputs = new FAUSTFLOAT*[fDSP2->getNumOutputs()];
+            fRing = new FAUSTFLOAT*[fDSP2->getNumOutputs()];
+            for (int chan = 0; chan < fDSP2->getNumOutputs(); chan++) {
+                fRing[chan] = new FAUSTFLOAT[fDelay];
+                memset(fRing[chan], 0, sizeof(FAUSTFLOAT) * fDelay);
+            }
+            prepare(fBufferSize);
         }
 
         virtual ~dsp_recursiver()
         {
-            deleteChannels(fDSP1Inputs, fDSP1->getNumInputs());
-            deleteChannels(fDSP1Outputs, fDSP1->getNumOutputs());
-            deleteChannels(fDSP2Inputs, fDSP2->getNumInputs());
-            deleteChannels(fDSP2Outputs, fDSP2->getNumOutputs());
+            delete [] fDSP1Inputs;
+            delete [] fDSP1Outputs;
+            delete [] fDSP2Inputs;
+            delete [] fDSP2Outputs;
+            deleteChannels(fRing, fDSP2->getNumOutputs());
         }
 
         virtual int getNumInputs() { return fDSP1->getNumInputs() - fDSP2->getNumOutputs(); }
         virtual int getNumOutputs() { return fDSP1->getNumOutputs(); }
 
+        int getDelay() { return fDelay; }
+
         virtual void buildUserInterface(UI* ui_interface)
         {
             buildUserInterfaceAux(ui_interface);
         }
 
+        virtual void instanceClear()
+        {
+            dsp_binary_combiner::instanceClear();
+            for (int chan = 0; chan < fDSP2->getNumOutputs(); chan++) {
+                memset(fRing[chan], 0, sizeof(FAUSTFLOAT) * fDelay);
+            }
+            fRingPos = 0;
+        }
+
         virtual dsp* clone()
         {
-            return new dsp_recursiver(fDSP1->clone(), fDSP2->clone(), fLayout, fLabel);
+            dsp_recursiver* recursiver = new dsp_recursiver(fDSP1->clone(), fDSP2->clone(), fLayout, fLabel, fDelay);
+            recursiver->prepare(fBufferSize);
+            return recursiver;
         }
 
         virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
         {
-            for (int frame = 0; (frame < count); frame++) {
-
-                for (int chan = 0; chan < fDSP2->getNumOutputs(); chan++) {
-                    fDSP1Inputs[chan][0] = fDSP2Outputs[chan][0];
-                }
-
-                for (int chan = 0; chan < fDSP1->getNumInputs() - fDSP2->getNumOutputs(); chan++) {
-                    fDSP1Inputs[chan + fDSP2->getNumOutputs()][0] = inputs[chan][frame];
-                }
-
-                fDSP1->compute(1, fDSP1Inputs, fDSP1Outputs);
-
-                for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
-                    outputs[chan][frame] = fDSP1Outputs[chan][0];
-                }
-
-                for (int chan = 0; chan < fDSP2->getNumInputs(); chan++) {
-                    fDSP2Inputs[chan][0] = fDSP1Outputs[chan][0];
-                }
-
-                fDSP2->compute(1, fDSP2Inputs, fDSP2Outputs);
-            }
+            computeChunk(count, inputs, outputs);
         }
 
         virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) { compute(count, inputs, outputs); }
@@ -494,7 +716,13 @@ class dsp_recursiver : public dsp_binary_combiner {
  * This class allows you to crossfade between two DSP modules.
  * The crossfade parameter (as a slider) controls the mix between the two modules' outputs.
  * When Crossfade = 1, the first DSP only is computed, when Crossfade = 0,
- * the second DSP only is computed, otherwise both DSPs are computed and mixed.
+ * the second DSP only is computed, otherwise both DSPs are computed and mixed,
+ * with linear or equal-power gains.
+ *
+ * A DSP which was not computed since a while resumes from its stale state. With a 'preroll' duration,
+ * a resumed DSP is cleared and computed on the next 'preroll' input frames (outputs being discarded)
+ * before being heard, the DSP heard until then being kept alone meanwhile. The pre-roll is thus
+ * spread over the following blocks, which never cost more than computing both DSPs.
  */
 class dsp_crossfader: public dsp_binary_combiner {
 
@@ -503,27 +731,149 @@ class dsp_crossfader: public dsp_binary_combiner {
         FAUSTFLOAT fCrossfade;
         FAUSTFLOAT** fDSPOutputs1;
         FAUSTFLOAT** fDSPOutputs2;
+
+        CrossfadeCurve fCurve;
+        bool fIdle1;        // fDSP1 was not computed by the previous block
+        bool fIdle2;        // fDSP2 was not computed by the previous block
+
+        int fPreroll;
+        int fWarm1;         // number of frames fDSP1 still has to be computed on before being heard
+        int fWarm2;         // number of frames fDSP2 still has to be computed on before being heard
+
+        template <typename REAL>
+        static void blend(int count, const REAL* in1, REAL gain1, const REAL* in2, REAL gain2, REAL* out)
+        {
+            for (int frame = 0; frame < count; frame++) {
+                out[frame] = in1[frame] * gain1 + in2[frame] * gain2;
+            }
+        }
+
+    #if defined (DSP_SIMD)
+        static void blend(int count, const float* in1, float gain1, const float* in2, float gain2, float* out)
+        {
+            simd_float4 g1 = simd_set1(gain1);
+            simd_float4 g2 = simd_set1(gain2);
+            int frame = 0;
+            for (; frame + 4 <= count; frame += 4) {
+                simd_store(&out[frame], simd_add(simd_mul(simd_load(&in1[frame]), g1), simd_mul(simd_load(&in2[frame]), g2)));
+            }
+            for (; frame < count; frame++) {
+                out[frame] = in1[frame] * gain1 + in2[frame] * gain2;
+            }
+        }
+    #endif
+
+        // Update the state of a DSP for a block, return whether it is wanted by the crossfade value
+        bool update(dsp* DSP, bool wanted, bool& idle, int& warm)
+        {
+            if (!wanted) {
+                warm = 0;
+            } else if (idle && fPreroll > 0) {
+                DSP->instanceClear();
+                warm = fPreroll;
+            }
+            return wanted;
+        }
+
+        // Compute a DSP which is not heard yet, on the block inputs
+        void warmup(dsp* DSP, int& warm, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            DSP->compute(count, inputs, outputs);
+            warm = std::max(0, warm - count);
+        }
+
+    protected:
+
+        virtual int getScratchChannels() { return 2 * fDSP1->getNumOutputs(); }
+
+        virtual void setScratchChannels(FAUSTFLOAT* scratch)
+        {
+            for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
+                fDSPOutputs1[chan] = scratch + chan * fBufferSize;
+                fDSPOutputs2[chan] = scratch + (fDSP1->getNumOutputs() + chan) * fBufferSize;
+            }
+        }
+
+        virtual void computeChunk(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            FAUSTFLOAT crossfade = fCrossfade;
+            bool wanted1 = update(fDSP1, crossfade != FAUSTFLOAT(0), fIdle1, fWarm1);
+            bool wanted2 = update(fDSP2, crossfade != FAUSTFLOAT(1), fIdle2, fWarm2);
+
+            // A DSP is heard once warm, the other one is kept alone while it is not
+            bool active1 = (wanted1 && fWarm1 == 0) || fWarm2 > 0;
+            bool active2 = (wanted2 && fWarm2 == 0) || fWarm1 > 0;
+            fIdle1 = !active1 && fWarm1 == 0;
+            fIdle2 = !active2 && fWarm2 == 0;
+
+            // Warming DSPs read the inputs before they are possibly overwritten by the outputs
+            if (fWarm1 > 0) {
+                warmup(fDSP1, fWarm1, count, inputs, fDSPOutputs1);
+                active1 = false;
+            }
+            if (fWarm2 > 0) {
+                warmup(fDSP2, fWarm2, count, inputs, fDSPOutputs2);
+                active2 = false;
+            }
+
+            if (!active2) {
+                fDSP1->compute(count, inputs, outputs);
+            } else if (!active1) {
+                fDSP2->compute(count, inputs, outputs);
+            } else {
+                // Compute each effect
+                fDSP1->compute(count, inputs, fDSPOutputs1);
+                fDSP2->compute(count, inputs, fDSPOutputs2);
+                // Mix between the two effects
+                FAUSTFLOAT gain1 = crossfade;
+                FAUSTFLOAT gain2 = FAUSTFLOAT(1) - gain1;
+                if (fCurve == kEqualPowerCurve) {
+                    gain1 = FAUSTFLOAT(sin(crossfade * 1.5707963267948966));
+                    gain2 = FAUSTFLOAT(cos(crossfade * 1.5707963267948966));
+                }
+                for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
+                    blend(count, fDSPOutputs1[chan], gain1, fDSPOutputs2[chan], gain2, outputs[chan]);
+                }
+            }
+        }
     
     public:
-    
+
+        /**
+         * Constructor.
+         *
+         * @param dsp1 - the DSP heard when Crossfade = 1
+         * @param dsp2 - the DSP heard when Crossfade = 0
+         * @param layout - the layout for the user interface
+         * @param label - the label for the combiner
+         * @param curve - kLinearCurve or kEqualPowerCurve (sin/cos gains, for uncorrelated signals)
+         * @param preroll - the number of input frames a resumed DSP is computed on (0 to resume it as it is)
+         */
         dsp_crossfader(dsp* dsp1, dsp* dsp2,
                        Layout layout = Layout::kTabGroup,
-                       const std::string& label = "Crossfade")
-        :dsp_binary_combiner(dsp1, dsp2, 4096, layout, label),fCrossfade(FAUSTFLOAT(0.5))
+                       const std::string& label = "Crossfade",
+                       CrossfadeCurve curve = kLinearCurve,
+                       int preroll = 0)
+        :dsp_binary_combiner(dsp1, dsp2, 4096, layout, label),fCrossfade(FAUSTFLOAT(0.5)),
+        fCurve(curve), fIdle1(false), fIdle2(false), fPreroll(std::max(0, preroll)), fWarm1(0), fWarm2(0)
         {
-            fDSPOutputs1 = allocateChannels(fDSP1->getNumOutputs());
-            fDSPOutputs2 = allocateChannels(fDSP1->getNumOutputs());
+            fDSPOutputs1 = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
+            fDSPOutputs2 = new FAUSTFLOAT*[fDSP1->getNumOutputs()];
+            prepare(fBufferSize);
         }
     
         virtual ~dsp_crossfader()
         {
-            deleteChannels(fDSPOutputs1, fDSP1->getNumInputs());
-            deleteChannels(fDSPOutputs2, fDSP1->getNumOutputs());
+            delete [] fDSPOutputs1;
+            delete [] fDSPOutputs2;
         }
     
         virtual int getNumInputs() { return fDSP1->getNumInputs(); }
         virtual int getNumOutputs() { return fDSP1->getNumOutputs(); }
 
+        CrossfadeCurve getCurve() { return fCurve; }
+        int getPreroll() { return fPreroll; }
+
         void buildUserInterface(UI* ui_interface)
         {
             switch (fLayout) {
@@ -557,33 +907,19 @@ class dsp_crossfader: public dsp_binary_combiner {
             }
         }
     
-        virtual dsp* clone()
+        virtual void instanceClear()
         {
-            return new dsp_crossfader(fDSP1->clone(), fDSP2->clone(), fLayout, fLabel);
+            dsp_binary_combiner::instanceClear();
+            fIdle1 = fIdle2 = false;
+            fWarm1 = fWarm2 = 0;
         }
-    
-        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+
+        virtual dsp* clone()
         {
-            if (fCrossfade == FAUSTFLOAT(1)) {
-                fDSP1->compute(count, inputs, outputs);
-            } else if (fCrossfade == FAUSTFLOAT(0)) {
-                fDSP2->compute(count, inputs, outputs);
-            } else {
-                // Compute each effect
-                fDSP1->compute(count, inputs, fDSPOutputs1);
-                fDSP2->compute(count, inputs, fDSPOutputs2);
-                // Mix between the two effects
-                FAUSTFLOAT gain1 = fCrossfade;
-                FAUSTFLOAT gain2 = FAUSTFLOAT(1) - gain1;
-                for (int frame = 0; (frame < count); frame++) {
-                    for (int chan = 0; chan < fDSP1->getNumOutputs(); chan++) {
-                        outputs[chan][frame] = fDSPOutputs1[chan][frame] * gain1 + fDSPOutputs2[chan][frame] * gain2;
-                    }
-                }
-            }
+            dsp_crossfader* crossfader = new dsp_crossfader(fDSP1->clone(), fDSP2->clone(), fLayout, fLabel, fCurve, fPreroll);
+            crossfader->prepare(fBufferSize);
+            return crossfader;
         }
-    
-        virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) { compute(count, inputs, outputs); }
 };
 
 #ifndef __dsp_algebra_api__
@@ -733,12 +1069,16 @@ static dsp* createDSPMerger(dsp* dsp1, dsp* dsp2,
  * @param error A reference to a string to store error messages (if any)
  * @param layout The layout for the user interface (default: kTabGroup)
  * @param label The label for the combiner (default: "Recursiver")
+ * @param delay The feedback delay in frames (default: 1 as with the Faust '~' operator), or 0 to use
+ * the 'delay' metadata of the second DSP. Both DSP are computed by chunks of 'delay' frames, so a
+ * larger delay (when the algorithm allows it) makes the recursion much cheaper.
  * @return A pointer to the created DSP Recursiver, or nullptr if an error occurs
  */
 static dsp* createDSPRecursiver(dsp* dsp1, dsp* dsp2,
                                 std::string& error,
                                 Layout layout = Layout::kTabGroup,
-                                const std::string& label = "Recursiver")
+                                const std::string& label = "Recursiver",
+                                int delay = 1)
 {
     if ((dsp2->getNumInputs() > dsp1->getNumOutputs()) || (dsp2->getNumOutputs() > dsp1->getNumInputs())) {
         std::stringstream error_aux;
@@ -758,7 +1098,7 @@ static dsp* createDSPRecursiver(dsp* dsp1, dsp* dsp2,
         error = error_aux.str();
         return nullptr;
     } else {
-        return new dsp_recursiver(dsp1, dsp2, layout, label);
+        return new dsp_recursiver(dsp1, dsp2, layout, label, delay);
     }
 }
 
@@ -775,12 +1115,16 @@ static dsp* createDSPRecursiver(dsp* dsp1, dsp* dsp2,
  * @param error A reference to a string to store error messages (if any)
  * @param layout The layout for the user interface (default: kTabGroup)
  * @param label The label for the crossfade slider (default: "Crossfade")
+ * @param curve The gains curve, kLinearCurve or kEqualPowerCurve (default: kLinearCurve)
+ * @param preroll The number of input frames a resumed DSP is computed on before being heard (default: 0)
  * @return A pointer to the created DSP Crossfader, or nullptr if an error occurs
  */
 static dsp* createDSPCrossfader(dsp* dsp1, dsp* dsp2,
                                 std::string& error,
                                 Layout layout = Layout::kTabGroup,
-                                const std::string& label = "Crossfade")
+                                const std::string& label = "Crossfade",
+                                CrossfadeCurve curve = kLinearCurve,
+                                int preroll = 0)
 {
     if (dsp1->getNumInputs() != dsp2->getNumInputs()) {
         std::stringstream error_aux;
@@ -797,7 +1141,7 @@ static dsp* createDSPCrossfader(dsp* dsp1, dsp* dsp2,
         error = error_aux.str();
         return nullptr;
     } else {
-        return new dsp_crossfader(dsp1, dsp2, layout, label);
+        return new dsp_crossfader(dsp1, dsp2, layout, label, curve, preroll);
     }
 }
 
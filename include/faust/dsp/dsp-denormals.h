@@ -0,0 +1,190 @@
+/************************** BEGIN dsp-denormals.h *************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __dsp_denormals__
+#define __dsp_denormals__
+
+#include <string.h>
+#include <atomic>
+
+#include "faust/dsp/dsp.h"
+
+//------------------------------------------------------------------------------------------
+// dsp_denormals: a DSP decorator applying its own denormal policy around 'compute'
+// (whatever the global ScopedNoDenormals policy is), with an optional sampling detector
+// counting subnormal output samples.
+//
+// The detector checks one block every 'period' blocks (0 disables it), so that it can be
+// kept in the audio path. Statistics are atomics: they can be read from another thread.
+//------------------------------------------------------------------------------------------
+
+struct denormal_stats {
+
+    int64_t fCheckedBlocks;     // number of blocks checked by the detector
+    int64_t fDenormalBlocks;    // number of checked blocks containing at least one subnormal output
+    int64_t fDenormalSamples;   // total number of subnormal output samples in checked blocks
+    int64_t fMaxPerBlock;       // maximum number of subnormal output samples in a checked block
+    int64_t fLastBlock;         // number of subnormal output samples in the last checked block
+
+    denormal_stats():fCheckedBlocks(0), fDenormalBlocks(0), fDenormalSamples(0), fMaxPerBlock(0), fLastBlock(0)
+    {}
+
+    /* Return the fraction of checked output samples which were subnormal */
+    double getRatio(int buffer_size, int chans) const
+    {
+        double samples = double(fCheckedBlocks) * double(buffer_size) * double(chans);
+        return (samples > 0) ? double(fDenormalSamples) / samples : 0.;
+    }
+
+};
+
+class dsp_denormals : public decorator_dsp {
+
+    private:
+
+        int fPolicy;
+        int fPeriod;
+        int fBlock;
+
+        std::atomic<int64_t> fCheckedBlocks;
+        std::atomic<int64_t> fDenormalBlocks;
+        std::atomic<int64_t> fDenormalSamples;
+        std::atomic<int64_t> fMaxPerBlock;
+        std::atomic<int64_t> fLastBlock;
+
+        static bool isSubnormal(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return ((bits & 0x7f800000) == 0) && ((bits & 0x007fffff) != 0);
+        }
+
+        static bool isSubnormal(double value)
+        {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return ((bits & 0x7ff0000000000000ULL) == 0) && ((bits & 0x000fffffffffffffULL) != 0);
+        }
+
+        void check(int count, FAUSTFLOAT** outputs)
+        {
+            if (fPeriod <= 0 || ++fBlock < fPeriod) return;
+            fBlock = 0;
+            int64_t denormals = 0;
+            for (int chan = 0; chan < fDSP->getNumOutputs(); chan++) {
+                FAUSTFLOAT* output = outputs[chan];
+                for (int frame = 0; frame < count; frame++) {
+                    denormals += isSubnormal(output[frame]);
+                }
+            }
+            fCheckedBlocks.fetch_add(1, std::memory_order_relaxed);
+            fLastBlock.store(denormals, std::memory_order_relaxed);
+            if (denormals > 0) {
+                fDenormalBlocks.fetch_add(1, std::memory_order_relaxed);
+                fDenormalSamples.fetch_add(denormals, std::memory_order_relaxed);
+                if (denormals > fMaxPerBlock.load(std::memory_order_relaxed)) {
+                    fMaxPerBlock.store(denormals, std::memory_order_relaxed);
+                }
+            }
+        }
+
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param dsp - the DSP to be decorated (owned by the decorator)
+         * @param policy - DENORMALS_KEEP, DENORMALS_FTZ or DENORMALS_FTZ_DAZ
+         * @param period - check the outputs of one block every 'period' blocks (0 to disable the detector)
+         */
+        dsp_denormals(dsp* dsp, int policy = DENORMALS_FTZ_DAZ, int period = 0)
+        :decorator_dsp(dsp), fPolicy(policy), fPeriod(period), fBlock(0),
+        fCheckedBlocks(0), fDenormalBlocks(0), fDenormalSamples(0), fMaxPerBlock(0), fLastBlock(0)
+        {}
+
+        virtual ~dsp_denormals() {}
+
+        virtual dsp_denormals* clone() { return new dsp_denormals(fDSP->clone(), fPolicy, fPeriod); }
+
+        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            ScopedNoDenormals ftz_scope(fPolicy);
+            fDSP->compute(count, inputs, outputs);
+            check(count, outputs);
+        }
+
+        virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            ScopedNoDenormals ftz_scope(fPolicy);
+            fDSP->compute(date_usec, count, inputs, outputs);
+            check(count, outputs);
+        }
+
+        // Can be changed while audio is running, the new values are used at the next block
+        void setPolicy(int policy) { fPolicy = policy; }
+        int getPolicy() { return fPolicy; }
+
+        void setPeriod(int period) { fPeriod = period; fBlock = 0; }
+        int getPeriod() { return fPeriod; }
+
+        denormal_stats getStats()
+        {
+            denormal_stats stats;
+            stats.fCheckedBlocks = fCheckedBlocks.load(std::memory_order_relaxed);
+            stats.fDenormalBlocks = fDenormalBlocks.load(std::memory_order_relaxed);
+            stats.fDenormalSamples = fDenormalSamples.load(std::memory_order_relaxed);
+            stats.fMaxPerBlock = fMaxPerBlock.load(std::memory_order_relaxed);
+            stats.fLastBlock = fLastBlock.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        void resetStats()
+        {
+            fCheckedBlocks = 0;
+            fDenormalBlocks = 0;
+            fDenormalSamples = 0;
+            fMaxPerBlock = 0;
+            fLastBlock = 0;
+        }
+
+};
+
+/**
+ * Compute one block with the global denormal policy (see ScopedNoDenormals),
+ * for hosts calling 'compute' directly instead of through an audio driver.
+ *
+ * @param dsp - the DSP instance
+ * @param count - the number of frames to compute
+ * @param inputs - the input audio buffers as an array of non-interleaved FAUSTFLOAT samples (either float, double or quad)
+ * @param outputs - the output audio buffers as an array of non-interleaved FAUSTFLOAT samples (either float, double or quad)
+ */
+template <typename DSP>
+void computeNoDenormals(DSP* dsp, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+{
+    AVOIDDENORMALS;
+    dsp->compute(count, inputs, outputs);
+}
+
+#endif
+/************************** END dsp-denormals.h **************************/
@@ -0,0 +1,362 @@
+/************************** BEGIN dsp-graph.h *****************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+***************************************************************************/
+
+#ifndef __dsp_graph__
+#define __dsp_graph__
+
+#include <string.h>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+
+#include "faust/dsp/dsp.h"
+#include "faust/dsp/dsp-combiner.h"
+
+#if defined (__SSE__)
+#include <xmmintrin.h>
+#endif
+
+/**
+ * @class dsp_graph
+ * @brief Parallel executor for a tree of dsp-combiner combiners
+ *
+ * The tree of sequencers, parallelizers, splitters and mergers is flattened at construction in a DAG
+ * of 'leaf' DSPs (any other DSP, including recursivers and crossfaders) and 'mix' nodes (for mergers),
+ * connected by preallocated buffers. Nodes are then grouped by level (the longest path from the inputs),
+ * so that all nodes of a level are independent.
+ *
+ * Each block, levels are computed in order: the audio thread and the workers take the next node of
+ * the current level from a shared atomic counter until the level is done. Levels with a single node,
+ * and graphs without any parallelism, are computed inline on the audio thread.
+ *
+ * Workers spin for a short time between blocks and then sleep. Inputs and outputs must not alias,
+ * and 'prepare' must not be called on the combiners of the graph after its construction.
+ */
+class dsp_graph : public decorator_dsp {
+
+    private:
+
+        struct Node {
+            dsp* fDSP;                  // nullptr for a 'mix' node (sum of the inputs to the single output)
+            std::vector<int> fInputs;   // wires
+            std::vector<int> fOutputs;  // wires
+            std::vector<FAUSTFLOAT*> fIns;
+            std::vector<FAUSTFLOAT*> fOuts;
+            int fLevel;
+        };
+
+        std::vector<Node> fNodes;
+        std::vector<std::vector<int> > fLevels;     // node indexes by level
+
+        // Wires: external inputs first, then one wire per node output
+        int fNumWires;
+        std::vector<int> fOutputWires;              // wire of each external output
+        std::vector<int> fWireOutput;               // external output written directly by the wire (or -1)
+        std::vector<std::vector<FAUSTFLOAT> > fStorage;
+        std::vector<FAUSTFLOAT*> fWires;            // current pointers (external ones change at each block)
+        int fBufferSize;
+
+        // Workers
+        std::vector<std::thread> fWorkers;
+        std::atomic<uint64_t> fWork;                // (generation << 24) | next node index in the level
+        std::atomic<int> fDone;
+        std::atomic<bool> fRunning;
+        std::atomic<int> fSleeping;
+        std::mutex fMutex;
+        std::condition_variable fWakeUp;
+        uint64_t fGeneration;
+        int fNumThreads;
+        int fCount;                                 // size of the current chunk
+
+        int newWire()
+        {
+            return fNumWires++;
+        }
+
+        std::vector<int> addNode(dsp* DSP, const std::vector<int>& inputs, int outputs)
+        {
+            Node node;
+            node.fDSP = DSP;
+            node.fInputs = inputs;
+            for (int chan = 0; chan < outputs; chan++) {
+                node.fOutputs.push_back(newWire());
+            }
+            node.fIns.resize(node.fInputs.size());
+            node.fOuts.resize(node.fOutputs.size());
+            node.fLevel = 0;
+            fNodes.push_back(node);
+            return node.fOutputs;
+        }
+
+        // Returns the output wires of 'DSP' fed with the 'inputs' wires
+        std::vector<int> flatten(dsp* DSP, const std::vector<int>& inputs)
+        {
+            if (dsp_sequencer* seq = dynamic_cast<dsp_sequencer*>(DSP)) {
+                return flatten(seq->getDSP2(), flatten(seq->getDSP1(), inputs));
+            } else if (dsp_parallelizer* par = dynamic_cast<dsp_parallelizer*>(DSP)) {
+                int split = par->getDSP1()->getNumInputs();
+                std::vector<int> outputs = flatten(par->getDSP1(), std::vector<int>(inputs.begin(), inputs.begin() + split));
+                std::vector<int> outputs2 = flatten(par->getDSP2(), std::vector<int>(inputs.begin() + split, inputs.end()));
+                outputs.insert(outputs.end(), outputs2.begin(), outputs2.end());
+                return outputs;
+            } else if (dsp_splitter* split = dynamic_cast<dsp_splitter*>(DSP)) {
+                std::vector<int> outputs = flatten(split->getDSP1(), inputs);
+                std::vector<int> inputs2;
+                for (int chan = 0; chan < split->getDSP2()->getNumInputs(); chan++) {
+                    inputs2.push_back(outputs[chan % outputs.size()]);
+                }
+                return flatten(split->getDSP2(), inputs2);
+            } else if (dsp_merger* merger = dynamic_cast<dsp_merger*>(DSP)) {
+                std::vector<int> outputs = flatten(merger->getDSP1(), inputs);
+                int num_inputs2 = merger->getDSP2()->getNumInputs();
+                std::vector<int> inputs2;
+                for (int chan = 0; chan < num_inputs2; chan++) {
+                    std::vector<int> mixed;
+                    for (size_t out = chan; out < outputs.size(); out += num_inputs2) {
+                        mixed.push_back(outputs[out]);
+                    }
+                    inputs2.push_back((mixed.size() == 1) ? mixed[0] : addNode(nullptr, mixed, 1)[0]);
+                }
+                return flatten(merger->getDSP2(), inputs2);
+            } else {
+                // Leaves are computed concurrently, so a combiner leaf (like a recursiver) gets its own scratch pool
+                if (dsp_binary_combiner* combiner = dynamic_cast<dsp_binary_combiner*>(DSP)) {
+                    combiner->prepare(fBufferSize);
+                }
+                return addNode(DSP, inputs, DSP->getNumOutputs());
+            }
+        }
+
+        void build()
+        {
+            fNumWires = 0;
+            std::vector<int> inputs;
+            for (int chan = 0; chan < fDSP->getNumInputs(); chan++) {
+                inputs.push_back(newWire());
+            }
+            fOutputWires = flatten(fDSP, inputs);
+
+            // Levels
+            std::vector<int> wire_level(fNumWires, 0);
+            for (auto& node : fNodes) {
+                for (int wire : node.fInputs) {
+                    node.fLevel = std::max(node.fLevel, wire_level[wire] + 1);
+                }
+                node.fLevel = std::max(node.fLevel, 1);
+                for (int wire : node.fOutputs) {
+                    wire_level[wire] = node.fLevel;
+                }
+            }
+            for (size_t i = 0; i < fNodes.size(); i++) {
+                if (int(fLevels.size()) < fNodes[i].fLevel) fLevels.resize(fNodes[i].fLevel);
+                fLevels[fNodes[i].fLevel - 1].push_back(int(i));
+            }
+
+            // Node outputs which are external outputs are directly written in the output buffers
+            fWireOutput.assign(fNumWires, -1);
+            for (size_t out = 0; out < fOutputWires.size(); out++) {
+                int wire = fOutputWires[out];
+                if (wire >= fDSP->getNumInputs() && fWireOutput[wire] < 0) {
+                    fWireOutput[wire] = int(out);
+                }
+            }
+
+            // Preallocated buffers for internal wires
+            fStorage.resize(fNumWires);
+            for (int wire = fDSP->getNumInputs(); wire < fNumWires; wire++) {
+                if (fWireOutput[wire] < 0) {
+                    fStorage[wire].assign(fBufferSize, FAUSTFLOAT(0));
+                }
+            }
+            fWires.resize(fNumWires);
+        }
+
+        void computeNode(int index, int count)
+        {
+            Node& node = fNodes[index];
+            if (node.fDSP) {
+                node.fDSP->compute(count, node.fIns.data(), node.fOuts.data());
+            } else {
+                FAUSTFLOAT* out = node.fOuts[0];
+                memcpy(out, node.fIns[0], sizeof(FAUSTFLOAT) * count);
+                for (size_t in = 1; in < node.fIns.size(); in++) {
+                    FAUSTFLOAT* src = node.fIns[in];
+                    for (int frame = 0; frame < count; frame++) {
+                        out[frame] += src[frame];
+                    }
+                }
+            }
+        }
+
+        // Take and compute nodes of the level published with 'generation', until there are no more
+        void computeLevel(uint64_t generation)
+        {
+            const std::vector<int>& level = fLevels[(generation - 1) % fLevels.size()];
+            uint64_t work = fWork.load(std::memory_order_acquire);
+            while ((work >> 24) == generation && (work & 0xFFFFFF) < level.size()) {
+                if (fWork.compare_exchange_weak(work, work + 1, std::memory_order_acq_rel)) {
+                    computeNode(level[work & 0xFFFFFF], fCount);
+                    fDone.fetch_add(1, std::memory_order_release);
+                    work = fWork.load(std::memory_order_acquire);
+                }
+            }
+        }
+
+        void worker()
+        {
+            AVOIDDENORMALS;
+            uint64_t seen = 0;
+            int idle = 0;
+            while (fRunning.load(std::memory_order_relaxed)) {
+                uint64_t generation = fWork.load(std::memory_order_acquire) >> 24;
+                if (generation != seen) {
+                    seen = generation;
+                    idle = 0;
+                    computeLevel(generation);
+                } else if (++idle < 20000) {
+                #if defined (__SSE__)
+                    _mm_pause();
+                #endif
+                } else {
+                    // Sleep until the next block
+                    std::unique_lock<std::mutex> lock(fMutex);
+                    fSleeping++;
+                    fWakeUp.wait_for(lock, std::chrono::milliseconds(10), [this, seen] {
+                        return !fRunning || (fWork.load(std::memory_order_acquire) >> 24) != seen;
+                    });
+                    fSleeping--;
+                    idle = 0;
+                }
+            }
+        }
+
+        void computeChunk(int count)
+        {
+            fCount = count;
+            for (auto& node : fNodes) {
+                for (size_t in = 0; in < node.fInputs.size(); in++) {
+                    node.fIns[in] = fWires[node.fInputs[in]];
+                }
+                for (size_t out = 0; out < node.fOutputs.size(); out++) {
+                    node.fOuts[out] = fWires[node.fOutputs[out]];
+                }
+            }
+            for (size_t level = 0; level < fLevels.size(); level++) {
+                // Generations follow the levels, so that a worker can find the level of the published work
+                fGeneration = (fGeneration / fLevels.size() + 1) * fLevels.size() + level + 1;
+                if (fWorkers.size() == 0 || fLevels[level].size() == 1) {
+                    for (int node : fLevels[level]) {
+                        computeNode(node, count);
+                    }
+                } else {
+                    fDone.store(0, std::memory_order_relaxed);
+                    fWork.store(fGeneration << 24, std::memory_order_release);
+                    if (fSleeping.load(std::memory_order_relaxed) > 0) {
+                        fWakeUp.notify_all();
+                    }
+                    computeLevel(fGeneration);
+                    while (fDone.load(std::memory_order_acquire) < int(fLevels[level].size())) {
+                    #if defined (__SSE__)
+                        _mm_pause();
+                    #endif
+                    }
+                }
+            }
+        }
+
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param DSP - the root of the combiners tree (owned by the graph)
+         * @param threads - the number of worker threads (-1 to use the number of cores minus one, capped
+         * by the largest level, 0 to compute inline)
+         * @param buffer_size - the size of the preallocated buffers (larger blocks are split)
+         */
+        dsp_graph(dsp* DSP, int threads = -1, int buffer_size = 4096)
+        :decorator_dsp(DSP), fNumWires(0), fBufferSize(buffer_size), fWork(0), fDone(0),
+        fRunning(true), fSleeping(0), fGeneration(0), fNumThreads(threads), fCount(0)
+        {
+            build();
+            size_t width = 0;
+            for (auto& level : fLevels) {
+                width = std::max(width, level.size());
+            }
+            int workers = (threads < 0) ? int(std::thread::hardware_concurrency()) - 1 : threads;
+            workers = std::min(workers, int(width) - 1);
+            for (int i = 0; i < workers; i++) {
+                fWorkers.push_back(std::thread(&dsp_graph::worker, this));
+            }
+        }
+
+        virtual ~dsp_graph()
+        {
+            fRunning = false;
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                fWakeUp.notify_all();
+            }
+            for (auto& worker : fWorkers) {
+                worker.join();
+            }
+        }
+
+        virtual dsp_graph* clone() { return new dsp_graph(fDSP->clone(), fNumThreads, fBufferSize); }
+
+        int getNumNodes() { return int(fNodes.size()); }
+        int getNumLevels() { return int(fLevels.size()); }
+        int getNumThreads() { return int(fWorkers.size()) + 1; }
+
+        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            for (int frame = 0; frame < count; frame += fBufferSize) {
+                int chunk = std::min(fBufferSize, count - frame);
+                for (int chan = 0; chan < fDSP->getNumInputs(); chan++) {
+                    fWires[chan] = inputs[chan] + frame;
+                }
+                for (int wire = fDSP->getNumInputs(); wire < fNumWires; wire++) {
+                    fWires[wire] = (fWireOutput[wire] >= 0) ? outputs[fWireOutput[wire]] + frame : fStorage[wire].data();
+                }
+                computeChunk(chunk);
+                // External inputs and duplicated wires sent to the outputs
+                for (size_t out = 0; out < fOutputWires.size(); out++) {
+                    int wire = fOutputWires[out];
+                    if (fWireOutput[wire] != int(out)) {
+                        memcpy(outputs[out] + frame, fWires[wire], sizeof(FAUSTFLOAT) * chunk);
+                    }
+                }
+            }
+        }
+
+        virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) { compute(count, inputs, outputs); }
+
+};
+
+#endif
+/************************** END dsp-graph.h **************************/
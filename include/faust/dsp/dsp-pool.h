@@ -0,0 +1,172 @@
+/************************** BEGIN dsp-pool.h *****************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __dsp_pool__
+#define __dsp_pool__
+
+#include <vector>
+#include <unordered_map>
+
+#include "faust/dsp/dsp.h"
+#include "faust/dsp/dsp-arena.h"
+
+/**
+ * A pool of prewarmed DSP instances.
+ *
+ * All instances are created and initialized ahead of time, either from a factory
+ * or by cloning a prototype instance. 'acquire' and 'release' never allocate:
+ * released instances are reset with 'instanceClear' and 'instanceResetUserInterface'
+ * instead of being deleted. The pool owns its instances, and deletes them in its destructor.
+ * The free list and the in-use table are reserved to the number of instances (so both operations
+ * are O(1)), and instances not acquired from the pool (or released twice) are rejected,
+ * so that the free list can never contain the same instance twice.
+ *
+ * The pool is not thread safe: acquire/release have to be called from a single thread
+ * (or protected by the caller).
+ */
+class dsp_pool {
+
+    private:
+
+        std::vector<dsp*> fInstances;   // All instances, owned by the pool
+        std::vector<dsp*> fFree;        // Instances available for 'acquire'
+        std::unordered_map<dsp*, bool> fInUse;  // Whether each instance is currently acquired (O(1) lookup)
+        dsp_factory* fFactory;
+        dsp* fPrototype;
+        arena_memory_manager* fArena;   // Used to record the zones of the prototype clones
+        int fSampleRate;
+
+        dsp* createInstance()
+        {
+            dsp* instance = (fFactory) ? createArenaDSPInstance(fFactory) : cloneArenaDSPInstance(fPrototype, fArena);
+            if (instance) {
+                instance->init(fSampleRate);
+            }
+            return instance;
+        }
+
+    public:
+
+        /**
+         * Create a pool from a factory.
+         *
+         * @param factory - the factory used to create instances (to be kept alive while the pool is used)
+         * @param count - the number of instances to pre-create
+         * @param sample_rate - the sample rate used to initialize instances
+         */
+        dsp_pool(dsp_factory* factory, int count, int sample_rate)
+        :fFactory(factory), fPrototype(nullptr), fArena(nullptr), fSampleRate(sample_rate)
+        {
+            reserve(count);
+        }
+
+        /**
+         * Create a pool by cloning a prototype instance.
+         *
+         * @param prototype - the instance to be cloned (not owned by the pool)
+         * @param count - the number of instances to pre-create
+         * @param sample_rate - the sample rate used to initialize instances
+         * @param arena - the arena of the prototype factory if any, so that clones can be snapshotted
+         */
+        dsp_pool(dsp* prototype, int count, int sample_rate, arena_memory_manager* arena = nullptr)
+        :fFactory(nullptr), fPrototype(prototype), fArena(arena), fSampleRate(sample_rate)
+        {
+            reserve(count);
+        }
+
+        virtual ~dsp_pool()
+        {
+            for (auto& it : fInstances) {
+                delete it;
+            }
+        }
+
+        /**
+         * Pre-create instances so that the pool contains at least 'count' of them.
+         * To be called outside of the real-time path.
+         *
+         * @param count - the wanted total number of instances
+         *
+         * @return the total number of instances.
+         */
+        int reserve(int count)
+        {
+            fInstances.reserve(count);
+            fFree.reserve(count);
+            fInUse.reserve(count);
+            while (int(fInstances.size()) < count) {
+                dsp* instance = createInstance();
+                if (!instance) break;
+                fInstances.push_back(instance);
+                fFree.push_back(instance);
+                fInUse[instance] = false;
+            }
+            return int(fInstances.size());
+        }
+
+        /**
+         * Take an initialized instance from the pool.
+         *
+         * @return an instance, or a null pointer if the pool is exhausted.
+         */
+        dsp* acquire()
+        {
+            if (fFree.empty()) return nullptr;
+            dsp* instance = fFree.back();
+            fFree.pop_back();
+            fInUse[instance] = true;
+            return instance;
+        }
+
+        /**
+         * Give back an instance previously returned by 'acquire'.
+         * Its state is cleared and its controls are reset to their default values.
+         *
+         * @param instance - the instance to be released
+         *
+         * @return false (and nothing is done) if the instance is not owned by the pool or not acquired.
+         */
+        bool release(dsp* instance)
+        {
+            auto it = fInUse.find(instance);
+            if (it == fInUse.end() || !it->second) return false;
+            it->second = false;
+            instance->instanceClear();
+            instance->instanceResetUserInterface();
+            fFree.push_back(instance);
+            return true;
+        }
+
+        /* Return the number of instances available for 'acquire' */
+        int getNumFree() { return int(fFree.size()); }
+
+        /* Return the total number of instances owned by the pool */
+        int getNumInstances() { return int(fInstances.size()); }
+
+        int getSampleRate() { return fSampleRate; }
+
+};
+
+#endif
+/************************** END dsp-pool.h **************************/
@@ -0,0 +1,469 @@
+/************************** BEGIN dsp-profiler.h **************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __dsp_profiler__
+#define __dsp_profiler__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <fstream>
+
+#include "faust/dsp/dsp.h"
+
+#ifndef PROFILER_BUFFER_SIZE
+#define PROFILER_BUFFER_SIZE (1 << 14)   // events per thread (a power of two)
+#endif
+#ifndef PROFILER_MAX_TRACE
+#define PROFILER_MAX_TRACE 100000       // events kept for the Chrome trace
+#endif
+
+/**
+ * A profile collector, shared by all profiled_dsp nodes of a DSP graph.
+ *
+ * Each compute thread writes the events of the nodes it computes in its own lock-free
+ * single producer/single consumer ring buffer, so the audio path never locks nor allocates.
+ * Ring buffers are allocated in advance (by the constructor and 'reserve'), and claimed by
+ * the threads at their first profiled compute: the events of threads finding no free buffer
+ * are dropped. 'collect' (called by the export methods from a non real-time thread) drains
+ * the buffers and aggregates the events:
+ *
+ * - as folded stacks ('root;child;grandchild self_time_ns' lines, for flamegraph.pl or speedscope)
+ * - as a Chrome trace JSON ('chrome://tracing' or Perfetto), keeping the last PROFILER_MAX_TRACE events
+ *
+ * Events dropped when a ring buffer is full (if 'collect' is not called often enough) are counted,
+ * and their time is attributed to the enclosing node: the children of a dropped node are
+ * reported as children of its closest recorded ancestor (or as roots).
+ */
+class dsp_profiler {
+
+    private:
+
+        struct Event {
+            int fNode;
+            int fDepth;
+            int64_t fStart;     // in nanoseconds, relative to the profiler creation
+            int64_t fDuration;
+        };
+
+        // Subtree of a completed node, waiting for its parent to complete
+        struct Pending {
+            int64_t fStart;
+            int64_t fDuration;
+            std::vector<std::pair<std::string, int64_t> > fFrames;   // relative path and self time
+        };
+
+        struct ThreadBuffer {
+            std::atomic<uint64_t> fThread;      // id of the thread which claimed the buffer (see getThreadId), 0 if free
+            int fIndex;
+            ThreadBuffer* fNext;
+            int fDepth;                         // current nesting depth, only used by the writer
+            int64_t fLastStart;                 // last start date, only used by the writer
+            std::atomic<uint64_t> fWrite;
+            std::atomic<uint64_t> fRead;
+            std::atomic<uint64_t> fDropped;
+            Event fEvents[PROFILER_BUFFER_SIZE];
+            std::vector<std::vector<Pending> > fPending;    // only used by 'collect', indexed by depth
+
+            ThreadBuffer(int index)
+            :fThread(0), fIndex(index), fNext(nullptr), fDepth(0), fLastStart(-1), fWrite(0), fRead(0), fDropped(0)
+            {}
+        };
+
+        uint64_t fId;   // unique for each profiler, to check the per-thread cache
+        std::atomic<bool> fEnabled;
+        std::atomic<ThreadBuffer*> fBuffers;
+        std::atomic<int> fNumBuffers;
+        std::atomic<uint64_t> fLost;    // events of threads without buffer
+        std::chrono::steady_clock::time_point fOrigin;
+
+        // Node names, registered from non real-time threads
+        std::mutex fMutex;
+        std::vector<std::string> fNodes;
+
+        // Aggregated results, only accessed by 'collect' and export methods (under fMutex)
+        std::map<std::string, int64_t> fFolded;
+        std::vector<std::pair<int, Event> > fTrace;   // (thread index, event)
+        size_t fTraceStart;
+
+        /* Unique and never 0 for each thread, unlike std::thread::id it can be atomically compared */
+        static uint64_t getThreadId()
+        {
+            static std::atomic<uint64_t> counter(0);
+            thread_local uint64_t id = ++counter;
+            return id;
+        }
+
+        /* Return the buffer of the calling thread, or a null pointer if all buffers are claimed by other threads */
+        ThreadBuffer* getThreadBuffer()
+        {
+            // Last (profiler, buffer) used by this thread
+            thread_local uint64_t tl_profiler = 0;
+            thread_local ThreadBuffer* tl_buffer = nullptr;
+            if (tl_profiler == fId) return tl_buffer;
+
+            uint64_t id = getThreadId();
+            ThreadBuffer* buffer = fBuffers.load(std::memory_order_acquire);
+            while (buffer && buffer->fThread.load(std::memory_order_acquire) != id) buffer = buffer->fNext;
+            if (!buffer) {
+                // First event of this thread: claim a free buffer (without allocating)
+                for (buffer = fBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->fNext) {
+                    uint64_t free = 0;
+                    if (buffer->fThread.compare_exchange_strong(free, id, std::memory_order_acq_rel)) break;
+                }
+                // Not cached, so that a buffer added later with 'reserve' can be claimed
+                if (!buffer) return nullptr;
+            }
+            tl_profiler = fId;
+            tl_buffer = buffer;
+            return buffer;
+        }
+
+        void addFolded(const Pending& node)
+        {
+            for (const auto& frame : node.fFrames) fFolded[frame.first] += frame.second;
+        }
+
+        void addPending(ThreadBuffer* buffer, const Event& event)
+        {
+            if (int(buffer->fPending.size()) < event.fDepth + 1) buffer->fPending.resize(event.fDepth + 1);
+
+            // Nodes have completed before their parent, and started after it (start dates are strictly increasing
+            // in a thread, see 'begin'): all pending nodes started after the event are its children, or descendants
+            // of a dropped child. The event gets their frames, prefixed with its name.
+            const std::string& name = fNodes[event.fNode];
+            Pending node;
+            node.fStart = event.fStart;
+            node.fDuration = event.fDuration;
+            int64_t self = event.fDuration;
+            for (size_t depth = event.fDepth + 1; depth < buffer->fPending.size(); depth++) {
+                std::vector<Pending>& pending = buffer->fPending[depth];
+                auto children = std::stable_partition(pending.begin(), pending.end(),
+                                                      [&](const Pending& p) { return p.fStart < event.fStart; });
+                for (auto child = children; child != pending.end(); child++) {
+                    self -= child->fDuration;
+                    for (const auto& frame : child->fFrames) {
+                        node.fFrames.push_back(std::make_pair(name + ";" + frame.first, frame.second));
+                    }
+                }
+                pending.erase(children, pending.end());
+                // Nodes started before a root node have lost all their ancestors: they become roots
+                if (event.fDepth == 0) {
+                    for (const auto& orphan : pending) addFolded(orphan);
+                    pending.clear();
+                }
+            }
+            node.fFrames.push_back(std::make_pair(name, std::max<int64_t>(0, self)));
+
+            if (event.fDepth == 0) {
+                addFolded(node);
+            } else {
+                buffer->fPending[event.fDepth].push_back(node);
+            }
+        }
+
+        static uint64_t getNextId()
+        {
+            static std::atomic<uint64_t> id(0);
+            return ++id;
+        }
+
+        static std::string escape(const std::string& str)
+        {
+            std::string res;
+            for (char c : str) {
+                if (c == '"' || c == '\\') res += '\\';
+                res += c;
+            }
+            return res;
+        }
+
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param enabled - whether profiling is enabled at creation
+         * @param threads - the number of threads computing profiled nodes (see 'reserve')
+         */
+        dsp_profiler(bool enabled = false, int threads = 1)
+        :fId(getNextId()), fEnabled(enabled), fBuffers(nullptr), fNumBuffers(0), fLost(0), fOrigin(std::chrono::steady_clock::now()), fTraceStart(0)
+        {
+            reserve(threads);
+        }
+
+        virtual ~dsp_profiler()
+        {
+            ThreadBuffer* buffer = fBuffers.load();
+            while (buffer) {
+                ThreadBuffer* next = buffer->fNext;
+                delete buffer;
+                buffer = next;
+            }
+        }
+
+        /* Can be called from any thread, profiled nodes only check this flag when disabled */
+        void setEnabled(bool enabled) { fEnabled.store(enabled, std::memory_order_relaxed); }
+
+        bool isEnabled() { return fEnabled.load(std::memory_order_relaxed); }
+
+        /**
+         * Allocate the ring buffers of 'threads' compute threads (not to be called in the real-time thread).
+         * Each thread computing profiled nodes keeps a buffer for the profiler lifetime.
+         *
+         * @param threads - the total number of buffers to be allocated
+         */
+        void reserve(int threads)
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            while (fNumBuffers.load() < threads) {
+                // Lock-free push at the head of the list, read by the compute threads
+                ThreadBuffer* buffer = new ThreadBuffer(fNumBuffers.load());
+                buffer->fNext = fBuffers.load(std::memory_order_relaxed);
+                fBuffers.store(buffer, std::memory_order_release);
+                fNumBuffers++;
+            }
+        }
+
+        int getNumBuffers() { return fNumBuffers.load(); }
+
+        /**
+         * Register a node name (not to be called in the real-time thread).
+         *
+         * @return the node index to be given to 'begin'/'end'.
+         */
+        int registerNode(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fNodes.push_back(name);
+            return int(fNodes.size()) - 1;
+        }
+
+        /* Return the current time in nanoseconds */
+        int64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - fOrigin).count();
+        }
+
+        /* Called before the node compute, return the start date */
+        int64_t begin()
+        {
+            ThreadBuffer* buffer = getThreadBuffer();
+            if (!buffer) return now();
+            buffer->fDepth++;
+            // Strictly increasing, to order nested nodes even with a coarse clock
+            buffer->fLastStart = std::max(now(), buffer->fLastStart + 1);
+            return buffer->fLastStart;
+        }
+
+        /* Called after the node compute */
+        void end(int node, int64_t start)
+        {
+            int64_t stop = std::max(now(), start);
+            ThreadBuffer* buffer = getThreadBuffer();
+            if (!buffer) {
+                fLost.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            buffer->fDepth--;
+            uint64_t write = buffer->fWrite.load(std::memory_order_relaxed);
+            if (write - buffer->fRead.load(std::memory_order_acquire) >= PROFILER_BUFFER_SIZE) {
+                buffer->fDropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            Event& event = buffer->fEvents[write & (PROFILER_BUFFER_SIZE - 1)];
+            event.fNode = node;
+            event.fDepth = buffer->fDepth;
+            event.fStart = start;
+            event.fDuration = stop - start;
+            buffer->fWrite.store(write + 1, std::memory_order_release);
+        }
+
+        /**
+         * Drain all thread buffers and aggregate their events (not to be called in the real-time thread).
+         * Called by the export methods, but should also be called regularly on long runs to avoid dropped events.
+         */
+        void collect()
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            for (ThreadBuffer* buffer = fBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->fNext) {
+                uint64_t read = buffer->fRead.load(std::memory_order_relaxed);
+                uint64_t write = buffer->fWrite.load(std::memory_order_acquire);
+                for (; read < write; read++) {
+                    const Event& event = buffer->fEvents[read & (PROFILER_BUFFER_SIZE - 1)];
+                    addPending(buffer, event);
+                    if (fTrace.size() < PROFILER_MAX_TRACE) {
+                        fTrace.push_back(std::make_pair(buffer->fIndex, event));
+                    } else {
+                        fTrace[fTraceStart] = std::make_pair(buffer->fIndex, event);
+                        fTraceStart = (fTraceStart + 1) % PROFILER_MAX_TRACE;
+                    }
+                }
+                buffer->fRead.store(read, std::memory_order_release);
+            }
+        }
+
+        /* Clear aggregated results (events still in buffers are kept) */
+        void reset()
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fFolded.clear();
+            fTrace.clear();
+            fTraceStart = 0;
+        }
+
+        /* Return the number of events dropped because a thread buffer was full, or a thread had no buffer */
+        uint64_t getDropped()
+        {
+            uint64_t dropped = fLost.load(std::memory_order_relaxed);
+            for (ThreadBuffer* buffer = fBuffers.load(std::memory_order_acquire); buffer; buffer = buffer->fNext) {
+                dropped += buffer->fDropped.load(std::memory_order_relaxed);
+            }
+            return dropped;
+        }
+
+        /**
+         * Return the aggregated self time (in nanoseconds) of each call path.
+         */
+        std::map<std::string, int64_t> getFolded()
+        {
+            collect();
+            std::lock_guard<std::mutex> lock(fMutex);
+            return fFolded;
+        }
+
+        /**
+         * Return the aggregated profile as folded stacks: one 'root;child;grandchild self_time_ns' line per call path.
+         */
+        std::string getFoldedStacks()
+        {
+            std::stringstream res;
+            for (const auto& it : getFolded()) {
+                res << it.first << " " << it.second << "\n";
+            }
+            return res.str();
+        }
+
+        /**
+         * Return the last events in the Chrome trace event format (dates and durations in microseconds).
+         */
+        std::string getChromeTrace()
+        {
+            collect();
+            std::lock_guard<std::mutex> lock(fMutex);
+            std::stringstream res;
+            res.precision(3);
+            res << std::fixed << "{\"traceEvents\":[";
+            for (size_t i = 0; i < fTrace.size(); i++) {
+                const auto& it = fTrace[(fTraceStart + i) % fTrace.size()];
+                res << ((i > 0) ? ",\n" : "\n")
+                    << "{\"name\":\"" << escape(fNodes[it.second.fNode]) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << it.first
+                    << ",\"ts\":" << double(it.second.fStart) / 1e3 << ",\"dur\":" << double(it.second.fDuration) / 1e3 << "}";
+            }
+            res << "\n],\"displayTimeUnit\":\"ns\"}\n";
+            return res.str();
+        }
+
+        bool writeFoldedStacks(const std::string& path)
+        {
+            std::ofstream file(path.c_str());
+            file << getFoldedStacks();
+            return file.good();
+        }
+
+        bool writeChromeTrace(const std::string& path)
+        {
+            std::ofstream file(path.c_str());
+            file << getChromeTrace();
+            return file.good();
+        }
+
+};
+
+/**
+ * A DSP decorator recording the duration of each 'compute' of the decorated node in a dsp_profiler.
+ * Nested profiled nodes (for instance the sub-DSPs of a dsp_sequencer, or the voices of a
+ * polyphonic DSP) are attributed to their enclosing profiled node.
+ * When the profiler is disabled, 'compute' only costs an atomic load.
+ */
+class profiled_dsp : public decorator_dsp {
+
+    private:
+
+        dsp_profiler* fProfiler;
+        std::string fName;
+        int fNode;
+
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param dsp - the DSP to be decorated (owned by the decorator)
+         * @param profiler - the profiler (to be kept alive while the node is used)
+         * @param name - the node name used in the profile
+         */
+        profiled_dsp(dsp* dsp, dsp_profiler* profiler, const std::string& name)
+        :decorator_dsp(dsp), fProfiler(profiler), fName(name), fNode(profiler->registerNode(name))
+        {}
+
+        virtual ~profiled_dsp() {}
+
+        virtual profiled_dsp* clone() { return new profiled_dsp(fDSP->clone(), fProfiler, fName); }
+
+        virtual void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            if (!fProfiler->isEnabled()) {
+                fDSP->compute(count, inputs, outputs);
+                return;
+            }
+            int64_t start = fProfiler->begin();
+            fDSP->compute(count, inputs, outputs);
+            fProfiler->end(fNode, start);
+        }
+
+        virtual void compute(double date_usec, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            if (!fProfiler->isEnabled()) {
+                fDSP->compute(date_usec, count, inputs, outputs);
+                return;
+            }
+            int64_t start = fProfiler->begin();
+            fDSP->compute(date_usec, count, inputs, outputs);
+            fProfiler->end(fNode, start);
+        }
+
+        const std::string& getName() { return fName; }
+
+};
+
+#endif
+/************************** END dsp-profiler.h **************************/
@@ -0,0 +1,126 @@
+/************************** BEGIN dsp-simd.h ******************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __dsp_simd__
+#define __dsp_simd__
+
+//=============================================================================
+// 4 floats vector primitives shared by the SSE/NEON kernels of the architecture
+// files (dsp-tools.h, dsp-adapter.h, dsp-combiner.h). DSP_SIMD is defined when
+// they are available, kernels otherwise keep their scalar version.
+//=============================================================================
+
+#if defined (__SSE__)
+#include <xmmintrin.h>
+#define DSP_SIMD 1
+#define DSP_SIMD_SSE 1
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#define DSP_SIMD 1
+#define DSP_SIMD_NEON 1
+#endif
+
+#if defined (DSP_SIMD_SSE)
+
+typedef __m128 simd_float4;
+
+static inline simd_float4 simd_load(const float* src) { return _mm_loadu_ps(src); }
+static inline void simd_store(float* dst, simd_float4 value) { _mm_storeu_ps(dst, value); }
+static inline simd_float4 simd_set1(float value) { return _mm_set1_ps(value); }
+static inline simd_float4 simd_add(simd_float4 a, simd_float4 b) { return _mm_add_ps(a, b); }
+static inline simd_float4 simd_mul(simd_float4 a, simd_float4 b) { return _mm_mul_ps(a, b); }
+
+static inline void simd_transpose4(simd_float4& r0, simd_float4& r1, simd_float4& r2, simd_float4& r3)
+{
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+// [l0 r0 l1 r1] [l2 r2 l3 r3] ==> [l0 l1 l2 l3] [r0 r1 r2 r3]
+static inline void simd_deinterleave2(simd_float4& a, simd_float4& b)
+{
+    simd_float4 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    simd_float4 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    a = left;
+    b = right;
+}
+
+// [l0 l1 l2 l3] [r0 r1 r2 r3] ==> [l0 r0 l1 r1] [l2 r2 l3 r3]
+static inline void simd_interleave2(simd_float4& left, simd_float4& right)
+{
+    simd_float4 a = _mm_unpacklo_ps(left, right);
+    simd_float4 b = _mm_unpackhi_ps(left, right);
+    left = a;
+    right = b;
+}
+
+#elif defined (DSP_SIMD_NEON)
+
+typedef float32x4_t simd_float4;
+
+static inline simd_float4 simd_load(const float* src) { return vld1q_f32(src); }
+static inline void simd_store(float* dst, simd_float4 value) { vst1q_f32(dst, value); }
+static inline simd_float4 simd_set1(float value) { return vdupq_n_f32(value); }
+static inline simd_float4 simd_add(simd_float4 a, simd_float4 b) { return vaddq_f32(a, b); }
+static inline simd_float4 simd_mul(simd_float4 a, simd_float4 b) { return vmulq_f32(a, b); }
+
+static inline void simd_transpose4(simd_float4& r0, simd_float4& r1, simd_float4& r2, simd_float4& r3)
+{
+    float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+static inline void simd_deinterleave2(simd_float4& a, simd_float4& b)
+{
+    float32x4x2_t res = vuzpq_f32(a, b);
+    a = res.val[0];
+    b = res.val[1];
+}
+
+static inline void simd_interleave2(simd_float4& left, simd_float4& right)
+{
+    float32x4x2_t res = vzipq_f32(left, right);
+    left = res.val[0];
+    right = res.val[1];
+}
+
+#endif
+
+#if defined (DSP_SIMD)
+
+// Sum of the 4 lanes, as (v0 + v1) + (v2 + v3)
+static inline float simd_sum(simd_float4 value)
+{
+    float res[4];
+    simd_store(res, value);
+    return (res[0] + res[1]) + (res[2] + res[3]);
+}
+
+#endif
+
+#endif
+/************************** END dsp-simd.h **************************/
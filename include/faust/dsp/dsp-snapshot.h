@@ -0,0 +1,470 @@
+/************************** BEGIN dsp-snapshot.h *************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __dsp_snapshot__
+#define __dsp_snapshot__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "faust/dsp/dsp.h"
+#include "faust/dsp/dsp-arena.h"
+#include "faust/gui/DecoratorUI.h"
+
+#define SNAPSHOT_MAGIC "FAUSTSNP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_SKIPPED UINT64_MAX
+
+/**
+ * A binary snapshot of the complete state of a DSP instance: delay lines, recursive
+ * state, tables and control values.
+ *
+ * The instance has to be created with createArenaDSPInstance or cloneArenaDSPInstance (or by a dsp_pool)
+ * from a factory using an arena_memory_manager, so that all its memory zones are known. Data zones are copied
+ * verbatim, while zones holding pointers (the instance objects themselves, soundfile slots)
+ * are detected and skipped, so that a snapshot can be restored in any instance of the same
+ * factory, possibly in another process (the snapshot then has to be saved to a file).
+ *
+ * Layout: a header, one (size, offset) descriptor per zone, the control values, then the zones data.
+ * Snapshots loaded with 'fromFile' are memory-mapped: restoring them does not copy the file
+ * in an intermediate buffer.
+ */
+class dsp_snapshot {
+
+    private:
+
+        struct Header {
+            char fMagic[8];
+            uint32_t fVersion;
+            uint32_t fNumZones;
+            uint32_t fNumControls;
+            int32_t fSampleRate;
+            uint64_t fDataSize;
+        };
+
+        struct ZoneDesc {
+            uint64_t fSize;
+            uint64_t fOffset;   // In the data section, or SNAPSHOT_SKIPPED
+        };
+
+        // Collect controls and soundfile slots of an instance
+        struct ZonesUI : public GenericUI {
+
+            std::vector<FAUSTFLOAT*> fControls;
+            std::vector<Soundfile**> fSoundfiles;
+
+            void addButton(const char* label, FAUSTFLOAT* zone) { fControls.push_back(zone); }
+            void addCheckButton(const char* label, FAUSTFLOAT* zone) { fControls.push_back(zone); }
+            void addVerticalSlider(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT min, FAUSTFLOAT max, FAUSTFLOAT step)
+            {
+                fControls.push_back(zone);
+            }
+            void addHorizontalSlider(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT min, FAUSTFLOAT max, FAUSTFLOAT step)
+            {
+                fControls.push_back(zone);
+            }
+            void addNumEntry(const char* label, FAUSTFLOAT* zone, FAUSTFLOAT init, FAUSTFLOAT min, FAUSTFLOAT max, FAUSTFLOAT step)
+            {
+                fControls.push_back(zone);
+            }
+            void addSoundfile(const char* label, const char* soundpath, Soundfile** sf_zone) { fSoundfiles.push_back(sf_zone); }
+
+        };
+
+        std::vector<char> fBuffer;  // Owned storage (captured or copied snapshots)
+        const char* fData;          // Start of the snapshot (in fBuffer or in the mapped file)
+        size_t fSize;
+        void* fMapped;
+        size_t fMappedSize;
+
+        dsp_snapshot():fData(nullptr), fSize(0), fMapped(nullptr), fMappedSize(0)
+        {}
+
+        const Header* getHeader() const { return reinterpret_cast<const Header*>(fData); }
+
+        const ZoneDesc* getZoneDescs() const
+        {
+            return reinterpret_cast<const ZoneDesc*>(fData + sizeof(Header));
+        }
+
+        const double* getControls() const
+        {
+            return reinterpret_cast<const double*>(fData + sizeof(Header) + getHeader()->fNumZones * sizeof(ZoneDesc));
+        }
+
+        const char* getZonesData() const
+        {
+            return reinterpret_cast<const char*>(getControls() + getHeader()->fNumControls);
+        }
+
+        // Check that the snapshot is consistent before using it
+        bool check(std::string& error)
+        {
+            const Header* header = getHeader();
+            if (fSize < sizeof(Header) || strncmp(header->fMagic, SNAPSHOT_MAGIC, 8) != 0) {
+                error = "ERROR : not a DSP snapshot";
+                return false;
+            }
+            if (header->fVersion != SNAPSHOT_VERSION) {
+                error = "ERROR : unsupported DSP snapshot version " + std::to_string(header->fVersion);
+                return false;
+            }
+            uint64_t size = uint64_t(sizeof(Header))
+                + uint64_t(header->fNumZones) * sizeof(ZoneDesc)
+                + uint64_t(header->fNumControls) * sizeof(double);
+            if (size > fSize || header->fDataSize != fSize - size) {
+                error = "ERROR : truncated DSP snapshot";
+                return false;
+            }
+            const ZoneDesc* zones = getZoneDescs();
+            for (uint32_t i = 0; i < header->fNumZones; i++) {
+                if (zones[i].fOffset != SNAPSHOT_SKIPPED
+                    && (zones[i].fOffset > header->fDataSize || zones[i].fSize > header->fDataSize - zones[i].fOffset)) {
+                    error = "ERROR : corrupted DSP snapshot";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Address ranges of an instance (the instance object and all its zones), sorted for binary search
+        struct Ranges {
+
+            std::vector<std::pair<uintptr_t, uintptr_t> > fRanges;
+
+            Ranges(const std::vector<arena_memory_manager::Zone>& zones, dsp* instance)
+            {
+                uintptr_t base = reinterpret_cast<uintptr_t>(instance);
+                fRanges.push_back(std::make_pair(base, base + sizeof(dsp)));
+                for (const auto& it : zones) {
+                    uintptr_t ptr = reinterpret_cast<uintptr_t>(it.fPtr);
+                    fRanges.push_back(std::make_pair(ptr, ptr + std::max<size_t>(it.fSize, 1)));
+                }
+                std::sort(fRanges.begin(), fRanges.end());
+            }
+
+            bool contains(uintptr_t value) const
+            {
+                auto it = std::upper_bound(fRanges.begin(), fRanges.end(), std::make_pair(value, UINTPTR_MAX));
+                return it != fRanges.begin() && value < (--it)->second;
+            }
+
+        };
+
+        /*
+         A zone holding pointers (the instance objects, whose words point to the instance or its zones)
+         or soundfile slots cannot be copied in another instance. Each pointer-aligned word is looked up
+         in the sorted instance ranges, so the scan is O(words * log(zones)). Data zones would only be
+         mistaken for object zones if they contain a bit pattern equal to one of these addresses
+         (a subnormal double, or an int pair): 'restore' checks that both instances agree on each zone.
+         */
+        static bool isObjectZone(const arena_memory_manager::Zone& zone,
+                                 const Ranges& ranges,
+                                 dsp* instance,
+                                 const std::vector<Soundfile**>& soundfiles)
+        {
+            if (zone.fPtr == reinterpret_cast<char*>(instance)) return true;
+            for (const auto& it : soundfiles) {
+                char* slot = reinterpret_cast<char*>(it);
+                if (slot >= zone.fPtr && slot < zone.fPtr + zone.fSize) return true;
+            }
+            size_t words = zone.fSize / sizeof(void*);
+            const uintptr_t* ptr = reinterpret_cast<const uintptr_t*>(zone.fPtr);
+            for (size_t w = 0; w < words; w++) {
+                if (ranges.contains(ptr[w])) return true;
+            }
+            return false;
+        }
+
+        static const std::vector<arena_memory_manager::Zone>* getZones(dsp* instance,
+                                                                      arena_memory_manager* arena,
+                                                                      std::string& error)
+        {
+            const std::vector<arena_memory_manager::Zone>* zones = arena->getInstanceZones(instance);
+            if (!zones) {
+                error = "ERROR : instance has not been created with createArenaDSPInstance or cloneArenaDSPInstance on this arena";
+            }
+            return zones;
+        }
+
+    public:
+
+        virtual ~dsp_snapshot()
+        {
+        #ifndef _WIN32
+            if (fMapped) munmap(fMapped, fMappedSize);
+        #endif
+        }
+
+        /**
+         * Capture the state of an instance.
+         *
+         * @param instance - the instance, created with createArenaDSPInstance or cloneArenaDSPInstance
+         * @param arena - the arena used by the instance factory
+         * @param error - the error string to be filled
+         *
+         * @return a new snapshot on success (to be deleted by the caller), otherwise a null pointer.
+         */
+        static dsp_snapshot* capture(dsp* instance, arena_memory_manager* arena, std::string& error)
+        {
+            const std::vector<arena_memory_manager::Zone>* zones = getZones(instance, arena, error);
+            if (!zones) return nullptr;
+
+            ZonesUI ui;
+            instance->buildUserInterface(&ui);
+            Ranges ranges(*zones, instance);
+
+            std::vector<ZoneDesc> descs(zones->size());
+            uint64_t data_size = 0;
+            for (size_t i = 0; i < zones->size(); i++) {
+                const arena_memory_manager::Zone& zone = (*zones)[i];
+                descs[i].fSize = zone.fSize;
+                if (isObjectZone(zone, ranges, instance, ui.fSoundfiles)) {
+                    descs[i].fOffset = SNAPSHOT_SKIPPED;
+                } else {
+                    descs[i].fOffset = data_size;
+                    data_size += zone.fSize;
+                }
+            }
+
+            dsp_snapshot* snapshot = new dsp_snapshot();
+            size_t head_size = sizeof(Header) + descs.size() * sizeof(ZoneDesc) + ui.fControls.size() * sizeof(double);
+            snapshot->fBuffer.resize(head_size + data_size);
+            char* data = snapshot->fBuffer.data();
+
+            Header* header = reinterpret_cast<Header*>(data);
+            memcpy(header->fMagic, SNAPSHOT_MAGIC, 8);
+            header->fVersion = SNAPSHOT_VERSION;
+            header->fNumZones = uint32_t(descs.size());
+            header->fNumControls = uint32_t(ui.fControls.size());
+            header->fSampleRate = instance->getSampleRate();
+            header->fDataSize = data_size;
+            memcpy(data + sizeof(Header), descs.data(), descs.size() * sizeof(ZoneDesc));
+
+            double* controls = reinterpret_cast<double*>(data + sizeof(Header) + descs.size() * sizeof(ZoneDesc));
+            for (size_t i = 0; i < ui.fControls.size(); i++) {
+                controls[i] = double(*ui.fControls[i]);
+            }
+
+            char* zones_data = data + head_size;
+            for (size_t i = 0; i < zones->size(); i++) {
+                if (descs[i].fOffset != SNAPSHOT_SKIPPED) {
+                    memcpy(zones_data + descs[i].fOffset, (*zones)[i].fPtr, (*zones)[i].fSize);
+                }
+            }
+
+            snapshot->fData = data;
+            snapshot->fSize = snapshot->fBuffer.size();
+            return snapshot;
+        }
+
+        /**
+         * Create a snapshot from a memory buffer (previously obtained with getData/getSize).
+         *
+         * @param buffer - the snapshot content (copied)
+         * @param size - the buffer size in bytes
+         * @param error - the error string to be filled
+         *
+         * @return a new snapshot on success (to be deleted by the caller), otherwise a null pointer.
+         */
+        static dsp_snapshot* fromBuffer(const void* buffer, size_t size, std::string& error)
+        {
+            dsp_snapshot* snapshot = new dsp_snapshot();
+            // The vector storage comes from operator new, so it is aligned for doubles and 64 bits descriptors
+            const char* data = static_cast<const char*>(buffer);
+            snapshot->fBuffer.assign(data, data + size);
+            snapshot->fData = snapshot->fBuffer.data();
+            snapshot->fSize = size;
+            if (!snapshot->check(error)) {
+                delete snapshot;
+                return nullptr;
+            }
+            return snapshot;
+        }
+
+        /**
+         * Load a snapshot from a file. The file is memory-mapped when possible.
+         *
+         * @param path - the snapshot file path
+         * @param error - the error string to be filled
+         *
+         * @return a new snapshot on success (to be deleted by the caller), otherwise a null pointer.
+         */
+        static dsp_snapshot* fromFile(const std::string& path, std::string& error)
+        {
+        #ifndef _WIN32
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                error = "ERROR : cannot open snapshot file " + path;
+                return nullptr;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                close(fd);
+                error = "ERROR : cannot read snapshot file " + path;
+                return nullptr;
+            }
+            void* ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (ptr == MAP_FAILED) {
+                error = "ERROR : cannot map snapshot file " + path;
+                return nullptr;
+            }
+            dsp_snapshot* snapshot = new dsp_snapshot();
+            snapshot->fMapped = ptr;
+            snapshot->fMappedSize = size_t(st.st_size);
+            snapshot->fData = static_cast<const char*>(ptr);
+            snapshot->fSize = size_t(st.st_size);
+            if (!snapshot->check(error)) {
+                delete snapshot;
+                return nullptr;
+            }
+            return snapshot;
+        #else
+            FILE* file = fopen(path.c_str(), "rb");
+            if (!file) {
+                error = "ERROR : cannot open snapshot file " + path;
+                return nullptr;
+            }
+            std::vector<char> content;
+            char buffer[4096];
+            size_t read;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                content.insert(content.end(), buffer, buffer + read);
+            }
+            fclose(file);
+            return fromBuffer(content.data(), content.size(), error);
+        #endif
+        }
+
+        /**
+         * Restore the state of an instance. The instance has to come from the same
+         * factory (or from a factory compiled from the same code with the same options).
+         * Not real-time safe: to be called outside of 'compute'.
+         *
+         * @param instance - the instance, created with createArenaDSPInstance or cloneArenaDSPInstance
+         * @param arena - the arena used by the instance factory
+         * @param error - the error string to be filled
+         *
+         * @return true on success, otherwise false (and the instance is not modified).
+         */
+        bool restore(dsp* instance, arena_memory_manager* arena, std::string& error) const
+        {
+            const std::vector<arena_memory_manager::Zone>* zones = getZones(instance, arena, error);
+            if (!zones) return false;
+
+            const Header* header = getHeader();
+            const ZoneDesc* descs = getZoneDescs();
+            if (zones->size() != header->fNumZones) {
+                error = "ERROR : snapshot does not match the instance memory layout";
+                return false;
+            }
+            for (size_t i = 0; i < zones->size(); i++) {
+                if ((*zones)[i].fSize != descs[i].fSize) {
+                    error = "ERROR : snapshot does not match the instance memory layout";
+                    return false;
+                }
+            }
+            ZonesUI ui;
+            instance->buildUserInterface(&ui);
+            if (ui.fControls.size() != header->fNumControls) {
+                error = "ERROR : snapshot does not match the instance controls";
+                return false;
+            }
+            // Never overwrite the objects of the instance
+            Ranges ranges(*zones, instance);
+            for (size_t i = 0; i < zones->size(); i++) {
+                if (isObjectZone((*zones)[i], ranges, instance, ui.fSoundfiles) != (descs[i].fOffset == SNAPSHOT_SKIPPED)) {
+                    error = "ERROR : snapshot does not match the instance memory layout";
+                    return false;
+                }
+            }
+
+            const char* zones_data = getZonesData();
+            for (size_t i = 0; i < zones->size(); i++) {
+                if (descs[i].fOffset != SNAPSHOT_SKIPPED) {
+                    memcpy((*zones)[i].fPtr, zones_data + descs[i].fOffset, descs[i].fSize);
+                }
+            }
+            const double* controls = getControls();
+            for (size_t i = 0; i < ui.fControls.size(); i++) {
+                *ui.fControls[i] = FAUSTFLOAT(controls[i]);
+            }
+            return true;
+        }
+
+        /**
+         * Save the snapshot in a file.
+         *
+         * @param path - the snapshot file path
+         * @param error - the error string to be filled
+         *
+         * @return true on success, otherwise false.
+         */
+        bool save(const std::string& path, std::string& error) const
+        {
+            FILE* file = fopen(path.c_str(), "wb");
+            if (!file) {
+                error = "ERROR : cannot create snapshot file " + path;
+                return false;
+            }
+            bool res = fwrite(fData, 1, fSize, file) == fSize;
+            res = (fclose(file) == 0) && res;
+            if (!res) error = "ERROR : cannot write snapshot file " + path;
+            return res;
+        }
+
+        /* Return the snapshot content, to be stored or given to 'fromBuffer' */
+        const char* getData() const { return fData; }
+
+        size_t getSize() const { return fSize; }
+
+        /* Return the sample rate of the captured instance */
+        int getSampleRate() const { return getHeader()->fSampleRate; }
+
+        int getNumZones() const { return int(getHeader()->fNumZones); }
+
+        int getNumControls() const { return int(getHeader()->fNumControls); }
+
+        /* Return the size in bytes of the copied state */
+        size_t getStateSize() const { return size_t(getHeader()->fDataSize); }
+
+        /* Whether the snapshot content is memory-mapped from a file */
+        bool isMapped() const { return fMapped != nullptr; }
+
+};
+
+#endif
+/************************** END dsp-snapshot.h **************************/
@@ -27,12 +27,329 @@ architecture section is not modified.
 
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include "faust/dsp/dsp-simd.h"
 
 #ifndef FAUSTFLOAT
 #define FAUSTFLOAT float
 #endif
 
-class Deinterleaver
+// Number of frames (de)interleaved at once: the interleaved block stays in cache while each channel is read or written
+#define DSP_TOOLS_BLOCK 64
+
+//=============================================================================
+// Sample format conversions between device buffers (float, int16, packed int24
+// or int32 samples, interleaved or not) and the non-interleaved FAUSTFLOAT
+// buffers of a Faust dsp. Conversion and (de)interleaving are fused in a single
+// pass over blocks of DSP_TOOLS_BLOCK frames. Float samples use SSE/NEON 4x4
+// transposes when FAUSTFLOAT is float.
+//=============================================================================
+
+// 24 bits signed integer packed in 3 little-endian bytes (as in RtAudio, ALSA S24_3LE...)
+struct int24_packed {
+    uint8_t fBytes[3];
+};
+
+template <typename SAMPLE>
+struct sample_format {
+    static FAUSTFLOAT read(SAMPLE sample) { return FAUSTFLOAT(sample); }
+    static void write(SAMPLE& sample, FAUSTFLOAT value) { sample = SAMPLE(value); }
+};
+
+template <>
+struct sample_format<float> {
+    static FAUSTFLOAT read(float sample) { return FAUSTFLOAT(sample); }
+    static void write(float& sample, FAUSTFLOAT value) { sample = float(value); }
+};
+
+template <>
+struct sample_format<double> {
+    static FAUSTFLOAT read(double sample) { return FAUSTFLOAT(sample); }
+    static void write(double& sample, FAUSTFLOAT value) { sample = double(value); }
+};
+
+// Integer samples are scaled by 2^(bits-1) both ways (and clipped when written), so that they are
+// read and written back unchanged (up to the FAUSTFLOAT precision for int32 samples)
+
+template <>
+struct sample_format<int16_t> {
+    static FAUSTFLOAT read(int16_t sample) { return FAUSTFLOAT(float(sample) * (1.f/32768.f)); }
+    static void write(int16_t& sample, FAUSTFLOAT value)
+    {
+        sample = int16_t(std::max(std::min(float(value) * 32768.f, 32767.f), -32768.f));
+    }
+};
+
+template <>
+struct sample_format<int24_packed> {
+    static FAUSTFLOAT read(const int24_packed& sample)
+    {
+        uint32_t bits = uint32_t(sample.fBytes[0]) | (uint32_t(sample.fBytes[1]) << 8) | (uint32_t(sample.fBytes[2]) << 16);
+        // sign extension of the 24 bits value (without shifting a negative value)
+        int32_t value = int32_t(bits ^ 0x800000) - 0x800000;
+        return FAUSTFLOAT(float(value) * (1.f/8388608.f));
+    }
+    static void write(int24_packed& sample, FAUSTFLOAT value)
+    {
+        int32_t res = int32_t(std::max(std::min(float(value) * 8388608.f, 8388607.f), -8388608.f));
+        uint32_t bits = uint32_t(res);
+        sample.fBytes[0] = uint8_t(bits);
+        sample.fBytes[1] = uint8_t(bits >> 8);
+        sample.fBytes[2] = uint8_t(bits >> 16);
+    }
+};
+
+template <>
+struct sample_format<int32_t> {
+    static FAUSTFLOAT read(int32_t sample) { return FAUSTFLOAT(double(sample) * (1./2147483648.)); }
+    static void write(int32_t& sample, FAUSTFLOAT value)
+    {
+        // computed in double since 2147483647 is not representable as a float
+        sample = int32_t(std::max(std::min(double(value) * 2147483648., 2147483647.), -2147483648.));
+    }
+};
+
+/**
+ * Deinterleave (and convert) the first 'chans' channels of an interleaved buffer.
+ *
+ * @param input - the interleaved buffer
+ * @param stride - the number of channels of the interleaved buffer
+ * @param outputs - the non-interleaved buffers
+ * @param chans - the number of channels to deinterleave (<= stride)
+ * @param frames - the number of frames
+ */
+template <typename SAMPLE>
+void deinterleaveSamples(const SAMPLE* input, int stride, FAUSTFLOAT** outputs, int chans, int frames)
+{
+    for (int block = 0; block < frames; block += DSP_TOOLS_BLOCK) {
+        int end = std::min(frames, block + DSP_TOOLS_BLOCK);
+        for (int chan = 0; chan < chans; chan++) {
+            const SAMPLE* src = &input[chan];
+            FAUSTFLOAT* dst = outputs[chan];
+            for (int frame = block; frame < end; frame++) {
+                dst[frame] = sample_format<SAMPLE>::read(src[frame * stride]);
+            }
+        }
+    }
+}
+
+/**
+ * Interleave (and convert) non-interleaved buffers to the first 'chans' channels of an interleaved buffer.
+ *
+ * @param inputs - the non-interleaved buffers
+ * @param chans - the number of channels to interleave (<= stride)
+ * @param output - the interleaved buffer, the channels above 'chans' are not written
+ * @param stride - the number of channels of the interleaved buffer
+ * @param frames - the number of frames
+ */
+template <typename SAMPLE>
+void interleaveSamples(FAUSTFLOAT** inputs, int chans, SAMPLE* output, int stride, int frames)
+{
+    for (int block = 0; block < frames; block += DSP_TOOLS_BLOCK) {
+        int end = std::min(frames, block + DSP_TOOLS_BLOCK);
+        for (int chan = 0; chan < chans; chan++) {
+            const FAUSTFLOAT* src = inputs[chan];
+            SAMPLE* dst = &output[chan];
+            for (int frame = block; frame < end; frame++) {
+                sample_format<SAMPLE>::write(dst[frame * stride], src[frame]);
+            }
+        }
+    }
+}
+
+#if defined (DSP_SIMD)
+
+/*
+ * Float versions (selected by overload resolution when FAUSTFLOAT is float): 1 channel is a copy,
+ * 2 channels use a dedicated shuffle, and groups of 4 channels (so 4 and 8 channels, and any
+ * count by groups of 4) use a 4x4 transpose per 4 frames. The remaining channels and frames
+ * use the scalar loop.
+ */
+inline void deinterleaveSamples(const float* input, int stride, float** outputs, int chans, int frames)
+{
+    if (chans == 1 && stride == 1) {
+        memcpy(outputs[0], input, sizeof(float) * frames);
+        return;
+    }
+    int vframes = frames & ~3;
+    for (int block = 0; block < vframes; block += DSP_TOOLS_BLOCK) {
+        int end = std::min(vframes, block + DSP_TOOLS_BLOCK);
+        int chan = 0;
+        if (chans == 2 && stride == 2) {
+            float* out0 = outputs[0];
+            float* out1 = outputs[1];
+            for (int frame = block; frame < end; frame += 4) {
+                simd_float4 a = simd_load(&input[frame * 2]);
+                simd_float4 b = simd_load(&input[frame * 2 + 4]);
+                simd_deinterleave2(a, b);
+                simd_store(&out0[frame], a);
+                simd_store(&out1[frame], b);
+            }
+            chan = 2;
+        }
+        for (; chan + 4 <= chans; chan += 4) {
+            float* out0 = outputs[chan];
+            float* out1 = outputs[chan + 1];
+            float* out2 = outputs[chan + 2];
+            float* out3 = outputs[chan + 3];
+            for (int frame = block; frame < end; frame += 4) {
+                const float* src = &input[frame * stride + chan];
+                simd_float4 r0 = simd_load(src);
+                simd_float4 r1 = simd_load(src + stride);
+                simd_float4 r2 = simd_load(src + 2 * stride);
+                simd_float4 r3 = simd_load(src + 3 * stride);
+                simd_transpose4(r0, r1, r2, r3);
+                simd_store(&out0[frame], r0);
+                simd_store(&out1[frame], r1);
+                simd_store(&out2[frame], r2);
+                simd_store(&out3[frame], r3);
+            }
+        }
+        for (; chan < chans; chan++) {
+            float* dst = outputs[chan];
+            for (int frame = block; frame < end; frame++) {
+                dst[frame] = input[frame * stride + chan];
+            }
+        }
+    }
+    for (int frame = vframes; frame < frames; frame++) {
+        for (int chan = 0; chan < chans; chan++) {
+            outputs[chan][frame] = input[frame * stride + chan];
+        }
+    }
+}
+
+inline void interleaveSamples(float** inputs, int chans, float* output, int stride, int frames)
+{
+    if (chans == 1 && stride == 1) {
+        memcpy(output, inputs[0], sizeof(float) * frames);
+        return;
+    }
+    int vframes = frames & ~3;
+    for (int block = 0; block < vframes; block += DSP_TOOLS_BLOCK) {
+        int end = std::min(vframes, block + DSP_TOOLS_BLOCK);
+        int chan = 0;
+        if (chans == 2 && stride == 2) {
+            const float* in0 = inputs[0];
+            const float* in1 = inputs[1];
+            for (int frame = block; frame < end; frame += 4) {
+                simd_float4 a = simd_load(&in0[frame]);
+                simd_float4 b = simd_load(&in1[frame]);
+                simd_interleave2(a, b);
+                simd_store(&output[frame * 2], a);
+                simd_store(&output[frame * 2 + 4], b);
+            }
+            chan = 2;
+        }
+        for (; chan + 4 <= chans; chan += 4) {
+            const float* in0 = inputs[chan];
+            const float* in1 = inputs[chan + 1];
+            const float* in2 = inputs[chan + 2];
+            const float* in3 = inputs[chan + 3];
+            for (int frame = block; frame < end; frame += 4) {
+                simd_float4 r0 = simd_load(&in0[frame]);
+                simd_float4 r1 = simd_load(&in1[frame]);
+                simd_float4 r2 = simd_load(&in2[frame]);
+                simd_float4 r3 = simd_load(&in3[frame]);
+                simd_transpose4(r0, r1, r2, r3);
+                float* dst = &output[frame * stride + chan];
+                simd_store(dst, r0);
+                simd_store(dst + stride, r1);
+                simd_store(dst + 2 * stride, r2);
+                simd_store(dst + 3 * stride, r3);
+            }
+        }
+        for (; chan < chans; chan++) {
+            const float* src = inputs[chan];
+            for (int frame = block; frame < end; frame++) {
+                output[frame * stride + chan] = src[frame];
+            }
+        }
+    }
+    for (int frame = vframes; frame < frames; frame++) {
+        for (int chan = 0; chan < chans; chan++) {
+            output[frame * stride + chan] = inputs[chan][frame];
+        }
+    }
+}
+
+#endif
+
+/**
+ * Convert and deinterleave a device input buffer to non-interleaved FAUSTFLOAT buffers.
+ *
+ * @param input - the device buffer
+ * @param inchans - the number of channels of the device buffer
+ * @param interleaved - whether the device buffer is interleaved (otherwise channels follow each other)
+ * @param outputs - the non-interleaved buffers, channels above 'inchans' are cleared
+ * @param outchans - the number of non-interleaved buffers
+ * @param frames - the number of frames to convert
+ */
+template <typename SAMPLE>
+void readSamples(const SAMPLE* input, int inchans, bool interleaved, FAUSTFLOAT** outputs, int outchans, int frames)
+{
+    int chans = std::min(inchans, outchans);
+    if (interleaved) {
+        deinterleaveSamples(input, inchans, outputs, chans, frames);
+    } else {
+        for (int chan = 0; chan < chans; chan++) {
+            const SAMPLE* src = &input[chan * frames];
+            FAUSTFLOAT* dst = outputs[chan];
+            for (int frame = 0; frame < frames; frame++) {
+                dst[frame] = sample_format<SAMPLE>::read(src[frame]);
+            }
+        }
+    }
+    for (int chan = chans; chan < outchans; chan++) {
+        memset(outputs[chan], 0, sizeof(FAUSTFLOAT) * frames);
+    }
+}
+
+/**
+ * Interleave and convert non-interleaved FAUSTFLOAT buffers to a device output buffer.
+ *
+ * @param inputs - the non-interleaved buffers
+ * @param inchans - the number of non-interleaved buffers
+ * @param output - the device buffer, channels above 'inchans' are cleared
+ * @param outchans - the number of channels of the device buffer
+ * @param interleaved - whether the device buffer is interleaved (otherwise channels follow each other)
+ * @param frames - the number of frames to convert
+ */
+template <typename SAMPLE>
+void writeSamples(FAUSTFLOAT** inputs, int inchans, SAMPLE* output, int outchans, bool interleaved, int frames)
+{
+    int chans = std::min(inchans, outchans);
+    int stride = (interleaved) ? outchans : 1;
+    if (interleaved) {
+        interleaveSamples(inputs, chans, output, outchans, frames);
+    } else {
+        for (int chan = 0; chan < chans; chan++) {
+            FAUSTFLOAT* src = inputs[chan];
+            SAMPLE* dst = &output[chan * frames];
+            for (int frame = 0; frame < frames; frame++) {
+                sample_format<SAMPLE>::write(dst[frame], src[frame]);
+            }
+        }
+    }
+    for (int chan = chans; chan < outchans; chan++) {
+        SAMPLE* dst = (interleaved) ? &output[chan] : &output[chan * frames];
+        for (int frame = 0; frame < frames; frame++) {
+            sample_format<SAMPLE>::write(dst[frame * stride], FAUSTFLOAT(0));
+        }
+    }
+}
+
+//=============================================================================
+// A Deinterleaver owns an interleaved input buffer of SAMPLE (float, int16_t,
+// int24_packed, int32_t...) and the non-interleaved FAUSTFLOAT output buffers
+// it is converted to, ready to use in the compute() method of a Faust dsp.
+// There is no limit on the number of channels.
+//=============================================================================
+
+template <typename SAMPLE>
+class SampleDeinterleaver
 {
     
     private:
@@ -41,27 +358,28 @@ class Deinterleaver
         int fNumInputs;
         int fNumOutputs;
         
-        FAUSTFLOAT* fInput;
-        FAUSTFLOAT* fOutputs[256];
+        SAMPLE* fInput;
+        FAUSTFLOAT** fOutputs;
         
     public:
         
-        Deinterleaver(int numFrames, int numInputs, int numOutputs)
+        SampleDeinterleaver(int numFrames, int numInputs, int numOutputs)
         {
             fNumFrames = numFrames;
             fNumInputs = numInputs;
             fNumOutputs = std::max<int>(numInputs, numOutputs);
             
             // allocate interleaved input channel
-            fInput = new FAUSTFLOAT[fNumFrames * fNumInputs];
+            fInput = new SAMPLE[fNumFrames * fNumInputs];
             
             // allocate separate output channels
+            fOutputs = new FAUSTFLOAT*[fNumOutputs];
             for (int i = 0; i < fNumOutputs; i++) {
                 fOutputs[i] = new FAUSTFLOAT[fNumFrames];
             }
         }
         
-        ~Deinterleaver()
+        ~SampleDeinterleaver()
         {
             // free interleaved input channel
             delete [] fInput;
@@ -70,23 +388,27 @@ class Deinterleaver
             for (int i = 0; i < fNumOutputs; i++) {
                 delete [] fOutputs[i];
             }
+            delete [] fOutputs;
         }
         
-        FAUSTFLOAT* input() { return fInput; }
+        SAMPLE* input() { return fInput; }
         
         FAUSTFLOAT** outputs() { return fOutputs; }
         
         void deinterleave()
         {
-            for (int s = 0; s < fNumFrames; s++) {
-                for (int c = 0; c < fNumInputs; c++) {
-                    fOutputs[c][s] = fInput[c + s * fNumInputs];
-                }
-            }
+            deinterleaveSamples(fInput, fNumInputs, fOutputs, fNumInputs, fNumFrames);
         }
 };
 
-class Interleaver
+//=============================================================================
+// An Interleaver owns the non-interleaved FAUSTFLOAT input buffers filled by
+// the compute() method of a Faust dsp and the interleaved output buffer of
+// SAMPLE they are converted to. There is no limit on the number of channels.
+//=============================================================================
+
+template <typename SAMPLE>
+class SampleInterleaver
 {
     
     private:
@@ -95,32 +417,34 @@ class Interleaver
         int fNumInputs;
         int fNumOutputs;
     
-        FAUSTFLOAT* fInputs[256];
-        FAUSTFLOAT* fOutput;
+        FAUSTFLOAT** fInputs;
+        SAMPLE* fOutput;
         
     public:
         
-        Interleaver(int numFrames, int numInputs, int numOutputs)
+        SampleInterleaver(int numFrames, int numInputs, int numOutputs)
         {
             fNumFrames = numFrames;
             fNumInputs 	= std::max(numInputs, numOutputs);
             fNumOutputs = numOutputs;
             
             // allocate separate input channels
+            fInputs = new FAUSTFLOAT*[fNumInputs];
             for (int i = 0; i < fNumInputs; i++) {
                 fInputs[i] = new FAUSTFLOAT[fNumFrames];
             }
             
             // allocate interleaved output channel
-            fOutput = new FAUSTFLOAT[fNumFrames * fNumOutputs];
+            fOutput = new SAMPLE[fNumFrames * fNumOutputs];
         }
         
-        ~Interleaver()
+        ~SampleInterleaver()
         {
             // free separate input channels
             for (int i = 0; i < fNumInputs; i++) {
                 delete [] fInputs[i];
             }
+            delete [] fInputs;
             
             // free interleaved output channel
             delete [] fOutput;
@@ -128,18 +452,24 @@ class Interleaver
         
         FAUSTFLOAT** inputs() { return fInputs; }
         
-        FAUSTFLOAT* output() { return fOutput; }
+        SAMPLE* output() { return fOutput; }
         
         void interleave()
         {
-            for (int s = 0; s < fNumFrames; s++) {
-                for (int c = 0; c < fNumOutputs; c++) {
-                    fOutput[c + s * fNumOutputs] = fInputs[c][s];
-                }
-            }
+            interleaveSamples(fInputs, fNumOutputs, fOutput, fNumOutputs, fNumFrames);
         }
 };
 
+typedef SampleDeinterleaver<FAUSTFLOAT> Deinterleaver;
+typedef SampleDeinterleaver<int16_t> Deinterleaver16;
+typedef SampleDeinterleaver<int24_packed> Deinterleaver24;
+typedef SampleDeinterleaver<int32_t> Deinterleaver32;
+
+typedef SampleInterleaver<FAUSTFLOAT> Interleaver;
+typedef SampleInterleaver<int16_t> Interleaver16;
+typedef SampleInterleaver<int24_packed> Interleaver24;
+typedef SampleInterleaver<int32_t> Interleaver32;
+
 //=============================================================================
 // An AudioChannels is a group of non-interleaved buffers that knows how to read
 // from or write to an interleaved buffer. The interleaved buffer may have a
@@ -171,7 +501,7 @@ class AudioChannels
         virtual ~AudioChannels()
         {
             // free separate input channels
-            for (int i = 0; i < fNumChannels; i++) {
+            for (unsigned int i = 0; i < fNumChannels; i++) {
                 delete[] fChannels[i];
             }
             delete[] fChannels;
@@ -184,18 +514,8 @@ class AudioChannels
         void interleavedRead(float* inbuffer, unsigned int length, unsigned int inchannels)
         {
             assert(length <= fNumFrames);
-            unsigned int C = std::min<unsigned int>(inchannels, fNumChannels);
             unsigned int F = std::min<unsigned int>(length, fNumFrames);
-            
-            for (unsigned int f = 0; f < F; f++) {
-                unsigned int p = f * inchannels;
-                for (unsigned int c = 0; c < C; c++) {
-                    fChannels[c][f] = inbuffer[p++];
-                }
-                for (unsigned int c = C; c < fNumChannels; c++) {
-                    fChannels[c][f] = 0;
-                }
-            }
+            readSamples(inbuffer, inchannels, true, fChannels, fNumChannels, F);
         }
         
         //----------------------------------------------------------------------------------------
@@ -205,18 +525,8 @@ class AudioChannels
         void interleavedWrite(float* outbuffer, unsigned int length, unsigned int outchannels)
         {
             assert(length <= fNumFrames);
-            unsigned int C = std::min<unsigned int>(outchannels, fNumChannels);
             unsigned int F = std::min<unsigned int>(length, fNumFrames);
-            
-            for (unsigned int f = 0; f < F; f++) {
-                unsigned int p = f * outchannels;
-                for (unsigned int c = 0; c < C; c++) {
-                    outbuffer[p++] = fChannels[c][f];
-                }
-                for (unsigned int c = C; c < outchannels; c++) {
-                    outbuffer[p++] = 0;
-                }
-            }
+            writeSamples(fChannels, fNumChannels, outbuffer, outchannels, true, F);
         }
         
         //----------------------------------------------------------------------------------------
@@ -28,6 +28,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <atomic>
 
 #include "faust/export.h"
 
@@ -261,11 +262,20 @@ class FAUST_API dsp_factory {
 #include <xmmintrin.h>
 #endif
 
+/**
+ * Denormal policy, used by ScopedNoDenormals (so by AVOIDDENORMALS in audio drivers and offline renderers):
+ * - DENORMALS_KEEP: the FP status register is not changed
+ * - DENORMALS_FTZ: denormal results are flushed to zero (FZ on ARM also treats denormal inputs as zero)
+ * - DENORMALS_FTZ_DAZ: denormal results are flushed to zero and denormal inputs are treated as zero (default)
+ */
+enum { DENORMALS_KEEP = 0, DENORMALS_FTZ = 1, DENORMALS_FTZ_DAZ = 2 };
+
 class FAUST_API ScopedNoDenormals {
     
     private:
     
         intptr_t fpsr = 0;
+        bool fChanged = false;
         
         void setFpStatusRegister(intptr_t fpsr_aux) noexcept
         {
@@ -288,29 +298,57 @@ class FAUST_API ScopedNoDenormals {
         #endif
         }
     
+        static std::atomic<int>& globalPolicy() noexcept
+        {
+            static std::atomic<int> policy(DENORMALS_FTZ_DAZ);
+            return policy;
+        }
+    
     public:
     
-        ScopedNoDenormals() noexcept
+        /**
+         * Set the FP status register of the calling thread according to the policy,
+         * and restore it in the destructor.
+         *
+         * @param policy - DENORMALS_KEEP, DENORMALS_FTZ or DENORMALS_FTZ_DAZ
+         */
+        ScopedNoDenormals(int policy = getPolicy()) noexcept
+        {
+            intptr_t mask = getMask(policy);
+            if (mask == 0) return;
+            getFpStatusRegister();
+            if ((fpsr & mask) != mask) {
+                setFpStatusRegister(fpsr | mask);
+                fChanged = true;
+            }
+        }
+        
+        ~ScopedNoDenormals() noexcept
+        {
+            if (fChanged) setFpStatusRegister(fpsr);
+        }
+    
+        /* Return the FP status register bits to be set for a policy on this architecture */
+        static intptr_t getMask(int policy) noexcept
         {
+            if (policy == DENORMALS_KEEP) return 0;
         #if defined (__arm64__) || defined (__aarch64__)
-            intptr_t mask = (1 << 24 /* FZ */);
+            return (1 << 24 /* FZ */);
         #elif defined (__SSE__)
         #if defined (__SSE2__)
-            intptr_t mask = 0x8040;
+            return (policy == DENORMALS_FTZ_DAZ) ? 0x8040 /* FTZ | DAZ */ : 0x8000 /* FTZ */;
         #else
-            intptr_t mask = 0x8000;
+            return 0x8000;
         #endif
         #else
-            intptr_t mask = 0x0000;
+            return 0x0000;
         #endif
-            getFpStatusRegister();
-            setFpStatusRegister(fpsr | mask);
-        }
-        
-        ~ScopedNoDenormals() noexcept
-        {
-            setFpStatusRegister(fpsr);
         }
+    
+        /* Set the process wide policy used by AVOIDDENORMALS, can be changed while audio is running */
+        static void setPolicy(int policy) noexcept { globalPolicy().store(policy, std::memory_order_relaxed); }
+    
+        static int getPolicy() noexcept { return globalPolicy().load(std::memory_order_relaxed); }
 
 };
 
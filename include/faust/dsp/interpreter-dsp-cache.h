@@ -0,0 +1,299 @@
+/************************** BEGIN interpreter-dsp-cache.h *****************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __interpreter_dsp_cache__
+#define __interpreter_dsp_cache__
+
+#include <limits.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+
+#include "faust/dsp/libfaust.h"
+#include "faust/dsp/interpreter-dsp.h"
+#include "faust/dsp/interpreter-dsp-optimizer.h"
+
+/**
+ * A memoizing front end for createInterpreterDSPFactoryFromSignals/FromBoxes.
+ *
+ * Signal and box trees are hash-consed by libfaust, so two structurally equal graphs
+ * have the same shared textual form (printSignal/printBox with 'shared' set, which
+ * prints each distinct sub-tree once, so in time linear in the size of the DAG).
+ * The SHA1 key of this form, of the program name and of the compilation parameters
+ * identifies the program: a graph equal to an already compiled one gets the cached
+ * factory back and the compilation is skipped entirely.
+ *
+ * Keys are textual, so they stay valid across createLibContext/destroyLibContext pairs:
+ * a graph rebuilt in a new context still hits the cache.
+ *
+ * When an optimizer is given, programs are compiled with the options it finds the fastest
+ * (the search is done at the first compilation of each program, and cached by the optimizer).
+ *
+ * Factories are owned by the cache: they must not be deleted with deleteInterpreterDSPFactory.
+ * Each factory returned by createFromSignals/createFromBoxes is referenced until it is given back
+ * with 'release' (once its instances are deleted): 'remove' and 'clear' only delete factories
+ * which are not referenced anymore, since deleting a factory also deletes its instances.
+ *
+ * Programs are compiled outside of the cache lock, so that lookups (and hits) are not blocked
+ * by a compilation. A program being compiled is marked as pending: other callers asking for it
+ * wait for the result instead of compiling it again. Compilations of different programs are
+ * still done one at a time, since libfaust and the optimizer are not thread safe. Keys are
+ * computed by the calling thread (with printSignal/printBox), which has to be serialized by
+ * the caller with its other libfaust calls, as when building the graphs.
+ */
+class interpreter_dsp_factory_cache {
+
+    private:
+
+        std::map<std::string, interpreter_dsp_factory*> fFactories;
+        std::map<interpreter_dsp_factory*, int> fReferences;
+        std::set<std::string> fPending;         // Keys of the programs being compiled
+        std::mutex fMutex;                      // Protects the tables and the counters
+        std::mutex fCompileMutex;               // Serializes the compilations
+        std::condition_variable fCompiled;      // Signaled when a pending compilation ends
+        interpreter_dsp_optimizer* fOptimizer;
+        int fHits;
+        int fMisses;
+
+        static std::string getKey(const std::string& kind,
+                                  const std::string& name_app,
+                                  const std::string& graph,
+                                  int argc, const char* argv[])
+        {
+            std::string key = kind + '\n' + name_app + '\n';
+            for (int i = 0; i < argc; i++) {
+                key += argv[i];
+                key += '\n';
+            }
+            return generateSHA1(key + graph);
+        }
+
+        // 'create' compiles the program with the given options: interpreter_dsp_factory* create(int argc, const char* argv[], std::string& error)
+        template <typename CREATE>
+        interpreter_dsp_factory* getFactory(const std::string& key,
+                                            int argc, const char* argv[],
+                                            std::string& error_msg,
+                                            CREATE create)
+        {
+            std::unique_lock<std::mutex> lock(fMutex);
+            // The same program being compiled by another caller is waited for
+            fCompiled.wait(lock, [&] { return fPending.count(key) == 0; });
+            auto it = fFactories.find(key);
+            if (it != fFactories.end()) {
+                fHits++;
+                fReferences[it->second]++;
+                return it->second;
+            }
+            fMisses++;
+            fPending.insert(key);
+            lock.unlock();
+
+            interpreter_dsp_factory* factory = nullptr;
+            try {
+                std::lock_guard<std::mutex> compile(fCompileMutex);
+                factory = (fOptimizer)
+                    ? fOptimizer->createDSPFactory(key, argc, argv, create, error_msg)
+                    : create(argc, argv, error_msg);
+            } catch (...) {
+                lock.lock();
+                fPending.erase(key);
+                lock.unlock();
+                fCompiled.notify_all();
+                throw;
+            }
+
+            lock.lock();
+            fPending.erase(key);
+            // Failures are not cached, the error message has to be returned each time
+            if (factory) {
+                fFactories[key] = factory;
+                fReferences[factory] = 1;
+            }
+            lock.unlock();
+            fCompiled.notify_all();
+            return factory;
+        }
+
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param optimizer - an optional optimizer used to compile programs with their fastest options
+         * (not owned by the cache, to be kept alive while the cache is used)
+         */
+        interpreter_dsp_factory_cache(interpreter_dsp_optimizer* optimizer = nullptr)
+        :fOptimizer(optimizer), fHits(0), fMisses(0)
+        {}
+
+        /*
+         * Factories still referenced are not deleted (their instances may still be used),
+         * they are left in the libfaust factories cache (see deleteAllInterpreterDSPFactories).
+         */
+        virtual ~interpreter_dsp_factory_cache()
+        {
+            clear();
+        }
+
+        /**
+         * Return the structural key of a vector of output signals.
+         * Same parameters as createInterpreterDSPFactoryFromSignals.
+         *
+         * @return the key as a SHA1 string.
+         */
+        static std::string getSignalsKey(const std::string& name_app, tvec signals, int argc, const char* argv[])
+        {
+            std::string graph;
+            for (const auto& sig : signals) {
+                graph += printSignal(sig, true, INT_MAX);
+                graph += '\n';
+            }
+            return getKey("signals", name_app, graph, argc, argv);
+        }
+
+        /**
+         * Return the structural key of a box expression.
+         * Same parameters as createInterpreterDSPFactoryFromBoxes.
+         *
+         * @return the key as a SHA1 string.
+         */
+        static std::string getBoxesKey(const std::string& name_app, Box box, int argc, const char* argv[])
+        {
+            return getKey("boxes", name_app, printBox(box, true, INT_MAX), argc, argv);
+        }
+
+        /**
+         * Return the factory of a vector of output signals, compiling it only
+         * if no equal graph has been compiled before with the same parameters.
+         * Same parameters as createInterpreterDSPFactoryFromSignals.
+         *
+         * @return a DSP factory (owned by the cache, to be given back with 'release') on success, otherwise a null pointer.
+         */
+        interpreter_dsp_factory* createFromSignals(const std::string& name_app,
+                                                   tvec signals,
+                                                   int argc, const char* argv[],
+                                                   std::string& error_msg)
+        {
+            return getFactory(getSignalsKey(name_app, signals, argc, argv), argc, argv, error_msg,
+                              [&](int argc1, const char* argv1[], std::string& error) {
+                                  return createInterpreterDSPFactoryFromSignals(name_app, signals, argc1, argv1, error);
+                              });
+        }
+
+        /**
+         * Return the factory of a box expression, compiling it only
+         * if no equal expression has been compiled before with the same parameters.
+         * Same parameters as createInterpreterDSPFactoryFromBoxes.
+         *
+         * @return a DSP factory (owned by the cache, to be given back with 'release') on success, otherwise a null pointer.
+         */
+        interpreter_dsp_factory* createFromBoxes(const std::string& name_app,
+                                                 Box box,
+                                                 int argc, const char* argv[],
+                                                 std::string& error_msg)
+        {
+            return getFactory(getBoxesKey(name_app, box, argc, argv), argc, argv, error_msg,
+                              [&](int argc1, const char* argv1[], std::string& error) {
+                                  return createInterpreterDSPFactoryFromBoxes(name_app, box, argc1, argv1, error);
+                              });
+        }
+
+        /**
+         * Give back a factory returned by createFromSignals/createFromBoxes, once its instances are deleted.
+         * The factory stays in the cache.
+         *
+         * @param factory - the DSP factory
+         *
+         * @return false if the factory is not referenced by the cache.
+         */
+        bool release(interpreter_dsp_factory* factory)
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            auto it = fReferences.find(factory);
+            if (it == fReferences.end() || it->second == 0) return false;
+            it->second--;
+            return true;
+        }
+
+        /**
+         * Delete a factory of the cache, if it is not referenced anymore.
+         *
+         * @param factory - the DSP factory
+         *
+         * @return true if the factory was found in the cache and deleted.
+         */
+        bool remove(interpreter_dsp_factory* factory)
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            for (auto it = fFactories.begin(); it != fFactories.end(); it++) {
+                if (it->second == factory) {
+                    if (fReferences[factory] > 0) return false;
+                    deleteInterpreterDSPFactory(factory);
+                    fReferences.erase(factory);
+                    fFactories.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Delete all factories of the cache which are not referenced anymore.
+         *
+         * @return the number of factories kept, since still referenced.
+         */
+        int clear()
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            for (auto it = fFactories.begin(); it != fFactories.end();) {
+                if (fReferences[it->second] > 0) {
+                    it++;
+                } else {
+                    deleteInterpreterDSPFactory(it->second);
+                    fReferences.erase(it->second);
+                    it = fFactories.erase(it);
+                }
+            }
+            return int(fFactories.size());
+        }
+
+        int getSize() { std::lock_guard<std::mutex> lock(fMutex); return int(fFactories.size()); }
+        int getHits() { std::lock_guard<std::mutex> lock(fMutex); return fHits; }
+        int getMisses() { std::lock_guard<std::mutex> lock(fMutex); return fMisses; }
+
+        /* Return the number of references of a factory of the cache (0 if not found) */
+        int getReferences(interpreter_dsp_factory* factory)
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            auto it = fReferences.find(factory);
+            return (it != fReferences.end()) ? it->second : 0;
+        }
+
+};
+
+#endif
+/************************** END interpreter-dsp-cache.h **************************/
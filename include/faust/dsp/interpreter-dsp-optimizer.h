@@ -0,0 +1,385 @@
+/************************** BEGIN interpreter-dsp-optimizer.h ****************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __interpreter_dsp_optimizer__
+#define __interpreter_dsp_optimizer__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "faust/dsp/libfaust.h"
+#include "faust/dsp/interpreter-dsp.h"
+#include "faust/dsp/dsp-bench.h"
+
+typedef std::vector<std::string> TOption;
+typedef std::vector<TOption> TOptionTable;
+
+/*
+    A class to find optimal Faust compiler parameters for a given DSP, using the interpreter backend
+    (the equivalent of dsp_optimizer_real for llvm_dsp_factory).
+
+    Results are cached by (DSP SHA key, buffer size), so that 'createDSPFactoryFromString' compiles
+    already tuned DSPs with their best options without measuring again. The cache can be saved
+    in a file and loaded back. Programs which are not given as a string (signals or boxes) are
+    tuned with 'createDSPFactory' and their own key, see interpreter_dsp_factory_cache.
+*/
+template <typename REAL>
+class interpreter_dsp_optimizer_real {
+
+    public:
+
+        // Result of a search: MBytes/sec, standard deviation (in %), DSP CPU (in 0..1), options
+        typedef std::tuple<double, double, double, TOption> TResult;
+
+    private:
+
+        int fBufferSize;
+        double fDuration;
+        int fCount;
+        bool fTrace;
+        bool fControl;
+        std::string fError;
+
+        std::map<std::string, TResult> fCache;
+
+        // Base options given by the user, added to all tested options
+        TOption fArgs;
+
+        TOptionTable makeScalTable()
+        {
+            TOptionTable table;
+            table.push_back({"-scal", "-mcd", "0"});
+            for (int size = 2; size <= fBufferSize; size *= 2) {
+                table.push_back({"-scal", "-mcd", std::to_string(size)});
+            }
+            return table;
+        }
+
+        TOptionTable makeVecTable()
+        {
+            TOptionTable table;
+            for (int lv = 0; lv <= 1; lv++) {
+                for (int size = 4; size <= fBufferSize; size *= 2) {
+                    table.push_back({"-vec", "-lv", std::to_string(lv), "-vs", std::to_string(size)});
+                }
+            }
+            return table;
+        }
+
+        std::string makeKey(const std::string& sha_key)
+        {
+            return sha_key + ":" + std::to_string(fBufferSize);
+        }
+
+        std::vector<const char*> makeArgv(const TOption& item)
+        {
+            std::vector<const char*> argv;
+            for (const auto& it : fArgs) argv.push_back(it.c_str());
+            for (const auto& it : item) argv.push_back(it.c_str());
+            return argv;
+        }
+
+        // 'create' compiles the program with the given options: interpreter_dsp_factory* create(int argc, const char* argv[], std::string& error)
+        template <typename CREATE>
+        bool computeOne(CREATE& create, const TOption& item, std::tuple<double, double, double>& res)
+        {
+            std::vector<const char*> argv = makeArgv(item);
+            interpreter_dsp_factory* factory = create(int(argv.size()), argv.data(), fError);
+            if (!factory) return false;
+
+            // The instance is deallocated by measure_dsp_real
+            dsp* DSP = factory->createDSPInstance();
+            if (!DSP) {
+                deleteInterpreterDSPFactory(factory);
+                fError = "ERROR : cannot create instance";
+                return false;
+            }
+
+            bench_stats stats;
+            if (fCount == -1) {
+                // First measure with the wanted duration, then keep the same number of cycles for all candidates
+                measure_dsp_real<REAL> mes(DSP, fBufferSize, fDuration, false, fControl);
+                mes.measure();
+                fCount = mes.getCount();
+                stats = mes.getBenchStats();
+            } else {
+                measure_dsp_real<REAL> mes(DSP, fBufferSize, fCount, false, fControl);
+                mes.measure();
+                stats = mes.getBenchStats();
+            }
+            res = std::make_tuple(stats.fMBPerSec, stats.fStdDev, stats.fCPULoad);
+            deleteInterpreterDSPFactory(factory);
+
+            if (fTrace) {
+                for (const auto& it : item) fprintf(stdout, " %s", it.c_str());
+                fprintf(stdout, " : %f MBytes/sec, SD : %f%%\n", std::get<0>(res), std::get<1>(res));
+            }
+            return true;
+        }
+
+        // 'found' tells whether 'best' already holds a measured result, which candidates then have to beat
+        template <typename CREATE>
+        bool findOptimizedParametersAux(CREATE& create, const TOptionTable& options, TResult& best, bool found)
+        {
+            for (const auto& item : options) {
+                std::tuple<double, double, double> res;
+                // Options not supported by the backend are just skipped
+                if (computeOne(create, item, res) && (!found || std::get<0>(res) > std::get<0>(best))) {
+                    best = std::make_tuple(std::get<0>(res), std::get<1>(res), std::get<2>(res), item);
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        template <typename CREATE>
+        bool search(const std::string& sha_key, CREATE& create, TResult& res)
+        {
+            auto it = fCache.find(makeKey(sha_key));
+            if (it != fCache.end()) {
+                res = it->second;
+                return true;
+            }
+
+            fCount = -1;
+            TResult best_scal, best_vec;
+            if (fTrace) fprintf(stdout, "Discover best parameters option\n");
+            bool has_scal = findOptimizedParametersAux(create, makeScalTable(), best_scal, false);
+            bool has_vec = findOptimizedParametersAux(create, makeVecTable(), best_vec, false);
+            if (!has_scal && !has_vec) return false;
+
+            if (has_vec) {
+                // Refine the best vector mode with -mcd
+                if (fTrace) fprintf(stdout, "Refined with -mcd\n");
+                TOptionTable refined;
+                for (int size = 0; size <= fBufferSize; size = (size == 0) ? 2 : size * 2) {
+                    TOption item = std::get<3>(best_vec);
+                    item.push_back("-mcd");
+                    item.push_back(std::to_string(size));
+                    refined.push_back(item);
+                }
+                findOptimizedParametersAux(create, refined, best_vec, true);
+            }
+            res = (has_scal && (!has_vec || std::get<0>(best_scal) > std::get<0>(best_vec))) ? best_scal : best_vec;
+
+            // Check with -ct 0
+            if (fTrace) fprintf(stdout, "Check with -ct 0\n");
+            TOption item = std::get<3>(res);
+            item.push_back("-ct");
+            item.push_back("0");
+            findOptimizedParametersAux(create, TOptionTable(1, item), res, true);
+
+            fCache[makeKey(sha_key)] = res;
+            return true;
+        }
+
+        std::string getSHAKey(const std::string& name_app, const std::string& dsp_content)
+        {
+            std::string sha_key;
+            std::vector<const char*> argv = makeArgv(TOption());
+            std::string expanded = expandDSPFromString(name_app, dsp_content, int(argv.size()), argv.data(), sha_key, fError);
+            return (expanded == "") ? "" : sha_key;
+        }
+
+    public:
+
+        /**
+         * Constructor.
+         *
+         * @param buffer_size - the buffer size in samples
+         * @param duration - the measure duration in seconds of each candidate
+         * @param trace - whether to log the trace
+         * @param control - whether to activate random changes of all control values at each cycle
+         */
+        interpreter_dsp_optimizer_real(int buffer_size, double duration = 0.5, bool trace = false, bool control = false)
+        :fBufferSize(buffer_size), fDuration(duration), fCount(-1), fTrace(trace), fControl(control)
+        {}
+
+        virtual ~interpreter_dsp_optimizer_real()
+        {}
+
+        /**
+         * Returns the best compilation parameters, measuring all candidates unless the DSP is already in the cache.
+         *
+         * @param name_app - the name of the Faust program
+         * @param dsp_content - the Faust program as a string
+         * @param argc - the number of parameters in argv array
+         * @param argv - the array of base parameters, kept in all tested options
+         * @param res - the best result (in Megabytes/seconds), its standard deviation, DSP CPU (in 0..1) and the best options
+         *
+         * @return true on success, otherwise false (and 'getError' returns the compilation error).
+         */
+        bool findOptimizedParameters(const std::string& name_app, const std::string& dsp_content, int argc, const char* argv[], TResult& res)
+        {
+            fArgs = TOption(argv, argv + argc);
+            fError = "";
+            std::string sha_key = getSHAKey(name_app, dsp_content);
+            if (sha_key == "") return false;
+            auto create = [&](int argc1, const char* argv1[], std::string& error) {
+                return createInterpreterDSPFactoryFromString(name_app, dsp_content, argc1, argv1, error);
+            };
+            return search(sha_key, create, res);
+        }
+
+        /**
+         * Returns the best compilation parameters of a program compiled by a given function
+         * (for instance from signals or boxes), measuring all candidates unless the key is already in the cache.
+         *
+         * @param key - a key identifying the program and the base parameters (see interpreter_dsp_factory_cache)
+         * @param argc - the number of parameters in argv array
+         * @param argv - the array of base parameters, kept in all tested options
+         * @param create - the function compiling the program, as 'interpreter_dsp_factory* create(int argc, const char* argv[], std::string& error)'
+         * @param res - the best result (in Megabytes/seconds), its standard deviation, DSP CPU (in 0..1) and the best options
+         *
+         * @return true on success, otherwise false (and 'getError' returns the compilation error).
+         */
+        template <typename CREATE>
+        bool findOptimizedParameters(const std::string& key, int argc, const char* argv[], CREATE create, TResult& res)
+        {
+            fArgs = TOption(argv, argv + argc);
+            fError = "";
+            return search(key, create, res);
+        }
+
+        /**
+         * Create a Faust DSP factory compiled with the best options for the optimizer buffer size,
+         * searching them first if the DSP is not in the cache.
+         * The factory has to be deleted with deleteInterpreterDSPFactory.
+         *
+         * @param name_app - the name of the Faust program
+         * @param dsp_content - the Faust program as a string
+         * @param argc - the number of parameters in argv array
+         * @param argv - the array of base parameters
+         * @param error_msg - the error string to be filled
+         *
+         * @return a DSP factory on success, otherwise a null pointer.
+         */
+        interpreter_dsp_factory* createDSPFactoryFromString(const std::string& name_app,
+                                                           const std::string& dsp_content,
+                                                           int argc,
+                                                           const char* argv[],
+                                                           std::string& error_msg)
+        {
+            TResult res;
+            if (!findOptimizedParameters(name_app, dsp_content, argc, argv, res)) {
+                error_msg = fError;
+                return nullptr;
+            }
+            std::vector<const char*> all_argv = makeArgv(std::get<3>(res));
+            return createInterpreterDSPFactoryFromString(name_app, dsp_content, int(all_argv.size()), all_argv.data(), error_msg);
+        }
+
+        /**
+         * Compile a program with the best options for the optimizer buffer size,
+         * searching them first if the key is not in the cache.
+         * The factory has to be deleted with deleteInterpreterDSPFactory.
+         *
+         * @param key - a key identifying the program and the base parameters (see interpreter_dsp_factory_cache)
+         * @param argc - the number of parameters in argv array
+         * @param argv - the array of base parameters
+         * @param create - the function compiling the program, as 'interpreter_dsp_factory* create(int argc, const char* argv[], std::string& error)'
+         * @param error_msg - the error string to be filled
+         *
+         * @return a DSP factory on success, otherwise a null pointer.
+         */
+        template <typename CREATE>
+        interpreter_dsp_factory* createDSPFactory(const std::string& key, int argc, const char* argv[], CREATE create, std::string& error_msg)
+        {
+            TResult res;
+            if (!findOptimizedParameters(key, argc, argv, create, res)) {
+                error_msg = fError;
+                return nullptr;
+            }
+            std::vector<const char*> all_argv = makeArgv(std::get<3>(res));
+            return create(int(all_argv.size()), all_argv.data(), error_msg);
+        }
+
+        /**
+         * Save the cache in a file, one line per DSP: 'key MBytes/sec SD CPU options...'
+         */
+        bool saveCache(const std::string& path)
+        {
+            std::ofstream file(path.c_str());
+            if (!file.is_open()) return false;
+            for (const auto& it : fCache) {
+                file << it.first << " " << std::get<0>(it.second) << " " << std::get<1>(it.second) << " " << std::get<2>(it.second);
+                for (const auto& opt : std::get<3>(it.second)) file << " " << opt;
+                file << std::endl;
+            }
+            return file.good();
+        }
+
+        /**
+         * Load (and merge) a cache previously saved with 'saveCache'
+         */
+        bool loadCache(const std::string& path)
+        {
+            std::ifstream file(path.c_str());
+            if (!file.is_open()) return false;
+            std::string line;
+            while (std::getline(file, line)) {
+                std::istringstream stream(line);
+                std::string key, opt;
+                double mbps, sd, cpu;
+                TOption options;
+                if (!(stream >> key >> mbps >> sd >> cpu)) continue;
+                while (stream >> opt) options.push_back(opt);
+                fCache[key] = std::make_tuple(mbps, sd, cpu, options);
+            }
+            return true;
+        }
+
+        void clearCache() { fCache.clear(); }
+
+        int getCacheSize() { return int(fCache.size()); }
+
+        int getBufferSize() { return fBufferSize; }
+
+        /**
+         * Returns the error (in case on compilation error).
+         *
+         * @return the compilation error as a string.
+         */
+        const char* getError() { return fError.c_str(); }
+
+};
+
+class interpreter_dsp_optimizer : public interpreter_dsp_optimizer_real<FAUSTFLOAT> {
+
+    public:
+
+        interpreter_dsp_optimizer(int buffer_size, double duration = 0.5, bool trace = false, bool control = false)
+        :interpreter_dsp_optimizer_real<FAUSTFLOAT>(buffer_size, duration, trace, control)
+        {}
+
+};
+
+#endif
+/************************** END interpreter-dsp-optimizer.h **************************/
@@ -0,0 +1,457 @@
+/************************** BEGIN signal-cost.h ***************************
+FAUST Architecture File
+Copyright (C) 2003-2022 GRAME, Centre National de Creation Musicale
+---------------------------------------------------------------------
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 2.1 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+EXCEPTION : As a special exception, you may create a larger work
+that contains this FAUST architecture section and distribute
+that work under terms of your choice, so long as this FAUST
+architecture section is not modified.
+************************************************************************/
+
+#ifndef __signal_cost__
+#define __signal_cost__
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <ostream>
+
+#include "faust/dsp/libfaust-signal.h"
+
+// Element of a list of the libfaust tree library (nil after the end), exported by libfaust but not declared by its API
+Signal nth(Signal l, int i);
+
+/*
+ The estimated cost of a signal graph, to be computed before compiling it.
+ Memory amounts are in samples (to be multiplied by the sample size of the target).
+ */
+
+struct signal_cost {
+
+    std::map<std::string, int> fNodes;  // number of distinct nodes by operator class
+    int fNumNodes;                      // number of distinct nodes
+    int fNumDelays;                     // number of delay lines (one per delayed signal)
+    int64_t fDelayMemory;               // total of the maximal delay amounts of each line
+    int fMaxDelay;                      // longest delay line
+    int fUnboundedDelays;               // variable delays without a finite maximum
+    int fNumTables;
+    int64_t fTableMemory;               // total of the known table sizes
+    int fUnknownTables;                 // tables with a non constant size, or waveforms
+    int fOpaqueNodes;                   // nodes whose operands are not visible with the public API
+    double fSampleOps;                  // estimated operations per sample
+    double fControlOps;                 // estimated operations per block (depending on controls only)
+    double fInitOps;                    // estimated operations at init time (table generators)
+
+    signal_cost():fNumNodes(0), fNumDelays(0), fDelayMemory(0), fMaxDelay(0), fUnboundedDelays(0),
+    fNumTables(0), fTableMemory(0), fUnknownTables(0), fOpaqueNodes(0),
+    fSampleOps(0), fControlOps(0), fInitOps(0)
+    {}
+
+    void print(std::ostream& out) const
+    {
+        out << "Nodes : " << fNumNodes;
+        for (const auto& it : fNodes) {
+            out << " " << it.first << "=" << it.second;
+        }
+        out << std::endl;
+        out << "Delays : " << fNumDelays << " lines, " << fDelayMemory << " samples, max " << fMaxDelay;
+        if (fUnboundedDelays > 0) out << ", " << fUnboundedDelays << " unbounded";
+        out << std::endl;
+        out << "Tables : " << fNumTables << " tables, " << fTableMemory << " samples";
+        if (fUnknownTables > 0) out << ", " << fUnknownTables << " of unknown size";
+        out << std::endl;
+        out << "Ops : " << fSampleOps << " per sample, " << fControlOps << " per block, " << fInitOps << " at init";
+        if (fOpaqueNodes > 0) out << " (" << fOpaqueNodes << " opaque nodes)";
+        out << std::endl;
+    }
+
+};
+
+/*
+ Walks a signal graph with the isSigXXX predicates of libfaust-signal.h.
+
+ Each distinct node is visited once (signals are hash-consed DAGs), with an explicit stack
+ so that very deep graphs can be analysed. The operand of variable delays is bounded with
+ its interval (see getSigInterval), which is only computed on signals in normal form: so
+ by default the graph is first simplified with simplifyToNormalForm2.
+
+ As in the generated code, all delays of a same signal share one line, sized by the
+ longest of them: 'x@100 + x@28' is one line of 100 samples.
+
+ Recursion groups are walked through their projections (isProj) and equations (isRec):
+ the delays and operations of the equations are counted like the others. isRec only
+ matches groups in symbolic form, which simplifyToNormalForm2 produces: without
+ normalization, groups built with sigRecursion are counted as opaque.
+
+ Operations are weighted (1 for simple arithmetic, 4 for divisions, 10 for transcendental
+ functions and foreign calls) and counted per sample only when they depend on inputs,
+ delays or recursions, otherwise per block. The operands of math primitives and foreign
+ functions are not exposed by the public API: these nodes are counted as opaque,
+ and assumed to be computed at each sample.
+ */
+
+class signal_cost_analyzer {
+
+    private:
+
+        enum Rate { kConst, kControl, kSample };
+
+        struct Node {
+            std::string fClass;
+            std::vector<Signal> fChildren;
+            double fOps;
+            Rate fRate;         // minimal rate of the node, whatever its operands
+            bool fInherit;      // whether the node also runs at the rate of its operands
+            Node():fOps(0), fRate(kConst), fInherit(true)
+            {}
+        };
+
+        std::map<Signal, Node> fGraph;
+        std::map<Signal, Rate> fRates;
+        std::map<Signal, int64_t> fDelays;  // longest delay of each delayed signal, -1 if unbounded
+        signal_cost fCost;
+
+        static bool isInt(Signal s, int64_t& n)
+        {
+            int i;
+            double r;
+            if (isSigInt(s, &i)) { n = i; return true; }
+            if (isSigReal(s, &r) && r == floor(r)) { n = int64_t(r); return true; }
+            return false;
+        }
+
+        static double getMathOps(const char* name)
+        {
+            static const char* cheap[] = { "abs", "fabs", "min", "max", "floor", "ceil", "rint", "round", nullptr };
+            for (int i = 0; cheap[i]; i++) {
+                if (strcmp(name, cheap[i]) == 0) return 1;
+            }
+            return (strcmp(name, "sqrt") == 0 || strcmp(name, "fmod") == 0 || strcmp(name, "remainder") == 0) ? 4 : 10;
+        }
+
+        // Account a delay of 'n' samples (-1 if unbounded) of the signal 'x'
+        void addDelay(Signal x, int64_t n)
+        {
+            auto it = fDelays.find(x);
+            if (it == fDelays.end()) {
+                fDelays[x] = n;
+            } else if (it->second >= 0) {
+                it->second = (n < 0) ? n : std::max(it->second, n);
+            }
+        }
+
+        void addDelay(Signal x, Signal amount)
+        {
+            int64_t n;
+            if (isInt(amount, n)) {
+                addDelay(x, n);
+            } else {
+                Interval it = getSigInterval(amount);
+                if (it.fHi < double(std::numeric_limits<int>::max()) && it.fHi >= 0) {
+                    addDelay(x, int64_t(ceil(it.fHi)));
+                } else {
+                    addDelay(x, -1);
+                }
+            }
+        }
+
+        void addTable(Signal size)
+        {
+            int64_t n;
+            fCost.fNumTables++;
+            if (size && isInt(size, n)) {
+                fCost.fTableMemory += n;
+            } else {
+                fCost.fUnknownTables++;
+            }
+        }
+
+        void opaque(Node& node, const std::string& cls, double ops)
+        {
+            node.fClass = cls;
+            node.fOps = ops;
+            node.fRate = kSample;
+            fCost.fOpaqueNodes++;
+        }
+
+        void add(Node& node, Signal s)
+        {
+            if (s && !isNil(s)) node.fChildren.push_back(s);
+        }
+
+        // Decode a node: class, operands, cost, and account delays and tables
+        Node decode(Signal s)
+        {
+            Node node;
+            int i;
+            double r;
+            Signal x, y, z, w, v;
+
+            if (isSigInt(s, &i) || isSigReal(s, &r)) {
+                node.fClass = "constant";
+            } else if (isSigFConst(s, x, y, z) || isSigFVar(s, x, y, z)) {
+                node.fClass = "constant";
+                node.fRate = kControl;
+            } else if (isSigInput(s, &i)) {
+                node.fClass = "input";
+                node.fRate = kSample;
+            } else if (isSigOutput(s, &i, x)) {
+                node.fClass = "output";
+                add(node, x);
+            } else if (isSigDelay1(s, x)) {
+                node.fClass = "delay";
+                node.fOps = 2;
+                node.fRate = kSample;
+                add(node, x);
+                addDelay(x, 1);
+            } else if (isSigDelay(s, x, y)) {
+                node.fClass = "delay";
+                node.fOps = 2;
+                node.fRate = kSample;
+                add(node, x);
+                add(node, y);
+                addDelay(x, y);
+            } else if (isSigPrefix(s, x, y)) {
+                node.fClass = "delay";
+                node.fOps = 2;
+                node.fRate = kSample;
+                add(node, x);
+                add(node, y);
+                // 'y' delayed by one sample, 'x' being the first value
+                addDelay(y, 1);
+            } else if (isSigRDTbl(s, x, y)) {
+                node.fClass = "table read";
+                node.fOps = 1;
+                add(node, x);
+                add(node, y);
+            } else if (isSigWRTbl(s, x, y, z, w)) {
+                node.fClass = "table";
+                add(node, x);
+                add(node, y);
+                add(node, z);
+                add(node, w);
+                // The write index and signal make a table change at each sample
+                if (!isNil(z)) {
+                    node.fOps = 1;
+                    node.fRate = kSample;
+                }
+                addTable(x);
+            } else if (isSigGen(s, x)) {
+                node.fClass = "table generator";
+                node.fInherit = false;
+                add(node, x);
+            } else if (isSigWaveform(s)) {
+                node.fClass = "table";
+                addTable(nullptr);
+            } else if (isSigSelect2(s, x, y, z)) {
+                node.fClass = "select";
+                node.fOps = 1;
+                add(node, x);
+                add(node, y);
+                add(node, z);
+            } else if (isSigBinOp(s, &i, x, y)) {
+                if (i >= kGT && i <= kNE) {
+                    node.fClass = "comparison";
+                } else if (i >= kAND || (i >= kLsh && i <= kLRsh)) {
+                    node.fClass = "bitwise";
+                } else {
+                    node.fClass = "arithmetic";
+                }
+                node.fOps = (i == kDiv || i == kRem) ? 4 : 1;
+                add(node, x);
+                add(node, y);
+            } else if (isSigIntCast(s, x) || isSigFloatCast(s, x)) {
+                node.fClass = "cast";
+                node.fOps = 1;
+                add(node, x);
+            } else if (isSigButton(s, x) || isSigCheckbox(s, x)
+                       || isSigHSlider(s, x, y, z, w, v) || isSigVSlider(s, x, y, z, w, v) || isSigNumEntry(s, x, y, z, w, v)) {
+                node.fClass = "control";
+                node.fRate = kControl;
+            } else if (isSigHBargraph(s, x, y, z, w) || isSigVBargraph(s, x, y, z, w)) {
+                node.fClass = "control";
+                node.fRate = kControl;
+                add(node, w);
+            } else if (isSigAttach(s, x, y)) {
+                node.fClass = "attach";
+                add(node, x);
+                add(node, y);
+            } else if (isSigEnable(s, x, y) || isSigControl(s, x, y)) {
+                node.fClass = "enable";
+                node.fOps = 1;
+                add(node, x);
+                add(node, y);
+            } else if (isSigAssertBounds(s, x, y, z)) {
+                node.fClass = "attach";
+                add(node, x);
+                add(node, y);
+                add(node, z);
+            } else if (isSigHighest(s, x) || isSigLowest(s, x)) {
+                // Computed at compile time
+                node.fClass = "constant";
+            } else if (isSigSoundfile(s, x)) {
+                node.fClass = "soundfile";
+                node.fRate = kControl;
+            } else if (isSigSoundfileLength(s, x, y) || isSigSoundfileRate(s, x, y)) {
+                node.fClass = "soundfile";
+                add(node, x);
+                add(node, y);
+            } else if (isSigSoundfileBuffer(s, x, y, z, w)) {
+                node.fClass = "soundfile";
+                node.fOps = 1;
+                add(node, x);
+                add(node, y);
+                add(node, z);
+                add(node, w);
+            } else if (isProj(s, &i, x)) {
+                // A projection of a group, or of the variable of an enclosing group inside its equations
+                node.fClass = "recursion";
+                node.fOps = 1;
+                node.fRate = kSample;
+                if (isRec(x, y, z)) add(node, x);
+            } else if (isRec(s, x, y)) {
+                node.fClass = "recursion group";
+                node.fRate = kSample;
+                for (i = 0; !isNil(z = nth(y, i)); i++) {
+                    add(node, z);
+                }
+            } else if (isSigFFun(s, x, y)) {
+                opaque(node, "foreign function", 10);
+            } else if (getUserData(s)) {
+                opaque(node, "math", getMathOps(xtendedName(s)));
+            } else {
+                opaque(node, "other", 1);
+            }
+            return node;
+        }
+
+        // Collect the nodes reachable from 'roots' in post-order (operands first)
+        void collect(const std::vector<Signal>& roots, std::vector<Signal>& order)
+        {
+            std::vector<std::pair<Signal, size_t>> stack;
+            for (const auto& root : roots) {
+                if (fGraph.count(root)) continue;
+                fGraph[root] = decode(root);
+                stack.push_back(std::make_pair(root, 0));
+                while (!stack.empty()) {
+                    Signal s = stack.back().first;
+                    size_t child = stack.back().second++;
+                    const std::vector<Signal>& children = fGraph[s].fChildren;
+                    if (child < children.size()) {
+                        Signal c = children[child];
+                        if (!fGraph.count(c)) {
+                            fGraph[c] = decode(c);
+                            stack.push_back(std::make_pair(c, 0));
+                        }
+                    } else {
+                        order.push_back(s);
+                        stack.pop_back();
+                    }
+                }
+            }
+        }
+
+    public:
+
+        signal_cost_analyzer()
+        {}
+
+        virtual ~signal_cost_analyzer()
+        {}
+
+        /**
+         * Analyse a vector of output signals.
+         * It has to be used in the lib context of the signals (see createLibContext).
+         *
+         * @param signals - the vector of output signals
+         * @param normalize - whether to first simplify the signals to normal form (required to bound variable delays)
+         *
+         * @return the estimated cost.
+         */
+        signal_cost analyze(tvec signals, bool normalize = true)
+        {
+            fGraph.clear();
+            fRates.clear();
+            fDelays.clear();
+            fCost = signal_cost();
+
+            tvec roots = normalize ? simplifyToNormalForm2(signals) : signals;
+            std::vector<Signal> order;
+            collect(roots, order);
+
+            // Operands come first in 'order', so the rate of a node can be computed from the rates of its operands
+            for (const auto& s : order) {
+                const Node& node = fGraph[s];
+                Rate rate = node.fRate;
+                if (node.fInherit) {
+                    for (const auto& c : node.fChildren) {
+                        rate = std::max(rate, fRates[c]);
+                    }
+                }
+                fRates[s] = rate;
+                fCost.fNodes[node.fClass]++;
+            }
+
+            // Nodes only used by table generators are computed at init time
+            std::map<Signal, bool> runtime;
+            std::vector<Signal> stack(roots.begin(), roots.end());
+            while (!stack.empty()) {
+                Signal s = stack.back();
+                stack.pop_back();
+                if (runtime[s]) continue;
+                runtime[s] = true;
+                const Node& node = fGraph[s];
+                if (!node.fInherit) continue;
+                for (const auto& c : node.fChildren) {
+                    if (!runtime[c]) stack.push_back(c);
+                }
+            }
+
+            for (const auto& it : fGraph) {
+                double ops = it.second.fOps;
+                if (!runtime[it.first]) {
+                    fCost.fInitOps += ops;
+                } else if (fRates[it.first] == kSample) {
+                    fCost.fSampleOps += ops;
+                } else {
+                    fCost.fControlOps += ops;
+                }
+            }
+
+            for (const auto& it : fDelays) {
+                fCost.fNumDelays++;
+                if (it.second < 0) {
+                    fCost.fUnboundedDelays++;
+                } else {
+                    fCost.fDelayMemory += it.second;
+                    fCost.fMaxDelay = int(std::max<int64_t>(fCost.fMaxDelay, it.second));
+                }
+            }
+
+            fCost.fNumNodes = int(fGraph.size());
+            return fCost;
+        }
+
+};
+
+#endif
+/************************** END signal-cost.h **************************/
@@ -1,6 +1,6 @@
 # distutils: language = c++
 
-from libc.stdlib cimport malloc, free
+from libc.stdlib cimport malloc, calloc, free
 
 cimport faust_interp as fi
 
@@ -23,6 +23,23 @@ def get_version():
     """
     return fi.getCLibFaustVersion().decode()
 
+DENORMALS_KEEP = fi.DENORMALS_KEEP
+DENORMALS_FTZ = fi.DENORMALS_FTZ
+DENORMALS_FTZ_DAZ = fi.DENORMALS_FTZ_DAZ
+
+def set_denormal_policy(int policy):
+    """Set the denormal policy applied by the audio driver.
+
+    DENORMALS_KEEP, DENORMALS_FTZ or DENORMALS_FTZ_DAZ (default).
+    """
+    if policy not in (DENORMALS_KEEP, DENORMALS_FTZ, DENORMALS_FTZ_DAZ):
+        raise ValueError(f"invalid denormal policy: {policy}")
+    fi.ScopedNoDenormals.setPolicy(policy)
+
+def get_denormal_policy() -> int:
+    """Return the denormal policy applied by the audio driver."""
+    return fi.ScopedNoDenormals.getPolicy()
+
 ## ---------------------------------------------------------------------------
 ## Extension Classes
 ##
@@ -235,6 +252,33 @@ cdef class InterpreterDsp:
         cdef fi.interpreter_dsp* dsp = fi.cloneCInterpreterDSPInstance(self.ptr)
         return InterpreterDsp.from_ptr(dsp)
 
+    def compute(self, float[:, ::1] inputs, float[:, ::1] outputs not None):
+        """Compute one block of (channels, frames) float32 buffers, without the GIL."""
+        cdef int n_ins = fi.getNumInputsCInterpreterDSPInstance(self.ptr)
+        cdef int n_outs = fi.getNumOutputsCInterpreterDSPInstance(self.ptr)
+        cdef int count = outputs.shape[1]
+        cdef int i
+        if outputs.shape[0] < n_outs or (n_ins > 0 and (inputs is None or inputs.shape[0] < n_ins)):
+            raise ValueError("not enough channels in buffers")
+        if n_ins > 0 and inputs.shape[1] < count:
+            raise ValueError("input buffers are shorter than output buffers")
+        cdef float** ins = <float**>calloc(n_ins + 1, sizeof(float*))
+        cdef float** outs = <float**>calloc(n_outs + 1, sizeof(float*))
+        if ins == NULL or outs == NULL:
+            free(ins)
+            free(outs)
+            raise MemoryError()
+        # empty buffers have no first frame to point to
+        if count > 0:
+            for i in range(n_ins):
+                ins[i] = &inputs[i, 0]
+            for i in range(n_outs):
+                outs[i] = &outputs[i, 0]
+        with nogil:
+            fi.computeCInterpreterDSPInstance(self.ptr, count, ins, outs)
+        free(ins)
+        free(outs)
+
 ## ---------------------------------------------------------------------------
 ## faust/dsp/interpreter-dsp-c
 ##
@@ -340,8 +384,10 @@ cdef class RtAudioDriver:
             del self.ptr
             self.ptr = NULL
 
-    def __cinit__(self, int srate, int bsize):
-        self.ptr = new fi.rtaudio(srate, bsize)
+    def __cinit__(self, int srate, int bsize, bint native=False):
+        """native: open the stream with the device sample format and interleaving,
+        and convert the buffers in the driver instead of in RtAudio."""
+        self.ptr = new fi.rtaudio(srate, bsize, native)
         self.ptr_owner = True
 
     def set_dsp(self, dsp: InterpreterDsp):
@@ -374,4 +420,10 @@ cdef class RtAudioDriver:
     def get_numoutputs(self):
         return self.ptr.getNumOutputs()
 
+    def is_native(self) -> bool:
+        return self.ptr.isNative()
+
+    def is_interleaved(self) -> bool:
+        return self.ptr.isInterleaved()
+
 
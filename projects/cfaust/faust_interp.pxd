@@ -121,17 +121,27 @@ cdef extern from "faust/dsp/interpreter-dsp-c.h":
     void instanceClearCInterpreterDSPInstance(interpreter_dsp* dsp)
     interpreter_dsp* cloneCInterpreterDSPInstance(interpreter_dsp* dsp)
     void metadataCInterpreterDSPInstance(interpreter_dsp* dsp, MetaGlue* meta)
-    void computeCInterpreterDSPInstance(interpreter_dsp* dsp, int count, FAUSTFLOAT** input, FAUSTFLOAT** output)
+    void computeCInterpreterDSPInstance(interpreter_dsp* dsp, int count, FAUSTFLOAT** input, FAUSTFLOAT** output) nogil
     interpreter_dsp* createCInterpreterDSPInstance(interpreter_dsp_factory* factory)
     void deleteCInterpreterDSPInstance(interpreter_dsp* dsp)
 
 cdef extern from "faust/dsp/dsp.h":
     cdef cppclass dsp_memory_manager
     cdef cppclass dsp
+    cdef enum:
+        DENORMALS_KEEP
+        DENORMALS_FTZ
+        DENORMALS_FTZ_DAZ
+    cdef cppclass ScopedNoDenormals:
+        @staticmethod
+        void setPolicy(int policy)
+        @staticmethod
+        int getPolicy()
 
 cdef extern from "faust/audio/rtaudio-dsp.h":
     cdef cppclass rtaudio:    
         rtaudio(int srate, int bsize) except +
+        rtaudio(int srate, int bsize, bint native) except +
         # bint init(const char* name, dsp* DSP)
         bint init(const char* name, int numInputs, int numOutputs)
         void setDsp(dsp* DSP)
@@ -141,5 +151,7 @@ cdef extern from "faust/audio/rtaudio-dsp.h":
         int getSampleRate()
         int getNumInputs()
         int getNumOutputs()
+        bint isNative()
+        bint isInterleaved()
 
 
@@ -1,10 +1,16 @@
 # distutils: language = c++
 
+cimport cython
+import weakref
 from libc.stdlib cimport malloc, free
+from libc.math cimport floor
+from libc.limits cimport INT_MIN, INT_MAX
 from libcpp.string cimport string
 from libcpp.vector cimport vector
 
 cimport faust_interp as fi
+cimport faust_box as fb
+cimport faust_signal as fs
 
 
 ## ---------------------------------------------------------------------------
@@ -45,6 +51,37 @@ cdef class ParamArray:
             free(self.argv)
 
 
+## ---------------------------------------------------------------------------
+## exceptions
+##
+
+class FaustError(RuntimeError):
+    """Error reported by libfaust.
+
+    message - the libfaust error message
+    warnings - the warning messages of the compilation
+    compile_options - the compilation options
+    """
+    def __init__(self, message, warnings=None, compile_options=""):
+        super().__init__(message)
+        self.message = message
+        self.warnings = list(warnings) if warnings else []
+        self.compile_options = compile_options
+
+
+class FaustCompileError(FaustError):
+    """DSP code could not be compiled."""
+
+
+class FaustBitcodeError(FaustError):
+    """Bitcode could not be read."""
+
+
+cdef _raise_error(error_type, string& error_msg, tuple args=()):
+    """Raise 'error_type' with the libfaust error message, without touching stdio."""
+    raise error_type(error_msg.decode().strip(), None, " ".join(args))
+
+
 
 ## ---------------------------------------------------------------------------
 ## faust/dsp/libfaust
@@ -61,8 +98,6 @@ def expand_dsp_from_file(filename: str, *args) -> tuple(str, str):
     """
     cdef ParamArray params = ParamArray(args)
     cdef string error_msg, sha_key 
-    error_msg.reserve(4096)
-    sha_key.reserve(100) # sha1 is 40 chars
     cdef string result = fi.expandDSPFromFile(
         filename.encode('utf8'),
         params.argc,
@@ -71,16 +106,13 @@ def expand_dsp_from_file(filename: str, *args) -> tuple(str, str):
         error_msg
     )
     if not error_msg.empty():
-        print(error_msg.decode())
-        return
+        _raise_error(FaustCompileError, error_msg, args)
     return (sha_key.decode(), result.decode())
 
 def expand_dsp_from_string(name_app: str, dsp_content: str, *args) -> str:
     """Expand dsp in a file into a self-contained dsp string."""
     cdef ParamArray params = ParamArray(args)
     cdef string error_msg, sha_key 
-    error_msg.reserve(4096)
-    sha_key.reserve(100) # sha1 is 40 chars
     cdef string result = fi.expandDSPFromString(
         name_app.encode('utf8'),
         dsp_content.encode('utf8'),
@@ -90,15 +122,13 @@ def expand_dsp_from_string(name_app: str, dsp_content: str, *args) -> str:
         error_msg
     )
     if not error_msg.empty():
-        print(error_msg.decode())
-        return
+        _raise_error(FaustCompileError, error_msg, args)
     return (sha_key.decode(), result.decode())
 
 def generate_auxfiles_from_file(filename: str, *args) -> str:
     """Generate additional files (other backends, SVG, XML, JSON...) from a file."""
     cdef ParamArray params = ParamArray(args)
     cdef string error_msg
-    error_msg.reserve(4096)
     result = fi.generateAuxFilesFromFile(
         filename.encode('utf8'),
         params.argc,
@@ -106,15 +136,13 @@ def generate_auxfiles_from_file(filename: str, *args) -> str:
         error_msg
     )
     if not error_msg.empty():
-        print(error_msg.decode())
-        return False
+        _raise_error(FaustCompileError, error_msg, args)
     return result
 
 def generate_auxfiles_from_string(name_app: str, dsp_content: str, *args) -> str:
     """Generate additional files (other backends, SVG, XML, JSON...) from a string."""
     cdef ParamArray params = ParamArray(args)
     cdef string error_msg
-    error_msg.reserve(4096)
     result = fi.generateAuxFilesFromString(
         name_app.encode('utf8'),
         dsp_content.encode('utf8'),
@@ -123,10 +151,36 @@ def generate_auxfiles_from_string(name_app: str, dsp_content: str, *args) -> str
         error_msg
     )
     if not error_msg.empty():
-        print(error_msg.decode())
-        return False
+        _raise_error(FaustCompileError, error_msg, args)
     return result
 
+include "faust_box.pxi"
+include "faust_signal.pxi"
+
+## ---------------------------------------------------------------------------
+## faust/dsp/dsp (denormals)
+##
+
+DENORMALS_KEEP = fi.DENORMALS_KEEP
+DENORMALS_FTZ = fi.DENORMALS_FTZ
+DENORMALS_FTZ_DAZ = fi.DENORMALS_FTZ_DAZ
+
+def set_denormal_policy(int policy):
+    """Set the denormal policy applied by audio drivers and bench() around each compute.
+
+    DENORMALS_KEEP leaves the FP status register unchanged, DENORMALS_FTZ flushes
+    denormal results to zero, DENORMALS_FTZ_DAZ (default) also treats denormal
+    inputs as zero. It can be changed while audio is running.
+    """
+    if policy not in (DENORMALS_KEEP, DENORMALS_FTZ, DENORMALS_FTZ_DAZ):
+        raise ValueError(f"invalid denormal policy: {policy}")
+    fi.ScopedNoDenormals.setPolicy(policy)
+
+def get_denormal_policy() -> int:
+    """Return the denormal policy applied by audio drivers and bench()."""
+    return fi.ScopedNoDenormals.getPolicy()
+
+
 ## ---------------------------------------------------------------------------
 ## faust/audio/rtaudio-dsp
 ##
@@ -135,20 +189,31 @@ cdef class RtAudioDriver:
     """faust audio driver using rtaudio cross-platform lib."""
     cdef fi.rtaudio *ptr
     cdef bint ptr_owner
+    cdef object dsp
+    cdef object __weakref__
 
     def __dealloc__(self):
         if self.ptr and self.ptr_owner:
             del self.ptr
             self.ptr = NULL
 
-    def __cinit__(self, int srate, int bsize):
-        self.ptr = new fi.rtaudio(srate, bsize)
+    def __cinit__(self, int srate, int bsize, bint native=False):
+        """native: open the stream with the device sample format and interleaving,
+        and convert the buffers in the driver instead of in RtAudio."""
+        self.ptr = new fi.rtaudio(srate, bsize, native)
         self.ptr_owner = True
 
-    def set_dsp(self, dsp: InterpreterDsp):
-        self.ptr.setDsp(<fi.dsp*>dsp.ptr)
-
-    def init(self, dsp: InterpreterDsp) -> bool:
+    def set_dsp(self, dsp):
+        """set an InterpreterDsp or a CombinedDsp."""
+        # keep the instance alive while the driver may call its 'compute',
+        # and prevent it from being given to a combiner meanwhile
+        self.ptr.setDsp(_dsp_ptr(dsp))
+        if self.dsp is not None:
+            _dsp_users(self.dsp).discard(self)
+        _dsp_users(dsp).add(self)
+        self.dsp = dsp
+
+    def init(self, dsp) -> bool:
         """initialize with dsp instance."""
         name = "RtAudioDriver".encode('utf8')
         if self.ptr.init(name, dsp.get_numinputs(), dsp.get_numoutputs()):
@@ -157,6 +222,8 @@ cdef class RtAudioDriver:
         return False
 
     def start(self):
+        if self.dsp is not None:
+            _dsp_ptr(self.dsp)
         if not self.ptr.start():
             print("RtAudioDriver: could not start")
 
@@ -175,6 +242,177 @@ cdef class RtAudioDriver:
     def get_numoutputs(self):
         return self.ptr.getNumOutputs()
 
+    def is_native(self) -> bool:
+        return self.ptr.isNative()
+
+    def is_interleaved(self) -> bool:
+        return self.ptr.isInterleaved()
+
+## ---------------------------------------------------------------------------
+## faust/dsp/dsp-arena
+##
+
+cdef class ArenaMemoryManager:
+    """Memory manager placing each instance state in contiguous,
+    cache-line aligned chunks, optionally backed by huge pages.
+
+    chunk_size - the capacity in bytes of each chunk (0 for the 1 MB default)
+    huge_pages - whether to back chunks with huge pages when available
+    alignment - the alignment in bytes of each memory zone
+    """
+    cdef fi.arena_memory_manager* ptr
+
+    def __cinit__(self, size_t chunk_size=0, bint huge_pages=False, size_t alignment=64):
+        self.ptr = new fi.arena_memory_manager(chunk_size, huge_pages, alignment)
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    def reserve(self, size_t size) -> bool:
+        """Make sure 'size' contiguous bytes are available without further allocation."""
+        return self.ptr.reserve(size)
+
+    def trim(self):
+        """Release all chunks which do not contain any live memory zone."""
+        self.ptr.trim()
+
+    @property
+    def allocated_size(self) -> int:
+        """Size in bytes of the memory zones currently allocated."""
+        return self.ptr.getAllocatedSize()
+
+    @property
+    def reserved_size(self) -> int:
+        """Size in bytes of all chunks reserved by the arena."""
+        return self.ptr.getReservedSize()
+
+    @property
+    def num_zones(self) -> int:
+        """Number of memory zones currently allocated."""
+        return self.ptr.getNumZones()
+
+    @property
+    def num_chunks(self) -> int:
+        """Number of chunks reserved by the arena."""
+        return self.ptr.getNumChunks()
+
+    @property
+    def planned_size(self) -> int:
+        """Instance size in bytes computed by the last sizing pass."""
+        return self.ptr.getPlannedSize()
+
+    @property
+    def alignment(self) -> int:
+        return self.ptr.getAlignment()
+
+    @property
+    def huge_pages(self) -> bool:
+        return self.ptr.hasHugePages()
+
+    def snapshot(self, InterpreterDsp dsp not None) -> DspSnapshot:
+        """Capture the complete state of an instance created while
+        this arena was set on its factory.
+        """
+        cdef string error_msg
+        cdef fi.dsp_snapshot* snapshot = fi.dsp_snapshot.capture(
+            <fi.dsp*>dsp.get_ptr(), self.ptr, error_msg)
+        if not snapshot:
+            raise RuntimeError(error_msg.decode())
+        return DspSnapshot.from_ptr(snapshot)
+
+    def restore(self, InterpreterDsp dsp not None, DspSnapshot snapshot not None):
+        """Restore the state of an instance created while this arena was
+        set on its factory, from a snapshot of an instance of the same factory.
+        """
+        cdef string error_msg
+        if not snapshot.ptr.restore(<fi.dsp*>dsp.get_ptr(), self.ptr, error_msg):
+            raise RuntimeError(error_msg.decode())
+
+
+cdef class DspSnapshot:
+    """Binary snapshot of the state of a DSP instance (delay lines,
+    recursive state, tables and control values).
+
+    Use ArenaMemoryManager.snapshot() to capture and ArenaMemoryManager.restore()
+    to restore. Snapshots loaded with from_file() are memory-mapped.
+    """
+    cdef fi.dsp_snapshot* ptr
+
+    def __cinit__(self):
+        self.ptr = NULL
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    @staticmethod
+    cdef DspSnapshot from_ptr(fi.dsp_snapshot* ptr):
+        """Wrap the snapshot and manage its lifetime."""
+        cdef DspSnapshot snapshot = DspSnapshot.__new__(DspSnapshot)
+        snapshot.ptr = ptr
+        return snapshot
+
+    @staticmethod
+    def from_bytes(const unsigned char[:] data) -> DspSnapshot:
+        """Create a snapshot from the content returned by to_bytes()."""
+        cdef string error_msg
+        cdef fi.dsp_snapshot* snapshot = fi.dsp_snapshot.fromBuffer(
+            &data[0] if data.shape[0] > 0 else NULL, data.shape[0], error_msg)
+        if not snapshot:
+            raise ValueError(error_msg.decode())
+        return DspSnapshot.from_ptr(snapshot)
+
+    @staticmethod
+    def from_file(str path) -> DspSnapshot:
+        """Load (memory-map) a snapshot saved with save()."""
+        cdef string error_msg
+        cdef fi.dsp_snapshot* snapshot = fi.dsp_snapshot.fromFile(path.encode(), error_msg)
+        if not snapshot:
+            raise ValueError(error_msg.decode())
+        return DspSnapshot.from_ptr(snapshot)
+
+    def save(self, str path):
+        """Save the snapshot in a file."""
+        cdef string error_msg
+        if not self.ptr.save(path.encode(), error_msg):
+            raise OSError(error_msg.decode())
+
+    def to_bytes(self) -> bytes:
+        """Return the snapshot content."""
+        return self.ptr.getData()[:self.ptr.getSize()]
+
+    def __bytes__(self):
+        return self.to_bytes()
+
+    def __len__(self):
+        return self.ptr.getSize()
+
+    @property
+    def sample_rate(self) -> int:
+        """Sample rate of the captured instance."""
+        return self.ptr.getSampleRate()
+
+    @property
+    def num_zones(self) -> int:
+        return self.ptr.getNumZones()
+
+    @property
+    def num_controls(self) -> int:
+        return self.ptr.getNumControls()
+
+    @property
+    def state_size(self) -> int:
+        """Size in bytes of the copied state."""
+        return self.ptr.getStateSize()
+
+    @property
+    def mapped(self) -> bool:
+        """Whether the snapshot content is memory-mapped from a file."""
+        return self.ptr.isMapped()
+
 ## ---------------------------------------------------------------------------
 ## faust/dsp/interpreter-dsp
 ##
@@ -193,10 +431,12 @@ cdef class InterpreterDspFactory:
 
     cdef fi.interpreter_dsp_factory* ptr
     cdef bint ptr_owner
+    cdef ArenaMemoryManager memory_manager
 
     def __cinit__(self):
         self.ptr = NULL
         self.ptr_owner = False
+        self.memory_manager = None
 
     def __dealloc__(self):
         if self.ptr and self.ptr_owner:
@@ -232,22 +472,42 @@ cdef class InterpreterDspFactory:
         return [msg.decode() for msg in self.ptr.getWarningMessages()]
 
     def create_dsp_instance(self) -> InterpreterDsp:
-        """Create a new DSP instance, to be deleted with C++ 'delete'"""
-        cdef fi.interpreter_dsp* dsp = self.ptr.createDSPInstance()
-        return InterpreterDsp.from_ptr(dsp)
+        """Create a new DSP instance.
 
-    cdef set_memory_manager(self, fi.dsp_memory_manager* manager):
-        """Set a custom memory manager to be used when creating instances"""
-        self.ptr.setMemoryManager(manager)
+        The instance keeps the factory (and its memory manager) alive, and is
+        deleted when garbage collected or explicitly with close().
+        """
+        cdef fi.interpreter_dsp* dsp = fi.createArenaDSPInstance(self.ptr)
+        if dsp == NULL:
+            raise MemoryError("cannot create DSP instance")
+        return InterpreterDsp.from_ptr(dsp, self)
 
-    cdef fi.dsp_memory_manager* get_memory_manager(self):
-        """Set a custom memory manager to be used when creating instances"""
-        return self.ptr.getMemoryManager()
+    def set_memory_manager(self, ArenaMemoryManager manager):
+        """Set a custom memory manager to be used when creating instances.
+
+        Has to be set before creating instances, and not changed while
+        instances created with it are alive. Passing None restores the
+        default allocator.
+        """
+        self.memory_manager = manager
+        if manager is None:
+            self.ptr.setMemoryManager(NULL)
+        else:
+            self.ptr.setMemoryManager(<fi.dsp_memory_manager*>manager.ptr)
+
+    def get_memory_manager(self) -> ArenaMemoryManager:
+        """Return the currently set custom memory manager"""
+        return self.memory_manager
 
     def write_to_bitcode(self) -> str:
         """Write a Faust DSP factory into a bitcode string."""
         return fi.writeInterpreterDSPFactoryToBitcode(self.ptr).decode()
 
+    def write_to_bitcode_bytes(self) -> bytes:
+        """Write a Faust DSP factory into bitcode bytes (without text decoding),
+        to be stored or sent as is and loaded with from_bitcode."""
+        return fi.writeInterpreterDSPFactoryToBitcode(self.ptr)
+
     def write_to_bitcode_file(self, bit_code_path: str) -> bool:
         """Write a Faust DSP factory into a bitcode file."""
         return fi.writeInterpreterDSPFactoryToBitcodeFile(
@@ -259,7 +519,7 @@ cdef class InterpreterDspFactory:
         cdef InterpreterDspFactory factory = InterpreterDspFactory.__new__(
             InterpreterDspFactory)
         factory.ptr = ptr
-        factory.owner = owner
+        factory.ptr_owner = owner
         return factory
 
     @staticmethod
@@ -270,13 +530,14 @@ cdef class InterpreterDspFactory:
         factory.ptr_owner = True
         factory.ptr = <fi.interpreter_dsp_factory*>fi.getInterpreterDSPFactoryFromSHAKey(
             sha_key.encode())
+        if factory.ptr == NULL:
+            raise FaustError(f"no factory with SHA key {sha_key}")
         return factory
 
     @staticmethod
     def from_file(str filepath, *args) -> InterpreterDspFactory:
         """create an interpreter dsp factory from a file"""
         cdef string error_msg
-        error_msg.reserve(4096)
         cdef InterpreterDspFactory factory = InterpreterDspFactory.__new__(
             InterpreterDspFactory)
         cdef ParamArray params = ParamArray(args)
@@ -287,16 +548,14 @@ cdef class InterpreterDspFactory:
             params.argv,
             error_msg,
         )
-        if not error_msg.empty():
-            print(error_msg.decode())
-            return
+        if factory.ptr == NULL:
+            _raise_error(FaustCompileError, error_msg, args)
         return factory
 
     @staticmethod
     def from_bitcode_file(str bit_code_path) -> InterpreterDspFactory:
         """Create a Faust DSP factory from a bitcode file."""
         cdef string error_msg
-        error_msg.reserve(4096)
         cdef InterpreterDspFactory factory = InterpreterDspFactory.__new__(
             InterpreterDspFactory)
         factory.ptr_owner = True
@@ -304,16 +563,14 @@ cdef class InterpreterDspFactory:
             bit_code_path.encode('utf8'),
             error_msg,
         )
-        if not error_msg.empty():
-            print(error_msg.decode())
-            return
+        if factory.ptr == NULL:
+            _raise_error(FaustBitcodeError, error_msg)
         return factory
 
     @staticmethod
     def from_string(str name_app, str code, *args) -> InterpreterDspFactory:
         """create an interpreter dsp factory from a string"""
         cdef string error_msg
-        error_msg.reserve(4096)
         cdef InterpreterDspFactory factory = InterpreterDspFactory.__new__(
             InterpreterDspFactory)
         cdef ParamArray params = ParamArray(args)
@@ -325,36 +582,78 @@ cdef class InterpreterDspFactory:
             params.argv,
             error_msg,
         )
-        if not error_msg.empty():
-            print(error_msg.decode())
-            return
+        if factory.ptr == NULL:
+            _raise_error(FaustCompileError, error_msg, args)
         return factory
 
     @staticmethod
-    def from_bitcode(str bitcode) -> InterpreterDspFactory:
+    def from_boxes(str name_app, Box box, *args) -> InterpreterDspFactory:
+        """Create an interpreter dsp factory from a box expression.
+
+        The box has to be alive (built in the current box_context), while the factory
+        does not depend on the context and stays valid after it is destroyed.
+        libfaust is not thread safe, so the GIL is kept during the compilation.
+        """
+        cdef string error_msg
+        cdef string c_name_app = name_app.encode('utf8')
+        cdef fb.Box c_box = box.get_ptr()
+        cdef ParamArray params = ParamArray(args)
+        cdef fi.interpreter_dsp_factory* ptr = fi.createInterpreterDSPFactoryFromBoxes(
+            c_name_app, c_box, params.argc, params.argv, error_msg)
+        if ptr == NULL:
+            _raise_error(FaustCompileError, error_msg, args)
+        return InterpreterDspFactory.from_ptr(ptr, True)
+
+    @staticmethod
+    def from_signals(str name_app, list signals, *args) -> InterpreterDspFactory:
+        """Create an interpreter dsp factory from a list of output signals.
+
+        The signals have to be alive (built in the current signal_context), while the factory
+        does not depend on the context and stays valid after it is destroyed.
+        libfaust is not thread safe, so the GIL is kept during the compilation.
+        """
+        cdef string error_msg
+        cdef string c_name_app = name_app.encode('utf8')
+        cdef fb.tvec c_signals
+        cdef ParamArray params = ParamArray(args)
+        cdef fi.interpreter_dsp_factory* ptr = NULL
+        for sig in _signal_vector(signals):
+            c_signals.push_back(<fb.Signal>sig)
+        ptr = fi.createInterpreterDSPFactoryFromSignals(
+            c_name_app, c_signals, params.argc, params.argv, error_msg)
+        if ptr == NULL:
+            _raise_error(FaustCompileError, error_msg, args)
+        return InterpreterDspFactory.from_ptr(ptr, True)
+
+    @staticmethod
+    def from_bitcode(bitcode) -> InterpreterDspFactory:
         """Create a Faust DSP factory from a bitcode string.
 
         Note that the library keeps an internal cache of all allocated factories so that
         the compilation of the same DSP code (that is the same bitcode code string) will return
         the same (reference counted) factory pointer.
 
-        bitcode - the bitcode string
-        error_msg - the error string to be filled
+        bitcode - the bitcode as a str, or as any buffer: bytes, bytearray, memoryview or mmap.
+        Buffers are parsed without text transcoding: a memory-mapped file is only copied once,
+        into the string libfaust parses. libfaust is not thread safe, so the GIL is kept.
 
-        returns the DSP factory on success, otherwise a null pointer.
+        returns the DSP factory, raises FaustBitcodeError on failure.
         """
         cdef string error_msg
-        error_msg.reserve(4096)
+        cdef string c_bitcode
+        cdef const unsigned char[::1] view
         cdef InterpreterDspFactory factory = InterpreterDspFactory.__new__(
             InterpreterDspFactory)
         factory.ptr_owner = True
-        factory.ptr = <fi.interpreter_dsp_factory*>fi.readInterpreterDSPFactoryFromBitcode(
-            bitcode.encode('utf8'),
-            error_msg,
-        )
-        if not error_msg.empty():
-            print(error_msg.decode())
-            return
+        if isinstance(bitcode, str):
+            c_bitcode = (<str>bitcode).encode('utf8')
+        else:
+            view = bitcode
+            if view.shape[0] > 0:
+                c_bitcode.assign(<const char*>&view[0], view.shape[0])
+        factory.ptr = fi.readInterpreterDSPFactoryFromBitcode(c_bitcode, error_msg)
+        if factory.ptr == NULL:
+            _raise_error(FaustBitcodeError, error_msg)
         return factory
 
 
@@ -363,60 +662,112 @@ cdef class InterpreterDsp:
 
     cdef fi.interpreter_dsp* ptr
     cdef bint ptr_owner
+    cdef object pool
+    # the factory and the memory manager used to create the instance
+    # have to outlive it
+    cdef InterpreterDspFactory factory
+    cdef ArenaMemoryManager memory_manager
+    # the MapUI and RtAudioDriver objects pointing into the instance
+    cdef object users
 
-    # def __dealloc__(self):
-    #     if self.ptr and self.ptr_owner:
-    #         del self.ptr
-    #         self.ptr = NULL
+    def __dealloc__(self):
+        if self.ptr and self.ptr_owner:
+            del self.ptr
+        elif self.ptr and self.pool is not None and (<InterpreterDspPool>self.pool).ptr:
+            # dropped without release(): give the instance back to its pool
+            (<InterpreterDspPool>self.pool).ptr.release(<fi.dsp*>self.ptr)
+        self.ptr = NULL
 
     def __cinit__(self):
         self.ptr = NULL
         self.ptr_owner = False
+        self.users = weakref.WeakSet()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
 
     @staticmethod
-    cdef InterpreterDsp from_ptr(fi.interpreter_dsp* ptr):
+    cdef InterpreterDsp from_ptr(fi.interpreter_dsp* ptr, InterpreterDspFactory factory=None):
         """Wrap the dsp instance and manage its lifetime."""
         cdef InterpreterDsp dsp = InterpreterDsp.__new__(InterpreterDsp)
         dsp.ptr_owner = True
         dsp.ptr = ptr
+        dsp.factory = factory
+        if factory is not None:
+            dsp.memory_manager = factory.memory_manager
         return dsp
 
+    def close(self):
+        """Delete the instance now (or give it back to its pool).
+
+        The instance cannot be used afterwards. Calling close() several
+        times is allowed. Raises ValueError while a MapUI or an RtAudioDriver
+        points into the instance.
+        """
+        _check_unused(self, "closed")
+        if self.pool is not None:
+            self.pool.release(self)
+        elif self.ptr and self.ptr_owner:
+            del self.ptr
+        self.ptr = NULL
+        self.factory = None
+        self.memory_manager = None
+
+    @property
+    def closed(self) -> bool:
+        """Whether the instance has been closed."""
+        return self.ptr == NULL
+
+    cdef fi.interpreter_dsp* get_ptr(self) except NULL:
+        if self.ptr == NULL:
+            raise ValueError("instance is closed")
+        return self.ptr
+
     def get_numinputs(self) -> int:
         """Return instance number of audio inputs."""
-        return self.ptr.getNumInputs()
+        return self.get_ptr().getNumInputs()
 
     def get_numoutputs(self) -> int:
         """Return instance number of audio outputs."""
-        return self.ptr.getNumOutputs()
+        return self.get_ptr().getNumOutputs()
 
     def get_samplerate(self) -> int:
         """Return the sample rate currently used by the instance."""
-        return self.ptr.getSampleRate()
+        return self.get_ptr().getSampleRate()
 
     def init(self, int sample_rate):
         """Global init, calls static class init and instance init."""
-        self.ptr.init(sample_rate)
+        self.get_ptr().init(sample_rate)
 
     def instance_init(self, int sample_rate):
         """Init instance state."""
-        self.ptr.instanceInit(sample_rate)
+        self.get_ptr().instanceInit(sample_rate)
 
     def instance_constants(self, int sample_rate):
         """Init instance constant state."""
-        self.ptr.instanceConstants(sample_rate)
+        self.get_ptr().instanceConstants(sample_rate)
 
     def instance_reset_user_interface(self):
         """Init default control parameters values."""
-        self.ptr.instanceResetUserInterface()
+        self.get_ptr().instanceResetUserInterface()
 
     def instance_clear(self):
         """Init instance state but keep the control parameter values."""
-        self.ptr.instanceClear()
+        self.get_ptr().instanceClear()
 
     def clone(self) -> InterpreterDsp:
         """Return a clone of the instance."""
-        cdef fi.interpreter_dsp* dsp = self.ptr.clone()
-        return InterpreterDsp.from_ptr(dsp)
+        # clones of arena instances are also recorded, so that they can be snapshotted
+        cdef fi.arena_memory_manager* arena = self.memory_manager.ptr if self.memory_manager is not None else NULL
+        cdef fi.interpreter_dsp* dsp = fi.cloneArenaDSPInstance(self.get_ptr(), arena)
+        if dsp == NULL:
+            raise MemoryError("cannot clone DSP instance")
+        cdef InterpreterDsp clone = InterpreterDsp.from_ptr(dsp, self.factory)
+        clone.memory_manager = self.memory_manager
+        return clone
 
     def build_user_interface(self):
         """Trigger the ui_interface parameter with instance specific calls
@@ -425,7 +776,7 @@ cdef class InterpreterDsp:
         ui_interface - the user interface builder
         """
         cdef fi.PrintUI ui_interface
-        self.ptr.buildUserInterface(<fi.UI*>&ui_interface)
+        self.get_ptr().buildUserInterface(<fi.UI*>&ui_interface)
 
     # cdef build_user_interface(self, fi.UI* ui_interface):
     #     """Trigger the ui_interface parameter with instance specific calls."""
@@ -433,12 +784,164 @@ cdef class InterpreterDsp:
 
     cdef metadata(self, fi.Meta* m):
         """Trigger the meta parameter with instance specific calls."""
-        self.ptr.metadata(m)
+        self.get_ptr().metadata(m)
+
+    def compute(self, float[:, ::1] inputs, float[:, ::1] outputs not None):
+        """DSP instance computation, with the GIL released.
+
+        inputs - a (numinputs, count) float32 C-contiguous buffer (or None without inputs)
+        outputs - a (numoutputs, count) float32 C-contiguous buffer
+
+        The denormal policy (see set_denormal_policy) is applied during the call.
+        """
+        cdef fi.interpreter_dsp* instance = self.get_ptr()
+        cdef int numinputs = instance.getNumInputs()
+        cdef int numoutputs = instance.getNumOutputs()
+        cdef int count = outputs.shape[1]
+        cdef int i
+        cdef vector[float*] ins
+        cdef vector[float*] outs
+        if outputs.shape[0] < numoutputs:
+            raise ValueError(f"outputs must have {numoutputs} channels")
+        if numinputs > 0 and (inputs is None or inputs.shape[0] < numinputs or inputs.shape[1] < count):
+            raise ValueError(f"inputs must have {numinputs} channels of {count} frames")
+        ins.resize(numinputs)
+        outs.resize(numoutputs)
+        # empty buffers have no first frame to point to
+        if count > 0:
+            for i in range(numinputs):
+                ins[i] = &inputs[i, 0]
+            for i in range(numoutputs):
+                outs[i] = &outputs[i, 0]
+        with nogil:
+            fi.computeNoDenormals(instance, count, ins.data(), outs.data())
+
+
+
+cdef class MapUI:
+    """Access the controls of a DSP instance by path (or label)."""
+    cdef fi.MapUI* ptr
+    cdef object dsp
+    cdef object __weakref__
+
+    def __cinit__(self, dsp):
+        """dsp - an InterpreterDsp or a CombinedDsp"""
+        cdef fi.dsp* instance = _dsp_ptr(dsp)
+        self.ptr = new fi.MapUI()
+        self.dsp = dsp
+        # the zones point into the instance, which cannot be given to a combiner meanwhile
+        _dsp_users(dsp).add(self)
+        instance.buildUserInterface(<fi.UI*>self.ptr)
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    def set_param_value(self, str path, float value):
+        """Set the param value."""
+        # the zones are only valid while the instance is open
+        _dsp_ptr(self.dsp)
+        self.ptr.setParamValue(path.encode('utf8'), value)
+
+    def get_param_value(self, str path) -> float:
+        """Return the param value."""
+        _dsp_ptr(self.dsp)
+        return self.ptr.getParamValue(path.encode('utf8'))
+
+    def get_params_count(self) -> int:
+        """Return the number of params."""
+        return self.ptr.getParamsCount()
+
+    def get_param_address(self, int index) -> str:
+        """Return the param path of a given index."""
+        return self.ptr.getParamAddress(index).decode()
+
+
+cdef class InterpreterDspPool:
+    """Pool of prewarmed DSP instances.
+
+    Instances are created and initialized ahead of time, either from a factory
+    or by cloning an existing instance. acquire() and release() are O(1):
+    released instances are reset with instance_clear() and
+    instance_reset_user_interface() instead of being deleted. Acquired
+    instances dropped without release() are given back when collected.
+
+    source - an InterpreterDspFactory or an InterpreterDsp to be cloned
+    count - the number of instances to pre-create
+    sample_rate - the sample rate used to initialize instances
+    """
+    cdef fi.dsp_pool* ptr
+    cdef object source
+    # the factory and the memory manager of the instances, kept alive by acquired instances
+    cdef InterpreterDspFactory factory
+    cdef ArenaMemoryManager memory_manager
+
+    def __cinit__(self, source, int count, int sample_rate):
+        self.ptr = NULL
+        self.source = source
+        if isinstance(source, InterpreterDspFactory):
+            self.factory = <InterpreterDspFactory>source
+            self.memory_manager = self.factory.memory_manager
+            self.ptr = new fi.dsp_pool(
+                <fi.dsp_factory*>self.factory.ptr, count, sample_rate)
+        elif isinstance(source, InterpreterDsp):
+            self.factory = (<InterpreterDsp>source).factory
+            self.memory_manager = (<InterpreterDsp>source).memory_manager
+            self.ptr = new fi.dsp_pool(
+                <fi.dsp*>(<InterpreterDsp>source).get_ptr(), count, sample_rate,
+                self.memory_manager.ptr if self.memory_manager is not None else NULL)
+        else:
+            raise TypeError("source must be an InterpreterDspFactory or an InterpreterDsp")
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    def __len__(self):
+        return self.ptr.getNumInstances()
+
+    def reserve(self, int count) -> int:
+        """Pre-create instances so that the pool holds at least 'count' of them."""
+        return self.ptr.reserve(count)
+
+    def acquire(self) -> InterpreterDsp:
+        """Take an initialized instance from the pool, None if exhausted."""
+        cdef fi.dsp* instance = self.ptr.acquire()
+        if instance == NULL:
+            return None
+        cdef InterpreterDsp dsp = InterpreterDsp.from_ptr(<fi.interpreter_dsp*>instance, self.factory)
+        dsp.memory_manager = self.memory_manager
+        dsp.ptr_owner = False
+        dsp.pool = self
+        return dsp
+
+    def release(self, InterpreterDsp dsp not None):
+        """Give back an acquired instance, which is reset for the next use."""
+        if dsp.pool is not self:
+            raise ValueError("instance was not acquired from this pool")
+        _check_unused(dsp, "released")
+        if dsp.ptr == NULL or not self.ptr.release(<fi.dsp*>dsp.ptr):
+            raise ValueError("instance was already released")
+        dsp.ptr = NULL
+        dsp.pool = None
+        dsp.factory = None
+        dsp.memory_manager = None
+
+    @property
+    def num_free(self) -> int:
+        """Number of instances available for acquire()."""
+        return self.ptr.getNumFree()
+
+    @property
+    def sample_rate(self) -> int:
+        return self.ptr.getSampleRate()
 
 
 def get_dsp_factory_from_sha_key(str sha_key) -> InterpreterDspFactory:
     """Get the Faust DSP factory associated with a given SHA key."""
-    return InterpreterDspFactory.from_sha_key(sha_key.encode())
+    return InterpreterDspFactory.from_sha_key(sha_key)
 
 def create_dsp_factory_from_file(filename: str, *args) -> InterpreterDspFactory:
     """Create a Faust DSP factory from a DSP source code as a file."""
@@ -448,6 +951,14 @@ def create_dsp_factory_from_string(name_app: str, code: str, *args) -> Interpret
     """Create a Faust DSP factory from a DSP source code as a string."""
     return InterpreterDspFactory.from_string(name_app, code, *args)
 
+def create_dsp_factory_from_boxes(name_app: str, Box box, *args) -> InterpreterDspFactory:
+    """Create a Faust DSP factory from a box expression."""
+    return InterpreterDspFactory.from_boxes(name_app, box, *args)
+
+def create_dsp_factory_from_signals(name_app: str, list signals, *args) -> InterpreterDspFactory:
+    """Create a Faust DSP factory from a list of output signals."""
+    return InterpreterDspFactory.from_signals(name_app, signals, *args)
+
 def delete_all_dsp_factories():
     """Delete all Faust DSP factories kept in the library cache."""
     fi.deleteAllInterpreterDSPFactories()
@@ -464,14 +975,860 @@ def stop_multithreaded_access_mode():
     """Stop multi-thread access mode."""
     fi.stopMTDSPFactories()
 
-def read_dsp_factory_from_bitcode(str bitcode) -> InterpreterDspFactory:
-    """Create a Faust DSP factory from a bitcode string."""
+def read_dsp_factory_from_bitcode(bitcode) -> InterpreterDspFactory:
+    """Create a Faust DSP factory from a bitcode str or buffer (bytes, memoryview, mmap...)."""
     return InterpreterDspFactory.from_bitcode(bitcode)
 
 def read_dsp_factory_from_bitcode_file(str bitcode_path) -> InterpreterDspFactory:
     """Create a Faust DSP factory from a bitcode file."""
     return InterpreterDspFactory.from_bitcode_file(bitcode_path)
 
+## ---------------------------------------------------------------------------
+## faust/dsp/dsp-combiner
+##
+
+LAYOUT_VERTICAL = fi.kVerticalGroup
+LAYOUT_HORIZONTAL = fi.kHorizontalGroup
+LAYOUT_TAB = fi.kTabGroup
+
+CROSSFADE_LINEAR = fi.kLinearCurve
+CROSSFADE_EQUAL_POWER = fi.kEqualPowerCurve
 
 
+cdef class CombinedDsp:
+    """DSP combining other DSP instances (see create_dsp_sequencer...).
 
+    The combined instances are owned by the combined DSP, so that a whole
+    chain is rendered natively by a single 'compute' call.
+    """
+
+    cdef fi.dsp_binary_combiner* ptr
+    # the factories and memory managers of the combined instances
+    cdef list resources
+    # the MapUI and RtAudioDriver objects pointing into the instance
+    cdef object users
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    def __cinit__(self):
+        self.ptr = NULL
+        self.resources = []
+        self.users = weakref.WeakSet()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    def close(self):
+        """Delete the combined DSP and the instances it owns now.
+
+        Raises ValueError while a MapUI or an RtAudioDriver points into the DSP.
+        """
+        _check_unused(self, "closed")
+        if self.ptr:
+            del self.ptr
+        self.ptr = NULL
+        self.resources = []
+
+    @property
+    def closed(self) -> bool:
+        """Whether the DSP has been closed (or combined into another one)."""
+        return self.ptr == NULL
+
+    cdef fi.dsp_binary_combiner* get_ptr(self) except NULL:
+        if self.ptr == NULL:
+            raise ValueError("combined DSP is closed")
+        return self.ptr
+
+    def get_numinputs(self) -> int:
+        """Return the number of audio inputs."""
+        return self.get_ptr().getNumInputs()
+
+    def get_numoutputs(self) -> int:
+        """Return the number of audio outputs."""
+        return self.get_ptr().getNumOutputs()
+
+    def get_samplerate(self) -> int:
+        """Return the sample rate currently used by the instances."""
+        return self.get_ptr().getSampleRate()
+
+    def init(self, int sample_rate):
+        """Global init of all combined instances."""
+        self.get_ptr().init(sample_rate)
+
+    def instance_init(self, int sample_rate):
+        """Init the state of all combined instances."""
+        self.get_ptr().instanceInit(sample_rate)
+
+    def instance_constants(self, int sample_rate):
+        """Init the constant state of all combined instances."""
+        self.get_ptr().instanceConstants(sample_rate)
+
+    def instance_reset_user_interface(self):
+        """Init default control parameters values."""
+        self.get_ptr().instanceResetUserInterface()
+
+    def instance_clear(self):
+        """Init the state of all combined instances but keep the control parameter values."""
+        self.get_ptr().instanceClear()
+
+    def prepare(self, int buffer_size):
+        """Set the largest block size computed without subdivision, and allocate
+        the intermediate buffers accordingly (typically the audio driver buffer size)."""
+        if buffer_size <= 0:
+            raise ValueError("buffer_size must be positive")
+        self.get_ptr().prepare(buffer_size)
+
+    def get_buffersize(self) -> int:
+        """Return the block size set with prepare (4096 by default)."""
+        return self.get_ptr().getBufferSize()
+
+    def clone(self) -> CombinedDsp:
+        """Return a clone of the combined DSP (with clones of all instances)."""
+        cdef CombinedDsp clone = CombinedDsp.__new__(CombinedDsp)
+        clone.ptr = <fi.dsp_binary_combiner*>self.get_ptr().clone()
+        clone.resources = list(self.resources)
+        return clone
+
+    def build_user_interface(self):
+        """Print the user interface of all combined instances."""
+        cdef fi.PrintUI ui_interface
+        self.get_ptr().buildUserInterface(<fi.UI*>&ui_interface)
+
+    def compute(self, float[:, ::1] inputs, float[:, ::1] outputs not None):
+        """Compute the whole combined DSP, with the GIL released.
+
+        inputs - a (numinputs, count) float32 C-contiguous buffer (or None without inputs)
+        outputs - a (numoutputs, count) float32 C-contiguous buffer
+
+        The denormal policy (see set_denormal_policy) is applied during the call.
+        """
+        cdef fi.dsp_binary_combiner* instance = self.get_ptr()
+        cdef int numinputs = instance.getNumInputs()
+        cdef int numoutputs = instance.getNumOutputs()
+        cdef int count = outputs.shape[1]
+        cdef int i
+        cdef vector[float*] ins
+        cdef vector[float*] outs
+        if outputs.shape[0] < numoutputs:
+            raise ValueError(f"outputs must have {numoutputs} channels")
+        if numinputs > 0 and (inputs is None or inputs.shape[0] < numinputs or inputs.shape[1] < count):
+            raise ValueError(f"inputs must have {numinputs} channels of {count} frames")
+        ins.resize(numinputs)
+        outs.resize(numoutputs)
+        # empty buffers have no first frame to point to
+        if count > 0:
+            for i in range(numinputs):
+                ins[i] = &inputs[i, 0]
+            for i in range(numoutputs):
+                outs[i] = &outputs[i, 0]
+        with nogil:
+            fi.computeNoDenormals(<fi.dsp*>instance, count, ins.data(), outs.data())
+
+
+cdef fi.dsp* _dsp_ptr(object instance) except NULL:
+    """Return the C++ instance of an InterpreterDsp, a CombinedDsp or a DecoratorDsp."""
+    if isinstance(instance, InterpreterDsp):
+        return <fi.dsp*>(<InterpreterDsp>instance).get_ptr()
+    elif isinstance(instance, CombinedDsp):
+        return <fi.dsp*>(<CombinedDsp>instance).get_ptr()
+    elif isinstance(instance, DecoratorDsp):
+        return (<DecoratorDsp>instance).get_ptr()
+    raise TypeError("an InterpreterDsp, a CombinedDsp or a DecoratorDsp is expected")
+
+
+cdef object _dsp_users(object instance):
+    """Return the MapUI and RtAudioDriver objects pointing into an instance."""
+    if isinstance(instance, InterpreterDsp):
+        return (<InterpreterDsp>instance).users
+    elif isinstance(instance, CombinedDsp):
+        return (<CombinedDsp>instance).users
+    return (<DecoratorDsp>instance).users
+
+
+cdef int _check_unused(object instance, str action) except -1:
+    """Raise if a MapUI or an RtAudioDriver points into the C++ instance."""
+    if len(_dsp_users(instance)) > 0:
+        raise ValueError(f"instances used by a MapUI or an RtAudioDriver cannot be {action}")
+    return 0
+
+
+cdef int _check_owned(object instance, str action) except -1:
+    """Raise if the C++ instance cannot be given to a combiner or a decorator."""
+    if isinstance(instance, InterpreterDsp) and not (<InterpreterDsp>instance).ptr_owner:
+        raise ValueError(f"instances acquired from a pool cannot be {action}")
+    return _check_unused(instance, action)
+
+
+cdef _take_dsp(object instance, list resources):
+    """Give the ownership of the C++ instance to a combiner: 'instance' is closed."""
+    cdef InterpreterDsp dsp
+    cdef CombinedDsp combined
+    cdef DecoratorDsp decorated
+    if isinstance(instance, InterpreterDsp):
+        dsp = <InterpreterDsp>instance
+        resources.append(dsp.factory)
+        resources.append(dsp.memory_manager)
+        dsp.ptr = NULL
+        dsp.ptr_owner = False
+        dsp.factory = None
+        dsp.memory_manager = None
+    elif isinstance(instance, CombinedDsp):
+        combined = <CombinedDsp>instance
+        resources.extend(combined.resources)
+        combined.ptr = NULL
+        combined.resources = []
+    else:
+        decorated = <DecoratorDsp>instance
+        resources.extend(decorated.resources)
+        decorated.ptr = NULL
+        decorated.resources = []
+
+
+cdef CombinedDsp _combine(int kind, object dsp1, object dsp2, int layout, str label, int delay=1, int curve=0, int preroll=0):
+    cdef fi.dsp* ptr1 = _dsp_ptr(dsp1)
+    cdef fi.dsp* ptr2 = _dsp_ptr(dsp2)
+    cdef fi.dsp* res = NULL
+    cdef string error
+    cdef string c_label = label.encode('utf8')
+    if ptr1 == ptr2:
+        raise ValueError("an instance cannot be combined with itself")
+    _check_owned(dsp1, "combined")
+    _check_owned(dsp2, "combined")
+    if kind == 0:
+        res = fi.createDSPSequencer(ptr1, ptr2, error, <fi.Layout>layout, c_label)
+    elif kind == 1:
+        res = fi.createDSPParallelizer(ptr1, ptr2, error, <fi.Layout>layout, c_label)
+    elif kind == 2:
+        res = fi.createDSPSplitter(ptr1, ptr2, error, <fi.Layout>layout, c_label)
+    elif kind == 3:
+        res = fi.createDSPMerger(ptr1, ptr2, error, <fi.Layout>layout, c_label)
+    elif kind == 4:
+        res = fi.createDSPRecursiver(ptr1, ptr2, error, <fi.Layout>layout, c_label, delay)
+    else:
+        res = fi.createDSPCrossfader(ptr1, ptr2, error, <fi.Layout>layout, c_label, <fi.CrossfadeCurve>curve, preroll)
+    if res == NULL:
+        raise ValueError(error.decode().strip())
+    cdef CombinedDsp combined = CombinedDsp.__new__(CombinedDsp)
+    combined.ptr = <fi.dsp_binary_combiner*>res
+    _take_dsp(dsp1, combined.resources)
+    _take_dsp(dsp2, combined.resources)
+    return combined
+
+
+def create_dsp_sequencer(dsp1, dsp2, int layout=LAYOUT_TAB, str label="Sequencer") -> CombinedDsp:
+    """Connect the outputs of dsp1 to the inputs of dsp2 (Faust ':' operator).
+
+    dsp1, dsp2 - InterpreterDsp or CombinedDsp instances, owned by the result
+    (and closed) on success
+    layout - the user interface layout (LAYOUT_VERTICAL, LAYOUT_HORIZONTAL or LAYOUT_TAB)
+    label - the user interface group label
+    """
+    return _combine(0, dsp1, dsp2, layout, label)
+
+def create_dsp_parallelizer(dsp1, dsp2, int layout=LAYOUT_TAB, str label="Parallelizer") -> CombinedDsp:
+    """Put dsp1 and dsp2 in parallel (Faust ',' operator), see create_dsp_sequencer."""
+    return _combine(1, dsp1, dsp2, layout, label)
+
+def create_dsp_splitter(dsp1, dsp2, int layout=LAYOUT_TAB, str label="Splitter") -> CombinedDsp:
+    """Split the outputs of dsp1 to the inputs of dsp2 (Faust '<:' operator), see create_dsp_sequencer."""
+    return _combine(2, dsp1, dsp2, layout, label)
+
+def create_dsp_merger(dsp1, dsp2, int layout=LAYOUT_TAB, str label="Merger") -> CombinedDsp:
+    """Mix the outputs of dsp1 to the inputs of dsp2 (Faust ':>' operator), see create_dsp_sequencer."""
+    return _combine(3, dsp1, dsp2, layout, label)
+
+def create_dsp_recursiver(dsp1, dsp2, int layout=LAYOUT_TAB, str label="Recursiver", int delay=1) -> CombinedDsp:
+    """Feed back the outputs of dsp2 to the inputs of dsp1 (Faust '~' operator), see create_dsp_sequencer.
+
+    delay - the feedback delay in frames, or 0 to use the 'delay' metadata of dsp2
+    """
+    if delay < 0:
+        raise ValueError("delay must be positive or 0")
+    return _combine(4, dsp1, dsp2, layout, label, delay)
+
+def create_dsp_crossfader(dsp1, dsp2, int layout=LAYOUT_TAB, str label="Crossfade",
+                          int curve=CROSSFADE_LINEAR, int preroll=0) -> CombinedDsp:
+    """Crossfade between dsp1 and dsp2 (with a 'Crossfade' slider), see create_dsp_sequencer.
+
+    Only dsp1 is computed when the slider is at 1, and only dsp2 at 0.
+
+    curve - CROSSFADE_LINEAR or CROSSFADE_EQUAL_POWER
+    preroll - the number of input frames a resumed DSP is computed on before being heard
+    (the DSP heard until then is kept alone meanwhile)
+    """
+    if curve != CROSSFADE_LINEAR and curve != CROSSFADE_EQUAL_POWER:
+        raise ValueError("invalid curve")
+    if preroll < 0:
+        raise ValueError("preroll must be positive or 0")
+    return _combine(5, dsp1, dsp2, layout, label, 1, curve, preroll)
+
+## ---------------------------------------------------------------------------
+## DSP decorators
+##
+
+cdef class DecoratorDsp:
+    """Base class of the DSP decorating another instance (see create_dsp_denormals,
+    create_profiled_dsp and create_dsp_graph).
+
+    The decorated instance is owned by the decorator.
+    """
+
+    cdef fi.dsp* ptr
+    # the factories, memory managers (and profilers) of the decorated instances
+    cdef list resources
+    # the MapUI and RtAudioDriver objects pointing into the instance
+    cdef object users
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    def __cinit__(self):
+        self.ptr = NULL
+        self.resources = []
+        self.users = weakref.WeakSet()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    def close(self):
+        """Delete the DSP and the instance it owns now.
+
+        Raises ValueError while a MapUI or an RtAudioDriver points into the DSP.
+        """
+        _check_unused(self, "closed")
+        if self.ptr:
+            del self.ptr
+        self.ptr = NULL
+        self.resources = []
+
+    @property
+    def closed(self) -> bool:
+        """Whether the DSP has been closed (or combined into another one)."""
+        return self.ptr == NULL
+
+    cdef fi.dsp* get_ptr(self) except NULL:
+        if self.ptr == NULL:
+            raise ValueError("decorated DSP is closed")
+        return self.ptr
+
+    def get_numinputs(self) -> int:
+        """Return the number of audio inputs."""
+        return self.get_ptr().getNumInputs()
+
+    def get_numoutputs(self) -> int:
+        """Return the number of audio outputs."""
+        return self.get_ptr().getNumOutputs()
+
+    def get_samplerate(self) -> int:
+        """Return the sample rate currently used by the instance."""
+        return self.get_ptr().getSampleRate()
+
+    def init(self, int sample_rate):
+        """Global init of the decorated instance."""
+        self.get_ptr().init(sample_rate)
+
+    def instance_clear(self):
+        """Init the state of the decorated instance but keep the control parameter values."""
+        self.get_ptr().instanceClear()
+
+    def compute(self, float[:, ::1] inputs, float[:, ::1] outputs not None):
+        """Compute one block through the decorator, with the GIL released.
+
+        inputs - a (numinputs, count) float32 C-contiguous buffer (or None without inputs)
+        outputs - a (numoutputs, count) float32 C-contiguous buffer
+        """
+        cdef fi.dsp* instance = self.get_ptr()
+        cdef int numinputs = instance.getNumInputs()
+        cdef int numoutputs = instance.getNumOutputs()
+        cdef int count = outputs.shape[1]
+        cdef int i
+        cdef vector[float*] ins
+        cdef vector[float*] outs
+        if outputs.shape[0] < numoutputs:
+            raise ValueError(f"outputs must have {numoutputs} channels")
+        if numinputs > 0 and (inputs is None or inputs.shape[0] < numinputs or inputs.shape[1] < count):
+            raise ValueError(f"inputs must have {numinputs} channels of {count} frames")
+        ins.resize(numinputs)
+        outs.resize(numoutputs)
+        # empty buffers have no first frame to point to
+        if count > 0:
+            for i in range(numinputs):
+                ins[i] = &inputs[i, 0]
+            for i in range(numoutputs):
+                outs[i] = &outputs[i, 0]
+        with nogil:
+            instance.compute(count, ins.data(), outs.data())
+
+
+cdef fi.dsp* _decorated_ptr(object dsp) except NULL:
+    """Return the C++ instance of a DSP to be decorated (and owned) by a new decorator."""
+    cdef fi.dsp* ptr = _dsp_ptr(dsp)
+    _check_owned(dsp, "decorated")
+    return ptr
+
+## faust/dsp/dsp-denormals
+
+cdef class DenormalDsp(DecoratorDsp):
+    """DSP applying its own denormal policy, with a sampling subnormal detector
+    (see create_dsp_denormals)."""
+
+    cdef fi.dsp_denormals* denormals(self) except NULL:
+        return <fi.dsp_denormals*>self.get_ptr()
+
+    def clone(self) -> DenormalDsp:
+        """Return a clone of the DSP (with a clone of the decorated instance, and new statistics)."""
+        cdef DenormalDsp clone = DenormalDsp.__new__(DenormalDsp)
+        clone.ptr = <fi.dsp*>self.denormals().clone()
+        clone.resources = list(self.resources)
+        return clone
+
+    @property
+    def policy(self) -> int:
+        """The denormal policy applied around compute (DENORMALS_KEEP, DENORMALS_FTZ or DENORMALS_FTZ_DAZ)."""
+        return self.denormals().getPolicy()
+
+    @policy.setter
+    def policy(self, int policy):
+        if policy not in (DENORMALS_KEEP, DENORMALS_FTZ, DENORMALS_FTZ_DAZ):
+            raise ValueError(f"invalid denormal policy: {policy}")
+        self.denormals().setPolicy(policy)
+
+    @property
+    def period(self) -> int:
+        """The detector checks the outputs of one block every 'period' blocks (0 when disabled)."""
+        return self.denormals().getPeriod()
+
+    @period.setter
+    def period(self, int period):
+        if period < 0:
+            raise ValueError("period must be positive or 0")
+        self.denormals().setPeriod(period)
+
+    @property
+    def stats(self) -> dict:
+        """Statistics of the detector: checked blocks, blocks with subnormal outputs,
+        subnormal output samples, maximum and last count of subnormal samples in a block."""
+        cdef fi.denormal_stats stats = self.denormals().getStats()
+        return {
+            'checked_blocks': stats.fCheckedBlocks,
+            'denormal_blocks': stats.fDenormalBlocks,
+            'denormal_samples': stats.fDenormalSamples,
+            'max_per_block': stats.fMaxPerBlock,
+            'last_block': stats.fLastBlock,
+        }
+
+    def reset_stats(self):
+        """Reset the statistics of the detector."""
+        self.denormals().resetStats()
+
+
+def create_dsp_denormals(dsp, int policy=DENORMALS_FTZ_DAZ, int period=0) -> DenormalDsp:
+    """Apply a denormal policy to one DSP, whatever the global one (see set_denormal_policy) is.
+
+    dsp - an InterpreterDsp, CombinedDsp or DecoratorDsp instance, owned by the result (and closed)
+    policy - DENORMALS_KEEP, DENORMALS_FTZ or DENORMALS_FTZ_DAZ
+    period - check the outputs of one block every 'period' blocks for subnormal
+    samples (see DenormalDsp.stats), 0 to disable the detector
+    """
+    cdef fi.dsp* ptr = _decorated_ptr(dsp)
+    if policy not in (DENORMALS_KEEP, DENORMALS_FTZ, DENORMALS_FTZ_DAZ):
+        raise ValueError(f"invalid denormal policy: {policy}")
+    if period < 0:
+        raise ValueError("period must be positive or 0")
+    cdef DenormalDsp decorated = DenormalDsp.__new__(DenormalDsp)
+    decorated.ptr = new fi.dsp_denormals(ptr, policy, period)
+    _take_dsp(dsp, decorated.resources)
+    return decorated
+
+## faust/dsp/dsp-profiler
+
+cdef class DspProfiler:
+    """Profile collector shared by the profiled nodes of a DSP graph (see create_profiled_dsp).
+
+    Each thread computing profiled nodes uses one of the 'threads' preallocated event
+    buffers: the events of additional threads are dropped (see reserve and dropped).
+    """
+
+    cdef fi.dsp_profiler* ptr
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    def __cinit__(self, bint enabled=False, int threads=1):
+        if threads < 0:
+            raise ValueError("threads must be positive or 0")
+        self.ptr = new fi.dsp_profiler(enabled, threads)
+
+    @property
+    def enabled(self) -> bool:
+        """Whether the profiled nodes record their compute duration."""
+        return self.ptr.isEnabled()
+
+    @enabled.setter
+    def enabled(self, bint enabled):
+        self.ptr.setEnabled(enabled)
+
+    def reserve(self, int threads):
+        """Allocate the event buffers of 'threads' compute threads in total."""
+        self.ptr.reserve(threads)
+
+    @property
+    def num_buffers(self) -> int:
+        """Number of allocated event buffers."""
+        return self.ptr.getNumBuffers()
+
+    @property
+    def dropped(self) -> int:
+        """Number of events dropped because a buffer was full, or a thread had no buffer."""
+        return self.ptr.getDropped()
+
+    def collect(self):
+        """Aggregate the recorded events, to be called regularly on long runs to avoid dropped events."""
+        with nogil:
+            self.ptr.collect()
+
+    def reset(self):
+        """Clear the aggregated results."""
+        self.ptr.reset()
+
+    def get_folded(self) -> dict:
+        """Return the aggregated self time (in nanoseconds) of each 'root;child;grandchild' call path."""
+        return {k.decode(): v for k, v in self.ptr.getFolded()}
+
+    def get_folded_stacks(self) -> str:
+        """Return the profile as folded stacks (for flamegraph.pl or speedscope)."""
+        return self.ptr.getFoldedStacks().decode()
+
+    def get_chrome_trace(self) -> str:
+        """Return the last events in the Chrome trace event format."""
+        return self.ptr.getChromeTrace().decode()
+
+    def write_folded_stacks(self, str path):
+        """Write the profile as folded stacks in a file."""
+        if not self.ptr.writeFoldedStacks(path.encode('utf8')):
+            raise IOError(f"cannot write {path}")
+
+    def write_chrome_trace(self, str path):
+        """Write the last events in the Chrome trace event format in a file."""
+        if not self.ptr.writeChromeTrace(path.encode('utf8')):
+            raise IOError(f"cannot write {path}")
+
+
+cdef class ProfiledDsp(DecoratorDsp):
+    """DSP recording the duration of each compute in a DspProfiler (see create_profiled_dsp)."""
+
+    cdef fi.profiled_dsp* profiled(self) except NULL:
+        return <fi.profiled_dsp*>self.get_ptr()
+
+    def clone(self) -> ProfiledDsp:
+        """Return a clone of the DSP (with a clone of the decorated instance), profiled under the same name."""
+        cdef ProfiledDsp clone = ProfiledDsp.__new__(ProfiledDsp)
+        clone.ptr = <fi.dsp*>self.profiled().clone()
+        clone.resources = list(self.resources)
+        return clone
+
+    @property
+    def name(self) -> str:
+        """The node name in the profile."""
+        return self.profiled().getName().decode()
+
+
+def create_profiled_dsp(dsp, DspProfiler profiler not None, str name) -> ProfiledDsp:
+    """Record the duration of each compute of a DSP in a profiler.
+
+    Profiled DSP can be combined (and profiled again): nested nodes are reported
+    as children of their enclosing profiled node.
+
+    dsp - an InterpreterDsp, CombinedDsp or DecoratorDsp instance, owned by the result (and closed)
+    profiler - the profiler, kept alive by the result
+    name - the node name in the profile
+    """
+    cdef fi.dsp* ptr = _decorated_ptr(dsp)
+    cdef ProfiledDsp decorated = ProfiledDsp.__new__(ProfiledDsp)
+    decorated.ptr = new fi.profiled_dsp(ptr, profiler.ptr, name.encode('utf8'))
+    decorated.resources.append(profiler)
+    _take_dsp(dsp, decorated.resources)
+    return decorated
+
+## faust/dsp/dsp-graph
+
+cdef class GraphDsp(DecoratorDsp):
+    """Combined DSP computed as a graph of independent nodes, level by level, on
+    several threads (see create_dsp_graph)."""
+
+    cdef fi.dsp_graph* graph(self) except NULL:
+        return <fi.dsp_graph*>self.get_ptr()
+
+    def clone(self) -> GraphDsp:
+        """Return a clone of the DSP (with a clone of the combined instance, and its own threads)."""
+        cdef GraphDsp clone = GraphDsp.__new__(GraphDsp)
+        clone.ptr = <fi.dsp*>self.graph().clone()
+        clone.resources = list(self.resources)
+        return clone
+
+    @property
+    def num_nodes(self) -> int:
+        """Number of nodes: the leaf DSPs of the combiners tree, and the sums of the mergers."""
+        return self.graph().getNumNodes()
+
+    @property
+    def num_levels(self) -> int:
+        """Number of levels, the nodes of a level being computed concurrently."""
+        return self.graph().getNumLevels()
+
+    @property
+    def num_threads(self) -> int:
+        """Number of threads computing the graph, including the calling one."""
+        return self.graph().getNumThreads()
+
+
+def create_dsp_graph(dsp, int threads=-1, int buffer_size=4096) -> GraphDsp:
+    """Compute a combiners tree (see create_dsp_sequencer...) as a graph, its independent
+    leaves being computed concurrently. Outputs are the same as the ones of the tree.
+
+    dsp - a CombinedDsp (or any other instance, then computed as a single node), owned by the result (and closed)
+    threads - the number of worker threads, -1 to use the number of cores minus one,
+    0 to compute all nodes on the calling thread (workers are capped by the widest level)
+    buffer_size - the size of the preallocated buffers (larger blocks are split)
+    """
+    cdef fi.dsp* ptr = _decorated_ptr(dsp)
+    if threads < -1:
+        raise ValueError("threads must be -1, 0 or positive")
+    if buffer_size <= 0:
+        raise ValueError("buffer_size must be positive")
+    cdef GraphDsp decorated = GraphDsp.__new__(GraphDsp)
+    decorated.ptr = new fi.dsp_graph(ptr, threads, buffer_size)
+    _take_dsp(dsp, decorated.resources)
+    return decorated
+
+## ---------------------------------------------------------------------------
+## faust/dsp/dsp-bench
+##
+
+cdef class BenchResult:
+    """Result of a DSP benchmark (see bench()).
+
+    Durations are per compute call, in seconds.
+    """
+    cdef fi.bench_stats stats
+
+    @property
+    def buffer_size(self) -> int:
+        return self.stats.fBufferSize
+
+    @property
+    def count(self) -> int:
+        """Number of measured compute calls."""
+        return self.stats.fCount
+
+    @property
+    def sample_rate(self) -> float:
+        """Sample rate used to compute the CPU load."""
+        return self.stats.fSampleRate
+
+    @property
+    def mb_per_sec(self) -> float:
+        """Throughput in MBytes/sec of the best blocks (as faustbench)."""
+        return self.stats.fMBPerSec
+
+    @property
+    def std_dev(self) -> float:
+        """Relative standard deviation of the best blocks (in %)."""
+        return self.stats.fStdDev
+
+    @property
+    def percentiles(self) -> dict:
+        """Block duration percentiles."""
+        return {
+            0: self.stats.fMin,
+            25: self.stats.fP25,
+            50: self.stats.fP50,
+            75: self.stats.fP75,
+            90: self.stats.fP90,
+            99: self.stats.fP99,
+            100: self.stats.fMax,
+        }
+
+    @property
+    def mean(self) -> float:
+        """Mean block duration."""
+        return self.stats.fMean
+
+    @property
+    def cpu_load(self) -> float:
+        """Mean block duration relative to the block period at sample_rate."""
+        return self.stats.fCPULoad
+
+    @property
+    def samples_per_sec(self) -> float:
+        """Frames computed per second."""
+        return self.stats.fSamplesPerSec
+
+    @property
+    def throughputs(self) -> list[float]:
+        """MBytes/sec of each measured block, in increasing order."""
+        return self.stats.fThroughputs
+
+    @property
+    def counters(self) -> dict:
+        """Hardware counters per sample and per channel sample (empty if not measured).
+
+        Keys are counter names, values are (per_sample, per_channel_sample) tuples,
+        or None when the counter is not available on this CPU. per_channel_sample
+        is per_sample divided by the number of input and output channels.
+        """
+        cdef int i
+        if not self.stats.fPerf.fValid:
+            return {}
+        res = {}
+        for i in range(fi.perf_counters_kNumCounters):
+            name = fi.perf_counters.getName(i).decode()
+            if self.stats.fPerf.fPerSample[i] < 0:
+                res[name] = None
+            else:
+                res[name] = (self.stats.fPerf.fPerSample[i], self.stats.fPerf.fPerChannelSample[i])
+        return res
+
+    @property
+    def ipc(self) -> float:
+        """Instructions per cycle (0 if not measured)."""
+        return self.stats.fPerf.fIPC
+
+    def as_dict(self) -> dict:
+        return {
+            'buffer_size': self.buffer_size,
+            'count': self.count,
+            'sample_rate': self.sample_rate,
+            'mb_per_sec': self.mb_per_sec,
+            'std_dev': self.std_dev,
+            'percentiles': self.percentiles,
+            'mean': self.mean,
+            'cpu_load': self.cpu_load,
+            'samples_per_sec': self.samples_per_sec,
+            'counters': self.counters,
+            'ipc': self.ipc,
+        }
+
+    def __repr__(self):
+        return (f"<BenchResult {self.mb_per_sec:.2f} MB/s p50={self.stats.fP50 * 1e6:.2f}us "
+                f"p99={self.stats.fP99 * 1e6:.2f}us cpu_load={self.cpu_load:.4f}>")
+
+
+def bench(InterpreterDsp dsp not None, int buffer_size=512, double duration=1.0,
+          bint random_controls=True, double sample_rate=48000, bint counters=False) -> BenchResult:
+    """Measure the CPU use of a DSP instance with 'measure_dsp'.
+
+    The measure is done on a clone of the instance (which is not modified)
+    with the GIL released.
+
+    dsp - the instance to be measured
+    buffer_size - the buffer size used when calling 'compute'
+    duration - the wanted measure duration in seconds
+    random_controls - whether to randomly change all control values at each cycle
+    sample_rate - the sample rate used to compute the CPU load
+    counters - whether to read hardware counters around each compute (Linux only)
+    """
+    cdef fi.dsp* instance = <fi.dsp*>dsp.get_ptr()
+    if buffer_size <= 0 or duration <= 0 or sample_rate <= 0:
+        raise ValueError("buffer_size, duration and sample_rate must be positive")
+    cdef BenchResult result = BenchResult.__new__(BenchResult)
+    with nogil:
+        result.stats = fi.benchDSP[float](instance, buffer_size, duration,
+                                          random_controls, sample_rate, counters)
+    return result
+
+
+## ---------------------------------------------------------------------------
+## faust/dsp/interpreter-dsp-optimizer
+##
+
+cdef class InterpreterDspOptimizer:
+    """Find the fastest compilation options of a DSP for the interpreter backend.
+
+    Candidates (-scal/-vec, -lv, -vs, -mcd, -ct) are compiled and measured with
+    'measure_dsp'. Results are cached by DSP SHA key and buffer size, so that
+    create_dsp_factory_from_string() compiles already tuned DSPs directly.
+
+    buffer_size - the buffer size used for the measures
+    duration - the measure duration in seconds of each candidate
+    trace - whether to print each candidate result
+    random_controls - whether to randomly change all control values at each cycle
+    """
+    cdef fi.interpreter_dsp_optimizer* ptr
+
+    def __cinit__(self, int buffer_size=512, double duration=0.5,
+                  bint trace=False, bint random_controls=False):
+        self.ptr = new fi.interpreter_dsp_optimizer(buffer_size, duration, trace, random_controls)
+
+    def __dealloc__(self):
+        if self.ptr:
+            del self.ptr
+            self.ptr = NULL
+
+    def find_optimized_parameters(self, str name_app, str code, *args) -> tuple:
+        """Return (options, mb_per_sec, std_dev, cpu_load) for the best options.
+
+        args are base options kept in all candidates.
+        """
+        cdef ParamArray params = ParamArray(args)
+        cdef string c_name_app = name_app.encode('utf8')
+        cdef string c_code = code.encode('utf8')
+        cdef fi.optimizer_result res
+        # candidates are compiled by libfaust, which is not thread safe: the GIL is kept
+        cdef bint found = self.ptr.findOptimizedParameters(c_name_app, c_code, params.argc, params.argv, res)
+        if not found:
+            raise FaustCompileError(self.ptr.getError().decode().strip(), None, " ".join(args))
+        return ([opt.decode() for opt in fi.optimizer_result_options(res)],
+                fi.optimizer_result_mbps(res),
+                fi.optimizer_result_sd(res),
+                fi.optimizer_result_cpu(res))
+
+    def create_dsp_factory_from_string(self, str name_app, str code, *args) -> InterpreterDspFactory:
+        """Create a factory compiled with the best options, searching them if needed."""
+        cdef ParamArray params = ParamArray(args)
+        cdef string c_name_app = name_app.encode('utf8')
+        cdef string c_code = code.encode('utf8')
+        cdef string error_msg
+        cdef InterpreterDspFactory factory = InterpreterDspFactory.__new__(
+            InterpreterDspFactory)
+        factory.ptr = self.ptr.createDSPFactoryFromString(
+            c_name_app, c_code, params.argc, params.argv, error_msg)
+        if factory.ptr == NULL:
+            _raise_error(FaustCompileError, error_msg, args)
+        factory.ptr_owner = True
+        return factory
+
+    def save_cache(self, str path):
+        """Save the cached results in a file."""
+        if not self.ptr.saveCache(path.encode('utf8')):
+            raise OSError(f"cannot write {path}")
+
+    def load_cache(self, str path):
+        """Load (and merge) results saved with save_cache()."""
+        if not self.ptr.loadCache(path.encode('utf8')):
+            raise OSError(f"cannot read {path}")
+
+    def clear_cache(self):
+        self.ptr.clearCache()
+
+    @property
+    def cache_size(self) -> int:
+        """Number of DSPs in the cache."""
+        return self.ptr.getCacheSize()
+
+    @property
+    def buffer_size(self) -> int:
+        return self.ptr.getBufferSize()
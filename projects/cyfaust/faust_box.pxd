@@ -3,7 +3,7 @@
 from libcpp.string cimport string
 from libcpp.vector cimport vector
 
-cdef extern from "faust/dsp/libfaust-box.h":
+cdef extern from "faust/dsp/libfaust-box.h" nogil:
     cdef cppclass CTree
     ctypedef vector[CTree*] tvec
     ctypedef CTree* Signal
@@ -0,0 +1,291 @@
+## ---------------------------------------------------------------------------
+## faust/dsp/libfaust-box
+##
+
+# Box and Signal pointers are only valid in the lib context they were built in:
+# each context gets a new id, and wrappers keep the id of their context.
+cdef int _lib_context_id = 0
+cdef bint _lib_context_active = False
+
+
+cdef int _current_context() except -1:
+    if not _lib_context_active:
+        raise RuntimeError("boxes and signals have to be built in a box_context or signal_context")
+    return _lib_context_id
+
+
+def create_lib_context():
+    """Create a libfaust context, required to build boxes and signals."""
+    global _lib_context_id, _lib_context_active
+    if _lib_context_active:
+        raise RuntimeError("a lib context is already active")
+    fb.createLibContext()
+    _lib_context_id += 1
+    _lib_context_active = True
+
+def destroy_lib_context():
+    """Destroy the libfaust context: all boxes and signals built in it become invalid."""
+    global _lib_context_active
+    if _lib_context_active:
+        fb.destroyLibContext()
+        _lib_context_active = False
+
+
+class box_context:
+    """Context manager creating and destroying a libfaust context."""
+    def __enter__(self):
+        create_lib_context()
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        destroy_lib_context()
+
+
+cdef class Box:
+    """faust Box wrapper, only valid in the lib context it was built in."""
+    cdef fb.Box ptr
+    cdef int context
+
+    def __cinit__(self):
+        self.ptr = NULL
+        self.context = 0
+
+    @staticmethod
+    cdef Box from_ptr(fb.Box ptr):
+        cdef Box box = Box.__new__(Box)
+        box.ptr = ptr
+        box.context = _current_context()
+        return box
+
+    cdef fb.Box get_ptr(self) except NULL:
+        if self.ptr == NULL:
+            raise ValueError("box is empty")
+        if not _lib_context_active or self.context != _lib_context_id:
+            raise RuntimeError("box was built in a lib context which has been destroyed")
+        return self.ptr
+
+    def __repr__(self):
+        return self.print() if self.is_valid else "<invalid Box>"
+
+    def print(self, bint shared=False, int max_size=256) -> str:
+        """Return the textual form of the box."""
+        return fb.printBox(self.get_ptr(), shared, max_size).decode()
+
+    @property
+    def is_valid(self) -> bool:
+        """Whether the box is alive and has a valid (inputs, outputs) type."""
+        cdef int inputs, outputs
+        if self.ptr == NULL or not _lib_context_active or self.context != _lib_context_id:
+            return False
+        return fb.getBoxType(self.ptr, &inputs, &outputs)
+
+    @property
+    def inputs(self) -> int:
+        """Number of inputs of the box."""
+        cdef int inputs, outputs
+        fb.getBoxType(self.get_ptr(), &inputs, &outputs)
+        return inputs
+
+    @property
+    def outputs(self) -> int:
+        """Number of outputs of the box."""
+        cdef int inputs, outputs
+        fb.getBoxType(self.get_ptr(), &inputs, &outputs)
+        return outputs
+
+    def create_source(self, name_app: str, lang: str, *args) -> str:
+        """Create source code in a target language from the box."""
+        return create_source_from_boxes(name_app, self, lang, *args)
+
+
+def box_int(int n) -> Box:
+    """Constant integer box."""
+    return Box.from_ptr(fb.boxInt(n))
+
+def box_real(double n) -> Box:
+    """Constant real box."""
+    return Box.from_ptr(fb.boxReal(n))
+
+def box_float(double n) -> Box:
+    """Constant real box (same as box_real)."""
+    return Box.from_ptr(fb.boxReal(n))
+
+def box_wire() -> Box:
+    """The identity box, copies its input to its output."""
+    return Box.from_ptr(fb.boxWire())
+
+def box_cut() -> Box:
+    """The cut box, stops the propagation of its input."""
+    return Box.from_ptr(fb.boxCut())
+
+def box_seq(Box x, Box y) -> Box:
+    """Sequential composition (x : y)."""
+    return Box.from_ptr(fb.boxSeq(x.get_ptr(), y.get_ptr()))
+
+def box_par(Box x, Box y) -> Box:
+    """Parallel composition (x , y)."""
+    return Box.from_ptr(fb.boxPar(x.get_ptr(), y.get_ptr()))
+
+def box_split(Box x, Box y) -> Box:
+    """Split composition (x <: y)."""
+    return Box.from_ptr(fb.boxSplit(x.get_ptr(), y.get_ptr()))
+
+def box_merge(Box x, Box y) -> Box:
+    """Merge composition (x :> y)."""
+    return Box.from_ptr(fb.boxMerge(x.get_ptr(), y.get_ptr()))
+
+def box_rec(Box x, Box y) -> Box:
+    """Recursive composition (x ~ y)."""
+    return Box.from_ptr(fb.boxRec(x.get_ptr(), y.get_ptr()))
+
+def box_delay(Box b, Box d) -> Box:
+    """Box delayed by d samples."""
+    return Box.from_ptr(fb.boxDelay(b.get_ptr(), d.get_ptr()))
+
+def create_source_from_boxes(name_app: str, Box box, lang: str, *args) -> str:
+    """Create source code in a target language from a box expression."""
+    cdef ParamArray params = ParamArray(args)
+    cdef string error_msg
+    cdef string code = fb.createSourceFromBoxes(
+        name_app.encode('utf8'),
+        box.get_ptr(),
+        lang.encode('utf8'),
+        params.argc,
+        params.argv,
+        error_msg
+    )
+    if code.empty():
+        _raise_error(FaustCompileError, error_msg, args)
+    return code.decode()
+
+
+## bulk construction
+##
+## A graph is described by parallel arrays, one entry per node, in topological order:
+##   opcodes - int32 array of BOX_OP_* (or SIG_OP_*) codes
+##   args    - (n, 3) int32 array of operand node indices (smaller than the node index), -1 when unused
+##   values  - float64 array of node values: constant, input index or SOperator (kAdd...),
+##             integer-typed entries have to be integers within int range
+## Nodes can be referenced several times, so DAGs are described without duplication.
+
+cpdef enum BoxOp:
+    BOX_OP_INT          # values[i]
+    BOX_OP_REAL         # values[i]
+    BOX_OP_WIRE
+    BOX_OP_CUT
+    BOX_OP_SEQ          # (x, y)
+    BOX_OP_PAR          # (x, y)
+    BOX_OP_SPLIT        # (x, y)
+    BOX_OP_MERGE        # (x, y)
+    BOX_OP_REC          # (x, y)
+    BOX_OP_DELAY        # () or (x, d)
+    BOX_OP_INTCAST      # () or (x)
+    BOX_OP_FLOATCAST    # () or (x)
+    BOX_OP_SELECT2      # () or (selector, x, y)
+    BOX_OP_BINOP        # () or (x, y), SOperator in values[i]
+
+
+cdef int _num_args(int a, int b, int c) noexcept nogil:
+    """Return the number of operands, or -1 if they are not contiguous."""
+    if a < 0:
+        return 0 if (b < 0 and c < 0) else -1
+    if b < 0:
+        return 1 if c < 0 else -1
+    return 2 if c < 0 else 3
+
+
+cdef bint _is_int(double value) noexcept nogil:
+    """Whether 'value' is an integer within int range (NaN fails every comparison)."""
+    return INT_MIN <= value <= INT_MAX and floor(value) == value
+
+
+cdef Py_ssize_t _check_program(const int[::1] opcodes, const int[:, ::1] args, const double[::1] values) except -2:
+    if args.shape[0] != opcodes.shape[0] or args.shape[1] != 3 or values.shape[0] != opcodes.shape[0]:
+        raise ValueError("args must have shape (n, 3) and values shape (n,) for n opcodes")
+    if opcodes.shape[0] == 0:
+        raise ValueError("empty program")
+    return opcodes.shape[0]
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef Py_ssize_t _build_boxes(const int[::1] opcodes, const int[:, ::1] args, const double[::1] values,
+                             vector[fb.Box]& nodes) noexcept nogil:
+    """Build all nodes in order, return the index of the first invalid node or -1."""
+    cdef Py_ssize_t i
+    cdef int a, b, c, n, op
+    cdef fb.Box x, y, z
+    for i in range(opcodes.shape[0]):
+        op = opcodes[i]
+        a = args[i, 0]
+        b = args[i, 1]
+        c = args[i, 2]
+        n = _num_args(a, b, c)
+        if n < 0 or a >= i or b >= i or c >= i:
+            return i
+        x = nodes[a] if a >= 0 else NULL
+        y = nodes[b] if b >= 0 else NULL
+        z = nodes[c] if c >= 0 else NULL
+        if op == BOX_OP_INT and n == 0 and _is_int(values[i]):
+            nodes[i] = fb.boxInt(<int>values[i])
+        elif op == BOX_OP_REAL and n == 0:
+            nodes[i] = fb.boxReal(values[i])
+        elif op == BOX_OP_WIRE and n == 0:
+            nodes[i] = fb.boxWire()
+        elif op == BOX_OP_CUT and n == 0:
+            nodes[i] = fb.boxCut()
+        elif op == BOX_OP_SEQ and n == 2:
+            nodes[i] = fb.boxSeq(x, y)
+        elif op == BOX_OP_PAR and n == 2:
+            nodes[i] = fb.boxPar(x, y)
+        elif op == BOX_OP_SPLIT and n == 2:
+            nodes[i] = fb.boxSplit(x, y)
+        elif op == BOX_OP_MERGE and n == 2:
+            nodes[i] = fb.boxMerge(x, y)
+        elif op == BOX_OP_REC and n == 2:
+            nodes[i] = fb.boxRec(x, y)
+        elif op == BOX_OP_DELAY and n == 0:
+            nodes[i] = fb.boxDelay()
+        elif op == BOX_OP_DELAY and n == 2:
+            nodes[i] = fb.boxDelay(x, y)
+        elif op == BOX_OP_INTCAST and n == 0:
+            nodes[i] = fb.boxIntCast()
+        elif op == BOX_OP_INTCAST and n == 1:
+            nodes[i] = fb.boxIntCast(x)
+        elif op == BOX_OP_FLOATCAST and n == 0:
+            nodes[i] = fb.boxFloatCast()
+        elif op == BOX_OP_FLOATCAST and n == 1:
+            nodes[i] = fb.boxFloatCast(x)
+        elif op == BOX_OP_SELECT2 and n == 0:
+            nodes[i] = fb.boxSelect2()
+        elif op == BOX_OP_SELECT2 and n == 3:
+            nodes[i] = fb.boxSelect2(x, y, z)
+        elif op == BOX_OP_BINOP and n == 0 and _is_int(values[i]) and <int>fb.kAdd <= values[i] <= <int>fb.kXOR:
+            nodes[i] = fb.boxBinOp(<fb.SOperator><int>values[i])
+        elif op == BOX_OP_BINOP and n == 2 and _is_int(values[i]) and <int>fb.kAdd <= values[i] <= <int>fb.kXOR:
+            nodes[i] = fb.boxBinOp(<fb.SOperator><int>values[i], x, y)
+        else:
+            return i
+        if nodes[i] == NULL:
+            return i
+    return -1
+
+
+def box_from_arrays(const int[::1] opcodes, const int[:, ::1] args, const double[::1] values) -> Box:
+    """Build a whole box graph in a single native call.
+
+    opcodes - int32 array of BOX_OP_* codes, one per node in topological order
+    args - (n, 3) int32 array of operand node indices, -1 when unused
+    values - float64 array of constants (BOX_OP_INT/REAL) and operators (BOX_OP_BINOP)
+
+    Returns the last node. libfaust is not thread safe, so the GIL is kept during the call.
+    """
+    cdef Py_ssize_t n = _check_program(opcodes, args, values)
+    cdef vector[fb.Box] nodes
+    cdef Py_ssize_t error
+    nodes.resize(n)
+    _current_context()
+    error = _build_boxes(opcodes, args, values, nodes)
+    if error >= 0:
+        raise ValueError(f"invalid node {error}: opcode {opcodes[error]}, args {[args[error, 0], args[error, 1], args[error, 2]]}")
+    return Box.from_ptr(nodes[n - 1])
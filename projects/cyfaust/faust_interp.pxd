@@ -1,5 +1,7 @@
+from libc.stdint cimport int64_t, uint64_t
 from libcpp.string cimport string
 from libcpp.vector cimport vector
+from libcpp.map cimport map
 
 from faust_box cimport Box, Signal, tvec
 
@@ -16,6 +18,14 @@ cdef extern from "faust/gui/UI.h":
     cdef cppclass UI:
         void declare(const char* key, const char* value)
 
+cdef extern from "faust/gui/MapUI.h":
+    cdef cppclass MapUI:
+        MapUI() except +
+        void setParamValue(const string& path, FAUSTFLOAT value)
+        FAUSTFLOAT getParamValue(const string& path)
+        int getParamsCount()
+        string getParamAddress(int index)
+
 cdef extern from "faust/gui/PrintUI.h":
     cdef cppclass PrintUI:
         PrintUI() except +
@@ -34,8 +44,177 @@ cdef extern from "faust/gui/PrintUI.h":
         void declare(FAUSTFLOAT* zone, const char* key, const char* val)
 
 cdef extern from "faust/dsp/dsp.h":
-    cdef cppclass dsp_memory_manager
-    cdef cppclass dsp
+    cdef cppclass dsp_memory_manager:
+        void begin(size_t count)
+        void info(size_t size, size_t reads, size_t writes)
+        void end()
+        void* allocate(size_t size)
+        void destroy(void* ptr)
+    cdef cppclass dsp:
+        int getNumInputs()
+        int getNumOutputs()
+        void buildUserInterface(UI* ui_interface)
+        int getSampleRate()
+        void init(int sample_rate)
+        void instanceInit(int sample_rate)
+        void instanceConstants(int sample_rate)
+        void instanceResetUserInterface()
+        void instanceClear()
+        dsp* clone()
+        void metadata(Meta* m)
+        void compute(int count, float** inputs, float** outputs) nogil
+    cdef cppclass dsp_factory
+    cdef enum:
+        DENORMALS_KEEP
+        DENORMALS_FTZ
+        DENORMALS_FTZ_DAZ
+    cdef cppclass ScopedNoDenormals:
+        @staticmethod
+        void setPolicy(int policy)
+        @staticmethod
+        int getPolicy()
+
+cdef extern from "faust/dsp/dsp-denormals.h":
+    cdef cppclass denormal_stats:
+        int64_t fCheckedBlocks
+        int64_t fDenormalBlocks
+        int64_t fDenormalSamples
+        int64_t fMaxPerBlock
+        int64_t fLastBlock
+    cdef cppclass dsp_denormals(dsp):
+        dsp_denormals(dsp* dsp, int policy, int period)
+        void setPolicy(int policy)
+        int getPolicy()
+        void setPeriod(int period)
+        int getPeriod()
+        denormal_stats getStats()
+        void resetStats()
+    void computeNoDenormals[DSP](DSP* dsp, int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs) nogil
+
+cdef extern from "faust/dsp/dsp-profiler.h":
+    cdef cppclass dsp_profiler:
+        dsp_profiler(bint enabled, int threads) except +
+        void setEnabled(bint enabled)
+        bint isEnabled()
+        void reserve(int threads) except +
+        int getNumBuffers()
+        void collect() except + nogil
+        void reset()
+        uint64_t getDropped()
+        map[string, int64_t] getFolded() except +
+        string getFoldedStacks() except +
+        string getChromeTrace() except +
+        bint writeFoldedStacks(const string& path)
+        bint writeChromeTrace(const string& path)
+    cdef cppclass profiled_dsp(dsp):
+        profiled_dsp(dsp* dsp, dsp_profiler* profiler, const string& name) except +
+        const string& getName()
+
+cdef extern from "faust/dsp/dsp-arena.h":
+    cdef cppclass arena_memory_manager(dsp_memory_manager):
+        arena_memory_manager(size_t chunk_size, bint huge_pages, size_t alignment) except +
+        bint reserve(size_t size)
+        void trim()
+        size_t getAllocatedSize()
+        size_t getReservedSize()
+        size_t getNumZones()
+        size_t getNumChunks()
+        size_t getPlannedSize()
+        size_t getAlignment()
+        bint hasHugePages()
+
+cdef extern from "faust/dsp/dsp-pool.h":
+    cdef cppclass dsp_pool:
+        dsp_pool(dsp_factory* factory, int count, int sample_rate) except +
+        dsp_pool(dsp* prototype, int count, int sample_rate, arena_memory_manager* arena) except +
+        int reserve(int count) except +
+        dsp* acquire()
+        bint release(dsp* instance)
+        int getNumFree()
+        int getNumInstances()
+        int getSampleRate()
+
+cdef extern from "faust/dsp/dsp-combiner.h":
+    cdef enum Layout:
+        kVerticalGroup
+        kHorizontalGroup
+        kTabGroup
+    cdef enum CrossfadeCurve:
+        kLinearCurve
+        kEqualPowerCurve
+    cdef cppclass dsp_binary_combiner(dsp):
+        void prepare(int buffer_size)
+        int getBufferSize()
+    dsp* createDSPSequencer(dsp* dsp1, dsp* dsp2, string& error, Layout layout, const string& label)
+    dsp* createDSPParallelizer(dsp* dsp1, dsp* dsp2, string& error, Layout layout, const string& label)
+    dsp* createDSPSplitter(dsp* dsp1, dsp* dsp2, string& error, Layout layout, const string& label)
+    dsp* createDSPMerger(dsp* dsp1, dsp* dsp2, string& error, Layout layout, const string& label)
+    dsp* createDSPRecursiver(dsp* dsp1, dsp* dsp2, string& error, Layout layout, const string& label, int delay)
+    dsp* createDSPCrossfader(dsp* dsp1, dsp* dsp2, string& error, Layout layout, const string& label, CrossfadeCurve curve, int preroll)
+
+cdef extern from "faust/dsp/dsp-graph.h":
+    cdef cppclass dsp_graph(dsp):
+        dsp_graph(dsp* dsp, int threads, int buffer_size) except +
+        int getNumNodes()
+        int getNumLevels()
+        int getNumThreads()
+
+cdef extern from "faust/dsp/dsp-snapshot.h":
+    cdef cppclass dsp_snapshot:
+        @staticmethod
+        dsp_snapshot* capture(dsp* instance, arena_memory_manager* arena, string& error)
+        @staticmethod
+        dsp_snapshot* fromBuffer(const void* buffer, size_t size, string& error)
+        @staticmethod
+        dsp_snapshot* fromFile(const string& path, string& error)
+        bint restore(dsp* instance, arena_memory_manager* arena, string& error)
+        bint save(const string& path, string& error)
+        const char* getData()
+        size_t getSize()
+        int getSampleRate()
+        int getNumZones()
+        int getNumControls()
+        size_t getStateSize()
+        bint isMapped()
+
+cdef extern from "faust/dsp/dsp-bench.h":
+    cdef cppclass perf_counters:
+        @staticmethod
+        const char* getName(int counter)
+    cdef enum:
+        perf_counters_kNumCounters "perf_counters::kNumCounters"
+    cdef cppclass perf_stats:
+        bint fValid
+        double fPerSample[perf_counters_kNumCounters]
+        double fPerChannelSample[perf_counters_kNumCounters]
+        double fIPC
+    cdef cppclass bench_stats:
+        int fBufferSize
+        int fCount
+        double fSampleRate
+        double fMBPerSec
+        double fStdDev
+        double fMin
+        double fP25
+        double fP50
+        double fP75
+        double fP90
+        double fP99
+        double fMax
+        double fMean
+        double fCPULoad
+        double fSamplesPerSec
+        vector[double] fThroughputs
+        perf_stats fPerf
+    bench_stats benchDSP[REAL](dsp* DSP, int buffer_size, double duration_in_sec, bint control, double sample_rate, bint perf) except + nogil
+
+cdef extern from "faust/dsp/interpreter-dsp-optimizer.h":
+    cdef cppclass optimizer_result "interpreter_dsp_optimizer::TResult":
+        pass
+    double optimizer_result_mbps "std::get<0>"(optimizer_result& res)
+    double optimizer_result_sd "std::get<1>"(optimizer_result& res)
+    double optimizer_result_cpu "std::get<2>"(optimizer_result& res)
+    vector[string] optimizer_result_options "std::get<3>"(optimizer_result& res)
 
 cdef extern from "faust/dsp/libfaust.h":
     string generateSHA1(const string& data)
@@ -72,7 +251,7 @@ cdef extern from "faust/dsp/interpreter-dsp.h":
         void instanceClear()
         interpreter_dsp* clone()
         void metadata(Meta* m)
-        # void compute(int count, float** inputs, float** outputs)
+        void compute(int count, float** inputs, float** outputs) nogil
 
     cdef cppclass interpreter_dsp_factory:
         # ~interpreter_dsp_factory()
@@ -92,8 +271,8 @@ cdef extern from "faust/dsp/interpreter-dsp.h":
     interpreter_dsp_factory* createInterpreterDSPFactoryFromFile(const string& filename, int argc, const char* argv[], string& error_msg)
     interpreter_dsp_factory* createInterpreterDSPFactoryFromString(const string& name_app, const string& dsp_content, int argc, const char* argv[], string& error_msg)
 
-    interpreter_dsp_factory* createInterpreterDSPFactoryFromSignals(const string& name_app, tvec signals, int argc, const char* argv[], string& error_msg)
-    interpreter_dsp_factory* createInterpreterDSPFactoryFromBoxes(const string& name_app, Box box, int argc, const char* argv[], string& error_msg)
+    interpreter_dsp_factory* createInterpreterDSPFactoryFromSignals(const string& name_app, tvec signals, int argc, const char* argv[], string& error_msg) nogil
+    interpreter_dsp_factory* createInterpreterDSPFactoryFromBoxes(const string& name_app, Box box, int argc, const char* argv[], string& error_msg) nogil
     bint deleteInterpreterDSPFactory(interpreter_dsp_factory* factory)
     void deleteAllInterpreterDSPFactories()
     vector[string] getAllInterpreterDSPFactories()
@@ -104,9 +283,26 @@ cdef extern from "faust/dsp/interpreter-dsp.h":
     interpreter_dsp_factory* readInterpreterDSPFactoryFromBitcodeFile(const string& bit_code_path, string& error_msg)
     bint writeInterpreterDSPFactoryToBitcodeFile(interpreter_dsp_factory* factory, const string& bit_code_path)
 
+cdef extern from "faust/dsp/interpreter-dsp-optimizer.h":
+    cdef cppclass interpreter_dsp_optimizer:
+        interpreter_dsp_optimizer(int buffer_size, double duration, bint trace, bint control) except +
+        bint findOptimizedParameters(const string& name_app, const string& dsp_content, int argc, const char* argv[], optimizer_result& res) except + nogil
+        interpreter_dsp_factory* createDSPFactoryFromString(const string& name_app, const string& dsp_content, int argc, const char* argv[], string& error_msg) except + nogil
+        bint saveCache(const string& path)
+        bint loadCache(const string& path)
+        void clearCache()
+        int getCacheSize()
+        int getBufferSize()
+        const char* getError()
+
+cdef extern from "faust/dsp/dsp-arena.h":
+    interpreter_dsp* createArenaDSPInstance(interpreter_dsp_factory* factory)
+    interpreter_dsp* cloneArenaDSPInstance(interpreter_dsp* instance, arena_memory_manager* arena)
+
 cdef extern from "faust/audio/rtaudio-dsp.h":
     cdef cppclass rtaudio:    
         rtaudio(int srate, int bsize) except +
+        rtaudio(int srate, int bsize, bint native) except +
         # bint init(const char* name, dsp* DSP)
         bint init(const char* name, int numInputs, int numOutputs)
         void setDsp(dsp* DSP)
@@ -116,3 +312,5 @@ cdef extern from "faust/audio/rtaudio-dsp.h":
         int getSampleRate()
         int getNumInputs()
         int getNumOutputs()
+        bint isNative()
+        bint isInterleaved()
@@ -1,7 +1,9 @@
 from libcpp.string cimport string
 from libcpp.vector cimport vector
+from libcpp.map cimport map
+from libc.stdint cimport int64_t
 
-cdef extern from "faust/dsp/libfaust-signal.h":
+cdef extern from "faust/dsp/libfaust-signal.h" nogil:
     cdef cppclass CTree
     ctypedef vector[CTree*] tvec
     ctypedef CTree* Signal
@@ -246,3 +248,24 @@ cdef extern from "faust/dsp/libfaust-signal.h":
     tvec simplifyToNormalForm2(tvec siglist)
 
     string createSourceFromSignals(const string& name_app, tvec osigs, const string& lang, int argc, const char* argv[], string& error_msg)
+
+
+cdef extern from "faust/dsp/signal-cost.h":
+    cdef cppclass signal_cost:
+        map[string, int] fNodes
+        int fNumNodes
+        int fNumDelays
+        int64_t fDelayMemory
+        int fMaxDelay
+        int fUnboundedDelays
+        int fNumTables
+        int64_t fTableMemory
+        int fUnknownTables
+        int fOpaqueNodes
+        double fSampleOps
+        double fControlOps
+        double fInitOps
+
+    cdef cppclass signal_cost_analyzer:
+        signal_cost_analyzer() except +
+        signal_cost analyze(tvec signals, bint normalize) except +
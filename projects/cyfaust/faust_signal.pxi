@@ -0,0 +1,212 @@
+## ---------------------------------------------------------------------------
+## faust/dsp/libfaust-signal
+##
+
+# signals share the lib context of boxes (see faust_box.pxi)
+signal_context = box_context
+
+
+cdef class Signal:
+    """faust Signal wrapper, only valid in the lib context it was built in."""
+    cdef fs.Signal ptr
+    cdef int context
+
+    def __cinit__(self):
+        self.ptr = NULL
+        self.context = 0
+
+    @staticmethod
+    cdef Signal from_ptr(fs.Signal ptr):
+        cdef Signal sig = Signal.__new__(Signal)
+        sig.ptr = ptr
+        sig.context = _current_context()
+        return sig
+
+    cdef fs.Signal get_ptr(self) except NULL:
+        if self.ptr == NULL:
+            raise ValueError("signal is empty")
+        if not _lib_context_active or self.context != _lib_context_id:
+            raise RuntimeError("signal was built in a lib context which has been destroyed")
+        return self.ptr
+
+    def __repr__(self):
+        return self.print() if self.is_valid else "<invalid Signal>"
+
+    def print(self, bint shared=False, int max_size=256) -> str:
+        """Return the textual form of the signal."""
+        return fs.printSignal(self.get_ptr(), shared, max_size).decode()
+
+    @property
+    def is_valid(self) -> bool:
+        """Whether the signal is alive."""
+        return self.ptr != NULL and _lib_context_active and self.context == _lib_context_id
+
+
+cdef fs.tvec _signal_vector(signals) except *:
+    cdef fs.tvec res
+    for sig in signals:
+        if not isinstance(sig, Signal):
+            raise TypeError("a list of Signal is expected")
+        res.push_back((<Signal>sig).get_ptr())
+    return res
+
+
+def sig_int(int n) -> Signal:
+    """Constant integer signal."""
+    return Signal.from_ptr(fs.sigInt(n))
+
+def sig_real(double n) -> Signal:
+    """Constant real signal."""
+    return Signal.from_ptr(fs.sigReal(n))
+
+def sig_input(int idx) -> Signal:
+    """Input signal of index 'idx'."""
+    return Signal.from_ptr(fs.sigInput(idx))
+
+def sig_delay(Signal s, Signal delay) -> Signal:
+    """Signal delayed by 'delay' samples."""
+    return Signal.from_ptr(fs.sigDelay(s.get_ptr(), delay.get_ptr()))
+
+def sig_bin_op(int op, Signal x, Signal y) -> Signal:
+    """Binary operation (op is one of the SOperator kAdd... values)."""
+    if op < <int>fs.kAdd or op > <int>fs.kXOR:
+        raise ValueError(f"invalid operator {op}")
+    return Signal.from_ptr(fs.sigBinOp(<fs.SOperator>op, x.get_ptr(), y.get_ptr()))
+
+def create_source_from_signals(name_app: str, signals: list, lang: str, *args) -> str:
+    """Create source code in a target language from a list of output signals."""
+    cdef ParamArray params = ParamArray(args)
+    cdef string error_msg
+    cdef fs.tvec osigs = _signal_vector(signals)
+    cdef string code = fs.createSourceFromSignals(
+        name_app.encode('utf8'),
+        osigs,
+        lang.encode('utf8'),
+        params.argc,
+        params.argv,
+        error_msg
+    )
+    if code.empty():
+        _raise_error(FaustCompileError, error_msg, args)
+    return code.decode()
+
+
+def analyze_signals(list signals, bint normalize=True) -> dict:
+    """Estimate the cost of a list of output signals before compiling them.
+
+    signals - the output signals
+    normalize - whether to first simplify the signals to normal form (required to bound variable delays)
+
+    Returns a dict with the node counts by operator class ('nodes'), the delay lines
+    and table memory in samples, and the estimated operations per sample, per block
+    and at init. 'opaque_nodes' counts the nodes whose operands could not be analysed.
+    """
+    cdef fs.signal_cost_analyzer analyzer
+    cdef fs.signal_cost cost = analyzer.analyze(_signal_vector(signals), normalize)
+    return {
+        'nodes': {k.decode(): v for k, v in cost.fNodes},
+        'num_nodes': cost.fNumNodes,
+        'num_delays': cost.fNumDelays,
+        'delay_memory': cost.fDelayMemory,
+        'max_delay': cost.fMaxDelay,
+        'unbounded_delays': cost.fUnboundedDelays,
+        'num_tables': cost.fNumTables,
+        'table_memory': cost.fTableMemory,
+        'unknown_tables': cost.fUnknownTables,
+        'opaque_nodes': cost.fOpaqueNodes,
+        'sample_ops': cost.fSampleOps,
+        'control_ops': cost.fControlOps,
+        'init_ops': cost.fInitOps,
+    }
+
+## bulk construction (same layout as box_from_arrays)
+
+cpdef enum SigOp:
+    SIG_OP_INT          # values[i]
+    SIG_OP_REAL         # values[i]
+    SIG_OP_INPUT        # input index in values[i]
+    SIG_OP_DELAY        # (x, d)
+    SIG_OP_DELAY1       # (x)
+    SIG_OP_INTCAST      # (x)
+    SIG_OP_FLOATCAST    # (x)
+    SIG_OP_SELECT2      # (selector, x, y)
+    SIG_OP_BINOP        # (x, y), SOperator in values[i]
+    SIG_OP_SELF         # the recursive signal, inside a SIG_OP_RECURSION
+    SIG_OP_RECURSION    # (x)
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef Py_ssize_t _build_signals(const int[::1] opcodes, const int[:, ::1] args, const double[::1] values,
+                               vector[fs.Signal]& nodes) noexcept nogil:
+    """Build all nodes in order, return the index of the first invalid node or -1."""
+    cdef Py_ssize_t i
+    cdef int a, b, c, n, op
+    cdef fs.Signal x, y, z
+    for i in range(opcodes.shape[0]):
+        op = opcodes[i]
+        a = args[i, 0]
+        b = args[i, 1]
+        c = args[i, 2]
+        n = _num_args(a, b, c)
+        if n < 0 or a >= i or b >= i or c >= i:
+            return i
+        x = nodes[a] if a >= 0 else NULL
+        y = nodes[b] if b >= 0 else NULL
+        z = nodes[c] if c >= 0 else NULL
+        if op == SIG_OP_INT and n == 0 and _is_int(values[i]):
+            nodes[i] = fs.sigInt(<int>values[i])
+        elif op == SIG_OP_REAL and n == 0:
+            nodes[i] = fs.sigReal(values[i])
+        elif op == SIG_OP_INPUT and n == 0 and _is_int(values[i]) and values[i] >= 0:
+            nodes[i] = fs.sigInput(<int>values[i])
+        elif op == SIG_OP_DELAY and n == 2:
+            nodes[i] = fs.sigDelay(x, y)
+        elif op == SIG_OP_DELAY1 and n == 1:
+            nodes[i] = fs.sigDelay1(x)
+        elif op == SIG_OP_INTCAST and n == 1:
+            nodes[i] = fs.sigIntCast(x)
+        elif op == SIG_OP_FLOATCAST and n == 1:
+            nodes[i] = fs.sigFloatCast(x)
+        elif op == SIG_OP_SELECT2 and n == 3:
+            nodes[i] = fs.sigSelect2(x, y, z)
+        elif op == SIG_OP_BINOP and n == 2 and _is_int(values[i]) and <int>fs.kAdd <= values[i] <= <int>fs.kXOR:
+            nodes[i] = fs.sigBinOp(<fs.SOperator><int>values[i], x, y)
+        elif op == SIG_OP_SELF and n == 0:
+            nodes[i] = fs.sigSelf()
+        elif op == SIG_OP_RECURSION and n == 1:
+            nodes[i] = fs.sigRecursion(x)
+        else:
+            return i
+        if nodes[i] == NULL:
+            return i
+    return -1
+
+
+def sig_from_arrays(const int[::1] opcodes, const int[:, ::1] args, const double[::1] values, outputs=None):
+    """Build a whole signal graph in a single native call.
+
+    opcodes - int32 array of SIG_OP_* codes, one per node in topological order
+    args - (n, 3) int32 array of operand node indices, -1 when unused
+    values - float64 array of constants, input indexes (SIG_OP_INPUT) and operators (SIG_OP_BINOP)
+    outputs - node indexes of the output signals
+
+    Returns the last node as a Signal, or the list of output signals if 'outputs' is given.
+    libfaust is not thread safe, so the GIL is kept during the call.
+    """
+    cdef Py_ssize_t n = _check_program(opcodes, args, values)
+    cdef vector[fs.Signal] nodes
+    cdef Py_ssize_t error
+    nodes.resize(n)
+    _current_context()
+    error = _build_signals(opcodes, args, values, nodes)
+    if error >= 0:
+        raise ValueError(f"invalid node {error}: opcode {opcodes[error]}, args {[args[error, 0], args[error, 1], args[error, 2]]}")
+    if outputs is None:
+        return Signal.from_ptr(nodes[n - 1])
+    res = []
+    for i in outputs:
+        if i < 0 or i >= n:
+            raise IndexError(f"output node {i} out of range")
+        res.append(Signal.from_ptr(nodes[i]))
+    return res
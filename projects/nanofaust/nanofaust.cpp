@@ -3,16 +3,26 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
+#include <nanobind/stl/map.h>
+#include <nanobind/ndarray.h>
 
 // faust
 #include "faust/dsp/dsp.h"
+#include "faust/dsp/dsp-arena.h"
+#include "faust/dsp/dsp-pool.h"
+#include "faust/dsp/dsp-snapshot.h"
+#include "faust/dsp/dsp-bench.h"
+#include "faust/dsp/dsp-combiner.h"
 #include "faust/dsp/libfaust.h"
 #include "faust/dsp/libfaust-signal.h"
 #include "faust/dsp/libfaust-box.h"
 #include "faust/dsp/interpreter-dsp.h"
+#include "faust/dsp/interpreter-dsp-cache.h"
+#include "faust/dsp/signal-cost.h"
 #include "faust/audio/rtaudio-dsp.h"
 #include "faust/gui/meta.h"
 #include "faust/gui/PrintUI.h"
+#include "faust/gui/MapUI.h"
 // #include "faust/compiler/tlib/tree.hh" // for CTree
 
 // rtaudio
@@ -23,6 +33,154 @@ using namespace nb::literals;
 
 struct CTree {};
 
+// Exception types raised when a factory cannot be created (created at module initialization)
+static PyObject* FaustError = nullptr;
+static PyObject* FaustCompileError = nullptr;
+static PyObject* FaustBitcodeError = nullptr;
+
+// Raise a Python exception carrying the libfaust error message and the compile options, without touching stdio
+[[noreturn]] static void raise_faust_error(PyObject* type, const std::string& error_msg, const std::vector<std::string>& args)
+{
+    std::string message = error_msg.substr(0, error_msg.find_last_not_of(" \n") + 1);
+    std::string compile_options;
+    for (const auto& it : args) {
+        compile_options += (compile_options.empty() ? "" : " ") + it;
+    }
+    nb::object error = nb::borrow(type)(message);
+    error.attr("message") = message;
+    error.attr("warnings") = nb::list();
+    error.attr("compile_options") = compile_options;
+    PyErr_SetObject(type, error.ptr());
+    throw nb::python_error();
+}
+
+// Convert arguments to the argv form expected by libfaust
+static std::vector<const char*> make_argv(const std::vector<std::string>& args)
+{
+    std::vector<const char*> argv;
+    argv.reserve(args.size());
+    for (const auto& it : args) argv.push_back(it.c_str());
+    return argv;
+}
+
+typedef nb::ndarray<float, nb::ndim<2>, nb::c_contig, nb::device::cpu> audio_buffer;
+
+// Compute one block of (channels, frames) buffers without the GIL ('inputs' may be None without inputs)
+static void compute_dsp(dsp& self, audio_buffer inputs, audio_buffer outputs)
+{
+    int n_ins = self.getNumInputs();
+    int n_outs = self.getNumOutputs();
+    int count = int(outputs.shape(1));
+    if (int(outputs.shape(0)) < n_outs) {
+        throw nb::value_error("not enough channels in buffers");
+    }
+    if (n_ins > 0 && (!inputs.is_valid() || int(inputs.shape(0)) < n_ins)) {
+        throw nb::value_error("not enough channels in buffers");
+    }
+    if (n_ins > 0 && int(inputs.shape(1)) < count) {
+        throw nb::value_error("input buffers are shorter than output buffers");
+    }
+    std::vector<float*> ins(n_ins), outs(n_outs);
+    // Empty buffers have no first frame to point to
+    if (count > 0) {
+        for (int i = 0; i < n_ins; i++) ins[i] = inputs.data() + i * inputs.shape(1);
+        for (int i = 0; i < n_outs; i++) outs[i] = outputs.data() + i * outputs.shape(1);
+    }
+    nb::gil_scoped_release release;
+    AVOIDDENORMALS;
+    self.compute(count, ins.data(), outs.data());
+}
+
+// A contiguous view of the buffer of a Python object, released with the view
+struct buffer_view : public Py_buffer {
+
+    buffer_view(nb::handle obj)
+    {
+        if (PyObject_GetBuffer(obj.ptr(), this, PyBUF_C_CONTIGUOUS) != 0) throw nb::python_error();
+    }
+    ~buffer_view() { PyBuffer_Release(this); }
+
+    buffer_view(const buffer_view&) = delete;
+    buffer_view& operator=(const buffer_view&) = delete;
+
+};
+
+// Number of MapUI objects pointing to the controls of each C++ instance (only accessed with the GIL held):
+// such instances cannot be given to a combiner, which would delete them with the combined DSP
+static std::map<dsp*, int> gDspUsers;
+
+// A MapUI registered as a user of its instance
+struct dsp_map_ui : public MapUI {
+
+    dsp* fDSP;
+
+    dsp_map_ui(dsp* instance):fDSP(instance)
+    {
+        instance->buildUserInterface(this);
+        gDspUsers[fDSP]++;
+    }
+
+    virtual ~dsp_map_ui()
+    {
+        if (--gDspUsers[fDSP] == 0) gDspUsers.erase(fDSP);
+    }
+
+};
+
+// Return the C++ instance of an InterpreterDsp or a CombinedDsp owned by Python
+static dsp* get_owned_dsp(nb::handle instance)
+{
+    if (!nb::isinstance<interpreter_dsp>(instance) && !nb::isinstance<dsp_binary_combiner>(instance)) {
+        throw nb::type_error("an InterpreterDsp or a CombinedDsp is expected");
+    }
+    if (!nb::inst_ready(instance)) {
+        throw nb::value_error("instance was already combined");
+    }
+    if (!nb::inst_state(instance).second) {
+        throw nb::value_error("instances acquired from a pool cannot be combined");
+    }
+    dsp* ptr = nb::cast<dsp*>(instance);
+    if (gDspUsers.count(ptr)) {
+        throw nb::value_error("instances used by a MapUI cannot be combined");
+    }
+    return ptr;
+}
+
+// Combine two instances with one of the createDSPXXX functions: on success, the result owns the C++ instances
+// and the Python objects cannot be used anymore (they are kept alive by the result, with their factory)
+template <typename CREATE>
+static dsp_binary_combiner* combine_dsp(nb::handle dsp1, nb::handle dsp2, int layout, CREATE create)
+{
+    if (layout < kVerticalGroup || layout > kTabGroup) {
+        throw nb::value_error("invalid layout");
+    }
+    dsp* ptr1 = get_owned_dsp(dsp1);
+    dsp* ptr2 = get_owned_dsp(dsp2);
+    if (ptr1 == ptr2) {
+        throw nb::value_error("an instance cannot be combined with itself");
+    }
+    std::string error_msg;
+    dsp* res = create(ptr1, ptr2, error_msg, Layout(layout));
+    if (!res) {
+        throw nb::value_error(error_msg.substr(0, error_msg.find_last_not_of(" \n") + 1).c_str());
+    }
+    nb::inst_set_state(dsp1, false, false);
+    nb::inst_set_state(dsp2, false, false);
+    return static_cast<dsp_binary_combiner*>(res);
+}
+
+// Return the Python object of a factory returned by an interpreter_dsp_factory_cache: the reference taken
+// by the cache is given back when the object is deleted, so after all its instances (which keep it alive)
+static nb::object cached_factory(nb::handle cache, interpreter_dsp_factory* factory)
+{
+    nb::object res = nb::cast(factory, nb::rv_policy::reference);
+    nb::object owner = nb::borrow(cache);
+    nb::module_::import_("weakref").attr("finalize")(res, nb::cpp_function([owner, factory]() {
+        nb::cast<interpreter_dsp_factory_cache&>(owner).release(factory);
+    }));
+    return res;
+}
+
 // struct DspMeta : Meta, std::map<const char*, const char*>
 // {
 //     void declare(const char* key, const char* value)
@@ -37,11 +195,52 @@ NB_MODULE(nanofaust, m)
     m.doc() = "nanofaust: a nanobind wrapper around the faust interpreter.";
     m.attr("__version__") = "0.0.1";
 
+    // -----------------------------------------------------------------------
+    // exceptions
+
+    FaustError = PyErr_NewExceptionWithDoc("nanofaust.FaustError", "Error reported by libfaust, with 'message', 'warnings' and 'compile_options' attributes.", PyExc_RuntimeError, nullptr);
+    FaustCompileError = PyErr_NewExceptionWithDoc("nanofaust.FaustCompileError", "DSP code could not be compiled.", FaustError, nullptr);
+    FaustBitcodeError = PyErr_NewExceptionWithDoc("nanofaust.FaustBitcodeError", "Bitcode could not be read.", FaustError, nullptr);
+    m.attr("FaustError") = nb::handle(FaustError);
+    m.attr("FaustCompileError") = nb::handle(FaustCompileError);
+    m.attr("FaustBitcodeError") = nb::handle(FaustBitcodeError);
+
     // -----------------------------------------------------------------------
     // faust/dsp/dsp.h
 
     nb::class_<dsp>(m, "Dsp");
 
+    nb::class_<dsp_memory_manager>(m, "DspMemoryManager");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-arena.h
+
+    nb::class_<arena_memory_manager, dsp_memory_manager>(m, "ArenaMemoryManager")
+        .def(nb::init<size_t, bool, size_t>(), "chunk_size"_a = 0, "huge_pages"_a = false, "alignment"_a = ARENA_CACHE_LINE)
+        .def("reserve", &arena_memory_manager::reserve, "Make sure 'size' contiguous bytes are available without further allocation")
+        .def("trim", &arena_memory_manager::trim, "Release all chunks which do not contain any live memory zone")
+        .def_prop_ro("allocated_size", &arena_memory_manager::getAllocatedSize, "Size in bytes of the memory zones currently allocated")
+        .def_prop_ro("reserved_size", &arena_memory_manager::getReservedSize, "Size in bytes of all chunks reserved by the arena")
+        .def_prop_ro("num_zones", &arena_memory_manager::getNumZones, "Number of memory zones currently allocated")
+        .def_prop_ro("num_chunks", &arena_memory_manager::getNumChunks, "Number of chunks reserved by the arena")
+        .def_prop_ro("planned_size", &arena_memory_manager::getPlannedSize, "Instance size in bytes computed by the last sizing pass")
+        .def_prop_ro("alignment", &arena_memory_manager::getAlignment)
+        .def_prop_ro("huge_pages", &arena_memory_manager::hasHugePages)
+        .def("snapshot", [](arena_memory_manager& self, interpreter_dsp* instance) {
+            std::string error_msg;
+            dsp_snapshot* snapshot = dsp_snapshot::capture(instance, &self, error_msg);
+            if (!snapshot) throw std::runtime_error(error_msg);
+            return snapshot;
+        }, "dsp"_a, "Capture the complete state of an instance created while this arena was set on its factory")
+        .def("restore", [](arena_memory_manager& self, interpreter_dsp* instance, const dsp_snapshot& snapshot) {
+            std::string error_msg;
+            if (!snapshot.restore(instance, &self, error_msg)) throw std::runtime_error(error_msg);
+        }, "dsp"_a, "snapshot"_a, "Restore the state of an instance from a snapshot of an instance of the same factory")
+        .def("clone", [](arena_memory_manager& self, interpreter_dsp* instance) {
+            return cloneArenaDSPInstance(instance, &self);
+        }, "dsp"_a, nb::keep_alive<0, 2>(), "Clone an instance created while this arena was set on its factory, so that the clone can also be snapshotted")
+        ;
+
     
     // -----------------------------------------------------------------------
     // faust/dsp/libfaust-signal.h
@@ -89,51 +288,69 @@ NB_MODULE(nanofaust, m)
     m.def("create_interpreter_dsp_factory_from_file", [](const std::string& filename, nb::args& args) -> interpreter_dsp_factory* {
         std::vector<std::string> params;
         std::string error_msg;
-        std::vector<const char *> argv;
         for (const auto &arg : args) {
             params.push_back(nb::cast<std::string>(arg));
         }
-        argv.reserve(params.size());
-        for (auto &i : params)
-            argv.push_back(const_cast<char *>(i.c_str()));
-        interpreter_dsp_factory* factory = (interpreter_dsp_factory*)createInterpreterDSPFactoryFromFile(filename, argv.size(), argv.data(), error_msg);
-        if (!factory) {
-            std::cerr << "Cannot create factory : " << error_msg;
-            return NULL;
-        }
+        std::vector<const char*> argv = make_argv(params);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromFile(filename, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, params);
         return factory;
     }, "Create a Faust DSP factory from a DSP source code as a file.", nb::rv_policy::reference);
-    // }, nb::args("filename"), nb::args("args"), "Create a Faust DSP factory from a DSP source code as a file.", nb::rv_policy::reference);
 
-    m.def("create_interpreter_dsp_factory_from_string", [](const std::string& name_app, const std::string& dsp_content, std::vector<std::string> args, std::string& error_msg) {
-        std::vector<const char *> argv;
-        argv.reserve(args.size());
-        for (auto &i : args) argv.push_back(const_cast<char *>(i.c_str()));
-        return createInterpreterDSPFactoryFromString(name_app, dsp_content, argv.size(), argv.data(), error_msg);
-    }, "Create a Faust DSP factory from a DSP source code as a string.");
+    m.def("create_interpreter_dsp_factory_from_string", [](const std::string& name_app, const std::string& dsp_content, std::vector<std::string> args) {
+        std::string error_msg;
+        std::vector<const char*> argv = make_argv(args);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromString(name_app, dsp_content, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+        return factory;
+    }, "name_app"_a, "dsp_content"_a, "args"_a = std::vector<std::string>(), "Create a Faust DSP factory from a DSP source code as a string.", nb::rv_policy::reference);
 
-    m.def("create_interpreter_dsp_factory_from_signals", [](const std::string& name_app, tvec signals, std::vector<std::string> args, std::string& error_msg) {
-        std::vector<const char *> argv;
-        argv.reserve(args.size());
-        for (auto &i : args) argv.push_back(const_cast<char *>(i.c_str()));    
-        return createInterpreterDSPFactoryFromSignals(name_app, signals, argv.size(), argv.data(), error_msg);
-    }, "Create a Faust DSP factory from a vector of output signals.");
+    m.def("create_interpreter_dsp_factory_from_signals", [](const std::string& name_app, tvec signals, std::vector<std::string> args) {
+        std::string error_msg;
+        std::vector<const char*> argv = make_argv(args);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromSignals(name_app, signals, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+        return factory;
+    }, "Create a Faust DSP factory from a vector of output signals.", nb::rv_policy::reference);
 
-    m.def("create_interpreter_dsp_factory_from_boxes", [](const std::string& name_app, Box box, std::vector<std::string> args, std::string& error_msg) {
-        std::vector<const char *> argv;
-        argv.reserve(args.size());
-        for (auto &i : args) argv.push_back(const_cast<char *>(i.c_str()));    
-        return createInterpreterDSPFactoryFromBoxes(name_app, box, argv.size(), argv.data(), error_msg);
-    }, "Create a Faust DSP factory from a box expression.");
+    m.def("create_interpreter_dsp_factory_from_boxes", [](const std::string& name_app, Box box, std::vector<std::string> args) {
+        std::string error_msg;
+        std::vector<const char*> argv = make_argv(args);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromBoxes(name_app, box, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+        return factory;
+    }, "Create a Faust DSP factory from a box expression.", nb::rv_policy::reference);
 
     m.def("delete_interpreter_dsp_factory", &deleteInterpreterDSPFactory, "Delete a Faust DSP factory,");
     m.def("delete_all_interpreter_dsp_factories", &deleteAllInterpreterDSPFactories, "Delete all Faust DSP factories kept in the library cache.");
     m.def("get_all_interpreter_dsp_factories", &getAllInterpreterDSPFactories, "Return Faust DSP factories of the library cache as a vector of their SHA keys.");
     m.def("start_multithreaded_dsp_factories", &startMTDSPFactories, "Start multi-thread access mode");
     m.def("stop_multithreaded_dsp_factories", &stopMTDSPFactories, "Stop multi-thread access mode");
-    m.def("read_interpreter_dsp_factory_from_bitcode", &readInterpreterDSPFactoryFromBitcode, "Create a Faust DSP factory from a bitcode string.");
+    m.def("read_interpreter_dsp_factory_from_bitcode", [](const std::string& bitcode) {
+        std::string error_msg;
+        interpreter_dsp_factory* factory = readInterpreterDSPFactoryFromBitcode(bitcode, error_msg);
+        if (!factory) raise_faust_error(FaustBitcodeError, error_msg, {});
+        return factory;
+    }, "Create a Faust DSP factory from a bitcode string.", nb::rv_policy::reference);
     m.def("write_interpreter_dsp_factory_to_bitcode", &writeInterpreterDSPFactoryToBitcode, "Write a Faust DSP factory into a bitcode string.");
-    m.def("read_interpreter_dsp_factory_from_bitcode_file", &readInterpreterDSPFactoryFromBitcodeFile, "Create a Faust DSP factory from a bitcode file.");
+    m.def("read_interpreter_dsp_factory_from_bitcode_buffer", [](nb::handle buffer) {
+        // libfaust is not thread safe: the GIL is kept
+        buffer_view view(buffer);
+        std::string error_msg;
+        interpreter_dsp_factory* factory = readInterpreterDSPFactoryFromBitcode(std::string(static_cast<const char*>(view.buf), view.len), error_msg);
+        if (!factory) raise_faust_error(FaustBitcodeError, error_msg, {});
+        return factory;
+    }, "buffer"_a, "Create a Faust DSP factory from bitcode in any buffer (bytes, memoryview, mmap...), without text decoding.", nb::rv_policy::reference);
+    m.def("write_interpreter_dsp_factory_to_bitcode_bytes", [](interpreter_dsp_factory* factory) {
+        std::string bitcode = writeInterpreterDSPFactoryToBitcode(factory);
+        return nb::bytes(bitcode.data(), bitcode.size());
+    }, "factory"_a, "Write a Faust DSP factory into bitcode bytes, without text decoding.");
+    m.def("read_interpreter_dsp_factory_from_bitcode_file", [](const std::string& bit_code_path) {
+        std::string error_msg;
+        interpreter_dsp_factory* factory = readInterpreterDSPFactoryFromBitcodeFile(bit_code_path, error_msg);
+        if (!factory) raise_faust_error(FaustBitcodeError, error_msg, {});
+        return factory;
+    }, "Create a Faust DSP factory from a bitcode file.", nb::rv_policy::reference);
     m.def("write_interpreter_dsp_factory_to_bitcode_file", &writeInterpreterDSPFactoryToBitcodeFile, "Write a Faust DSP factory into a bitcode file.");
 
     nb::class_<interpreter_dsp, dsp>(m, "InterpreterDsp")
@@ -150,12 +367,14 @@ NB_MODULE(nanofaust, m)
         .def("instance_constants", &interpreter_dsp::instanceConstants, "Init instance constant state")
         .def("instance_reset_user_interface", &interpreter_dsp::instanceResetUserInterface, "Init default control parameters values")
         .def("instance_clear", &interpreter_dsp::instanceClear, "Init instance state but keep the control parameter values")
-        .def("clone", &interpreter_dsp::clone, "Return a clone of the instance.")
+        .def("clone", &interpreter_dsp::clone, nb::keep_alive<0, 1>(), "Return a clone of the instance.")
         .def("metadata", &interpreter_dsp::metadata, "Trigger the Meta* parameter with instance specific calls to 'declare' (key, value) metadata.")
-        // .def("compute", &interpreter_dsp::compute, "DSP instance computation, to be called with successive in/out audio buffers.")
+        .def("compute", [](interpreter_dsp& self, audio_buffer inputs, audio_buffer outputs) {
+            compute_dsp(self, inputs, outputs);
+        }, "inputs"_a.none(), "outputs"_a, "DSP instance computation of one block of (channels, frames) float32 buffers (inputs may be None without inputs), without the GIL.")
         ;
 
-    nb::class_<interpreter_dsp_factory>(m, "InterpreterDspFactory")
+    nb::class_<interpreter_dsp_factory>(m, "InterpreterDspFactory", nb::is_weak_referenceable())
         .def("get_name", &interpreter_dsp_factory::getName, "Return factory name")
         .def("get_sha_key", &interpreter_dsp_factory::getSHAKey, "Return factory SHA key")
         .def("get_dsp_code", &interpreter_dsp_factory::getDSPCode, "Return factory expanded DSP code")
@@ -163,11 +382,258 @@ NB_MODULE(nanofaust, m)
         .def("get_library_list", &interpreter_dsp_factory::getLibraryList, "Get the Faust DSP factory list of library dependancies")
         .def("get_include_pathnames", &interpreter_dsp_factory::getIncludePathnames, "Get the list of all used includes")
         .def("get_warning_messages", &interpreter_dsp_factory::getWarningMessages, "Get warning messages list for a given compilation")
-        .def("create_dsp_instance", &interpreter_dsp_factory::createDSPInstance, "Create a new DSP instance, to be deleted with C++ 'delete'")
-        .def("set_memory_manager", &interpreter_dsp_factory::setMemoryManager, "Set a custom memory manager to be used when creating instances")
-        .def("get_memory_manager", &interpreter_dsp_factory::getMemoryManager, "Return the currently set custom memory manager")
+        .def("create_dsp_instance", &createArenaDSPInstance<interpreter_dsp_factory>, nb::keep_alive<0, 1>(), "Create a new DSP instance, which keeps the factory alive")
+        .def("set_memory_manager", &interpreter_dsp_factory::setMemoryManager, nb::keep_alive<1, 2>(), nb::arg("manager").none(), "Set a custom memory manager to be used when creating instances")
+        .def("get_memory_manager", &interpreter_dsp_factory::getMemoryManager, nb::rv_policy::reference, "Return the currently set custom memory manager")
         ;
 
+    // -----------------------------------------------------------------------
+    // faust/dsp/signal-cost.h
+
+    nb::class_<signal_cost>(m, "SignalCost")
+        .def_ro("nodes", &signal_cost::fNodes, "Number of distinct nodes by operator class")
+        .def_ro("num_nodes", &signal_cost::fNumNodes, "Number of distinct nodes")
+        .def_ro("num_delays", &signal_cost::fNumDelays, "Number of delay lines (one per delayed signal)")
+        .def_ro("delay_memory", &signal_cost::fDelayMemory, "Total of the maximal delay amounts of each line in samples")
+        .def_ro("max_delay", &signal_cost::fMaxDelay, "Longest delay line in samples")
+        .def_ro("unbounded_delays", &signal_cost::fUnboundedDelays, "Variable delays without a finite maximum")
+        .def_ro("num_tables", &signal_cost::fNumTables, "Number of tables")
+        .def_ro("table_memory", &signal_cost::fTableMemory, "Total of the known table sizes in samples")
+        .def_ro("unknown_tables", &signal_cost::fUnknownTables, "Tables with a non constant size, or waveforms")
+        .def_ro("opaque_nodes", &signal_cost::fOpaqueNodes, "Nodes whose operands could not be analysed")
+        .def_ro("sample_ops", &signal_cost::fSampleOps, "Estimated operations per sample")
+        .def_ro("control_ops", &signal_cost::fControlOps, "Estimated operations per block")
+        .def_ro("init_ops", &signal_cost::fInitOps, "Estimated operations at init time")
+        ;
+
+    m.def("analyze_signals", [](tvec signals, bool normalize) {
+        signal_cost_analyzer analyzer;
+        return analyzer.analyze(signals, normalize);
+    }, "signals"_a, "normalize"_a = true, "Estimate the cost of a vector of output signals before compiling them.");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/interpreter-dsp-cache.h
+
+    nb::class_<interpreter_dsp_factory_cache>(m, "InterpreterDspFactoryCache")
+        .def(nb::init<>())
+        .def("create_from_signals", [](interpreter_dsp_factory_cache& self, const std::string& name_app, tvec signals, std::vector<std::string> args) {
+            std::string error_msg;
+            std::vector<const char*> argv = make_argv(args);
+            interpreter_dsp_factory* factory = self.createFromSignals(name_app, signals, argv.size(), argv.data(), error_msg);
+            if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+            return cached_factory(nb::find(&self), factory);
+        }, "name_app"_a, "signals"_a, "args"_a = std::vector<std::string>(), "Return the factory of a vector of output signals, compiled only if no equal graph was compiled before", nb::keep_alive<0, 1>())
+        .def("create_from_boxes", [](interpreter_dsp_factory_cache& self, const std::string& name_app, Box box, std::vector<std::string> args) {
+            std::string error_msg;
+            std::vector<const char*> argv = make_argv(args);
+            interpreter_dsp_factory* factory = self.createFromBoxes(name_app, box, argv.size(), argv.data(), error_msg);
+            if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+            return cached_factory(nb::find(&self), factory);
+        }, "name_app"_a, "box"_a, "args"_a = std::vector<std::string>(), "Return the factory of a box expression, compiled only if no equal expression was compiled before", nb::keep_alive<0, 1>())
+        .def("remove", &interpreter_dsp_factory_cache::remove, "factory"_a, "Delete a factory of the cache, False if it was not found or is still used")
+        .def("clear", &interpreter_dsp_factory_cache::clear, "Delete the factories of the cache which are not used anymore (by an instance or a Python object), return the number of factories kept")
+        .def_prop_ro("size", &interpreter_dsp_factory_cache::getSize, "Number of cached factories")
+        .def_prop_ro("hits", &interpreter_dsp_factory_cache::getHits, "Number of requests served from the cache")
+        .def_prop_ro("misses", &interpreter_dsp_factory_cache::getMisses, "Number of requests which needed a compilation")
+        ;
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-combiner.h
+
+    m.attr("LAYOUT_VERTICAL") = int(kVerticalGroup);
+    m.attr("LAYOUT_HORIZONTAL") = int(kHorizontalGroup);
+    m.attr("LAYOUT_TAB") = int(kTabGroup);
+    m.attr("CROSSFADE_LINEAR") = int(kLinearCurve);
+    m.attr("CROSSFADE_EQUAL_POWER") = int(kEqualPowerCurve);
+
+    nb::class_<dsp_binary_combiner, dsp>(m, "CombinedDsp")
+        .def("get_numinputs", &dsp::getNumInputs, "Return the number of audio inputs")
+        .def("get_numoutputs", &dsp::getNumOutputs, "Return the number of audio outputs")
+        .def("build_user_interface", [](dsp_binary_combiner &self) {
+            PrintUI print_ui;
+            self.buildUserInterface(&print_ui);
+         }, "Print the user interface of all combined instances")
+        .def("get_samplerate", &dsp::getSampleRate, "Return the sample rate currently used by the instances")
+        .def("init", &dsp::init, "Global init of all combined instances")
+        .def("instance_init", &dsp::instanceInit, "Init the state of all combined instances")
+        .def("instance_constants", &dsp::instanceConstants, "Init the constant state of all combined instances")
+        .def("instance_reset_user_interface", &dsp::instanceResetUserInterface, "Init default control parameters values")
+        .def("instance_clear", &dsp::instanceClear, "Init the state of all combined instances but keep the control parameter values")
+        .def("prepare", [](dsp_binary_combiner& self, int buffer_size) {
+            if (buffer_size <= 0) throw nb::value_error("buffer_size must be positive");
+            self.prepare(buffer_size);
+        }, "buffer_size"_a, "Set the largest block size computed without subdivision (typically the audio driver buffer size)")
+        .def("get_buffersize", &dsp_binary_combiner::getBufferSize, "Return the block size set with prepare (4096 by default)")
+        .def("clone", [](dsp_binary_combiner& self) {
+            return static_cast<dsp_binary_combiner*>(self.clone());
+        }, nb::keep_alive<0, 1>(), "Return a clone of the combined DSP (with clones of all instances)")
+        .def("compute", [](dsp_binary_combiner& self, audio_buffer inputs, audio_buffer outputs) {
+            compute_dsp(self, inputs, outputs);
+        }, "inputs"_a.none(), "outputs"_a, "Compute the whole combined DSP on one block of (channels, frames) float32 buffers (inputs may be None without inputs), without the GIL.")
+        ;
+
+    m.def("create_dsp_sequencer", [](nb::handle dsp1, nb::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPSequencer(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, "dsp1"_a, "dsp2"_a, "layout"_a = int(kTabGroup), "label"_a = "Sequencer", nb::keep_alive<0, 1>(), nb::keep_alive<0, 2>(),
+    "Connect the outputs of dsp1 to the inputs of dsp2 (Faust ':'), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_parallelizer", [](nb::handle dsp1, nb::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPParallelizer(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, "dsp1"_a, "dsp2"_a, "layout"_a = int(kTabGroup), "label"_a = "Parallelizer", nb::keep_alive<0, 1>(), nb::keep_alive<0, 2>(),
+    "Put dsp1 and dsp2 in parallel (Faust ','), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_splitter", [](nb::handle dsp1, nb::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPSplitter(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, "dsp1"_a, "dsp2"_a, "layout"_a = int(kTabGroup), "label"_a = "Splitter", nb::keep_alive<0, 1>(), nb::keep_alive<0, 2>(),
+    "Split the outputs of dsp1 to the inputs of dsp2 (Faust '<:'), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_merger", [](nb::handle dsp1, nb::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPMerger(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, "dsp1"_a, "dsp2"_a, "layout"_a = int(kTabGroup), "label"_a = "Merger", nb::keep_alive<0, 1>(), nb::keep_alive<0, 2>(),
+    "Mix the outputs of dsp1 to the inputs of dsp2 (Faust ':>'), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_recursiver", [](nb::handle dsp1, nb::handle dsp2, int layout, const std::string& label, int delay) {
+        if (delay < 0) throw nb::value_error("delay must be positive or 0");
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPRecursiver(ptr1, ptr2, error_msg, lay, label, delay);
+        });
+    }, "dsp1"_a, "dsp2"_a, "layout"_a = int(kTabGroup), "label"_a = "Recursiver", "delay"_a = 1, nb::keep_alive<0, 1>(), nb::keep_alive<0, 2>(),
+    "Feed back the outputs of dsp2 to the inputs of dsp1 (Faust '~') with a 'delay' frames feedback (0 to use the 'delay' metadata of dsp2), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_crossfader", [](nb::handle dsp1, nb::handle dsp2, int layout, const std::string& label, int curve, int preroll) {
+        if (curve != kLinearCurve && curve != kEqualPowerCurve) throw nb::value_error("invalid curve");
+        if (preroll < 0) throw nb::value_error("preroll must be positive or 0");
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPCrossfader(ptr1, ptr2, error_msg, lay, label, CrossfadeCurve(curve), preroll);
+        });
+    }, "dsp1"_a, "dsp2"_a, "layout"_a = int(kTabGroup), "label"_a = "Crossfade", "curve"_a = int(kLinearCurve), "preroll"_a = 0, nb::keep_alive<0, 1>(), nb::keep_alive<0, 2>(),
+    "Crossfade between dsp1 and dsp2 (with a 'Crossfade' slider, only dsp1 is computed at 1 and only dsp2 at 0) with CROSSFADE_LINEAR or CROSSFADE_EQUAL_POWER gains. A resumed DSP is first computed on the next 'preroll' input frames before being heard. The result owns both instances which cannot be used anymore.");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-pool.h
+
+    nb::class_<dsp_pool>(m, "InterpreterDspPool")
+        .def("__init__", [](dsp_pool* self, interpreter_dsp_factory* factory, int count, int sample_rate) {
+            new (self) dsp_pool(static_cast<dsp_factory*>(factory), count, sample_rate);
+        }, nb::keep_alive<1, 2>(), "factory"_a, "count"_a, "sample_rate"_a)
+        .def("__init__", [](dsp_pool* self, interpreter_dsp* prototype, int count, int sample_rate, arena_memory_manager* arena) {
+            new (self) dsp_pool(prototype, count, sample_rate, arena);
+        }, nb::keep_alive<1, 2>(), nb::keep_alive<1, 5>(), "prototype"_a, "count"_a, "sample_rate"_a, "arena"_a.none() = nb::none())
+        .def("reserve", &dsp_pool::reserve, "Pre-create instances so that the pool holds at least 'count' of them")
+        .def("acquire", [](dsp_pool& self) {
+            return static_cast<interpreter_dsp*>(self.acquire());
+        }, nb::rv_policy::reference, nb::keep_alive<0, 1>(), "Take an initialized instance from the pool, None if exhausted")
+        .def("release", [](dsp_pool& self, interpreter_dsp* instance) {
+            if (!self.release(instance)) throw nb::value_error("instance was not acquired from this pool, or already released");
+        }, "Give back an acquired instance, which is reset for the next use")
+        .def("__len__", &dsp_pool::getNumInstances)
+        .def_prop_ro("num_free", &dsp_pool::getNumFree, "Number of instances available for acquire")
+        .def_prop_ro("sample_rate", &dsp_pool::getSampleRate)
+        ;
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-snapshot.h
+
+    nb::class_<dsp_snapshot>(m, "DspSnapshot")
+        .def_static("from_bytes", [](nb::bytes data) {
+            std::string error_msg;
+            dsp_snapshot* snapshot = dsp_snapshot::fromBuffer(data.c_str(), data.size(), error_msg);
+            if (!snapshot) throw std::invalid_argument(error_msg);
+            return snapshot;
+        }, "data"_a, "Create a snapshot from the content returned by to_bytes")
+        .def_static("from_file", [](const std::string& path) {
+            std::string error_msg;
+            dsp_snapshot* snapshot = dsp_snapshot::fromFile(path, error_msg);
+            if (!snapshot) throw std::invalid_argument(error_msg);
+            return snapshot;
+        }, "path"_a, "Load (memory-map) a snapshot saved with save")
+        .def("save", [](const dsp_snapshot& self, const std::string& path) {
+            std::string error_msg;
+            if (!self.save(path, error_msg)) throw std::runtime_error(error_msg);
+        }, "path"_a, "Save the snapshot in a file")
+        .def("to_bytes", [](const dsp_snapshot& self) {
+            return nb::bytes(self.getData(), self.getSize());
+        }, "Return the snapshot content")
+        .def("__len__", &dsp_snapshot::getSize)
+        .def_prop_ro("sample_rate", &dsp_snapshot::getSampleRate, "Sample rate of the captured instance")
+        .def_prop_ro("num_zones", &dsp_snapshot::getNumZones)
+        .def_prop_ro("num_controls", &dsp_snapshot::getNumControls)
+        .def_prop_ro("state_size", &dsp_snapshot::getStateSize, "Size in bytes of the copied state")
+        .def_prop_ro("mapped", &dsp_snapshot::isMapped, "Whether the snapshot content is memory-mapped from a file")
+        ;
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-bench.h
+
+    nb::class_<bench_stats>(m, "BenchResult")
+        .def_ro("buffer_size", &bench_stats::fBufferSize)
+        .def_ro("count", &bench_stats::fCount, "Number of measured compute calls")
+        .def_ro("sample_rate", &bench_stats::fSampleRate, "Sample rate used to compute the CPU load")
+        .def_ro("mb_per_sec", &bench_stats::fMBPerSec, "Throughput in MBytes/sec of the best blocks (as faustbench)")
+        .def_ro("std_dev", &bench_stats::fStdDev, "Relative standard deviation of the best blocks (in %)")
+        .def_ro("mean", &bench_stats::fMean, "Mean block duration in seconds")
+        .def_ro("cpu_load", &bench_stats::fCPULoad, "Mean block duration relative to the block period at sample_rate")
+        .def_ro("samples_per_sec", &bench_stats::fSamplesPerSec, "Frames computed per second")
+        .def_ro("throughputs", &bench_stats::fThroughputs, "MBytes/sec of each measured block, in increasing order")
+        .def_prop_ro("percentiles", [](const bench_stats& self) {
+            nb::dict res;
+            res[nb::int_(0)] = self.fMin;
+            res[nb::int_(25)] = self.fP25;
+            res[nb::int_(50)] = self.fP50;
+            res[nb::int_(75)] = self.fP75;
+            res[nb::int_(90)] = self.fP90;
+            res[nb::int_(99)] = self.fP99;
+            res[nb::int_(100)] = self.fMax;
+            return res;
+        }, "Block duration percentiles in seconds")
+        .def_prop_ro("counters", [](const bench_stats& self) {
+            nb::dict res;
+            if (!self.fPerf.fValid) return res;
+            for (int i = 0; i < perf_counters::kNumCounters; i++) {
+                nb::str name(perf_counters::getName(i));
+                if (self.fPerf.fPerSample[i] < 0) {
+                    res[name] = nb::none();
+                } else {
+                    res[name] = nb::make_tuple(self.fPerf.fPerSample[i], self.fPerf.fPerChannelSample[i]);
+                }
+            }
+            return res;
+        }, "Hardware counters as (per_sample, per_channel_sample) tuples, None when not available on this CPU")
+        .def_prop_ro("ipc", [](const bench_stats& self) { return self.fPerf.fIPC; }, "Instructions per cycle (0 if not measured)")
+        ;
+
+    m.def("bench", [](interpreter_dsp* instance, int buffer_size, double duration, bool random_controls, double sample_rate, bool counters) {
+        if (buffer_size <= 0 || duration <= 0 || sample_rate <= 0) {
+            throw std::invalid_argument("buffer_size, duration and sample_rate must be positive");
+        }
+        nb::gil_scoped_release release;
+        return benchDSP<FAUSTFLOAT>(instance, buffer_size, duration, random_controls, sample_rate, counters);
+    }, "dsp"_a, "buffer_size"_a = 512, "duration"_a = 1.0, "random_controls"_a = true, "sample_rate"_a = 48000.0, "counters"_a = false,
+    "Measure the CPU use of a DSP instance (on a clone of it) with the GIL released");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp.h (denormals)
+
+    m.attr("DENORMALS_KEEP") = int(DENORMALS_KEEP);
+    m.attr("DENORMALS_FTZ") = int(DENORMALS_FTZ);
+    m.attr("DENORMALS_FTZ_DAZ") = int(DENORMALS_FTZ_DAZ);
+
+    m.def("set_denormal_policy", [](int policy) {
+        if (policy != DENORMALS_KEEP && policy != DENORMALS_FTZ && policy != DENORMALS_FTZ_DAZ) {
+            throw std::invalid_argument("invalid denormal policy");
+        }
+        ScopedNoDenormals::setPolicy(policy);
+    }, "policy"_a, "Set the denormal policy applied by audio drivers, compute and bench (DENORMALS_FTZ_DAZ by default)");
+    m.def("get_denormal_policy", &ScopedNoDenormals::getPolicy, "Return the denormal policy applied by audio drivers, compute and bench");
+
     // -----------------------------------------------------------------------
     // faust/audio/rtaudio-dsp.h
     
@@ -206,6 +672,17 @@ NB_MODULE(nanofaust, m)
         .def("declare", &PrintUI::declare)
         ;
 
+    // -----------------------------------------------------------------------
+    // faust/gui/MapUI.h
+
+    nb::class_<dsp_map_ui>(m, "MapUI")
+        .def(nb::init<dsp*>(), nb::keep_alive<1, 2>(), "dsp"_a)
+        .def("set_param_value", &MapUI::setParamValue, "path"_a, "value"_a, "Set the param value")
+        .def("get_param_value", &MapUI::getParamValue, "path"_a, "Return the param value")
+        .def("get_params_count", &MapUI::getParamsCount, "Return the number of params")
+        .def("get_param_address", nb::overload_cast<int>(&MapUI::getParamAddress), "index"_a, "Return the param path")
+        ;
+
     // -----------------------------------------------------------------------
     // faust/gui/meta.h
 
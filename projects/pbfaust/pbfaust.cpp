@@ -2,16 +2,27 @@
 
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+
+#include <set>
 
 // faust
 #include "faust/dsp/dsp.h"
+#include "faust/dsp/dsp-arena.h"
+#include "faust/dsp/dsp-pool.h"
+#include "faust/dsp/dsp-snapshot.h"
+#include "faust/dsp/dsp-bench.h"
+#include "faust/dsp/dsp-combiner.h"
 #include "faust/dsp/libfaust.h"
 #include "faust/dsp/libfaust-signal.h"
 #include "faust/dsp/libfaust-box.h"
 #include "faust/dsp/interpreter-dsp.h"
+#include "faust/dsp/interpreter-dsp-cache.h"
+#include "faust/dsp/signal-cost.h"
 #include "faust/audio/rtaudio-dsp.h"
 #include "faust/gui/meta.h"
 #include "faust/gui/PrintUI.h"
+#include "faust/gui/MapUI.h"
 // #include "faust/compiler/tlib/tree.hh" // for CTree
 
 // rtaudio
@@ -21,6 +32,179 @@ namespace py = pybind11;
 
 struct CTree {};
 
+// Exception types raised when a factory cannot be created (created at module initialization)
+static PyObject* FaustError = nullptr;
+static PyObject* FaustCompileError = nullptr;
+static PyObject* FaustBitcodeError = nullptr;
+
+// Raise a Python exception carrying the libfaust error message and the compile options, without touching stdio
+[[noreturn]] static void raise_faust_error(PyObject* type, const std::string& error_msg, const std::vector<std::string>& args)
+{
+    std::string message = error_msg.substr(0, error_msg.find_last_not_of(" \n") + 1);
+    std::string compile_options;
+    for (const auto& it : args) {
+        compile_options += (compile_options.empty() ? "" : " ") + it;
+    }
+    py::object error = py::reinterpret_borrow<py::object>(type)(message);
+    error.attr("message") = message;
+    error.attr("warnings") = py::list();
+    error.attr("compile_options") = compile_options;
+    PyErr_SetObject(type, error.ptr());
+    throw py::error_already_set();
+}
+
+// Convert arguments to the argv form expected by libfaust
+static std::vector<const char*> make_argv(const std::vector<std::string>& args)
+{
+    std::vector<const char*> argv;
+    argv.reserve(args.size());
+    for (const auto& it : args) argv.push_back(it.c_str());
+    return argv;
+}
+
+typedef py::array_t<float, py::array::c_style> audio_buffer;
+
+// Compute one block of (channels, frames) buffers without the GIL ('in_obj' may be None without inputs)
+static void compute_dsp(dsp& self, py::object in_obj, audio_buffer outputs)
+{
+    int n_ins = self.getNumInputs();
+    int n_outs = self.getNumOutputs();
+    audio_buffer inputs = in_obj.is_none() ? audio_buffer(std::vector<py::ssize_t>{0, 0}) : in_obj.cast<audio_buffer>();
+    if (inputs.ndim() != 2 || outputs.ndim() != 2) {
+        throw py::value_error("buffers must be (channels, frames) arrays");
+    }
+    int count = int(outputs.shape(1));
+    if (int(inputs.shape(0)) < n_ins || int(outputs.shape(0)) < n_outs) {
+        throw py::value_error("not enough channels in buffers");
+    }
+    if (n_ins > 0 && int(inputs.shape(1)) < count) {
+        throw py::value_error("input buffers are shorter than output buffers");
+    }
+    std::vector<float*> ins(n_ins), outs(n_outs);
+    // Empty buffers have no first frame to point to (mutable_data is bounds-checked)
+    if (count > 0) {
+        for (int i = 0; i < n_ins; i++) ins[i] = inputs.mutable_data(i, 0);
+        for (int i = 0; i < n_outs; i++) outs[i] = outputs.mutable_data(i, 0);
+    }
+    py::gil_scoped_release release;
+    AVOIDDENORMALS;
+    self.compute(count, ins.data(), outs.data());
+}
+
+// Number of MapUI objects pointing to the controls of each C++ instance (only accessed with the GIL held):
+// such instances cannot be given to a combiner, which would delete them with the combined DSP
+static std::map<dsp*, int> gDspUsers;
+
+// A MapUI registered as a user of its instance
+struct dsp_map_ui : public MapUI {
+
+    dsp* fDSP;
+
+    dsp_map_ui(dsp* instance):fDSP(instance)
+    {
+        instance->buildUserInterface(this);
+        gDspUsers[fDSP]++;
+    }
+
+    virtual ~dsp_map_ui()
+    {
+        if (--gDspUsers[fDSP] == 0) gDspUsers.erase(fDSP);
+    }
+
+};
+
+// Instances lent by the pools (which own them), until the pool is deleted
+static std::set<dsp*> gPoolInstances;
+
+// A pool recording the instances it lends, which cannot be given to a combiner
+struct lending_dsp_pool : public dsp_pool {
+
+    std::set<dsp*> fLent;
+
+    lending_dsp_pool(dsp_factory* factory, int count, int sample_rate)
+    :dsp_pool(factory, count, sample_rate)
+    {}
+
+    lending_dsp_pool(dsp* prototype, int count, int sample_rate, arena_memory_manager* arena)
+    :dsp_pool(prototype, count, sample_rate, arena)
+    {}
+
+    virtual ~lending_dsp_pool()
+    {
+        for (const auto& it : fLent) gPoolInstances.erase(it);
+    }
+
+    dsp* lend()
+    {
+        dsp* instance = acquire();
+        if (instance && fLent.insert(instance).second) gPoolInstances.insert(instance);
+        return instance;
+    }
+
+};
+
+// Return the C++ instance of an InterpreterDsp or a CombinedDsp owned by Python
+// (a disowned instance, already given to a combiner, raises a ValueError when cast)
+static dsp* get_owned_dsp(py::handle instance)
+{
+    if (!py::isinstance<interpreter_dsp>(instance) && !py::isinstance<dsp_binary_combiner>(instance)) {
+        throw py::type_error("an InterpreterDsp or a CombinedDsp is expected");
+    }
+    dsp* ptr = instance.cast<dsp*>();
+    if (gPoolInstances.count(ptr)) {
+        throw py::value_error("instances acquired from a pool cannot be combined");
+    }
+    if (gDspUsers.count(ptr)) {
+        throw py::value_error("instances used by a MapUI cannot be combined");
+    }
+    return ptr;
+}
+
+// Take the C++ instance from its Python object, which is disowned and cannot be used anymore:
+// the unique_ptr is released since the instance is now owned by a combiner
+static void release_dsp(py::handle instance)
+{
+    if (py::isinstance<interpreter_dsp>(instance)) {
+        instance.cast<std::unique_ptr<interpreter_dsp>>().release();
+    } else {
+        instance.cast<std::unique_ptr<dsp_binary_combiner>>().release();
+    }
+}
+
+// Combine two instances with one of the createDSPXXX functions: on success, the result owns the C++ instances
+// and the Python objects cannot be used anymore (they are kept alive by the result, with their factory)
+template <typename CREATE>
+static dsp_binary_combiner* combine_dsp(py::handle dsp1, py::handle dsp2, int layout, CREATE create)
+{
+    if (layout < kVerticalGroup || layout > kTabGroup) {
+        throw py::value_error("invalid layout");
+    }
+    dsp* ptr1 = get_owned_dsp(dsp1);
+    dsp* ptr2 = get_owned_dsp(dsp2);
+    if (ptr1 == ptr2) {
+        throw py::value_error("an instance cannot be combined with itself");
+    }
+    std::string error_msg;
+    dsp* res = create(ptr1, ptr2, error_msg, Layout(layout));
+    if (!res) {
+        throw py::value_error(error_msg.substr(0, error_msg.find_last_not_of(" \n") + 1));
+    }
+    release_dsp(dsp1);
+    release_dsp(dsp2);
+    return static_cast<dsp_binary_combiner*>(res);
+}
+
+// Return the Python object of a factory returned by an interpreter_dsp_factory_cache: the reference taken
+// by the cache is given back when the object is deleted, so after all its instances (which keep it alive)
+static py::object cached_factory(py::handle cache, interpreter_dsp_factory* factory)
+{
+    py::object res = py::cast(factory, py::return_value_policy::reference);
+    py::object owner = py::reinterpret_borrow<py::object>(cache);
+    py::module_::import("weakref").attr("finalize")(res, py::cpp_function([owner, factory]() {
+        py::cast<interpreter_dsp_factory_cache&>(owner).release(factory);
+    }));
+    return res;
+}
 
 // struct DspMeta : Meta, std::map<const char*, const char*>
 // {
@@ -36,10 +220,52 @@ PYBIND11_MODULE(pbfaust, m)
     m.doc() = "pbfaust: a pybind11 wrapper around the faust interpreter.";
     m.attr("__version__") = "0.0.1";
 
+    // -----------------------------------------------------------------------
+    // exceptions
+
+    FaustError = PyErr_NewExceptionWithDoc("pbfaust.FaustError", "Error reported by libfaust, with 'message', 'warnings' and 'compile_options' attributes.", PyExc_RuntimeError, nullptr);
+    FaustCompileError = PyErr_NewExceptionWithDoc("pbfaust.FaustCompileError", "DSP code could not be compiled.", FaustError, nullptr);
+    FaustBitcodeError = PyErr_NewExceptionWithDoc("pbfaust.FaustBitcodeError", "Bitcode could not be read.", FaustError, nullptr);
+    m.attr("FaustError") = py::handle(FaustError);
+    m.attr("FaustCompileError") = py::handle(FaustCompileError);
+    m.attr("FaustBitcodeError") = py::handle(FaustBitcodeError);
+
     // -----------------------------------------------------------------------
     // faust/dsp/dsp.h
 
-    py::class_<dsp>(m, "Dsp");
+    // DSP instances use the smart holder, so that combiners can take them from their Python objects
+    py::class_<dsp, py::smart_holder>(m, "Dsp");
+
+    py::class_<dsp_memory_manager>(m, "DspMemoryManager");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-arena.h
+
+    py::class_<arena_memory_manager, dsp_memory_manager>(m, "ArenaMemoryManager")
+        .def(py::init<size_t, bool, size_t>(), py::arg("chunk_size") = 0, py::arg("huge_pages") = false, py::arg("alignment") = ARENA_CACHE_LINE)
+        .def("reserve", &arena_memory_manager::reserve, "Make sure 'size' contiguous bytes are available without further allocation")
+        .def("trim", &arena_memory_manager::trim, "Release all chunks which do not contain any live memory zone")
+        .def_property_readonly("allocated_size", &arena_memory_manager::getAllocatedSize, "Size in bytes of the memory zones currently allocated")
+        .def_property_readonly("reserved_size", &arena_memory_manager::getReservedSize, "Size in bytes of all chunks reserved by the arena")
+        .def_property_readonly("num_zones", &arena_memory_manager::getNumZones, "Number of memory zones currently allocated")
+        .def_property_readonly("num_chunks", &arena_memory_manager::getNumChunks, "Number of chunks reserved by the arena")
+        .def_property_readonly("planned_size", &arena_memory_manager::getPlannedSize, "Instance size in bytes computed by the last sizing pass")
+        .def_property_readonly("alignment", &arena_memory_manager::getAlignment)
+        .def_property_readonly("huge_pages", &arena_memory_manager::hasHugePages)
+        .def("snapshot", [](arena_memory_manager& self, interpreter_dsp* instance) {
+            std::string error_msg;
+            dsp_snapshot* snapshot = dsp_snapshot::capture(instance, &self, error_msg);
+            if (!snapshot) throw std::runtime_error(error_msg);
+            return snapshot;
+        }, py::arg("dsp"), "Capture the complete state of an instance created while this arena was set on its factory")
+        .def("restore", [](arena_memory_manager& self, interpreter_dsp* instance, const dsp_snapshot& snapshot) {
+            std::string error_msg;
+            if (!snapshot.restore(instance, &self, error_msg)) throw std::runtime_error(error_msg);
+        }, py::arg("dsp"), py::arg("snapshot"), "Restore the state of an instance from a snapshot of an instance of the same factory")
+        .def("clone", [](arena_memory_manager& self, interpreter_dsp* instance) {
+            return cloneArenaDSPInstance(instance, &self);
+        }, py::arg("dsp"), py::keep_alive<0, 2>(), "Clone an instance created while this arena was set on its factory, so that the clone can also be snapshotted")
+        ;
 
     
     // -----------------------------------------------------------------------
@@ -89,53 +315,77 @@ PYBIND11_MODULE(pbfaust, m)
     m.def("create_interpreter_dsp_factory_from_file", [](const std::string& filename, py::args& args) -> interpreter_dsp_factory* {
         std::vector<std::string> params;
         std::string error_msg;
-        std::vector<const char *> argv;
         for (const auto &arg : args) {
             params.push_back(arg.cast<std::string>());
         }
-        argv.reserve(params.size());
-        for (auto &i : params)
-            argv.push_back(const_cast<char *>(i.c_str()));
-        interpreter_dsp_factory* factory = (interpreter_dsp_factory*)createInterpreterDSPFactoryFromFile(filename, argv.size(), argv.data(), error_msg);
-        if (!factory) {
-            std::cerr << "Cannot create factory : " << error_msg;
-            return NULL;
-        }
+        std::vector<const char*> argv = make_argv(params);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromFile(filename, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, params);
         return factory;
     }, py::arg("filename"), "Create a Faust DSP factory from a DSP source code as a file.", py::return_value_policy::reference);
 
-    m.def("create_interpreter_dsp_factory_from_string", [](const std::string& name_app, const std::string& dsp_content, std::vector<std::string> args, std::string& error_msg) {
-        std::vector<const char *> argv;
-        argv.reserve(args.size());
-        for (auto &i : args) argv.push_back(const_cast<char *>(i.c_str()));
-        return createInterpreterDSPFactoryFromString(name_app, dsp_content, argv.size(), argv.data(), error_msg);
-    }, "Create a Faust DSP factory from a DSP source code as a string.");
+    m.def("create_interpreter_dsp_factory_from_string", [](const std::string& name_app, const std::string& dsp_content, std::vector<std::string> args) {
+        std::string error_msg;
+        std::vector<const char*> argv = make_argv(args);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromString(name_app, dsp_content, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+        return factory;
+    }, py::arg("name_app"), py::arg("dsp_content"), py::arg("args") = std::vector<std::string>(), "Create a Faust DSP factory from a DSP source code as a string.", py::return_value_policy::reference);
 
-    m.def("create_interpreter_dsp_factory_from_signals", [](const std::string& name_app, tvec signals, std::vector<std::string> args, std::string& error_msg) {
-        std::vector<const char *> argv;
-        argv.reserve(args.size());
-        for (auto &i : args) argv.push_back(const_cast<char *>(i.c_str()));    
-        return createInterpreterDSPFactoryFromSignals(name_app, signals, argv.size(), argv.data(), error_msg);
-    }, "Create a Faust DSP factory from a vector of output signals.");
+    m.def("create_interpreter_dsp_factory_from_signals", [](const std::string& name_app, tvec signals, std::vector<std::string> args) {
+        std::string error_msg;
+        std::vector<const char*> argv = make_argv(args);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromSignals(name_app, signals, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+        return factory;
+    }, "Create a Faust DSP factory from a vector of output signals.", py::return_value_policy::reference);
 
-    m.def("create_interpreter_dsp_factory_from_boxes", [](const std::string& name_app, Box box, std::vector<std::string> args, std::string& error_msg) {
-        std::vector<const char *> argv;
-        argv.reserve(args.size());
-        for (auto &i : args) argv.push_back(const_cast<char *>(i.c_str()));    
-        return createInterpreterDSPFactoryFromBoxes(name_app, box, argv.size(), argv.data(), error_msg);
-    }, "Create a Faust DSP factory from a box expression.");
+    m.def("create_interpreter_dsp_factory_from_boxes", [](const std::string& name_app, Box box, std::vector<std::string> args) {
+        std::string error_msg;
+        std::vector<const char*> argv = make_argv(args);
+        interpreter_dsp_factory* factory = createInterpreterDSPFactoryFromBoxes(name_app, box, argv.size(), argv.data(), error_msg);
+        if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+        return factory;
+    }, "Create a Faust DSP factory from a box expression.", py::return_value_policy::reference);
 
     m.def("delete_interpreter_dsp_factory", &deleteInterpreterDSPFactory, "Delete a Faust DSP factory,");
     m.def("delete_all_interpreter_dsp_factories", &deleteAllInterpreterDSPFactories, "Delete all Faust DSP factories kept in the library cache.");
     m.def("get_all_interpreter_dsp_factories", &getAllInterpreterDSPFactories, "Return Faust DSP factories of the library cache as a vector of their SHA keys.");
     m.def("start_multithreaded_dsp_factories", &startMTDSPFactories, "Start multi-thread access mode");
     m.def("stop_multithreaded_dsp_factories", &stopMTDSPFactories, "Stop multi-thread access mode");
-    m.def("read_interpreter_dsp_factory_from_bitcode", &readInterpreterDSPFactoryFromBitcode, "Create a Faust DSP factory from a bitcode string.");
+    m.def("read_interpreter_dsp_factory_from_bitcode", [](const std::string& bitcode) {
+        std::string error_msg;
+        interpreter_dsp_factory* factory = readInterpreterDSPFactoryFromBitcode(bitcode, error_msg);
+        if (!factory) raise_faust_error(FaustBitcodeError, error_msg, {});
+        return factory;
+    }, "Create a Faust DSP factory from a bitcode string.", py::return_value_policy::reference);
     m.def("write_interpreter_dsp_factory_to_bitcode", &writeInterpreterDSPFactoryToBitcode, "Write a Faust DSP factory into a bitcode string.");
-    m.def("read_interpreter_dsp_factory_from_bitcode_file", &readInterpreterDSPFactoryFromBitcodeFile, "Create a Faust DSP factory from a bitcode file.");
+    m.def("read_interpreter_dsp_factory_from_bitcode_buffer", [](py::buffer buffer) {
+        // buffer.request() accepts strided buffers: a C-contiguous view is requested instead,
+        // owned (and released) by the buffer_info. libfaust is not thread safe: the GIL is kept.
+        Py_buffer* view = new Py_buffer();
+        if (PyObject_GetBuffer(buffer.ptr(), view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+            delete view;
+            throw py::error_already_set();
+        }
+        py::buffer_info info(view);
+        std::string error_msg;
+        interpreter_dsp_factory* factory = readInterpreterDSPFactoryFromBitcode(std::string(static_cast<const char*>(info.ptr), info.size * info.itemsize), error_msg);
+        if (!factory) raise_faust_error(FaustBitcodeError, error_msg, {});
+        return factory;
+    }, py::arg("buffer"), "Create a Faust DSP factory from bitcode in any buffer (bytes, memoryview, mmap...), without text decoding.", py::return_value_policy::reference);
+    m.def("write_interpreter_dsp_factory_to_bitcode_bytes", [](interpreter_dsp_factory* factory) {
+        return py::bytes(writeInterpreterDSPFactoryToBitcode(factory));
+    }, py::arg("factory"), "Write a Faust DSP factory into bitcode bytes, without text decoding.");
+    m.def("read_interpreter_dsp_factory_from_bitcode_file", [](const std::string& bit_code_path) {
+        std::string error_msg;
+        interpreter_dsp_factory* factory = readInterpreterDSPFactoryFromBitcodeFile(bit_code_path, error_msg);
+        if (!factory) raise_faust_error(FaustBitcodeError, error_msg, {});
+        return factory;
+    }, "Create a Faust DSP factory from a bitcode file.", py::return_value_policy::reference);
     m.def("write_interpreter_dsp_factory_to_bitcode_file", &writeInterpreterDSPFactoryToBitcodeFile, "Write a Faust DSP factory into a bitcode file.");
 
-    py::class_<interpreter_dsp, dsp>(m, "InterpreterDsp")
+    py::class_<interpreter_dsp, dsp, py::smart_holder>(m, "InterpreterDsp")
         .def("get_numinputs", &interpreter_dsp::getNumInputs, "Return instance number of audio inputs")
         .def("get_numoutputs", &interpreter_dsp::getNumOutputs, "Return instance number of audio outputs")
         // .def("build_user_interface", &interpreter_dsp::buildUserInterface, "Trigger the ui_interface parameter with instance specific calls")
@@ -149,9 +399,11 @@ PYBIND11_MODULE(pbfaust, m)
         .def("instance_constants", &interpreter_dsp::instanceConstants, "Init instance constant state")
         .def("instance_reset_user_interface", &interpreter_dsp::instanceResetUserInterface, "Init default control parameters values")
         .def("instance_clear", &interpreter_dsp::instanceClear, "Init instance state but keep the control parameter values")
-        .def("clone", &interpreter_dsp::clone, "Return a clone of the instance.")
+        .def("clone", &interpreter_dsp::clone, py::keep_alive<0, 1>(), "Return a clone of the instance.")
         .def("metadata", &interpreter_dsp::metadata, "Trigger the Meta* parameter with instance specific calls to 'declare' (key, value) metadata.")
-        // .def("compute", &interpreter_dsp::compute, "DSP instance computation, to be called with successive in/out audio buffers.")
+        .def("compute", [](interpreter_dsp& self, py::object inputs, audio_buffer outputs) {
+            compute_dsp(self, inputs, outputs);
+        }, py::arg("inputs"), py::arg("outputs").noconvert(), "DSP instance computation of one block of (channels, frames) float32 buffers (inputs may be None without inputs), without the GIL.")
         ;
 
     py::class_<interpreter_dsp_factory>(m, "InterpreterDspFactory")
@@ -162,11 +414,258 @@ PYBIND11_MODULE(pbfaust, m)
         .def("get_library_list", &interpreter_dsp_factory::getLibraryList, "Get the Faust DSP factory list of library dependancies")
         .def("get_include_pathnames", &interpreter_dsp_factory::getIncludePathnames, "Get the list of all used includes")
         .def("get_warning_messages", &interpreter_dsp_factory::getWarningMessages, "Get warning messages list for a given compilation")
-        .def("create_dsp_instance", &interpreter_dsp_factory::createDSPInstance, "Create a new DSP instance, to be deleted with C++ 'delete'")
-        .def("set_memory_manager", &interpreter_dsp_factory::setMemoryManager, "Set a custom memory manager to be used when creating instances")
-        .def("get_memory_manager", &interpreter_dsp_factory::getMemoryManager, "Return the currently set custom memory manager")
+        .def("create_dsp_instance", &createArenaDSPInstance<interpreter_dsp_factory>, py::keep_alive<0, 1>(), "Create a new DSP instance, which keeps the factory alive")
+        .def("set_memory_manager", &interpreter_dsp_factory::setMemoryManager, py::keep_alive<1, 2>(), py::arg("manager"), "Set a custom memory manager to be used when creating instances")
+        .def("get_memory_manager", &interpreter_dsp_factory::getMemoryManager, py::return_value_policy::reference, "Return the currently set custom memory manager")
+        ;
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/signal-cost.h
+
+    py::class_<signal_cost>(m, "SignalCost")
+        .def_readonly("nodes", &signal_cost::fNodes, "Number of distinct nodes by operator class")
+        .def_readonly("num_nodes", &signal_cost::fNumNodes, "Number of distinct nodes")
+        .def_readonly("num_delays", &signal_cost::fNumDelays, "Number of delay lines (one per delayed signal)")
+        .def_readonly("delay_memory", &signal_cost::fDelayMemory, "Total of the maximal delay amounts of each line in samples")
+        .def_readonly("max_delay", &signal_cost::fMaxDelay, "Longest delay line in samples")
+        .def_readonly("unbounded_delays", &signal_cost::fUnboundedDelays, "Variable delays without a finite maximum")
+        .def_readonly("num_tables", &signal_cost::fNumTables, "Number of tables")
+        .def_readonly("table_memory", &signal_cost::fTableMemory, "Total of the known table sizes in samples")
+        .def_readonly("unknown_tables", &signal_cost::fUnknownTables, "Tables with a non constant size, or waveforms")
+        .def_readonly("opaque_nodes", &signal_cost::fOpaqueNodes, "Nodes whose operands could not be analysed")
+        .def_readonly("sample_ops", &signal_cost::fSampleOps, "Estimated operations per sample")
+        .def_readonly("control_ops", &signal_cost::fControlOps, "Estimated operations per block")
+        .def_readonly("init_ops", &signal_cost::fInitOps, "Estimated operations at init time")
+        ;
+
+    m.def("analyze_signals", [](tvec signals, bool normalize) {
+        signal_cost_analyzer analyzer;
+        return analyzer.analyze(signals, normalize);
+    }, py::arg("signals"), py::arg("normalize") = true, "Estimate the cost of a vector of output signals before compiling them.");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/interpreter-dsp-cache.h
+
+    py::class_<interpreter_dsp_factory_cache>(m, "InterpreterDspFactoryCache")
+        .def(py::init<>())
+        .def("create_from_signals", [](interpreter_dsp_factory_cache& self, const std::string& name_app, tvec signals, std::vector<std::string> args) {
+            std::string error_msg;
+            std::vector<const char*> argv = make_argv(args);
+            interpreter_dsp_factory* factory = self.createFromSignals(name_app, signals, argv.size(), argv.data(), error_msg);
+            if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+            return cached_factory(py::cast(&self, py::return_value_policy::reference), factory);
+        }, py::arg("name_app"), py::arg("signals"), py::arg("args") = std::vector<std::string>(), "Return the factory of a vector of output signals, compiled only if no equal graph was compiled before", py::keep_alive<0, 1>())
+        .def("create_from_boxes", [](interpreter_dsp_factory_cache& self, const std::string& name_app, Box box, std::vector<std::string> args) {
+            std::string error_msg;
+            std::vector<const char*> argv = make_argv(args);
+            interpreter_dsp_factory* factory = self.createFromBoxes(name_app, box, argv.size(), argv.data(), error_msg);
+            if (!factory) raise_faust_error(FaustCompileError, error_msg, args);
+            return cached_factory(py::cast(&self, py::return_value_policy::reference), factory);
+        }, py::arg("name_app"), py::arg("box"), py::arg("args") = std::vector<std::string>(), "Return the factory of a box expression, compiled only if no equal expression was compiled before", py::keep_alive<0, 1>())
+        .def("remove", &interpreter_dsp_factory_cache::remove, py::arg("factory"), "Delete a factory of the cache, False if it was not found or is still used")
+        .def("clear", &interpreter_dsp_factory_cache::clear, "Delete the factories of the cache which are not used anymore (by an instance or a Python object), return the number of factories kept")
+        .def_property_readonly("size", &interpreter_dsp_factory_cache::getSize, "Number of cached factories")
+        .def_property_readonly("hits", &interpreter_dsp_factory_cache::getHits, "Number of requests served from the cache")
+        .def_property_readonly("misses", &interpreter_dsp_factory_cache::getMisses, "Number of requests which needed a compilation")
+        ;
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-combiner.h
+
+    m.attr("LAYOUT_VERTICAL") = int(kVerticalGroup);
+    m.attr("LAYOUT_HORIZONTAL") = int(kHorizontalGroup);
+    m.attr("LAYOUT_TAB") = int(kTabGroup);
+    m.attr("CROSSFADE_LINEAR") = int(kLinearCurve);
+    m.attr("CROSSFADE_EQUAL_POWER") = int(kEqualPowerCurve);
+
+    py::class_<dsp_binary_combiner, dsp, py::smart_holder>(m, "CombinedDsp")
+        .def("get_numinputs", &dsp::getNumInputs, "Return the number of audio inputs")
+        .def("get_numoutputs", &dsp::getNumOutputs, "Return the number of audio outputs")
+        .def("build_user_interface", [](dsp_binary_combiner &self) {
+            PrintUI print_ui;
+            self.buildUserInterface(&print_ui);
+         }, "Print the user interface of all combined instances")
+        .def("get_samplerate", &dsp::getSampleRate, "Return the sample rate currently used by the instances")
+        .def("init", &dsp::init, "Global init of all combined instances")
+        .def("instance_init", &dsp::instanceInit, "Init the state of all combined instances")
+        .def("instance_constants", &dsp::instanceConstants, "Init the constant state of all combined instances")
+        .def("instance_reset_user_interface", &dsp::instanceResetUserInterface, "Init default control parameters values")
+        .def("instance_clear", &dsp::instanceClear, "Init the state of all combined instances but keep the control parameter values")
+        .def("prepare", [](dsp_binary_combiner& self, int buffer_size) {
+            if (buffer_size <= 0) throw py::value_error("buffer_size must be positive");
+            self.prepare(buffer_size);
+        }, py::arg("buffer_size"), "Set the largest block size computed without subdivision (typically the audio driver buffer size)")
+        .def("get_buffersize", &dsp_binary_combiner::getBufferSize, "Return the block size set with prepare (4096 by default)")
+        .def("clone", [](dsp_binary_combiner& self) {
+            return static_cast<dsp_binary_combiner*>(self.clone());
+        }, py::keep_alive<0, 1>(), "Return a clone of the combined DSP (with clones of all instances)")
+        .def("compute", [](dsp_binary_combiner& self, py::object inputs, audio_buffer outputs) {
+            compute_dsp(self, inputs, outputs);
+        }, py::arg("inputs"), py::arg("outputs").noconvert(), "Compute the whole combined DSP on one block of (channels, frames) float32 buffers (inputs may be None without inputs), without the GIL.")
+        ;
+
+    m.def("create_dsp_sequencer", [](py::handle dsp1, py::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPSequencer(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, py::arg("dsp1"), py::arg("dsp2"), py::arg("layout") = int(kTabGroup), py::arg("label") = "Sequencer", py::keep_alive<0, 1>(), py::keep_alive<0, 2>(),
+    "Connect the outputs of dsp1 to the inputs of dsp2 (Faust ':'), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_parallelizer", [](py::handle dsp1, py::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPParallelizer(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, py::arg("dsp1"), py::arg("dsp2"), py::arg("layout") = int(kTabGroup), py::arg("label") = "Parallelizer", py::keep_alive<0, 1>(), py::keep_alive<0, 2>(),
+    "Put dsp1 and dsp2 in parallel (Faust ','), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_splitter", [](py::handle dsp1, py::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPSplitter(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, py::arg("dsp1"), py::arg("dsp2"), py::arg("layout") = int(kTabGroup), py::arg("label") = "Splitter", py::keep_alive<0, 1>(), py::keep_alive<0, 2>(),
+    "Split the outputs of dsp1 to the inputs of dsp2 (Faust '<:'), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_merger", [](py::handle dsp1, py::handle dsp2, int layout, const std::string& label) {
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPMerger(ptr1, ptr2, error_msg, lay, label);
+        });
+    }, py::arg("dsp1"), py::arg("dsp2"), py::arg("layout") = int(kTabGroup), py::arg("label") = "Merger", py::keep_alive<0, 1>(), py::keep_alive<0, 2>(),
+    "Mix the outputs of dsp1 to the inputs of dsp2 (Faust ':>'), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_recursiver", [](py::handle dsp1, py::handle dsp2, int layout, const std::string& label, int delay) {
+        if (delay < 0) throw py::value_error("delay must be positive or 0");
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPRecursiver(ptr1, ptr2, error_msg, lay, label, delay);
+        });
+    }, py::arg("dsp1"), py::arg("dsp2"), py::arg("layout") = int(kTabGroup), py::arg("label") = "Recursiver", py::arg("delay") = 1, py::keep_alive<0, 1>(), py::keep_alive<0, 2>(),
+    "Feed back the outputs of dsp2 to the inputs of dsp1 (Faust '~') with a 'delay' frames feedback (0 to use the 'delay' metadata of dsp2), the result owns both instances which cannot be used anymore.");
+
+    m.def("create_dsp_crossfader", [](py::handle dsp1, py::handle dsp2, int layout, const std::string& label, int curve, int preroll) {
+        if (curve != kLinearCurve && curve != kEqualPowerCurve) throw py::value_error("invalid curve");
+        if (preroll < 0) throw py::value_error("preroll must be positive or 0");
+        return combine_dsp(dsp1, dsp2, layout, [&](dsp* ptr1, dsp* ptr2, std::string& error_msg, Layout lay) {
+            return createDSPCrossfader(ptr1, ptr2, error_msg, lay, label, CrossfadeCurve(curve), preroll);
+        });
+    }, py::arg("dsp1"), py::arg("dsp2"), py::arg("layout") = int(kTabGroup), py::arg("label") = "Crossfade", py::arg("curve") = int(kLinearCurve), py::arg("preroll") = 0, py::keep_alive<0, 1>(), py::keep_alive<0, 2>(),
+    "Crossfade between dsp1 and dsp2 (with a 'Crossfade' slider, only dsp1 is computed at 1 and only dsp2 at 0) with CROSSFADE_LINEAR or CROSSFADE_EQUAL_POWER gains. A resumed DSP is first computed on the next 'preroll' input frames before being heard. The result owns both instances which cannot be used anymore.");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-pool.h
+
+    py::class_<lending_dsp_pool>(m, "InterpreterDspPool")
+        .def(py::init([](interpreter_dsp_factory* factory, int count, int sample_rate) {
+            return new lending_dsp_pool(static_cast<dsp_factory*>(factory), count, sample_rate);
+        }), py::keep_alive<1, 2>(), py::arg("factory"), py::arg("count"), py::arg("sample_rate"))
+        .def(py::init([](interpreter_dsp* prototype, int count, int sample_rate, arena_memory_manager* arena) {
+            return new lending_dsp_pool(prototype, count, sample_rate, arena);
+        }), py::keep_alive<1, 2>(), py::keep_alive<1, 5>(), py::arg("prototype"), py::arg("count"), py::arg("sample_rate"), py::arg("arena") = py::none())
+        .def("reserve", &dsp_pool::reserve, "Pre-create instances so that the pool holds at least 'count' of them")
+        .def("acquire", [](lending_dsp_pool& self) {
+            return static_cast<interpreter_dsp*>(self.lend());
+        }, py::return_value_policy::reference, py::keep_alive<0, 1>(), "Take an initialized instance from the pool, None if exhausted")
+        .def("release", [](lending_dsp_pool& self, interpreter_dsp* instance) {
+            if (!self.release(instance)) throw py::value_error("instance was not acquired from this pool, or already released");
+        }, "Give back an acquired instance, which is reset for the next use")
+        .def("__len__", &dsp_pool::getNumInstances)
+        .def_property_readonly("num_free", &dsp_pool::getNumFree, "Number of instances available for acquire")
+        .def_property_readonly("sample_rate", &dsp_pool::getSampleRate)
+        ;
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-snapshot.h
+
+    py::class_<dsp_snapshot>(m, "DspSnapshot")
+        .def_static("from_bytes", [](const std::string& data) {
+            std::string error_msg;
+            dsp_snapshot* snapshot = dsp_snapshot::fromBuffer(data.data(), data.size(), error_msg);
+            if (!snapshot) throw std::invalid_argument(error_msg);
+            return snapshot;
+        }, py::arg("data"), "Create a snapshot from the content returned by to_bytes")
+        .def_static("from_file", [](const std::string& path) {
+            std::string error_msg;
+            dsp_snapshot* snapshot = dsp_snapshot::fromFile(path, error_msg);
+            if (!snapshot) throw std::invalid_argument(error_msg);
+            return snapshot;
+        }, py::arg("path"), "Load (memory-map) a snapshot saved with save")
+        .def("save", [](const dsp_snapshot& self, const std::string& path) {
+            std::string error_msg;
+            if (!self.save(path, error_msg)) throw std::runtime_error(error_msg);
+        }, py::arg("path"), "Save the snapshot in a file")
+        .def("to_bytes", [](const dsp_snapshot& self) {
+            return py::bytes(self.getData(), self.getSize());
+        }, "Return the snapshot content")
+        .def("__len__", &dsp_snapshot::getSize)
+        .def_property_readonly("sample_rate", &dsp_snapshot::getSampleRate, "Sample rate of the captured instance")
+        .def_property_readonly("num_zones", &dsp_snapshot::getNumZones)
+        .def_property_readonly("num_controls", &dsp_snapshot::getNumControls)
+        .def_property_readonly("state_size", &dsp_snapshot::getStateSize, "Size in bytes of the copied state")
+        .def_property_readonly("mapped", &dsp_snapshot::isMapped, "Whether the snapshot content is memory-mapped from a file")
         ;
 
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp-bench.h
+
+    py::class_<bench_stats>(m, "BenchResult")
+        .def_readonly("buffer_size", &bench_stats::fBufferSize)
+        .def_readonly("count", &bench_stats::fCount, "Number of measured compute calls")
+        .def_readonly("sample_rate", &bench_stats::fSampleRate, "Sample rate used to compute the CPU load")
+        .def_readonly("mb_per_sec", &bench_stats::fMBPerSec, "Throughput in MBytes/sec of the best blocks (as faustbench)")
+        .def_readonly("std_dev", &bench_stats::fStdDev, "Relative standard deviation of the best blocks (in %)")
+        .def_readonly("mean", &bench_stats::fMean, "Mean block duration in seconds")
+        .def_readonly("cpu_load", &bench_stats::fCPULoad, "Mean block duration relative to the block period at sample_rate")
+        .def_readonly("samples_per_sec", &bench_stats::fSamplesPerSec, "Frames computed per second")
+        .def_readonly("throughputs", &bench_stats::fThroughputs, "MBytes/sec of each measured block, in increasing order")
+        .def_property_readonly("percentiles", [](const bench_stats& self) {
+            py::dict res;
+            res[py::int_(0)] = self.fMin;
+            res[py::int_(25)] = self.fP25;
+            res[py::int_(50)] = self.fP50;
+            res[py::int_(75)] = self.fP75;
+            res[py::int_(90)] = self.fP90;
+            res[py::int_(99)] = self.fP99;
+            res[py::int_(100)] = self.fMax;
+            return res;
+        }, "Block duration percentiles in seconds")
+        .def_property_readonly("counters", [](const bench_stats& self) {
+            py::dict res;
+            if (!self.fPerf.fValid) return res;
+            for (int i = 0; i < perf_counters::kNumCounters; i++) {
+                py::str name(perf_counters::getName(i));
+                if (self.fPerf.fPerSample[i] < 0) {
+                    res[name] = py::none();
+                } else {
+                    res[name] = py::make_tuple(self.fPerf.fPerSample[i], self.fPerf.fPerChannelSample[i]);
+                }
+            }
+            return res;
+        }, "Hardware counters as (per_sample, per_channel_sample) tuples, None when not available on this CPU")
+        .def_property_readonly("ipc", [](const bench_stats& self) { return self.fPerf.fIPC; }, "Instructions per cycle (0 if not measured)")
+        ;
+
+    m.def("bench", [](interpreter_dsp* instance, int buffer_size, double duration, bool random_controls, double sample_rate, bool counters) {
+        if (buffer_size <= 0 || duration <= 0 || sample_rate <= 0) {
+            throw std::invalid_argument("buffer_size, duration and sample_rate must be positive");
+        }
+        py::gil_scoped_release release;
+        return benchDSP<FAUSTFLOAT>(instance, buffer_size, duration, random_controls, sample_rate, counters);
+    }, py::arg("dsp"), py::arg("buffer_size") = 512, py::arg("duration") = 1.0, py::arg("random_controls") = true, py::arg("sample_rate") = 48000.0, py::arg("counters") = false,
+    "Measure the CPU use of a DSP instance (on a clone of it) with the GIL released");
+
+    // -----------------------------------------------------------------------
+    // faust/dsp/dsp.h (denormals)
+
+    m.attr("DENORMALS_KEEP") = int(DENORMALS_KEEP);
+    m.attr("DENORMALS_FTZ") = int(DENORMALS_FTZ);
+    m.attr("DENORMALS_FTZ_DAZ") = int(DENORMALS_FTZ_DAZ);
+
+    m.def("set_denormal_policy", [](int policy) {
+        if (policy != DENORMALS_KEEP && policy != DENORMALS_FTZ && policy != DENORMALS_FTZ_DAZ) {
+            throw std::invalid_argument("invalid denormal policy");
+        }
+        ScopedNoDenormals::setPolicy(policy);
+    }, py::arg("policy"), "Set the denormal policy applied by audio drivers, compute and bench (DENORMALS_FTZ_DAZ by default)");
+    m.def("get_denormal_policy", &ScopedNoDenormals::getPolicy, "Return the denormal policy applied by audio drivers, compute and bench");
+
     // -----------------------------------------------------------------------
     // faust/audio/rtaudio-dsp.h
     
@@ -205,6 +704,17 @@ PYBIND11_MODULE(pbfaust, m)
         .def("declare", &PrintUI::declare)
         ;
 
+    // -----------------------------------------------------------------------
+    // faust/gui/MapUI.h
+
+    py::class_<dsp_map_ui>(m, "MapUI")
+        .def(py::init<dsp*>(), py::keep_alive<1, 2>(), py::arg("dsp"))
+        .def("set_param_value", &MapUI::setParamValue, py::arg("path"), py::arg("value"), "Set the param value")
+        .def("get_param_value", &MapUI::getParamValue, py::arg("path"), "Return the param value")
+        .def("get_params_count", &MapUI::getParamsCount, "Return the number of params")
+        .def("get_param_address", py::overload_cast<int>(&MapUI::getParamAddress), py::arg("index"), "Return the param path")
+        ;
+
     // -----------------------------------------------------------------------
     // faust/gui/meta.h
 
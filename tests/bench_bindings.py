@@ -0,0 +1,229 @@
+"""Compare the call overhead of the cyfaust, cfaust, nanofaust and pbfaust bindings.
+
+Each binding is measured in its own subprocess (so that import time is cold):
+
+    - import time
+    - factory creation (from a file, with a fresh DSP each time to bypass the factory cache)
+    - instance creation
+    - param set/get through MapUI
+    - compute call per block, for buffer sizes from 1 to 4096 frames
+
+Features missing from a binding are reported as n/a.
+
+usage: python3 tests/bench_bindings.py [output.json] [module ...]
+"""
+import os, sys
+BUILD_PATH = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), 'build')
+os.chdir(BUILD_PATH); sys.path.insert(0, BUILD_PATH)
+
+
+import json
+import subprocess
+import time
+
+from testutils import print_section
+
+MODULES = ['cyfaust', 'cfaust', 'nanofaust', 'pbfaust']
+
+BUFFER_SIZES = [2 ** i for i in range(13)]
+
+N_FACTORIES = 20
+N_INSTANCES = 1000
+N_PARAMS = 100_000
+
+# minimum measure duration of each compute buffer size (in seconds)
+COMPUTE_DURATION = 0.2
+
+DSP_CODE = """\
+import("stdfaust.lib");
+gain = hslider("gain", 0.5, 0, 1, 0.01);
+process = _, os.osc(440 + {}) : + : *(gain);
+"""
+
+# ---------------------------------------------------------------------------
+# binding adapters
+
+def create_factory(mod, name, path):
+    if name == 'cyfaust':
+        return mod.create_dsp_factory_from_file(path)
+    if name == 'cfaust':
+        return mod.InterpreterDspFactory.from_file(path)
+    return mod.create_interpreter_dsp_factory_from_file(path)
+
+
+def timeit(func, n):
+    start = time.perf_counter()
+    for i in range(n):
+        func()
+    return (time.perf_counter() - start) / n
+
+
+# ---------------------------------------------------------------------------
+# measures (run in the child process)
+
+def measure_factories(mod, name, results):
+    paths = []
+    for i in range(N_FACTORIES + 1):
+        path = os.path.join(BUILD_PATH, f'bench_bindings_{name}_{os.getpid()}_{i}.dsp')
+        with open(path, 'w') as f:
+            f.write(DSP_CODE.format(i))
+        paths.append(path)
+    try:
+        # first compilation also loads the libraries
+        factory = create_factory(mod, name, paths[0])
+        factories = []
+        start = time.perf_counter()
+        for path in paths[1:]:
+            factories.append(create_factory(mod, name, path))
+        results['factory_us'] = (time.perf_counter() - start) / N_FACTORIES * 1e6
+    finally:
+        for path in paths:
+            os.remove(path)
+    return factory
+
+
+def measure_instances(factory, results):
+    def create():
+        dsp = factory.create_dsp_instance()
+        del dsp
+    results['instance_us'] = timeit(create, N_INSTANCES) * 1e6
+
+
+def measure_params(mod, dsp, results):
+    if not hasattr(mod, 'MapUI'):
+        return
+    ui = mod.MapUI(dsp)
+    results['param_set_ns'] = timeit(lambda: ui.set_param_value('gain', 0.25), N_PARAMS) * 1e9
+    results['param_get_ns'] = timeit(lambda: ui.get_param_value('gain'), N_PARAMS) * 1e9
+    assert abs(ui.get_param_value('gain') - 0.25) < 1e-6
+
+
+def measure_compute(dsp, results):
+    if not hasattr(dsp, 'compute'):
+        return
+    try:
+        import numpy as np
+    except ImportError:
+        return
+    compute = {}
+    for size in BUFFER_SIZES:
+        inputs = np.zeros((dsp.get_numinputs(), size), dtype=np.float32)
+        outputs = np.zeros((dsp.get_numoutputs(), size), dtype=np.float32)
+        dsp.compute(inputs, outputs)
+        count = 0
+        start = time.perf_counter()
+        elapsed = 0.0
+        while elapsed < COMPUTE_DURATION:
+            for i in range(100):
+                dsp.compute(inputs, outputs)
+            count += 100
+            elapsed = time.perf_counter() - start
+        block_ns = elapsed / count * 1e9
+        compute[str(size)] = {'block_ns': block_ns, 'sample_ns': block_ns / size}
+    results['compute'] = compute
+
+
+def run_child(name):
+    results = {'module': name}
+    start = time.perf_counter()
+    try:
+        if name == 'pbfaust':
+            try:
+                import pbfaust as mod
+            except ImportError:
+                import pyfaust as mod
+        else:
+            mod = __import__(name)
+    except ImportError as e:
+        results['error'] = str(e)
+        return results
+    results['import_ms'] = (time.perf_counter() - start) * 1e3
+
+    factory = measure_factories(mod, name, results)
+    measure_instances(factory, results)
+    dsp = factory.create_dsp_instance()
+    dsp.init(48000)
+    measure_params(mod, dsp, results)
+    measure_compute(dsp, results)
+    return results
+
+
+# ---------------------------------------------------------------------------
+# report
+
+def fmt(value, spec='.2f'):
+    return 'n/a' if value is None else format(value, spec)
+
+
+def print_table(all_results):
+    names = [r['module'] for r in all_results]
+    width = 12
+    header = f"{'':<20}" + ''.join(f'{n:>{width}}' for n in names)
+
+    def row(label, values, spec='.2f'):
+        print(f'{label:<20}' + ''.join(f'{fmt(v, spec):>{width}}' for v in values))
+
+    print_section("binding overhead")
+    print(header)
+    row('import (ms)', [r.get('import_ms') for r in all_results])
+    row('factory (us)', [r.get('factory_us') for r in all_results], '.0f')
+    row('instance (us)', [r.get('instance_us') for r in all_results])
+    row('param set (ns)', [r.get('param_set_ns') for r in all_results], '.0f')
+    row('param get (ns)', [r.get('param_get_ns') for r in all_results], '.0f')
+
+    print_section("compute per block (ns) / per sample (ns)")
+    print(header)
+    for size in BUFFER_SIZES:
+        cells = []
+        for r in all_results:
+            c = r.get('compute', {}).get(str(size))
+            cells.append('n/a' if c is None else f"{c['block_ns']:.0f}/{c['sample_ns']:.1f}")
+        print(f'{size:<20}' + ''.join(f'{c:>{width}}' for c in cells))
+
+    for r in all_results:
+        if 'error' in r:
+            print(f"{r['module']}: {r['error']}")
+
+
+def build_info():
+    """Identify the measured build: git commit (with local changes or not) and platform."""
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    def git(*args):
+        try:
+            proc = subprocess.run(['git', '-C', root] + list(args), capture_output=True, text=True)
+            return proc.stdout.strip() if proc.returncode == 0 else None
+        except OSError:
+            return None
+    status = git('status', '--porcelain', '--untracked-files=no')
+    return {
+        'commit': git('rev-parse', 'HEAD'),
+        'dirty': bool(status) if status is not None else None,
+        'python': sys.version.split()[0],
+        'platform': sys.platform,
+    }
+
+
+def main(argv):
+    output = argv[0] if argv and argv[0].endswith('.json') else 'bench_bindings.json'
+    modules = [a for a in argv if not a.endswith('.json')] or MODULES
+
+    all_results = []
+    for name in modules:
+        proc = subprocess.run([sys.executable, os.path.abspath(__file__), '--child', name],
+                              capture_output=True, text=True)
+        try:
+            all_results.append(json.loads(proc.stdout.strip().splitlines()[-1]))
+        except (IndexError, ValueError):
+            all_results.append({'module': name, 'error': (proc.stderr.strip().splitlines() or ['failed'])[-1]})
+
+    print_table(all_results)
+    with open(output, 'w') as f:
+        json.dump({'build': build_info(), 'buffer_sizes': BUFFER_SIZES, 'results': all_results}, f, indent=2)
+    print(f"results written to {os.path.abspath(output)}")
+
+
+if __name__ == '__main__':
+    if len(sys.argv) > 2 and sys.argv[1] == '--child':
+        print(json.dumps(run_child(sys.argv[2])))
+    else:
+        main(sys.argv[1:])
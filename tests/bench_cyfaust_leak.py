@@ -0,0 +1,68 @@
+import os, sys
+BUILD_PATH = os.path.join(os.path.dirname(os.path.dirname(__file__)), 'build')
+os.chdir(BUILD_PATH); sys.path.insert(0, BUILD_PATH)
+
+
+import gc
+import resource
+import time
+import cyfaust
+
+from testutils import print_section
+
+N_INSTANCES = int(sys.argv[1]) if len(sys.argv) > 1 else 1_000_000
+
+# resident set size growth allowed over the whole run (in KB)
+MAX_GROWTH_KB = 16 * 1024
+
+
+def max_rss_kb():
+    rss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # bytes on macOS, KB on Linux
+    return rss // 1024 if sys.platform == 'darwin' else rss
+
+
+def bench_create_destroy(n):
+    factory = cyfaust.create_dsp_factory_from_file('noise.dsp')
+
+    # warm up allocator pools before taking the reference measure
+    for i in range(1000):
+        factory.create_dsp_instance()
+    gc.collect()
+    start_rss = max_rss_kb()
+
+    start = time.perf_counter()
+    for i in range(n):
+        dsp = factory.create_dsp_instance()
+        dsp.init(48000)
+    del dsp
+    for i in range(n // 10):
+        with factory.create_dsp_instance() as dsp:
+            dsp.init(48000)
+        assert dsp.closed
+    elapsed = time.perf_counter() - start
+
+    growth = max_rss_kb() - start_rss
+    total = n + n // 10
+    print(f"{total} instances in {elapsed:.2f}s ({elapsed / total * 1e6:.2f} us/instance)")
+    print(f"max rss growth: {growth} KB")
+    assert growth < MAX_GROWTH_KB, "instances are leaking"
+
+
+def bench_factory_lifetime():
+    # instances keep their factory alive
+    dsp = cyfaust.create_dsp_factory_from_file('noise.dsp').create_dsp_instance()
+    gc.collect()
+    dsp.init(48000)
+    assert dsp.get_samplerate() == 48000
+    clone = dsp.clone()
+    dsp.close()
+    dsp.close()
+    clone.init(44100)
+    assert clone.get_samplerate() == 44100
+
+
+if __name__ == '__main__':
+    print_section("benchmarking cyfaust instance lifetime")
+    bench_factory_lifetime()
+    bench_create_destroy(N_INSTANCES)
@@ -0,0 +1,12 @@
+// Many-channel: 32 inputs and 32 outputs with per-channel filters and a channel permutation
+
+import("stdfaust.lib");
+
+declare name "channels";
+
+N = 32;
+gain = hslider("gain", 0.5, 0, 1, 0.01);
+
+chan(i) = fi.highpass(2, 20 + 10 * i) : *(gain);
+
+process = par(i, N, chan(i)) : ro.cross(N) : par(i, N, fi.lowpass(1, 1000 + 200 * i));
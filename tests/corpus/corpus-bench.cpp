@@ -0,0 +1,331 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+
+/*
+    Regression benchmark of the DSP corpus with the interpreter backend.
+
+    Each DSP of the corpus directory is compiled, rendered offline for a fixed duration with
+    deterministic inputs (and deterministic notes for polyphonic DSPs), and its throughput and
+    output checksum are reported. Checksums are compared with a reference file, to check that
+    a change is bit-exact:
+
+        corpus-bench tests/corpus -update            # record references.txt (before the change)
+        corpus-bench tests/corpus                    # compare with references.txt (after the change)
+
+    Options:
+        -duration <sec>     rendered duration (default 10)
+        -bs <frames>        buffer size (default 512)
+        -sr <hz>            sample rate (default 48000)
+        -ref <file>         reference file (default <dir>/references.txt)
+        -update             write the reference file instead of comparing with it
+        -json <file>        also write the results as JSON
+        -opt "<options>"    compilation options given to the interpreter backend
+
+    Checksums depend on the libm and the CPU, so references have to be recorded on the same machine.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <dirent.h>
+#include <string.h>
+
+#include "faust/dsp/interpreter-dsp.h"
+#include "faust/dsp/poly-interpreter-dsp.h"
+#include "faust/dsp/libfaust.h"
+#include "faust/gui/SoundUI.h"
+#include "faust/misc.h"
+
+using namespace std;
+
+// Deterministic sound resources for soundfile based DSPs (each file has a different length and pitch)
+struct CorpusReader : public SoundfileReader {
+
+    int getLength(const string& path_name)
+    {
+        return 22050 + int(path_name.size() % 7) * 4410;
+    }
+
+    virtual bool checkFile(const string& path_name) override { return true; }
+
+    virtual void getParamsFile(const string& path_name, int& channels, int& length) override
+    {
+        channels = 2;
+        length = getLength(path_name);
+    }
+
+    virtual void readFile(Soundfile* soundfile, const string& path_name, int part, int& offset, int max_chan) override
+    {
+        int length = getLength(path_name);
+        soundfile->fLength[part] = length;
+        soundfile->fSR[part] = 44100;
+        soundfile->fOffset[part] = offset;
+        for (int chan = 0; chan < 2; chan++) {
+            for (int frame = 0; frame < length; frame++) {
+                double value = sin(2.0 * M_PI * frame * (220.0 * (part + 1) + 110.0 * chan) / 44100.0);
+                if (soundfile->fIsDouble) {
+                    static_cast<double**>(soundfile->fBuffers)[chan][offset + frame] = value;
+                } else {
+                    static_cast<float**>(soundfile->fBuffers)[chan][offset + frame] = float(value);
+                }
+            }
+        }
+        offset += length;
+    }
+
+};
+
+struct CorpusResult {
+    string fName;
+    string fError;
+    int fInputs = 0;
+    int fOutputs = 0;
+    double fCompileTime = 0;    // in seconds
+    double fRenderTime = 0;     // in seconds
+    double fMBPerSec = 0;
+    double fRealTime = 0;       // rendered duration / render time
+    string fChecksum;
+    string fStatus;             // "ok", "changed", "new" or "error"
+};
+
+// FNV-1a on the output samples bits
+struct Checksum {
+
+    uint64_t fHash = 14695981039346656037ULL;
+
+    void add(const FAUSTFLOAT* buffer, int count)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(buffer);
+        for (size_t i = 0; i < count * sizeof(FAUSTFLOAT); i++) {
+            fHash = (fHash ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+
+    string get()
+    {
+        stringstream res;
+        res << hex << setw(16) << setfill('0') << fHash;
+        return res.str();
+    }
+
+};
+
+static int getVoices(const string& content)
+{
+    size_t pos = content.find("[nvoices:");
+    return (pos != string::npos) ? atoi(content.c_str() + pos + 9) : 0;
+}
+
+static vector<string> listDSPs(const string& dir)
+{
+    vector<string> files;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return files;
+    while (struct dirent* entry = readdir(d)) {
+        string name = entry->d_name;
+        if (name.size() > 4 && name.substr(name.size() - 4) == ".dsp") files.push_back(name);
+    }
+    closedir(d);
+    sort(files.begin(), files.end());
+    return files;
+}
+
+static CorpusResult renderDSP(const string& dir, const string& file, int argc, const char* argv[],
+                              double duration, int buffer_size, int sample_rate)
+{
+    CorpusResult res;
+    res.fName = file.substr(0, file.size() - 4);
+    string path = dir + "/" + file;
+    string content = pathToContent(path);
+    int voices = getVoices(content);
+    string error_msg;
+
+    // Compile
+    auto start = chrono::steady_clock::now();
+    interpreter_dsp_factory* factory = nullptr;
+    dsp_poly_factory* poly_factory = nullptr;
+    dsp* DSP = nullptr;
+    dsp_poly* poly = nullptr;
+    if (voices > 0) {
+        poly_factory = createInterpreterPolyDSPFactoryFromString(res.fName, content, argc, argv, error_msg);
+        if (poly_factory) DSP = poly = poly_factory->createPolyDSPInstance(voices, true, false);
+    } else {
+        factory = createInterpreterDSPFactoryFromString(res.fName, content, argc, argv, error_msg);
+        if (factory) DSP = factory->createDSPInstance();
+    }
+    res.fCompileTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!DSP) {
+        res.fError = (error_msg != "") ? error_msg : "cannot create instance";
+        res.fStatus = "error";
+        delete poly_factory;
+        if (factory) deleteInterpreterDSPFactory(factory);
+        return res;
+    }
+
+    SoundUI sound_ui(dir, sample_rate, new CorpusReader());
+    DSP->buildUserInterface(&sound_ui);
+    DSP->init(sample_rate);
+    res.fInputs = DSP->getNumInputs();
+    res.fOutputs = DSP->getNumOutputs();
+
+    // Deterministic inputs (as in measure_dsp, to avoid the speedup of null values)
+    vector<vector<FAUSTFLOAT> > inputs(res.fInputs, vector<FAUSTFLOAT>(buffer_size));
+    vector<vector<FAUSTFLOAT> > outputs(res.fOutputs, vector<FAUSTFLOAT>(buffer_size));
+    vector<FAUSTFLOAT*> ins(res.fInputs), outs(res.fOutputs);
+    for (int chan = 0; chan < res.fInputs; chan++) ins[chan] = inputs[chan].data();
+    for (int chan = 0; chan < res.fOutputs; chan++) outs[chan] = outputs[chan].data();
+    int seed = 0;
+
+    // Render
+    int frames = int(duration * sample_rate);
+    int note_period = sample_rate / 4;
+    int next_note = 0;
+    int chord = 0;
+    Checksum checksum;
+    chrono::steady_clock::duration render(0);
+    for (int frame = 0; frame < frames; frame += buffer_size) {
+        int count = std::min(buffer_size, frames - frame);
+        for (int chan = 0; chan < res.fInputs; chan++) {
+            for (int i = 0; i < count; i++) {
+                seed = 12345 + 1103515245 * seed;
+                inputs[chan][i] = FAUSTFLOAT(4.656613e-10f * seed);
+            }
+        }
+        // A new chord of 4 notes every 1/4 sec
+        if (poly && frame >= next_note) {
+            for (int i = 0; i < 4 && chord > 0; i++) poly->keyOff(0, 48 + ((chord - 1) * 5 + i * 7) % 24, 0);
+            for (int i = 0; i < 4; i++) poly->keyOn(0, 48 + (chord * 5 + i * 7) % 24, 100);
+            next_note += note_period;
+            chord++;
+        }
+        auto block_start = chrono::steady_clock::now();
+        DSP->compute(count, ins.data(), outs.data());
+        render += chrono::steady_clock::now() - block_start;
+        for (int chan = 0; chan < res.fOutputs; chan++) checksum.add(outs[chan], count);
+    }
+
+    res.fRenderTime = chrono::duration<double>(render).count();
+    res.fRealTime = duration / res.fRenderTime;
+    res.fMBPerSec = (double(frames) * double(res.fInputs + res.fOutputs) * double(sizeof(FAUSTFLOAT))) / (1024. * 1024. * res.fRenderTime);
+    res.fChecksum = checksum.get();
+
+    delete DSP;
+    delete poly_factory;
+    if (factory) deleteInterpreterDSPFactory(factory);
+    return res;
+}
+
+static map<string, string> readReferences(const string& path)
+{
+    map<string, string> refs;
+    ifstream file(path.c_str());
+    string name, checksum;
+    while (file >> name >> checksum) refs[name] = checksum;
+    return refs;
+}
+
+static void writeJSON(const string& path, const vector<CorpusResult>& results, double duration, int buffer_size, int sample_rate)
+{
+    ofstream file(path.c_str());
+    file << "{\n  \"duration\": " << duration << ", \"buffer_size\": " << buffer_size << ", \"sample_rate\": " << sample_rate << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const CorpusResult& res = results[i];
+        file << ((i > 0) ? ",\n" : "\n")
+             << "    {\"name\": \"" << res.fName << "\", \"status\": \"" << res.fStatus << "\", \"inputs\": " << res.fInputs
+             << ", \"outputs\": " << res.fOutputs << ", \"compile_time\": " << res.fCompileTime
+             << ", \"render_time\": " << res.fRenderTime << ", \"mb_per_sec\": " << res.fMBPerSec
+             << ", \"real_time\": " << res.fRealTime << ", \"checksum\": \"" << res.fChecksum << "\"}";
+    }
+    file << "\n  ]\n}\n";
+}
+
+int main(int argc, const char* argv[])
+{
+    if (isopt((char**)argv, "-h") || isopt((char**)argv, "-help") || argc < 2) {
+        cout << "corpus-bench <corpus-dir> [-duration <sec>] [-bs <frames>] [-sr <hz>] [-ref <file>] [-update] [-json <file>] [-opt \"<options>\"]" << endl;
+        exit(EXIT_FAILURE);
+    }
+
+    string dir = argv[1];
+    double duration = lopt((char**)argv, "-duration", 10);
+    int buffer_size = lopt((char**)argv, "-bs", 512);
+    int sample_rate = lopt((char**)argv, "-sr", 48000);
+    string ref_path = lopts((char**)argv, "-ref", (dir + "/references.txt").c_str());
+    string json_path = lopts((char**)argv, "-json", "");
+    bool update = isopt((char**)argv, "-update");
+
+    // Compilation options
+    vector<string> options;
+    stringstream opt_stream(lopts((char**)argv, "-opt", ""));
+    string opt;
+    while (opt_stream >> opt) options.push_back(opt);
+    vector<const char*> opt_argv;
+    for (const auto& it : options) opt_argv.push_back(it.c_str());
+
+    map<string, string> refs = readReferences(ref_path);
+    vector<CorpusResult> results;
+    bool failed = false;
+
+    cout << "Libfaust version : " << getCLibFaustVersion() << endl;
+    cout << left << setw(12) << "DSP" << right << setw(8) << "in/out" << setw(12) << "compile(s)" << setw(12) << "MB/sec"
+         << setw(12) << "x realtime" << setw(20) << "checksum" << "  status" << endl;
+
+    for (const auto& file : listDSPs(dir)) {
+        CorpusResult res = renderDSP(dir, file, int(opt_argv.size()), opt_argv.data(), duration, buffer_size, sample_rate);
+        if (res.fStatus == "") {
+            auto ref = refs.find(res.fName);
+            res.fStatus = (ref == refs.end()) ? "new" : ((ref->second == res.fChecksum) ? "ok" : "changed");
+        }
+        failed |= (res.fStatus == "error") || (!update && res.fStatus == "changed");
+        if (res.fStatus == "error") {
+            cout << left << setw(12) << res.fName << "  ERROR : " << res.fError << endl;
+        } else {
+            cout << left << setw(12) << res.fName << right << setw(8) << (to_string(res.fInputs) + "/" + to_string(res.fOutputs))
+                 << fixed << setprecision(3) << setw(12) << res.fCompileTime << setprecision(2) << setw(12) << res.fMBPerSec
+                 << setw(12) << res.fRealTime << setw(20) << res.fChecksum << "  " << res.fStatus << endl;
+        }
+        results.push_back(res);
+    }
+
+    if (update) {
+        ofstream file(ref_path.c_str());
+        for (const auto& res : results) {
+            if (res.fStatus != "error") file << res.fName << " " << res.fChecksum << endl;
+        }
+        cout << "References written to " << ref_path << endl;
+    }
+    if (json_path != "") {
+        writeJSON(json_path, results, duration, buffer_size, sample_rate);
+        cout << "Results written to " << json_path << endl;
+    }
+
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
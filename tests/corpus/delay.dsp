@@ -0,0 +1,15 @@
+// Delay-heavy: a bank of modulated fractional delay lines feeding a long feedback echo
+
+import("stdfaust.lib");
+
+declare name "delay";
+
+N = 16;
+maxdel = 65536;
+fb = hslider("feedback", 0.6, 0, 0.95, 0.01);
+
+lfo(i) = os.osc(0.1 + 0.05 * i) * 0.5 + 0.5;
+tap(i) = de.fdelay(maxdel, (1 + i) * 1000 + 500 * lfo(i));
+echo = + ~ (de.delay(maxdel, 24000) * fb);
+
+process = _ <: par(i, N, tap(i)) :> echo / N <: _, _;
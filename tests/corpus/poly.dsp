@@ -0,0 +1,15 @@
+// Polyphonic: a 16 voices subtractive synthesizer, to be instantiated with mydsp_poly
+
+import("stdfaust.lib");
+
+declare name "poly";
+declare options "[nvoices:16]";
+
+freq = hslider("freq", 440, 20, 2000, 0.01);
+gain = hslider("gain", 0.5, 0, 1, 0.01);
+gate = button("gate");
+
+env = en.adsr(0.01, 0.1, 0.8, 0.3, gate);
+voice = (os.sawtooth(freq) + os.square(freq * 1.01)) * 0.5 : fi.resonlp(2000 + 4000 * env, 2, 1) : *(env * gain);
+
+process = voice <: _, _;
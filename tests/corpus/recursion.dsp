@@ -0,0 +1,13 @@
+// Recursion-heavy: cascaded resonant filters inside a non-linear feedback loop
+
+import("stdfaust.lib");
+
+declare name "recursion";
+
+N = 24;
+q = hslider("q", 5, 0.5, 20, 0.1);
+
+stage(i) = fi.resonbp(200 * (i + 1), q, 1) : fi.lowpass(2, 8000);
+cascade = seq(i, N, _ <: _, stage(i) :> *(0.5));
+
+process = (+ : cascade) ~ (*(0.3) : ma.tanh) <: _, _;
@@ -0,0 +1,15 @@
+// Soundfile-based: two parts of a soundfile played in loop at different speeds
+
+import("stdfaust.lib");
+
+declare name "soundfile";
+
+sf = soundfile("sound[url:{'corpus1.wav';'corpus2.wav'}]", 2);
+
+length(part) = (part, 0) : sf : _, !, !, !;
+read(part, idx) = (part, idx) : sf : !, !, _, _;
+speed(part) = 0.5 + 0.75 * part;
+pos(part) = (+(speed(part)) : fmod(_, float(length(part)))) ~ _;
+play(part) = read(part, int(pos(part)));
+
+process = play(0), play(1) :> _, _;
@@ -0,0 +1,15 @@
+// Table-heavy: wavetable oscillators reading a rdtable, mixed into a rwtable looper
+
+import("stdfaust.lib");
+
+declare name "table";
+
+N = 8;
+size = 65536;
+sine = os.sinwaveform(size);
+
+freq(i) = 110 * (i + 1) * (1 + 0.01 * os.osc(0.3 * (i + 1)));
+wave(i) = rdtable(size, sine, int(os.lf_sawpos(freq(i)) * size));
+looper = rwtable(size, 0.0, ba.time % size, _, int(ba.time * 3 / 2) % size);
+
+process = _, (par(i, N, wave(i)) :> /(N)) : + : looper <: _, _;
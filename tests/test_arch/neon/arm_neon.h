@@ -0,0 +1,128 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+
+/*
+    Portable C version of the NEON intrinsics used by dsp-simd.h, following the ARM
+    definitions lane by lane. 'make neon' builds the tests with it on any host, so that
+    the NEON kernels are compiled and checked without an ARM toolchain.
+*/
+
+#ifndef __test_arm_neon__
+#define __test_arm_neon__
+
+typedef struct { float v[2]; } float32x2_t;
+typedef struct { float v[4]; } float32x4_t;
+typedef struct { float32x4_t val[2]; } float32x4x2_t;
+
+static inline float32x4_t vld1q_f32(const float* src)
+{
+    float32x4_t res;
+    for (int i = 0; i < 4; i++) res.v[i] = src[i];
+    return res;
+}
+
+static inline void vst1q_f32(float* dst, float32x4_t value)
+{
+    for (int i = 0; i < 4; i++) dst[i] = value.v[i];
+}
+
+static inline float32x4_t vdupq_n_f32(float value)
+{
+    float32x4_t res;
+    for (int i = 0; i < 4; i++) res.v[i] = value;
+    return res;
+}
+
+static inline float32x4_t vaddq_f32(float32x4_t a, float32x4_t b)
+{
+    float32x4_t res;
+    for (int i = 0; i < 4; i++) res.v[i] = a.v[i] + b.v[i];
+    return res;
+}
+
+static inline float32x4_t vmulq_f32(float32x4_t a, float32x4_t b)
+{
+    float32x4_t res;
+    for (int i = 0; i < 4; i++) res.v[i] = a.v[i] * b.v[i];
+    return res;
+}
+
+static inline float32x2_t vget_low_f32(float32x4_t a)
+{
+    float32x2_t res = { { a.v[0], a.v[1] } };
+    return res;
+}
+
+static inline float32x2_t vget_high_f32(float32x4_t a)
+{
+    float32x2_t res = { { a.v[2], a.v[3] } };
+    return res;
+}
+
+static inline float32x4_t vcombine_f32(float32x2_t low, float32x2_t high)
+{
+    float32x4_t res = { { low.v[0], low.v[1], high.v[0], high.v[1] } };
+    return res;
+}
+
+// [a0 b0 a2 b2] [a1 b1 a3 b3]
+static inline float32x4x2_t vtrnq_f32(float32x4_t a, float32x4_t b)
+{
+    float32x4x2_t res;
+    for (int i = 0; i < 2; i++) {
+        res.val[0].v[2 * i] = a.v[2 * i];
+        res.val[0].v[2 * i + 1] = b.v[2 * i];
+        res.val[1].v[2 * i] = a.v[2 * i + 1];
+        res.val[1].v[2 * i + 1] = b.v[2 * i + 1];
+    }
+    return res;
+}
+
+// [a0 a2 b0 b2] [a1 a3 b1 b3]
+static inline float32x4x2_t vuzpq_f32(float32x4_t a, float32x4_t b)
+{
+    float32x4x2_t res;
+    for (int i = 0; i < 2; i++) {
+        res.val[0].v[i] = a.v[2 * i];
+        res.val[0].v[i + 2] = b.v[2 * i];
+        res.val[1].v[i] = a.v[2 * i + 1];
+        res.val[1].v[i + 2] = b.v[2 * i + 1];
+    }
+    return res;
+}
+
+// [a0 b0 a1 b1] [a2 b2 a3 b3]
+static inline float32x4x2_t vzipq_f32(float32x4_t a, float32x4_t b)
+{
+    float32x4x2_t res;
+    for (int i = 0; i < 2; i++) {
+        res.val[0].v[2 * i] = a.v[i];
+        res.val[0].v[2 * i + 1] = b.v[i];
+        res.val[1].v[2 * i] = a.v[i + 2];
+        res.val[1].v[2 * i + 1] = b.v[i + 2];
+    }
+    return res;
+}
+
+#endif
@@ -0,0 +1,116 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+#include "test-dsp.h"
+#include "faust/dsp/dsp-adapter.h"
+
+// Error in dB of 'output' (at 'rate') against a sine of 'freq' Hz delayed by 'latency' output frames, from 'start'
+static double sineError(const std::vector<FAUSTFLOAT>& output, double rate, double freq, double latency, int start)
+{
+    double error = 0., power = 0.;
+    for (size_t i = start; i < output.size(); i++) {
+        double expected = 0.5 * sin(2. * M_PI * freq * (double(i) - latency) / rate);
+        error += (output[i] - expected) * (output[i] - expected);
+        power += expected * expected;
+    }
+    return 10. * log10(error / power);
+}
+
+static void testResampler(int in_rate, int out_rate, double freq)
+{
+    const int frames = 16384;
+    std::vector<FAUSTFLOAT> input(frames);
+    for (int i = 0; i < frames; i++) input[i] = FAUSTFLOAT(0.5 * sin(2. * M_PI * freq * i / in_rate));
+
+    // Whole signal at once, and by varying blocks: same outputs
+    polyphase_resampler resampler1(out_rate, in_rate, 1, frames);
+    std::vector<FAUSTFLOAT> output1(resampler1.getMaxOutputs(frames));
+    FAUSTFLOAT* in[1] = { input.data() };
+    FAUSTFLOAT* out[1] = { output1.data() };
+    int produced1 = resampler1.compute(frames, in, out, int(output1.size()));
+    output1.resize(produced1);
+    CHECK(std::abs(produced1 - int(int64_t(frames) * out_rate / in_rate)) <= 1);
+
+    polyphase_resampler resampler2(out_rate, in_rate, 1, 512);
+    std::vector<FAUSTFLOAT> output2;
+    std::vector<FAUSTFLOAT> block(resampler2.getMaxOutputs(512));
+    for (int i = 0, n = 0; i < frames; n++) {
+        int count = std::min(frames - i, 1 + (n * 37) % 512);
+        FAUSTFLOAT* in2[1] = { &input[i] };
+        FAUSTFLOAT* out2[1] = { block.data() };
+        int produced = resampler2.compute(count, in2, out2, resampler2.getMaxOutputs(count));
+        output2.insert(output2.end(), block.begin(), block.begin() + produced);
+        i += count;
+    }
+    CHECK(output2 == output1);
+
+    // Close to the ideal resampled sine, once the filter is primed
+    double latency = resampler1.getLatency() * out_rate / in_rate;
+    double error = sineError(output1, out_rate, freq, latency, int(2 * latency));
+    printf("resampler %d -> %d, %g Hz : %.1f dB\n", in_rate, out_rate, freq, error);
+    CHECK(error < -96.);
+}
+
+// The rate adapter gives 'count' frames for each block, with the DSP running at its own rate
+static void testRateAdapter(int rate, int dsp_rate)
+{
+    const int frames = 16384;
+    copy_dsp* inner = new copy_dsp(2);
+    dsp_resampler* adapter = static_cast<dsp_resampler*>(createRateAdapter(inner, dsp_rate, 512));
+    adapter->init(rate);
+    CHECK(inner->getSampleRate() == dsp_rate);
+
+    test_buffers in(2, frames), out(2, frames);
+    for (int i = 0; i < frames; i++) {
+        in.fData[0][i] = FAUSTFLOAT(0.5 * sin(2. * M_PI * 1000. * i / rate));
+        in.fData[1][i] = FAUSTFLOAT(0.5 * sin(2. * M_PI * 3000. * i / rate));
+    }
+    render(adapter, in, out, frames, 512, true);
+    double latency = adapter->getLatency();
+    double error0 = sineError(out.fData[0], rate, 1000., latency, int(2 * latency));
+    double error1 = sineError(out.fData[1], rate, 3000., latency, int(2 * latency));
+    printf("rate adapter %d -> %d : %.1f dB, %.1f dB\n", rate, dsp_rate, error0, error1);
+    CHECK(error0 < -96. && error1 < -96.);
+
+    // Clones run at the same rate
+    dsp* clone = adapter->clone();
+    clone->init(rate);
+    test_buffers out2(2, frames);
+    render(clone, in, out2, frames, 512, true);
+    CHECK(out2.maxDiff(out) == 0.);
+    delete clone;
+    delete adapter;
+}
+
+int main()
+{
+    testResampler(44100, 48000, 1000.);
+    testResampler(48000, 44100, 5000.);
+    testResampler(48000, 96000, 15000.);
+    testResampler(96000, 48000, 440.);
+    testRateAdapter(44100, 48000);
+    testRateAdapter(48000, 32000);
+    testRateAdapter(48000, 48000);
+
+    return testResult("dsp-adapter");
+}
@@ -0,0 +1,239 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+#include "test-dsp.h"
+#include "faust/dsp/dsp-combiner.h"
+#include "faust/gui/MapUI.h"
+
+/* Count the frames computed by the decorated DSP, and the largest number of frames per block */
+class counting_dsp : public decorator_dsp {
+
+    public:
+
+        int fFrames;
+
+        counting_dsp(dsp* dsp):decorator_dsp(dsp), fFrames(0) {}
+
+        void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            fFrames += count;
+            fDSP->compute(count, inputs, outputs);
+        }
+
+};
+
+// Render 'frames' frames from 'offset' by blocks, checking that each block computes at most both DSPs
+static void renderCounted(dsp* DSP, counting_dsp* dsp1, counting_dsp* dsp2,
+                          test_buffers& in, test_buffers& out, int offset, int frames, int block)
+{
+    for (int i = offset; i < offset + frames; i += block) {
+        int before = dsp1->fFrames + dsp2->fFrames;
+        std::vector<FAUSTFLOAT*> ins(in.at(i), in.at(i) + 1);
+        DSP->compute(block, ins.data(), out.at(i));
+        CHECK(dsp1->fFrames + dsp2->fFrames - before <= 2 * block);
+    }
+}
+
+// Maximum difference between 'out' and 'ref' on [start, end[
+static double diff(test_buffers& out, test_buffers& ref, int start, int end)
+{
+    double res = 0.;
+    for (int i = start; i < end; i++) res = std::max(res, double(fabs(out.fData[0][i] - ref.fData[0][i])));
+    return res;
+}
+
+/* test_dsp declaring a feedback 'delay' metadata */
+class delay_dsp : public test_dsp {
+
+    public:
+
+        delay_dsp():test_dsp(1, 1, 0.8) {}
+
+        void metadata(Meta* m) { m->declare("delay", "7"); }
+
+};
+
+// Reference of a recursiver, computed frame by frame
+static void renderRecursion(test_buffers& in, test_buffers& out, int frames, int delay)
+{
+    test_dsp dsp1(2, 1, 0.5), dsp2(1, 1, 0.8);
+    std::vector<FAUSTFLOAT> feedback(frames + delay, FAUSTFLOAT(0));
+    for (int i = 0; i < frames; i++) {
+        FAUSTFLOAT in1[2] = { feedback[i], in.fData[0][i] };
+        FAUSTFLOAT* ins1[2] = { &in1[0], &in1[1] };
+        FAUSTFLOAT* outs1[1] = { &out.fData[0][i] };
+        dsp1.compute(1, ins1, outs1);
+        FAUSTFLOAT* outs2[1] = { &feedback[i + delay] };
+        dsp2.compute(1, outs1, outs2);
+    }
+}
+
+static void testRecursiver(int delay, int buffer_size)
+{
+    const int frames = 2048;
+    test_buffers in(1, frames), expected(1, frames);
+    in.fill();
+    renderRecursion(in, expected, frames, delay);
+
+    dsp_recursiver recursiver(new test_dsp(2, 1, 0.5), new test_dsp(1, 1, 0.8), Layout::kTabGroup, "Recursiver", delay);
+    recursiver.prepare(buffer_size);
+    recursiver.init(48000);
+    CHECK(recursiver.getNumInputs() == 1 && recursiver.getDelay() == delay);
+
+    // Chunks of 'delay' frames are bit identical to the frame by frame computation, whatever the block sizes
+    for (int block : { 1, 5, 64, 300 }) {
+        test_buffers out(1, frames);
+        recursiver.instanceClear();
+        render(&recursiver, in, out, frames, block, true);
+        CHECK(out.maxDiff(expected) == 0.);
+    }
+
+    // Clones start from a cleared state
+    dsp* clone = recursiver.clone();
+    clone->init(48000);
+    test_buffers out(1, frames);
+    render(clone, in, out, frames, 256);
+    CHECK(out.maxDiff(expected) == 0.);
+    delete clone;
+}
+
+static void testCrossfaderPreroll(int preroll)
+{
+    const int block = 64, frames = 1024, change = 256;
+    counting_dsp* dsp1 = new counting_dsp(new test_dsp(1, 1, 0.5));
+    counting_dsp* dsp2 = new counting_dsp(new test_dsp(1, 1, 0.9));
+    dsp_crossfader crossfader(dsp1, dsp2, Layout::kTabGroup, "Crossfade", kLinearCurve, preroll);
+    crossfader.init(48000);
+    MapUI ui;
+    crossfader.buildUserInterface(&ui);
+
+    test_buffers in(1, frames), out(1, frames), ref1(1, frames), ref2(1, frames);
+    in.fill();
+
+    // Only dsp1 is heard (and computed) at 1
+    ui.setParamValue("Crossfade", 1);
+    renderCounted(&crossfader, dsp1, dsp2, in, out, 0, change, block);
+    CHECK(dsp2->fFrames == 0);
+    test_dsp expected1(1, 1, 0.5);
+    render(&expected1, in, ref1, frames, block);
+    CHECK(diff(out, ref1, 0, change) == 0.);
+
+    // dsp2 is cleared when resumed, and heard after 'preroll' frames (rounded to the block size),
+    // dsp1 being heard alone until then
+    ui.setParamValue("Crossfade", 0);
+    renderCounted(&crossfader, dsp1, dsp2, in, out, change, frames - change, block);
+    test_dsp expected2(1, 1, 0.9);
+    test_buffers in2(1, frames - change), out2(1, frames - change);
+    for (int i = 0; i < frames - change; i++) in2.fData[0][i] = in.fData[0][change + i];
+    render(&expected2, in2, out2, frames - change, block);
+    for (int i = 0; i < frames - change; i++) ref2.fData[0][change + i] = out2.fData[0][i];
+    int heard = change + ((preroll + block - 1) / block) * block;
+    CHECK(diff(out, ref1, change, heard) == 0.);
+    CHECK(diff(out, ref2, heard, frames) == 0.);
+    CHECK(dsp2->fFrames == frames - change);
+    CHECK(dsp1->fFrames == heard);
+}
+
+static void testCrossfaderBlend(CrossfadeCurve curve)
+{
+    const int frames = 512;
+    dsp_crossfader crossfader(new test_dsp(1, 1, 0.5), new test_dsp(1, 1, 0.9), Layout::kTabGroup, "Crossfade", curve);
+    crossfader.init(48000);
+    MapUI ui;
+    crossfader.buildUserInterface(&ui);
+    ui.setParamValue("Crossfade", 0.25);
+
+    test_buffers in(1, frames), out(1, frames), out1(1, frames), out2(1, frames);
+    in.fill();
+    render(&crossfader, in, out, frames, 100, true);
+    test_dsp dsp1(1, 1, 0.5), dsp2(1, 1, 0.9);
+    render(&dsp1, in, out1, frames, frames);
+    render(&dsp2, in, out2, frames, frames);
+    double gain1 = (curve == kLinearCurve) ? 0.25 : sin(0.25 * M_PI / 2);
+    double gain2 = (curve == kLinearCurve) ? 0.75 : cos(0.25 * M_PI / 2);
+    double res = 0.;
+    for (int i = 0; i < frames; i++) {
+        res = std::max(res, fabs(out.fData[0][i] - (gain1 * out1.fData[0][i] + gain2 * out2.fData[0][i])));
+    }
+    CHECK(res < 1e-6);
+}
+
+// 1 input, 1 output: a splitter and a merger in sequence, with a recursiver leaf
+static dsp* makeTree()
+{
+    dsp* split = new dsp_splitter(new test_dsp(1, 2, 0.3), new dsp_parallelizer(new test_dsp(2, 1, 0.6), new test_dsp(2, 1, 0.1)));
+    dsp* recursiver = new dsp_recursiver(new test_dsp(2, 2, 0.5), new test_dsp(2, 1, 0.8), Layout::kTabGroup, "Recursiver", 5);
+    dsp* merge = new dsp_merger(new dsp_parallelizer(recursiver, new test_dsp(1, 2, 0.9)), new test_dsp(2, 1, 0.4));
+    return new dsp_sequencer(split, merge);
+}
+
+// Blocks larger than the scratch pool are subdivided, clones keep the buffer size
+static void testLargeBlocks()
+{
+    const int frames = 6000;
+    dsp_binary_combiner* tree = static_cast<dsp_binary_combiner*>(makeTree());
+    dsp* reference = makeTree();
+    tree->prepare(32);
+    // The deepest path only: sequencer (2 channels), merger (4) and recursiver (2), not the splitter (2)
+    CHECK(tree->getBufferSize() == 32 && tree->getPoolSize() == (2 + 4 + 2) * 32);
+    tree->init(48000);
+    reference->init(48000);
+
+    test_buffers in(1, frames), out(1, frames), expected(1, frames);
+    in.fill();
+    render(reference, in, expected, frames, 100);
+    render(tree, in, out, frames, 1000, true);
+    CHECK(out.maxDiff(expected) == 0.);
+
+    dsp_binary_combiner* clone = static_cast<dsp_binary_combiner*>(tree->clone());
+    CHECK(clone->getBufferSize() == 32 && clone->getPoolSize() == tree->getPoolSize());
+    clone->init(48000);
+    test_buffers out2(1, frames);
+    render(clone, in, out2, frames, 777);
+    CHECK(out2.maxDiff(expected) == 0.);
+    delete clone;
+    delete reference;
+    delete tree;
+}
+
+int main()
+{
+    testRecursiver(1, 4096);
+    testRecursiver(3, 4096);
+    testRecursiver(100, 4096);
+    testRecursiver(100, 32);    // chunks limited by the buffer size
+
+    // The delay can be declared by the feedback DSP
+    dsp_recursiver recursiver(new test_dsp(2, 1), new delay_dsp(), Layout::kTabGroup, "Recursiver", 0);
+    CHECK(recursiver.getDelay() == 7);
+
+    testLargeBlocks();
+
+    testCrossfaderPreroll(0);
+    testCrossfaderPreroll(100);
+    testCrossfaderPreroll(128);
+    testCrossfaderBlend(kLinearCurve);
+    testCrossfaderBlend(kEqualPowerCurve);
+
+    return testResult("dsp-combiner");
+}
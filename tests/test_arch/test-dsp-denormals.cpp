@@ -0,0 +1,109 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+#include "test-dsp.h"
+#include "faust/dsp/dsp-denormals.h"
+
+/* Halves its output at each sample (in float), so goes through the 23 float subnormals before 0 */
+class decay_dsp : public test_dsp {
+
+    private:
+
+        float fValue;
+
+    public:
+
+        decay_dsp():test_dsp(0, 1), fValue(1.f) {}
+
+        void instanceClear() { fValue = 1.f; }
+        decay_dsp* clone() { return new decay_dsp(); }
+
+        void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            for (int i = 0; i < count; i++) {
+                fValue = fValue * fFactor;
+                outputs[0][i] = FAUSTFLOAT(fValue);
+            }
+        }
+
+        static volatile float fFactor;
+
+};
+
+volatile float decay_dsp::fFactor = 0.5f;
+
+static denormal_stats renderStats(dsp_denormals& decorated)
+{
+    test_buffers in(0, 256), out(1, 256);
+    decorated.instanceClear();
+    decorated.resetStats();
+    render(&decorated, in, out, 256, 32);
+    return decorated.getStats();
+}
+
+int main()
+{
+    dsp_denormals decorated(new decay_dsp(), DENORMALS_KEEP, 1);
+
+    // Without flushing, the 23 subnormals are counted (in the blocks [96, 128[ and [128, 160[)
+    denormal_stats stats = renderStats(decorated);
+    CHECK(stats.fCheckedBlocks == 8);
+    CHECK(stats.fDenormalSamples == 23);
+    CHECK(stats.fDenormalBlocks == 2);
+    CHECK(stats.fMaxPerBlock == 21 && stats.fLastBlock == 0);
+    CHECK(stats.getRatio(32, 1) == 23. / 256.);
+
+    // The detector only checks one block every 'period' blocks (here [96, 128[ and [224, 256[)
+    decorated.setPeriod(4);
+    stats = renderStats(decorated);
+    CHECK(stats.fCheckedBlocks == 2 && stats.fDenormalSamples == 2);
+    decorated.setPeriod(0);
+    stats = renderStats(decorated);
+    CHECK(stats.fCheckedBlocks == 0);
+
+#if defined (__SSE__) || defined (__arm64__) || defined (__aarch64__)
+    // Flushing policies of the decorator, whatever the global one is
+    decorated.setPeriod(1);
+    ScopedNoDenormals::setPolicy(DENORMALS_KEEP);
+    for (int policy : { DENORMALS_FTZ, DENORMALS_FTZ_DAZ }) {
+        decorated.setPolicy(policy);
+        stats = renderStats(decorated);
+        CHECK(stats.fCheckedBlocks == 8 && stats.fDenormalSamples == 0);
+    }
+    ScopedNoDenormals::setPolicy(DENORMALS_FTZ_DAZ);
+#endif
+#if defined (__SSE__)
+    // The FP status register of the calling thread is restored after each block
+    unsigned int csr = _mm_getcsr();
+    renderStats(decorated);
+    CHECK(_mm_getcsr() == csr);
+#endif
+
+    // Clones keep the policy and the period, with their own statistics
+    dsp_denormals* clone = decorated.clone();
+    CHECK(clone->getPolicy() == decorated.getPolicy() && clone->getPeriod() == decorated.getPeriod());
+    CHECK(clone->getStats().fCheckedBlocks == 0);
+    delete clone;
+
+    return testResult("dsp-denormals");
+}
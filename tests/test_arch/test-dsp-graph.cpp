@@ -0,0 +1,94 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+#include "test-dsp.h"
+#include "test-dsp.h"
+#include "faust/dsp/dsp-graph.h"
+
+/*
+ 2 inputs, 3 outputs: a parallelizer split to a wider one, merged into a recursiver and a filter
+ (so with 'mix' nodes), then sequenced into a last filter.
+ */
+static dsp* makeTree()
+{
+    dsp* split = new dsp_splitter(new dsp_parallelizer(new test_dsp(1, 2, 0.3), new test_dsp(1, 2, 0.6)),
+                                  new dsp_parallelizer(new test_dsp(4, 2, 0.1), new test_dsp(4, 2, 0.9)));
+    dsp* recursiver = new dsp_recursiver(new test_dsp(2, 1, 0.5), new test_dsp(1, 1, 0.8));
+    dsp* merge = new dsp_merger(split, new dsp_parallelizer(recursiver, new test_dsp(1, 1, 0.7)));
+    return new dsp_sequencer(merge, new test_dsp(2, 3, 0.4));
+}
+
+// 4 inputs, 4 outputs: 4 independent chains of 3 filters
+static dsp* makeWideTree()
+{
+    dsp* chains[4];
+    for (int i = 0; i < 4; i++) {
+        chains[i] = new dsp_sequencer(new dsp_sequencer(new test_dsp(1, 1, 0.1 * i), new test_dsp(1, 1, 0.5)), new test_dsp(1, 1, 0.9));
+    }
+    return new dsp_parallelizer(new dsp_parallelizer(chains[0], chains[1]), new dsp_parallelizer(chains[2], chains[3]));
+}
+
+// Same outputs as the serial combiners tree, with blocks larger than the graph buffers
+static void testGraph(dsp* (*make)(), int threads, int nodes, int levels, int width)
+{
+    const int frames = 20000;
+    dsp* serial = make();
+    dsp_graph graph(make(), threads, 256);
+    serial->init(48000);
+    graph.init(48000);
+    int inputs = serial->getNumInputs();
+    int outputs = serial->getNumOutputs();
+    CHECK(graph.getNumInputs() == inputs && graph.getNumOutputs() == outputs);
+    CHECK(graph.getNumNodes() == nodes);
+    CHECK(graph.getNumLevels() == levels);
+    // Workers are capped by the largest level
+    CHECK(graph.getNumThreads() == std::min(threads + 1, width));
+
+    test_buffers in(inputs, frames), out1(outputs, frames), out2(outputs, frames);
+    in.fill();
+    render(serial, in, out1, frames, 300, true);
+    render(&graph, in, out2, frames, 300, true);
+    CHECK(out1.maxDiff(out2) == 0.);
+
+    // Clones have the same threads
+    dsp* clone = graph.clone();
+    clone->init(48000);
+    CHECK(static_cast<dsp_graph*>(clone)->getNumThreads() == graph.getNumThreads());
+    test_buffers out3(outputs, frames);
+    render(clone, in, out3, frames, 64);
+    CHECK(out1.maxDiff(out3) == 0.);
+    delete clone;
+    delete serial;
+}
+
+int main()
+{
+    // 7 DSPs and 2 mix nodes
+    testGraph(makeTree, 0, 9, 5, 2);
+    testGraph(makeTree, 3, 9, 5, 2);
+    testGraph(makeWideTree, 0, 12, 3, 4);
+    testGraph(makeWideTree, 2, 12, 3, 4);
+    testGraph(makeWideTree, 8, 12, 3, 4);
+
+    return testResult("dsp-graph");
+}
@@ -0,0 +1,67 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+
+#include "test-dsp.h"
+#include "faust/dsp/dsp-pool.h"
+
+int main()
+{
+    test_dsp prototype(1, 1);
+    dsp_pool pool(&prototype, 4, 48000);
+    CHECK(pool.getNumInstances() == 4 && pool.getNumFree() == 4);
+
+    std::vector<dsp*> instances;
+    while (dsp* instance = pool.acquire()) instances.push_back(instance);
+    CHECK(instances.size() == 4 && pool.getNumFree() == 0);
+    CHECK(instances[0]->getSampleRate() == 48000);
+
+    // Released instances are reset
+    test_buffers in(1, 64), out(1, 64);
+    in.fill();
+    instances[0]->compute(64, in.get(), out.get());
+    CHECK(pool.release(instances[0]));
+    dsp* reused = pool.acquire();
+    CHECK(reused == instances[0]);
+    test_buffers out2(1, 64);
+    reused->compute(64, in.get(), out2.get());
+    CHECK(out.maxDiff(out2) == 0.);
+
+    // Double release and foreign instances are rejected
+    CHECK(pool.release(reused));
+    CHECK(!pool.release(reused));
+    CHECK(!pool.release(&prototype));
+    CHECK(pool.getNumFree() == 1);
+    CHECK(pool.acquire() == reused);
+    CHECK(pool.acquire() == nullptr);
+
+    for (auto& it : instances) CHECK(pool.release(it));
+    CHECK(pool.getNumFree() == 4);
+
+    // 'reserve' adds instances without giving back acquired ones twice
+    dsp* acquired = pool.acquire();
+    CHECK(pool.reserve(6) == 6 && pool.getNumFree() == 5);
+    CHECK(pool.release(acquired) && pool.getNumFree() == 6);
+
+    return testResult("dsp-pool");
+}
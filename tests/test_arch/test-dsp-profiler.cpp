@@ -0,0 +1,130 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+// Small ring buffers, to test dropped events
+#define PROFILER_BUFFER_SIZE 4
+
+#include <thread>
+
+#include "test-dsp.h"
+#include "faust/dsp/dsp-profiler.h"
+#include "faust/dsp/dsp-combiner.h"
+
+/* Record one event without computing anything */
+static void event(dsp_profiler& profiler, int node)
+{
+    profiler.end(node, profiler.begin());
+}
+
+static bool hasPath(dsp_profiler& profiler, const std::string& path)
+{
+    std::map<std::string, int64_t> folded = profiler.getFolded();
+    return folded.find(path) != folded.end();
+}
+
+int main()
+{
+    // Nested profiled nodes
+    {
+        dsp_profiler profiler(true);
+        profiled_dsp root(new dsp_sequencer(new profiled_dsp(new test_dsp(1, 1), &profiler, "a"),
+                                            new profiled_dsp(new test_dsp(1, 1), &profiler, "b")), &profiler, "root");
+        test_buffers in(1, 4096), out(1, 4096);
+        in.fill();
+        // Collect after each block, as the ring buffers are small
+        for (int i = 0; i < 4096; i += 512) {
+            root.compute(512, in.at(i), out.at(i));
+            profiler.collect();
+        }
+        std::map<std::string, int64_t> folded = profiler.getFolded();
+        CHECK(folded.size() == 3 && hasPath(profiler, "root") && hasPath(profiler, "root;a") && hasPath(profiler, "root;b"));
+        CHECK(folded["root;a"] > 0 && folded["root;b"] > 0);
+        CHECK(profiler.getDropped() == 0);
+        CHECK(profiler.getChromeTrace().find("\"name\":\"root\"") != std::string::npos);
+
+        // Disabled profiler
+        profiler.reset();
+        profiler.setEnabled(false);
+        root.compute(512, in.get(), out.get());
+        CHECK(profiler.getFolded().empty());
+    }
+
+    // The children of a dropped node are not attributed to the next node at its depth
+    {
+        dsp_profiler profiler(true);
+        int x = profiler.registerNode("x");
+        int p = profiler.registerNode("p");
+        int c = profiler.registerNode("c");
+        int q = profiler.registerNode("q");
+        int d = profiler.registerNode("d");
+        for (int i = 0; i < 3; i++) event(profiler, x);
+        int64_t start = profiler.begin();
+        event(profiler, c);
+        profiler.end(p, start);     // the buffer is full: 'p' is dropped
+        CHECK(profiler.getDropped() == 1);
+        profiler.collect();
+        start = profiler.begin();
+        event(profiler, d);
+        profiler.end(q, start);
+        CHECK(hasPath(profiler, "q;d") && !hasPath(profiler, "q;c"));
+        CHECK(hasPath(profiler, "c"));   // its only ancestor was dropped
+    }
+
+    // The children of a dropped node are attributed to its recorded parent
+    {
+        dsp_profiler profiler(true);
+        int x = profiler.registerNode("x");
+        int g = profiler.registerNode("g");
+        int p = profiler.registerNode("p");
+        int c = profiler.registerNode("c");
+        for (int i = 0; i < 3; i++) event(profiler, x);
+        int64_t start_g = profiler.begin();
+        int64_t start_p = profiler.begin();
+        event(profiler, c);
+        profiler.end(p, start_p);   // dropped
+        profiler.collect();
+        profiler.end(g, start_g);
+        std::map<std::string, int64_t> folded = profiler.getFolded();
+        CHECK(folded.size() == 3 && hasPath(profiler, "g;c") && hasPath(profiler, "g"));
+    }
+
+    // Threads without a preallocated buffer drop their events
+    {
+        dsp_profiler profiler(true, 2);
+        CHECK(profiler.getNumBuffers() == 2);
+        int n = profiler.registerNode("n");
+        for (int i = 0; i < 3; i++) {
+            std::thread thread([&]() { event(profiler, n); });
+            thread.join();
+        }
+        CHECK(profiler.getDropped() == 1);
+        profiler.reserve(3);
+        CHECK(profiler.getNumBuffers() == 3);
+        std::thread thread([&]() { event(profiler, n); });
+        thread.join();
+        CHECK(profiler.getDropped() == 1);
+        CHECK(profiler.getFolded()["n"] >= 0 && hasPath(profiler, "n"));
+    }
+
+    return testResult("dsp-profiler");
+}
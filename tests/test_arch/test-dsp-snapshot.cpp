@@ -0,0 +1,149 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+
+
+#include "test-dsp.h"
+#include "faust/dsp/dsp-snapshot.h"
+#include "faust/dsp/dsp-pool.h"
+#include "faust/gui/MapUI.h"
+
+/* A DSP allocated in the arena with its state, as the interpreter DSPs are */
+class arena_test_dsp : public test_dsp {
+
+    public:
+
+        static arena_memory_manager* gArena;
+
+        arena_test_dsp():test_dsp(1, 2, FAUSTFLOAT(0.99), gArena)
+        {}
+
+        static void* operator new(size_t size) { return gArena->allocate(size); }
+        static void operator delete(void* ptr) { gArena->destroy(ptr); }
+
+        arena_test_dsp* clone() { return new arena_test_dsp(); }
+
+};
+
+arena_memory_manager* arena_test_dsp::gArena = nullptr;
+
+struct test_factory {
+    dsp_memory_manager* getMemoryManager() { return arena_test_dsp::gArena; }
+    arena_test_dsp* createDSPInstance() { return new arena_test_dsp(); }
+};
+
+static const int kFrames = 1000;
+
+/* Output of the source instance after the snapshot */
+static test_buffers gExpected(2, kFrames);
+
+static void renderAfterSnapshot(dsp* instance, test_buffers& out)
+{
+    test_buffers in(1, kFrames);
+    in.fill(12345);
+    render(instance, in, out, kFrames, 64);
+}
+
+/* Restored instances have to continue exactly as the source */
+static bool checkRestore(dsp_snapshot* snapshot, dsp* instance, arena_memory_manager* arena)
+{
+    std::string error;
+    instance->init(44100);
+    if (!snapshot->restore(instance, arena, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    test_buffers out(2, kFrames);
+    renderAfterSnapshot(instance, out);
+    return out.maxDiff(gExpected) == 0.;
+}
+
+int main()
+{
+    arena_memory_manager arena;
+    arena_test_dsp::gArena = &arena;
+    test_factory factory;
+    std::string error;
+
+    dsp* source = createArenaDSPInstance(&factory);
+    source->init(48000);
+    test_buffers in(1, kFrames), out(2, kFrames);
+    in.fill();
+    render(source, in, out, kFrames, 100);
+
+    MapUI ui;
+    source->buildUserInterface(&ui);
+    ui.setParamValue("/test/Gain", FAUSTFLOAT(0.7));
+
+    dsp_snapshot* snapshot = dsp_snapshot::capture(source, &arena, error);
+    CHECK(snapshot);
+    // The object zone is skipped, the state zone is copied
+    CHECK(snapshot->getNumZones() == 2 && snapshot->getStateSize() == 2 * sizeof(double));
+    CHECK(snapshot->getNumControls() == 1 && snapshot->getSampleRate() == 48000);
+
+    // Restored instances continue exactly as the source
+    dsp* clone = cloneArenaDSPInstance(source, &arena);
+    renderAfterSnapshot(source, gExpected);
+    dsp* instance = createArenaDSPInstance(&factory);
+    CHECK(checkRestore(snapshot, instance, &arena));
+
+    // Clones of tracked instances, and pool instances cloned from a prototype
+    CHECK(arena.getInstanceZones(clone));
+    CHECK(checkRestore(snapshot, clone, &arena));
+    {
+        dsp_pool pool(source, 2, 44100, &arena);
+        dsp* pooled = pool.acquire();
+        CHECK(checkRestore(snapshot, pooled, &arena));
+    }
+
+    // Untracked instances are rejected
+    dsp* untracked = source->clone();
+    CHECK(!snapshot->restore(untracked, &arena, error));
+    CHECK(!dsp_snapshot::capture(untracked, &arena, error));
+
+    // Buffer and file round trips
+    dsp_snapshot* copy = dsp_snapshot::fromBuffer(snapshot->getData(), snapshot->getSize(), error);
+    CHECK(copy && copy->getSize() == snapshot->getSize());
+    CHECK(copy && checkRestore(copy, instance, &arena));
+    std::string path = "/tmp/test-dsp-snapshot.snp";
+    CHECK(snapshot->save(path, error));
+    dsp_snapshot* loaded = dsp_snapshot::fromFile(path, error);
+    CHECK(loaded && memcmp(loaded->getData(), snapshot->getData(), snapshot->getSize()) == 0);
+    CHECK(loaded && checkRestore(loaded, instance, &arena));
+    remove(path.c_str());
+
+    // Corrupted content is rejected
+    std::vector<char> truncated(snapshot->getData(), snapshot->getData() + snapshot->getSize() - 1);
+    CHECK(!dsp_snapshot::fromBuffer(truncated.data(), truncated.size(), error));
+
+    delete loaded;
+    delete copy;
+    delete untracked;
+    delete clone;
+    delete instance;
+    delete snapshot;
+    delete source;
+    CHECK(arena.getNumZones() == 0);
+
+    return testResult("dsp-snapshot");
+}
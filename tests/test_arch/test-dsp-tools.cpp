@@ -0,0 +1,199 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+#include "test-dsp.h"
+#include "test-dsp.h"
+#include "faust/dsp/dsp-tools.h"
+
+// Interleaved test frames, each sample identifying its frame and channel
+static std::vector<float> makeInterleaved(int stride, int frames)
+{
+    std::vector<float> res(stride * frames);
+    for (size_t i = 0; i < res.size(); i++) res[i] = float(i) + 0.25f;
+    return res;
+}
+
+// The (SIMD when available) float kernels against the scalar templates, on all channel counts, strides and frame tails
+static void testKernels()
+{
+    const int chans_list[] = { 1, 2, 3, 4, 5, 8, 11 };
+    const int frames_list[] = { 1, 3, 4, 7, 63, 64, 65, 130 };
+    for (int chans : chans_list) {
+        for (int extra = 0; extra <= 3; extra += 3) {
+            int stride = chans + extra;
+            for (int frames : frames_list) {
+                std::vector<float> input = makeInterleaved(stride, frames);
+                test_buffers out1(chans, frames), out2(chans, frames);
+                deinterleaveSamples(input.data(), stride, out1.get(), chans, frames);
+                deinterleaveSamples<float>(input.data(), stride, out2.get(), chans, frames);
+                CHECK(out1.maxDiff(out2) == 0.);
+                for (int frame = 0; frame < frames; frame++) {
+                    CHECK(out1.fData[chans - 1][frame] == input[frame * stride + chans - 1]);
+                }
+
+                // Channels above 'chans' are kept
+                std::vector<float> output1(stride * frames, -1.f), output2(stride * frames, -1.f);
+                interleaveSamples(out1.get(), chans, output1.data(), stride, frames);
+                interleaveSamples<float>(out1.get(), chans, output2.data(), stride, frames);
+                CHECK(output1 == output2);
+                for (int i = 0; i < stride * frames; i++) {
+                    CHECK(output1[i] == ((i % stride < chans) ? input[i] : -1.f));
+                }
+            }
+        }
+    }
+}
+
+template <typename SAMPLE>
+static int64_t toInt(SAMPLE sample) { return int64_t(sample); }
+
+static int64_t toInt(const int24_packed& sample)
+{
+    return int64_t(sample.fBytes[0]) | (int64_t(sample.fBytes[1]) << 8) | (int64_t(int8_t(sample.fBytes[2])) * 65536);
+}
+
+static int24_packed toInt24(int32_t value)
+{
+    uint32_t bits = uint32_t(value);
+    int24_packed res = { { uint8_t(bits), uint8_t(bits >> 8), uint8_t(bits >> 16) } };
+    return res;
+}
+
+// Read and write back a sample, which is unchanged
+template <typename SAMPLE>
+static void testRoundTrip(SAMPLE sample, double scale)
+{
+    FAUSTFLOAT value = sample_format<SAMPLE>::read(sample);
+    CHECK(fabs(double(value) - double(toInt(sample)) / scale) <= 1e-7 * fabs(double(value)));
+    SAMPLE res;
+    sample_format<SAMPLE>::write(res, value);
+    // int32 samples keep the FAUSTFLOAT precision only
+    double tolerance = (sizeof(SAMPLE) == 4 && sizeof(FAUSTFLOAT) == 4) ? fabs(double(toInt(sample))) * 6e-8 : 0.;
+    CHECK(fabs(double(toInt(res) - toInt(sample))) <= tolerance);
+}
+
+// Written values are clipped
+template <typename SAMPLE>
+static void testClip(int64_t min, int64_t max)
+{
+    SAMPLE sample;
+    sample_format<SAMPLE>::write(sample, FAUSTFLOAT(1));
+    CHECK(toInt(sample) == max);
+    sample_format<SAMPLE>::write(sample, FAUSTFLOAT(2));
+    CHECK(toInt(sample) == max);
+    sample_format<SAMPLE>::write(sample, FAUSTFLOAT(-1));
+    CHECK(toInt(sample) == min);
+    sample_format<SAMPLE>::write(sample, FAUSTFLOAT(-2));
+    CHECK(toInt(sample) == min);
+    sample_format<SAMPLE>::write(sample, FAUSTFLOAT(0));
+    CHECK(toInt(sample) == 0);
+}
+
+static void testConverters()
+{
+    for (int value = -32768; value <= 32767; value++) {
+        testRoundTrip(int16_t(value), 32768.);
+    }
+    for (int value = -8388608; value <= 8388607; value += 127) {
+        testRoundTrip(toInt24(value), 8388608.);
+    }
+    const int32_t limits24[] = { -8388608, -8388607, -65536, -256, -1, 0, 1, 255, 65535, 8388607 };
+    for (int32_t value : limits24) {
+        testRoundTrip(toInt24(value), 8388608.);
+    }
+    CHECK(sample_format<int24_packed>::read(toInt24(-1)) == FAUSTFLOAT(-1./8388608.));
+    CHECK(sample_format<int24_packed>::read(toInt24(-8388608)) == FAUSTFLOAT(-1));
+    for (int64_t value = -2147483648LL; value <= 2147483647LL; value += 16777259) {
+        testRoundTrip(int32_t(value), 2147483648.);
+    }
+    testRoundTrip(int32_t(-2147483647 - 1), 2147483648.);
+    testRoundTrip(int32_t(2147483647), 2147483648.);
+    testClip<int16_t>(-32768, 32767);
+    testClip<int24_packed>(-8388608, 8388607);
+    testClip<int32_t>(-2147483648LL, 2147483647LL);
+}
+
+// readSamples then writeSamples give the device buffer back, extra channels being cleared
+template <typename SAMPLE>
+static void testReadWrite(int scale, bool interleaved)
+{
+    const int frames = 37;
+    const int dev_chans = 5;
+    std::vector<SAMPLE> input(dev_chans * frames);
+    for (size_t i = 0; i < input.size(); i++) {
+        sample_format<SAMPLE>::write(input[i], FAUSTFLOAT((int(i * 7919) % scale) / double(scale)));
+    }
+
+    // More buffers than device channels: the extra ones are cleared
+    test_buffers buffers(dev_chans + 2, frames);
+    for (auto& channel : buffers.fData) std::fill(channel.begin(), channel.end(), FAUSTFLOAT(1));
+    readSamples(input.data(), dev_chans, interleaved, buffers.get(), dev_chans + 2, frames);
+    CHECK(buffers.fData[dev_chans][0] == FAUSTFLOAT(0) && buffers.fData[dev_chans + 1][frames - 1] == FAUSTFLOAT(0));
+    std::vector<SAMPLE> output(dev_chans * frames);
+    writeSamples(buffers.get(), dev_chans, output.data(), dev_chans, interleaved, frames);
+    CHECK(memcmp(output.data(), input.data(), sizeof(SAMPLE) * input.size()) == 0);
+
+    // Less buffers than device channels: the extra device channels are cleared
+    writeSamples(buffers.get(), 2, output.data(), dev_chans, interleaved, frames);
+    for (int chan = 0; chan < dev_chans; chan++) {
+        for (int frame = 0; frame < frames; frame++) {
+            int index = (interleaved) ? frame * dev_chans + chan : chan * frames + frame;
+            CHECK(toInt(output[index]) == ((chan < 2) ? toInt(input[index]) : 0));
+        }
+    }
+}
+
+// No channel count limit
+static void testInterleavers()
+{
+    const int chans = 300;
+    const int frames = 21;
+    SampleDeinterleaver<int16_t> deinterleaver(frames, chans, chans);
+    for (int i = 0; i < chans * frames; i++) deinterleaver.input()[i] = int16_t(i);
+    deinterleaver.deinterleave();
+    CHECK(deinterleaver.outputs()[chans - 1][frames - 1] == FAUSTFLOAT((chans * frames - 1) / 32768.));
+
+    SampleInterleaver<int16_t> interleaver(frames, chans, chans);
+    for (int chan = 0; chan < chans; chan++) {
+        memcpy(interleaver.inputs()[chan], deinterleaver.outputs()[chan], sizeof(FAUSTFLOAT) * frames);
+    }
+    interleaver.interleave();
+    CHECK(memcmp(interleaver.output(), deinterleaver.input(), sizeof(int16_t) * chans * frames) == 0);
+}
+
+int main()
+{
+    testKernels();
+    testConverters();
+    testReadWrite<float>(1000, true);
+    testReadWrite<float>(1000, false);
+    testReadWrite<int16_t>(32768, true);
+    testReadWrite<int16_t>(32768, false);
+    testReadWrite<int24_packed>(8388608, true);
+    testReadWrite<int24_packed>(8388608, false);
+    testReadWrite<int32_t>(65536, true);
+    testReadWrite<int32_t>(65536, false);
+    testInterleavers();
+
+    return testResult("dsp-tools");
+}
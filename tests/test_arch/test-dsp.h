@@ -0,0 +1,211 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+
+/*
+    Shared helpers of the architecture tests: a CHECK macro, hand written DSPs
+    (so that the tests do not need libfaust) and buffers to render them.
+*/
+
+#ifndef __test_dsp__
+#define __test_dsp__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+#include "faust/dsp/dsp.h"
+#include "faust/gui/UI.h"
+#include "faust/gui/meta.h"
+
+static int gFailures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); gFailures++; } } while (0)
+
+static int testResult(const char* name)
+{
+    printf("%s : %s\n", name, (gFailures == 0) ? "OK" : "FAILED");
+    return (gFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*
+ A stateful DSP: each output is a one-pole filter of the sum of the inputs (or of a noise
+ when there are no inputs), scaled by a 'Gain' slider. Its state is allocated with the
+ memory manager when one is set, as compiled DSPs do.
+ */
+class test_dsp : public dsp {
+
+    protected:
+
+        int fInputs;
+        int fOutputs;
+        FAUSTFLOAT fDecay;
+        FAUSTFLOAT fGain;
+        int fSampleRate;
+        unsigned int fSeed;
+        double* fState;
+        dsp_memory_manager* fManager;
+
+    public:
+
+        test_dsp(int inputs, int outputs, FAUSTFLOAT decay = FAUSTFLOAT(0.5), dsp_memory_manager* manager = nullptr)
+        :fInputs(inputs), fOutputs(outputs), fDecay(decay), fGain(1), fSampleRate(0), fSeed(0), fManager(manager)
+        {
+            size_t size = sizeof(double) * std::max(1, outputs);
+            fState = static_cast<double*>(fManager ? fManager->allocate(size) : malloc(size));
+            instanceClear();
+        }
+
+        virtual ~test_dsp()
+        {
+            if (fManager) fManager->destroy(fState); else free(fState);
+        }
+
+        int getNumInputs() { return fInputs; }
+        int getNumOutputs() { return fOutputs; }
+
+        void buildUserInterface(UI* ui_interface)
+        {
+            ui_interface->openVerticalBox("test");
+            ui_interface->addHorizontalSlider("Gain", &fGain, FAUSTFLOAT(1), FAUSTFLOAT(0), FAUSTFLOAT(2), FAUSTFLOAT(0.01));
+            ui_interface->closeBox();
+        }
+
+        int getSampleRate() { return fSampleRate; }
+
+        void init(int sample_rate) { instanceInit(sample_rate); }
+        void instanceInit(int sample_rate)
+        {
+            instanceConstants(sample_rate);
+            instanceResetUserInterface();
+            instanceClear();
+        }
+        void instanceConstants(int sample_rate) { fSampleRate = sample_rate; }
+        void instanceResetUserInterface() { fGain = FAUSTFLOAT(1); }
+        void instanceClear()
+        {
+            fSeed = 0;
+            for (int o = 0; o < std::max(1, fOutputs); o++) fState[o] = 0.;
+        }
+
+        test_dsp* clone() { return new test_dsp(fInputs, fOutputs, fDecay, fManager); }
+        void metadata(Meta* m) { m->declare("name", "test"); }
+
+        void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            for (int i = 0; i < count; i++) {
+                double in = 0.;
+                if (fInputs == 0) {
+                    fSeed = 1103515245u * fSeed + 12345u;
+                    in = int(fSeed) * 4.6566128752457969e-10;
+                }
+                for (int c = 0; c < fInputs; c++) in += inputs[c][i];
+                for (int o = 0; o < fOutputs; o++) {
+                    fState[o] = fDecay * fState[o] + (1. - fDecay) * in * (o + 1);
+                    outputs[o][i] = FAUSTFLOAT(fGain * fState[o]);
+                }
+            }
+        }
+
+};
+
+/* Copy the inputs to the outputs */
+class copy_dsp : public test_dsp {
+
+    public:
+
+        copy_dsp(int channels):test_dsp(channels, channels) {}
+
+        copy_dsp* clone() { return new copy_dsp(fInputs); }
+
+        void compute(int count, FAUSTFLOAT** inputs, FAUSTFLOAT** outputs)
+        {
+            for (int chan = 0; chan < fOutputs; chan++) {
+                memcpy(outputs[chan], inputs[chan], sizeof(FAUSTFLOAT) * count);
+            }
+        }
+
+};
+
+/* Channel buffers, with the FAUSTFLOAT** view expected by 'compute' */
+struct test_buffers {
+
+    std::vector<std::vector<FAUSTFLOAT> > fData;
+    std::vector<FAUSTFLOAT*> fChannels;
+
+    test_buffers(int channels, int frames)
+    :fData(channels, std::vector<FAUSTFLOAT>(frames)), fChannels(channels)
+    {
+        for (int c = 0; c < channels; c++) fChannels[c] = fData[c].data();
+    }
+
+    /* Fill with a deterministic signal, different on each channel */
+    void fill(int offset = 0)
+    {
+        for (size_t c = 0; c < fData.size(); c++) {
+            for (size_t i = 0; i < fData[c].size(); i++) {
+                fData[c][i] = FAUSTFLOAT(0.5 * sin(0.01 * (c + 1) * (offset + i)) + 0.1 * cos(0.37 * (offset + i)));
+            }
+        }
+    }
+
+    /* Return the channel pointers moved by 'offset' frames */
+    FAUSTFLOAT** at(int offset)
+    {
+        for (size_t c = 0; c < fData.size(); c++) fChannels[c] = fData[c].data() + offset;
+        return fChannels.data();
+    }
+
+    FAUSTFLOAT** get() { return at(0); }
+
+    double maxDiff(const test_buffers& other) const
+    {
+        double res = 0.;
+        for (size_t c = 0; c < fData.size(); c++) {
+            for (size_t i = 0; i < fData[c].size(); i++) {
+                res = std::max(res, double(fabs(fData[c][i] - other.fData[c][i])));
+            }
+        }
+        return res;
+    }
+
+};
+
+/* Render 'frames' frames of 'in' through 'instance' in blocks of 'block' frames (varied when 'vary' is set) */
+static void render(dsp* instance, test_buffers& in, test_buffers& out, int frames, int block, bool vary = false)
+{
+    for (int i = 0, n = 0; i < frames; n++) {
+        int count = std::min(frames - i, vary ? 1 + (block * (n % 5 + 1)) / 3 : block);
+        FAUSTFLOAT** inputs = in.at(i);
+        std::vector<FAUSTFLOAT*> ins(inputs, inputs + in.fData.size());
+        instance->compute(count, ins.data(), out.at(i));
+        i += count;
+    }
+}
+
+#endif
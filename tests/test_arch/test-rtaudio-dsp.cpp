@@ -0,0 +1,96 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+#include "test-dsp.h"
+#include "test-dsp.h"
+#include "faust/audio/rtaudio-dsp.h"
+
+// The 'native' mode of the driver, with the device format and interleaving set by hand (no device is opened)
+class test_rtaudio : public rtaudio {
+
+    public:
+
+        test_rtaudio(int inchans, int outchans, RtAudioFormat format, bool interleaved, int bsize)
+        :rtaudio(48000, bsize, true)
+        {
+            fDevNumInChans = inchans;
+            fDevNumOutChans = outchans;
+            fFormat = format;
+            fInterleaved = interleaved;
+            allocateBuffers();
+        }
+
+        void process(void* inbuf, void* outbuf, unsigned long frames) { processAudio(0., inbuf, outbuf, frames); }
+};
+
+/*
+ A copy DSP on a device with one more output channel: each block of the device input buffer
+ is found unchanged in the output buffer, and the extra output channel is cleared.
+ */
+template <typename SAMPLE>
+static void testRoundTrip(RtAudioFormat format, bool interleaved, double scale)
+{
+    const int chans = 3;
+    const int frames = 67;
+    test_rtaudio driver(chans, chans + 1, format, interleaved, frames);
+    copy_dsp copy(chans);
+    driver.setDsp(&copy);
+
+    std::vector<SAMPLE> input(chans * frames);
+    std::vector<SAMPLE> output((chans + 1) * frames);
+    SAMPLE one;
+    sample_format<SAMPLE>::write(one, FAUSTFLOAT(1));
+    for (int block = 0; block < 3; block++) {
+        for (size_t i = 0; i < input.size(); i++) {
+            int value = int((i * 7919 + block * 104729) % 65536) - 32768;
+            sample_format<SAMPLE>::write(input[i], FAUSTFLOAT(value / scale));
+        }
+        std::fill(output.begin(), output.end(), one);
+        // The last block is shorter than the buffer size
+        int count = (block < 2) ? frames : frames / 2;
+        driver.process(input.data(), output.data(), count);
+        for (int chan = 0; chan <= chans; chan++) {
+            for (int frame = 0; frame < count; frame++) {
+                const SAMPLE& res = (interleaved) ? output[frame * (chans + 1) + chan] : output[chan * count + frame];
+                if (chan < chans) {
+                    const SAMPLE& sample = (interleaved) ? input[frame * chans + chan] : input[chan * count + frame];
+                    CHECK(memcmp(&res, &sample, sizeof(SAMPLE)) == 0);
+                } else {
+                    CHECK(sample_format<SAMPLE>::read(res) == FAUSTFLOAT(0));
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    for (int interleaved = 0; interleaved < 2; interleaved++) {
+        testRoundTrip<float>(RTAUDIO_FLOAT32, interleaved, 32768.);
+        testRoundTrip<int16_t>(RTAUDIO_SINT16, interleaved, 32768.);
+        testRoundTrip<int24_packed>(RTAUDIO_SINT24, interleaved, 32768.);
+        testRoundTrip<int32_t>(RTAUDIO_SINT32, interleaved, 32768.);
+    }
+
+    return testResult("rtaudio-dsp");
+}
@@ -58,8 +58,21 @@ def test_audio():
     # pyfaust.delete_interpreter_dsp_factory(factory)
     print("OK: test_create_interpreter_dsp_factory_from_file")
 
+def test_compute():
+    import numpy as np
+    factory = cfaust.InterpreterDspFactory.from_file('noise.dsp')
+    dsp = factory.create_dsp_instance()
+    dsp.init(48000)
+    outputs = np.zeros((1, 256), dtype=np.float32)
+    dsp.compute(None, outputs)
+    assert np.any(outputs != 0)
+    # empty buffers are accepted
+    dsp.compute(None, np.zeros((1, 0), dtype=np.float32))
+    print("OK: test_compute")
+
 
 if __name__ == '__main__':
     print_section("testing cfaust")
+    test_compute()
     test_audio()
 
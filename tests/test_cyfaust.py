@@ -36,7 +36,372 @@ def test_cyfaust():
     time.sleep(1)
     # audio.stop() # not needed here
 
+def test_arena_memory_manager():
+    arena = cyfaust.ArenaMemoryManager(huge_pages=False)
+    factory = cyfaust.create_dsp_factory_from_file('noise.dsp')
+    factory.set_memory_manager(arena)
+    assert factory.get_memory_manager() is arena
+
+    dsps = [factory.create_dsp_instance() for i in range(16)]
+    for dsp in dsps:
+        dsp.init(48000)
+    assert arena.num_zones > 0
+    assert arena.allocated_size % arena.alignment == 0
+    print("arena:", arena.allocated_size, "bytes in", arena.num_chunks, "chunk(s)")
+
+def test_dsp_pool():
+    factory = cyfaust.create_dsp_factory_from_file('noise.dsp')
+    pool = cyfaust.InterpreterDspPool(factory, 8, 48000)
+    assert len(pool) == 8 and pool.num_free == 8
+
+    dsps = [pool.acquire() for i in range(8)]
+    assert pool.acquire() is None
+    assert all(dsp.get_samplerate() == 48000 for dsp in dsps)
+    for dsp in dsps:
+        pool.release(dsp)
+    assert pool.num_free == 8
+    try:
+        pool.release(dsps[0])
+        assert False, "double release must fail"
+    except ValueError:
+        pass
+    assert pool.num_free == 8
+
+    # instances dropped without release() go back to the pool
+    dsp = pool.acquire()
+    assert pool.num_free == 7
+    del dsp
+    assert pool.num_free == 8
+
+    clones = cyfaust.InterpreterDspPool(factory.create_dsp_instance(), 4, 44100)
+    assert clones.acquire().get_samplerate() == 44100
+    # acquired instances and their clones keep the factory alive
+    dsp = clones.acquire()
+    del clones, pool, factory
+    clone = dsp.clone()
+    clone.init(48000)
+    assert clone.get_samplerate() == 48000
+
+
+def test_dsp_snapshot():
+    factory = cyfaust.create_dsp_factory_from_file('noise.dsp')
+    arena = cyfaust.ArenaMemoryManager()
+    factory.set_memory_manager(arena)
+    dsp1 = factory.create_dsp_instance()
+    dsp2 = factory.create_dsp_instance()
+    dsp1.init(48000)
+    dsp2.init(48000)
+
+    import numpy as np
+    outputs = np.zeros((1, 256), dtype=np.float32)
+    dsp1.compute(None, outputs)
+    snap = arena.snapshot(dsp1)
+    assert snap.sample_rate == 48000 and len(snap) > 0
+    # restored instances (clones included) continue exactly as the source
+    clone = dsp1.clone()
+    expected = np.zeros((1, 256), dtype=np.float32)
+    dsp1.compute(None, expected)
+    for dsp in (dsp2, clone):
+        arena.restore(dsp, snap)
+        dsp.compute(None, outputs)
+        assert np.array_equal(outputs, expected)
+
+    copy = cyfaust.DspSnapshot.from_bytes(snap.to_bytes())
+    assert copy.state_size == snap.state_size
+    snap.save('noise.snp')
+    loaded = cyfaust.DspSnapshot.from_file('noise.snp')
+    assert loaded.mapped and loaded.num_zones == snap.num_zones
+    arena.restore(dsp2, loaded)
+    os.remove('noise.snp')
+
+
+
+def test_dsp_lifetime():
+    factory = cyfaust.create_dsp_factory_from_file('noise.dsp')
+    with factory.create_dsp_instance() as dsp:
+        dsp.init(48000)
+        clone = dsp.clone()
+    assert dsp.closed and not clone.closed
+    # closed instances raise instead of crashing
+    for method, args in (('get_numinputs', ()), ('init', (48000,)), ('clone', ()), ('instance_clear', ())):
+        try:
+            getattr(dsp, method)(*args)
+            assert False, f"{method} must fail on a closed instance"
+        except ValueError:
+            pass
+    del factory
+    clone.init(44100)
+    # empty buffers are accepted
+    import numpy as np
+    clone.compute(None, np.zeros((1, 0), dtype=np.float32))
+    clone.close()
+    clone.close()
+
+
+def test_dsp_ownership():
+    import numpy as np
+    factory = cyfaust.create_dsp_factory_from_string("gain", "process = *(0.5);")
+    dsp1 = factory.create_dsp_instance()
+    dsp2 = factory.create_dsp_instance()
+    # instances pointed to by a MapUI or a driver cannot be given to a combiner or a decorator
+    ui = cyfaust.MapUI(dsp1)
+    driver = cyfaust.RtAudioDriver(48000, 256)
+    driver.set_dsp(dsp2)
+    for make in (lambda: cyfaust.create_dsp_sequencer(dsp1, dsp2),
+                 lambda: cyfaust.create_dsp_denormals(dsp1, cyfaust.DENORMALS_FTZ),
+                 lambda: cyfaust.create_dsp_graph(dsp2, 0)):
+        try:
+            make()
+            assert False, "an instance in use was taken"
+        except ValueError:
+            pass
+    assert not dsp1.closed and not dsp2.closed
+    # nor closed
+    for instance in (dsp1, dsp2):
+        try:
+            instance.close()
+            assert False, "an instance in use was closed"
+        except ValueError:
+            pass
+    assert not dsp1.closed and not dsp2.closed
+    # closed instances are refused by MapUI and RtAudioDriver
+    dsp3 = factory.create_dsp_instance()
+    dsp3.close()
+    for make in (lambda: cyfaust.MapUI(dsp3), lambda: driver.set_dsp(dsp3)):
+        try:
+            make()
+            assert False, "a closed instance was used"
+        except ValueError:
+            pass
+    del ui
+    driver.set_dsp(dsp1)
+    try:
+        cyfaust.create_dsp_sequencer(dsp1, dsp2)
+        assert False, "the instance of a driver was combined"
+    except ValueError:
+        pass
+    del driver
+    combined = cyfaust.create_dsp_sequencer(dsp1, dsp2)
+    assert dsp1.closed and dsp2.closed
+    try:
+        cyfaust.create_dsp_sequencer(dsp1, factory.create_dsp_instance())
+        assert False, "a closed instance was combined"
+    except ValueError:
+        pass
+    # instances acquired from a pool stay owned by the pool
+    pool = cyfaust.InterpreterDspPool(factory, 1, 48000)
+    try:
+        cyfaust.create_dsp_parallelizer(pool.acquire(), factory.create_dsp_instance())
+        assert False, "an instance acquired from a pool was combined"
+    except ValueError:
+        pass
+    combined.init(48000)
+    inputs = np.ones((1, 16), dtype=np.float32)
+    outputs = np.zeros((1, 16), dtype=np.float32)
+    combined.compute(inputs, outputs)
+    assert np.all(outputs == 0.25)
+    # empty buffers are accepted, but outputs are required
+    combined.compute(np.zeros((1, 0), dtype=np.float32), np.zeros((1, 0), dtype=np.float32))
+    try:
+        combined.compute(inputs, None)
+        assert False, "None outputs accepted"
+    except TypeError:
+        pass
+    combined.close()
+
+
+def test_factory_errors():
+    try:
+        cyfaust.create_dsp_factory_from_string("broken", "process = +(;", "-vec")
+        assert False, "FaustCompileError expected"
+    except cyfaust.FaustCompileError as e:
+        assert e.message and e.compile_options == "-vec"
+        assert e.warnings == []
+
+    try:
+        cyfaust.read_dsp_factory_from_bitcode("not a bitcode")
+        assert False, "FaustBitcodeError expected"
+    except cyfaust.FaustError as e:
+        assert isinstance(e, cyfaust.FaustBitcodeError)
+
+
+def test_bench():
+    factory = cyfaust.create_dsp_factory_from_file('noise.dsp')
+    dsp = factory.create_dsp_instance()
+    res = cyfaust.bench(dsp, 256, 0.2, sample_rate=48000)
+    print(res)
+    p = res.percentiles
+    assert res.count > 0 and res.mb_per_sec > 0
+    assert p[0] <= p[50] <= p[99] <= p[100]
+    assert res.samples_per_sec > 0 and res.cpu_load > 0
+    # hardware counters may not be available (not Linux, VM, perf_event_paranoid)
+    res = cyfaust.bench(dsp, 256, 0.1, counters=True)
+    print("counters:", res.counters, "ipc:", res.ipc)
+    assert all(v is None or v[0] >= v[1] >= 0 for v in res.counters.values())
+
+
+def test_denormal_policy():
+    assert cyfaust.get_denormal_policy() == cyfaust.DENORMALS_FTZ_DAZ
+    code = "process = 1 - 1' : + ~ *(0.999);"
+    factory = cyfaust.create_dsp_factory_from_string("decay", code)
+    dsp = factory.create_dsp_instance()
+    dsp.init(48000)
+    try:
+        for policy in (cyfaust.DENORMALS_KEEP, cyfaust.DENORMALS_FTZ, cyfaust.DENORMALS_FTZ_DAZ):
+            cyfaust.set_denormal_policy(policy)
+            assert cyfaust.get_denormal_policy() == policy
+            print(policy, cyfaust.bench(dsp, 256, 0.05, random_controls=False))
+        try:
+            cyfaust.set_denormal_policy(3)
+            assert False, "invalid policy accepted"
+        except ValueError:
+            pass
+    finally:
+        cyfaust.set_denormal_policy(cyfaust.DENORMALS_FTZ_DAZ)
+
+
+def test_denormal_detector():
+    import numpy as np
+    # an impulse halved at each sample goes through the 23 float subnormals
+    code = "process = 1 - 1' : + ~ *(0.5);"
+    factory = cyfaust.create_dsp_factory_from_string("halve", code)
+    dsp = factory.create_dsp_instance()
+    dsp.init(48000)
+    decorated = cyfaust.create_dsp_denormals(dsp, cyfaust.DENORMALS_KEEP, period=1)
+    assert dsp.closed and decorated.get_numoutputs() == 1
+    outputs = np.zeros((1, 32), dtype=np.float32)
+    for i in range(8):
+        decorated.compute(None, outputs)
+    stats = decorated.stats
+    print(stats)
+    assert stats['checked_blocks'] == 8 and stats['denormal_samples'] == 23
+    decorated.policy = cyfaust.DENORMALS_FTZ_DAZ
+    decorated.instance_clear()
+    decorated.reset_stats()
+    for i in range(8):
+        decorated.compute(None, outputs)
+    assert decorated.stats['checked_blocks'] == 8 and decorated.stats['denormal_samples'] == 0
+    decorated.period = 0
+    clone = decorated.clone()
+    assert clone.policy == cyfaust.DENORMALS_FTZ_DAZ and clone.period == 0
+    for invalid in (lambda: setattr(decorated, 'policy', 3), lambda: setattr(decorated, 'period', -1)):
+        try:
+            invalid()
+            assert False, "invalid value accepted"
+        except ValueError:
+            pass
+    # the decorator can be combined like any other instance
+    combined = cyfaust.create_dsp_parallelizer(decorated, clone)
+    assert decorated.closed and combined.get_numoutputs() == 2
+    combined.close()
+
+
+def test_profiler():
+    import numpy as np
+    profiler = cyfaust.DspProfiler(enabled=True)
+    factory = cyfaust.create_dsp_factory_from_string("gain", "process = *(0.5);")
+    nodes = []
+    for name in ("a", "b"):
+        dsp = factory.create_dsp_instance()
+        dsp.init(48000)
+        nodes.append(cyfaust.create_profiled_dsp(dsp, profiler, name))
+    root = cyfaust.create_profiled_dsp(cyfaust.create_dsp_sequencer(*nodes), profiler, "root")
+    assert root.name == "root" and all(node.closed for node in nodes)
+    inputs = np.ones((1, 256), dtype=np.float32)
+    outputs = np.zeros((1, 256), dtype=np.float32)
+    for i in range(16):
+        root.compute(inputs, outputs)
+        profiler.collect()
+    assert np.all(outputs == 0.25)
+    folded = profiler.get_folded()
+    print(profiler.get_folded_stacks())
+    assert set(folded) == {"root", "root;a", "root;b"} and profiler.dropped == 0
+    assert '"name":"a"' in profiler.get_chrome_trace()
+    profiler.reset()
+    profiler.enabled = False
+    root.compute(inputs, outputs)
+    assert profiler.get_folded() == {}
+    root.close()
+
+
+def test_dsp_graph():
+    import numpy as np
+    factory = cyfaust.create_dsp_factory_from_string("filter", "import(\"stdfaust.lib\"); process = fi.lowpass(3, 1000) <: _, fi.highpass(2, 500);")
+    mixer = cyfaust.create_dsp_factory_from_string("mixer", "process = _, _ :> *(0.5);")
+
+    def make_tree():
+        # 2 parallel filters (1 -> 2) merged into a mixer (4 -> 2 -> 1)
+        instances = []
+        for i in range(2):
+            dsp = factory.create_dsp_instance()
+            dsp.init(48000)
+            instances.append(dsp)
+        mix = mixer.create_dsp_instance()
+        mix.init(48000)
+        return cyfaust.create_dsp_merger(cyfaust.create_dsp_parallelizer(*instances), mix)
+
+    inputs = np.random.default_rng(0).uniform(-1, 1, (2, 1000)).astype(np.float32)
+    serial = make_tree()
+    expected = np.zeros((1, 1000), dtype=np.float32)
+    serial.compute(inputs, expected)
+    for threads in (0, 2):
+        tree = make_tree()
+        graph = cyfaust.create_dsp_graph(tree, threads, buffer_size=256)
+        assert tree.closed and graph.num_nodes == 5 and graph.num_levels == 3
+        # workers are capped by the widest level (the 2 filters, or the 2 sums)
+        assert graph.num_threads == (1 if threads == 0 else 2)
+        outputs = np.zeros((1, 1000), dtype=np.float32)
+        graph.compute(inputs, outputs)
+        assert np.array_equal(outputs, expected)
+        graph.close()
+    serial.close()
+
+
+def test_optimizer():
+    code = "import(\"stdfaust.lib\"); process = no.noise : fi.lowpass(3, 1000);"
+    optimizer = cyfaust.InterpreterDspOptimizer(buffer_size=16, duration=0.05)
+    options, mb_per_sec, std_dev, cpu_load = optimizer.find_optimized_parameters("noise", code)
+    print("best options:", " ".join(options), mb_per_sec)
+    assert options and mb_per_sec > 0 and optimizer.cache_size == 1
+    factory = optimizer.create_dsp_factory_from_string("noise", code)
+    assert optimizer.cache_size == 1
+    assert factory.create_dsp_instance() is not None
+
+
+def test_bitcode_buffers():
+    import mmap, tempfile
+    factory = cyfaust.create_dsp_factory_from_file('noise.dsp')
+    bitcode = factory.write_to_bitcode_bytes()
+    assert isinstance(bitcode, bytes) and bitcode.decode() == factory.write_to_bitcode()
+    for buffer in (bitcode, bytearray(bitcode), memoryview(bitcode)):
+        assert cyfaust.read_dsp_factory_from_bitcode(buffer).create_dsp_instance() is not None
+    with tempfile.TemporaryFile() as f:
+        f.write(bitcode)
+        f.flush()
+        with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as blob:
+            factory = cyfaust.read_dsp_factory_from_bitcode(blob)
+    assert factory.create_dsp_instance() is not None
+    # strided buffers are rejected
+    try:
+        cyfaust.read_dsp_factory_from_bitcode(memoryview(bitcode)[::2])
+        assert False, "ValueError expected"
+    except (ValueError, BufferError):
+        pass
+
 
 if __name__ == '__main__':
     print_section("testing cyfaust")
     test_cyfaust()
+    test_arena_memory_manager()
+    test_dsp_pool()
+    test_dsp_snapshot()
+    test_dsp_lifetime()
+    test_dsp_ownership()
+    test_factory_errors()
+    test_bench()
+    test_denormal_policy()
+    test_denormal_detector()
+    test_profiler()
+    test_dsp_graph()
+    test_optimizer()
+    test_bitcode_buffers()
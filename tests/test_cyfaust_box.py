@@ -1,3 +1,5 @@
+import numpy as np
+
 from cyfaust import *
 
 # functional way
@@ -22,6 +24,132 @@ def test_box_create_source():
         assert "class mydsp : public dsp" in code
         print(code)
 
+# bulk construction from arrays
+def test_box_from_arrays():
+    with box_context():
+        # 7, 3.14, (7, 3.14)
+        opcodes = np.array([BOX_OP_INT, BOX_OP_REAL, BOX_OP_PAR], dtype=np.int32)
+        args = np.array([[-1, -1, -1], [-1, -1, -1], [0, 1, -1]], dtype=np.int32)
+        values = np.array([7, 3.14, 0], dtype=np.float64)
+        box = box_from_arrays(opcodes, args, values)
+        assert box.is_valid, "box is not valid"
+        assert box.outputs == 2
+        code = box.create_source("test_dsp", "cpp")
+        assert code == box_par(box_int(7), box_float(3.14)).create_source("test_dsp", "cpp")
+
+def test_sig_from_arrays():
+    with signal_context():
+        # (in0 + in0@1) * 0.5
+        opcodes = np.array([SIG_OP_INPUT, SIG_OP_INT, SIG_OP_DELAY, SIG_OP_BINOP, SIG_OP_REAL, SIG_OP_BINOP], dtype=np.int32)
+        args = np.array([[-1, -1, -1], [-1, -1, -1], [0, 1, -1], [0, 2, -1], [-1, -1, -1], [3, 4, -1]], dtype=np.int32)
+        values = np.array([0, 1, 0, 0, 0.5, 2], dtype=np.float64) # kAdd = 0, kMul = 2
+        sigs = sig_from_arrays(opcodes, args, values, outputs=[5])
+        assert len(sigs) == 1 and sigs[0].is_valid
+        assert "class mydsp : public dsp" in create_source_from_signals("test_dsp", sigs, "cpp")
+
+def test_from_arrays_invalid():
+    with box_context():
+        # operand indices must refer to previous nodes
+        opcodes = np.array([BOX_OP_WIRE, BOX_OP_SEQ], dtype=np.int32)
+        args = np.array([[-1, -1, -1], [0, 1, -1]], dtype=np.int32)
+        values = np.zeros(2)
+        try:
+            box_from_arrays(opcodes, args, values)
+            assert False, "invalid program accepted"
+        except ValueError:
+            pass
+        # integer values must be finite integers within int range
+        opcodes = np.array([BOX_OP_INT], dtype=np.int32)
+        args = np.array([[-1, -1, -1]], dtype=np.int32)
+        for value in (1.5, np.nan, np.inf, 2.0**40):
+            try:
+                box_from_arrays(opcodes, args, np.array([value]))
+                assert False, f"invalid integer {value} accepted"
+            except ValueError:
+                pass
+
+# direct factory creation, without source round-trip
+def test_create_dsp_factory_from_boxes():
+    with box_context():
+        box = box_par(box_int(7), box_float(3.14))
+        factory = create_dsp_factory_from_boxes("test_dsp", box)
+        assert factory.get_name() == "test_dsp"
+    # the factory outlives the context of its boxes
+    assert not box.is_valid, "box outlived its context"
+    dsp = factory.create_dsp_instance()
+    dsp.init(48000)
+    outputs = np.zeros((2, 16), dtype=np.float32)
+    dsp.compute(None, outputs)
+    assert np.allclose(outputs[0], 7) and np.allclose(outputs[1], 3.14)
+
+def test_create_dsp_factory_from_signals():
+    with signal_context():
+        sigs = [sig_bin_op(2, sig_input(0), sig_real(0.5))] # kMul = 2
+        factory = create_dsp_factory_from_signals("test_dsp", sigs)
+    dsp = factory.create_dsp_instance()
+    assert dsp.get_numinputs() == 1 and dsp.get_numoutputs() == 1
+
+# libfaust is not thread safe: its calls keep the GIL, so that threads can share a context
+def test_threaded_compilation():
+    import threading
+    errors = []
+    def compile(i):
+        try:
+            box = box_par(box_int(i), box_float(0.5))
+            factory = create_dsp_factory_from_boxes(f"test_dsp{i}", box)
+            dsp = factory.create_dsp_instance()
+            dsp.init(48000)
+            outputs = np.zeros((2, 16), dtype=np.float32)
+            dsp.compute(None, outputs)
+            assert np.allclose(outputs[0], i) and np.allclose(outputs[1], 0.5)
+        except Exception as e:
+            errors.append(e)
+    with box_context():
+        threads = [threading.Thread(target=compile, args=(i,)) for i in range(4)]
+        for thread in threads:
+            thread.start()
+        for i in range(200):
+            assert box_seq(box_wire(), box_delay(box_wire(), box_int(i))).is_valid
+        for thread in threads:
+            thread.join()
+    assert not errors, errors
+
+# cost estimation before compilation
+def test_analyze_signals():
+    with signal_context():
+        x = sig_input(0)
+        y = sig_bin_op(0, sig_delay(x, sig_int(100)), sig_delay(x, sig_int(28))) # kAdd = 0
+        cost = analyze_signals([y])
+        # both delays of x share one line
+        assert cost['num_delays'] == 1
+        assert cost['delay_memory'] == 100
+        assert cost['max_delay'] == 100
+        assert cost['sample_ops'] > 0
+
+def test_analyze_recursive_signals():
+    # y = x + 0.5 * y@10
+    opcodes = np.array([SIG_OP_INPUT, SIG_OP_SELF, SIG_OP_INT, SIG_OP_DELAY,
+                        SIG_OP_REAL, SIG_OP_BINOP, SIG_OP_BINOP, SIG_OP_RECURSION], dtype=np.int32)
+    args = np.array([[-1, -1, -1], [-1, -1, -1], [-1, -1, -1], [1, 2, -1],
+                     [-1, -1, -1], [3, 4, -1], [0, 5, -1], [6, -1, -1]], dtype=np.int32)
+    values = np.array([0, 0, 10, 0, 0.5, 2, 0, 0], dtype=np.float64) # kMul = 2, kAdd = 0
+    with signal_context():
+        y = sig_from_arrays(opcodes, args, values)
+        cost = analyze_signals([y])
+        # the equations of the group are walked: nothing is opaque and the delay inside is counted
+        assert cost['opaque_nodes'] == 0
+        assert cost['nodes']['recursion group'] == 1
+        assert cost['nodes']['arithmetic'] >= 2
+        assert cost['max_delay'] >= 10
+
 if __name__ == '__main__':
     test_create_source_from_boxes()
     test_box_create_source()
+    test_box_from_arrays()
+    test_sig_from_arrays()
+    test_from_arrays_invalid()
+    test_create_dsp_factory_from_boxes()
+    test_create_dsp_factory_from_signals()
+    test_threaded_compilation()
+    test_analyze_signals()
+    test_analyze_recursive_signals()
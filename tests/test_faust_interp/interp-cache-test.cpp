@@ -0,0 +1,134 @@
+/************************************************************************
+    FAUST Architecture File
+    Copyright (C) 2020 GRAME, Centre National de Creation Musicale
+    ---------------------------------------------------------------------
+    This Architecture section is free software; you can redistribute it
+    and/or modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 3 of
+    the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; If not, see <http://www.gnu.org/licenses/>.
+
+    EXCEPTION : As a special exception, you may create a larger work
+    that contains this FAUST architecture section and distribute
+    that work under terms of your choice, so long as this FAUST
+    architecture section is not modified.
+
+ ************************************************************************/
+
+
+/*
+    Tests of the interpreter factory cache (interpreter-dsp-cache.h) and
+    of the compile options optimizer (interpreter-dsp-optimizer.h).
+*/
+
+#include <iostream>
+#include <string>
+
+#include "faust/dsp/libfaust.h"
+#include "faust/dsp/libfaust-box.h"
+#include "faust/dsp/interpreter-dsp.h"
+#include "faust/dsp/interpreter-dsp-cache.h"
+#include "faust/dsp/interpreter-dsp-optimizer.h"
+
+using namespace std;
+
+static int gFailures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " << #cond << endl; gFailures++; } } while (0)
+
+static const char* gCode = "import(\"stdfaust.lib\"); process = os.osc(440) : fi.lowpass(4, 2000) <: _,_;";
+
+static void testOptimizer()
+{
+    cout << "Test interpreter_dsp_optimizer\n";
+    string error_msg;
+    interpreter_dsp_optimizer optimizer(256, 0.05);
+    interpreter_dsp_optimizer::TResult res, cached;
+
+    CHECK(optimizer.findOptimizedParameters("FaustDSP", gCode, 0, nullptr, res));
+    CHECK(std::get<0>(res) > 0 && std::get<3>(res).size() > 0);
+    // The second search is served by the cache
+    CHECK(optimizer.findOptimizedParameters("FaustDSP", gCode, 0, nullptr, cached));
+    CHECK(cached == res && optimizer.getCacheSize() == 1);
+
+    interpreter_dsp_factory* factory = optimizer.createDSPFactoryFromString("FaustDSP", gCode, 0, nullptr, error_msg);
+    CHECK(factory);
+    if (factory) {
+        CHECK(factory->getCompileOptions().find(std::get<3>(res)[0]) != string::npos);
+        deleteInterpreterDSPFactory(factory);
+    }
+
+    // The factory cache compiles boxes with the tuned options
+    createLibContext();
+    int inputs, outputs;
+    Box box = DSPToBoxes("FaustDSP", gCode, 0, nullptr, &inputs, &outputs, error_msg);
+    CHECK(box);
+    {
+        interpreter_dsp_factory_cache cache(&optimizer);
+        factory = cache.createFromBoxes("FaustDSP", box, 0, nullptr, error_msg);
+        CHECK(factory && optimizer.getCacheSize() == 2);
+        interpreter_dsp_optimizer::TResult tuned;
+        auto none = [](int, const char*[], string&) -> interpreter_dsp_factory* { return nullptr; };
+        CHECK(optimizer.findOptimizedParameters(interpreter_dsp_factory_cache::getBoxesKey("FaustDSP", box, 0, nullptr),
+                                                0, nullptr, none, tuned));
+        if (factory) {
+            CHECK(factory->getCompileOptions().find(std::get<3>(tuned)[0]) != string::npos);
+        }
+        CHECK(cache.createFromBoxes("FaustDSP", box, 0, nullptr, error_msg) == factory && cache.getHits() == 1);
+        if (factory) {
+            CHECK(cache.release(factory) && cache.release(factory));
+        }
+    }
+    destroyLibContext();
+}
+
+static void testReferences()
+{
+    cout << "Test interpreter_dsp_factory_cache references\n";
+    string error_msg;
+    createLibContext();
+    int inputs, outputs;
+    Box box = DSPToBoxes("FaustDSP", gCode, 0, nullptr, &inputs, &outputs, error_msg);
+    CHECK(box);
+    interpreter_dsp_factory_cache cache;
+    interpreter_dsp_factory* factory = cache.createFromBoxes("FaustDSP", box, 0, nullptr, error_msg);
+    CHECK(factory && cache.getReferences(factory) == 1 && cache.getMisses() == 1);
+    CHECK(cache.createFromBoxes("FaustDSP", box, 0, nullptr, error_msg) == factory);
+    CHECK(cache.getReferences(factory) == 2 && cache.getHits() == 1);
+    if (factory) {
+        dsp* instance = factory->createDSPInstance();
+        CHECK(instance);
+        // A referenced factory is neither removed nor cleared, so that its instances stay valid
+        CHECK(!cache.remove(factory) && cache.clear() == 1 && cache.getSize() == 1);
+        if (instance) {
+            instance->init(44100);
+            CHECK(instance->getSampleRate() == 44100);
+            delete instance;
+        }
+        CHECK(cache.release(factory) && cache.release(factory) && !cache.release(factory));
+        CHECK(cache.remove(factory) && cache.getSize() == 0 && !cache.remove(factory));
+    }
+    // A removed program is compiled again
+    factory = cache.createFromBoxes("FaustDSP", box, 0, nullptr, error_msg);
+    CHECK(factory && cache.getMisses() == 2 && cache.getReferences(factory) == 1);
+    if (factory) {
+        CHECK(cache.release(factory) && cache.clear() == 0 && cache.getSize() == 0);
+    }
+    destroyLibContext();
+}
+
+int main(int argc, const char** argv)
+{
+    testOptimizer();
+    testReferences();
+    cout << "interp-cache-test : " << ((gFailures == 0) ? "OK" : "FAILED") << endl;
+    return (gFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -42,6 +42,64 @@ def test_nanofaust():
     nanofaust.delete_interpreter_dsp_factory(factory)
 
 
+def test_ownership():
+    import numpy as np
+    factory = nanofaust.create_interpreter_dsp_factory_from_string("gain", "process = *(0.5);")
+    dsp1 = factory.create_dsp_instance()
+    dsp2 = factory.create_dsp_instance()
+    # an instance whose controls are referenced by a MapUI cannot be given to a combiner
+    ui = nanofaust.MapUI(dsp1)
+    try:
+        nanofaust.create_dsp_sequencer(dsp1, dsp2)
+        assert False, "an instance used by a MapUI was combined"
+    except ValueError:
+        pass
+    del ui
+    combined = nanofaust.create_dsp_sequencer(dsp1, dsp2)
+    combined.init(48000)
+    # the combined instances are owned by the result and cannot be used anymore
+    for instance in (dsp1, dsp2):
+        try:
+            instance.get_numinputs()
+            assert False, "a combined instance is still usable"
+        except (ValueError, TypeError):
+            pass
+    try:
+        nanofaust.create_dsp_sequencer(dsp1, factory.create_dsp_instance())
+        assert False, "an instance was combined twice"
+    except (ValueError, TypeError):
+        pass
+    # instances acquired from a pool stay owned by the pool
+    pool = nanofaust.InterpreterDspPool(factory, 1, 48000)
+    try:
+        nanofaust.create_dsp_parallelizer(pool.acquire(), factory.create_dsp_instance())
+        assert False, "an instance acquired from a pool was combined"
+    except ValueError:
+        pass
+    inputs = np.ones((1, 16), dtype=np.float32)
+    outputs = np.zeros((1, 16), dtype=np.float32)
+    combined.compute(inputs, outputs)
+    assert np.all(outputs == 0.25)
+    del dsp1, dsp2
+    combined.compute(inputs, outputs)
+    assert np.all(outputs == 0.25)
+
+
+def test_compute_buffers():
+    import numpy as np
+    factory = nanofaust.create_interpreter_dsp_factory_from_file('noise.dsp')
+    dsp = factory.create_dsp_instance()
+    dsp.init(48000)
+    # None inputs for input-less DSPs, and empty buffers
+    outputs = np.zeros((1, 16), dtype=np.float32)
+    dsp.compute(None, outputs)
+    assert np.any(outputs != 0)
+    dsp.compute(None, np.zeros((1, 0), dtype=np.float32))
+    dsp.compute(np.zeros((0, 0), dtype=np.float32), np.zeros((1, 0), dtype=np.float32))
+
+
 if __name__ == '__main__':
     print_section("testing nanofaust")
     test_nanofaust()
+    test_ownership()
+    test_compute_buffers()